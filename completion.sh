@@ -1,3 +1,17 @@
+_tcIndexed()
+{
+    #
+    #  Every index entry, reading the segments the manifest lists instead of
+    #  globbing the index directory. Stores without a manifest yet fall back.
+    #
+    local dir=~/.tc/indexes
+    if [[ -f ${dir}/manifest ]] ; then
+        cut -d ' ' -f 1 ${dir}/manifest | while read segment ; do cat ${dir}/${segment}.index ; done
+    else
+        cat ${dir}/*.index 2>/dev/null
+    fi
+}
+
 _tcBase() 
 {
     local cur prev opts base flags
@@ -8,7 +22,7 @@ _tcBase()
     #
     #  The basic options we'll complete.
     #
-    opts="start add-info finish view --help pause delete"
+    opts="start add-info finish view --help pause delete export import index archive fsck metrics merge log timeline stats prompt report"
     flags="--help -h"
 
     if [[ ${prev} == "start" ]] ; then 
@@ -32,12 +46,106 @@ _tcBase()
     fi
 
     if [[ ${prev} == "pause" ]] ;  then
-        COMPREPLY=( $(compgen -W "${flags}" -- ${cur}) )
+        COMPREPLY=( $(compgen -W "${flags} -m --multi" -- ${cur}) )
         return 0
     fi
 
     if [[ ${prev} == "delete" ]] ; then
-        _tcDelete
+        if [[ ${cur} == -* ]] ; then
+            COMPREPLY=( $(compgen -W "--state -s --older-than -o --yes -y --dry-run -n -h --help" -- ${cur}) )
+        else
+            _tcDelete
+        fi
+        return 0
+    fi
+
+    if [[ ${prev} == "--state" || ${prev} == "-s" ]] && [[ ${COMP_WORDS[1]} == "delete" ]] ; then
+        COMPREPLY=( $(compgen -W "started paused finished" -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "import" ]] ; then
+        COMPREPLY=( $(compgen -W "--csv -c -h --help" -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "index" ]] ; then
+        COMPREPLY=( $(compgen -W "--merge -m --rebuild -r -h --help" -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "archive" ]] ; then
+        COMPREPLY=( $(compgen -W "--finished-before -f -h --help" -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "fsck" ]] ; then
+        COMPREPLY=( $(compgen -W "--repair -r -h --help" -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "metrics" ]] ; then
+        COMPREPLY=( $(compgen -W "--textfile -t -h --help" -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "log" ]] ; then
+        COMPREPLY=( $(compgen -W "--tail -n --since -s -h --help" -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "timeline" ]] ; then
+        COMPREPLY=( $(compgen -W "--day -d --week -w -h --help" -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "prompt" ]] ; then
+        COMPREPLY=( $(compgen -W "-h --help" -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "report" ]] ; then
+        COMPREPLY=( $(compgen -W "--between -b --by -y -h --help" -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "--by" || ${prev} == "-y" ]] && [[ ${COMP_WORDS[1]} == "report" ]] ; then
+        COMPREPLY=( $(compgen -W "task day hour" -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "stats" ]] ; then
+        if [[ ${cur} == -* ]] ; then
+            COMPREPLY=( $(compgen -W "--project -p --include-archived -i --between -b -h --help" -- ${cur}) )
+        else
+            _tcView
+        fi
+        return 0
+    fi
+
+    if [[ ${prev} == "--project" || ${prev} == "-p" ]] && [[ ${COMP_WORDS[1]} == "stats" ]] ; then
+        local projects=$(cut -d ' ' -f 3- ~/.tc/projects 2>/dev/null)
+        COMPREPLY=( $(compgen -W "${projects}" -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "merge" ]] ; then
+        COMPREPLY=( $(compgen -d -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "--textfile" ]] ; then
+        COMPREPLY=( $(compgen -f -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "--csv" || ${prev} == "-c" ]] ; then
+        COMPREPLY=( $(compgen -f -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "export" ]] ; then
+        _tcExport
         return 0
     fi
 
@@ -58,7 +166,7 @@ _tcStart()
     cur="${COMP_WORDS[COMP_CWORD]}"
     prev="${COMP_WORDS[COMP_CWORD-1]}"
 
-    opts="-s --switch -h --help"
+    opts="-s --switch -m --multi -h --help"
 
     if [[ ${cur} == -* ]] ; then
         COMPREPLY=( $(compgen -W "${opts}" -- ${cur}) )
@@ -66,7 +174,7 @@ _tcStart()
     fi
 
     if [[ ${cur} == * ]] ; then
-        local tasknames=$(for x in `cat ~/.tc/indexes/*.index | cut -d ' ' -f 2- | uniq | grep -v  [[:space:]]*8 | rev | cut -d ' ' -f 2- | rev`; do echo ${x} ; done )
+        local tasknames=$(for x in `_tcIndexed | cut -d ' ' -f 2- | uniq | grep -v  [[:space:]]*8 | rev | cut -d ' ' -f 2- | rev`; do echo ${x} ; done )
         COMPREPLY=( $(compgen -W "${tasknames}" -- ${cur}) )
         return 0
     fi
@@ -89,7 +197,7 @@ _tcFinish()
         return 0
     fi
 
-    local tasknames=$(for x in `cat ~/.tc/indexes/*.index | cut -d ' ' -f 2- | uniq | grep -v [[:space:]]*32 | rev | cut -d ' ' -f 2- | rev`; do echo ${x} ; done )
+    local tasknames=$(for x in `_tcIndexed | cut -d ' ' -f 2- | uniq | grep -v [[:space:]]*32 | rev | cut -d ' ' -f 2- | rev`; do echo ${x} ; done )
     COMPREPLY=( $(compgen -W "${tasknames}" -- ${cur}) )
     return 0
     
@@ -102,7 +210,18 @@ _tcView()
     cur="${COMP_WORDS[COMP_CWORD]}"
     prev="${COMP_WORDS[COMP_CWORD-1]}"
 
-    opts="-v --verbose -h --help -a --all"
+    opts="-v --verbose -h --help -a --all -m --multi -i --include-archived -p --project -d --depth -b --between -t --top -y --by"
+
+    if [[ ${prev} == "-y" || ${prev} == "--by" ]] ; then
+        COMPREPLY=( $(compgen -W "time updated sessions" -- ${cur}) )
+        return 0
+    fi
+
+    if [[ ${prev} == "-p" || ${prev} == "--project" ]] ; then
+        local projects=$(cut -d ' ' -f 3- ~/.tc/projects 2>/dev/null)
+        COMPREPLY=( $(compgen -W "${projects}" -- ${cur}) )
+        return 0
+    fi
 
     if [[ ${cur} == -* ]] ; then
         COMPREPLY=( $(compgen -W "${opts}" -- ${cur}) )
@@ -110,7 +229,7 @@ _tcView()
     fi
 
     if [[ ${cur} == * ]] ; then
-        local tasknames=$(for x in `cat ~/.tc/indexes/*.index | cut -d ' ' -f 2- | uniq | rev | cut -d ' ' -f 2- | rev`; do echo ${x} ; done )
+        local tasknames=$(for x in `_tcIndexed | cut -d ' ' -f 2- | uniq | rev | cut -d ' ' -f 2- | rev`; do echo ${x} ; done )
         COMPREPLY=( $(compgen -W "${tasknames}" -- ${cur}) )
         return 0
     fi
@@ -134,7 +253,7 @@ _addInfo()
     fi
 
     if [[ ${cur} == * ]] ; then
-        local tasknames=$(for x in `cat ~/.tc/indexes/*.index | cut -d ' ' -f 2- | uniq | rev | cut -d ' ' -f 2- | rev`; do echo ${x} ; done )
+        local tasknames=$(for x in `_tcIndexed | cut -d ' ' -f 2- | uniq | rev | cut -d ' ' -f 2- | rev`; do echo ${x} ; done )
         COMPREPLY=( $(compgen -W "${tasknames}" -- ${cur}) )
         return 0
     fi
@@ -158,7 +277,7 @@ _tcDelete()
     fi
 
     if [[ ${cur} == * ]] ; then
-        local tasknames=$(for x in `cat ~/.tc/indexes/*.index | cut -d ' ' -f 2- | uniq | grep -v  [[:space:]]*8 | rev | cut -d ' ' -f 2- | rev`; do echo ${x} ; done )
+        local tasknames=$(for x in `_tcIndexed | cut -d ' ' -f 2- | uniq | grep -v  [[:space:]]*8 | rev | cut -d ' ' -f 2- | rev`; do echo ${x} ; done )
         COMPREPLY=( $(compgen -W "${tasknames}" -- ${cur}) )
         return 0
     fi
@@ -168,6 +287,24 @@ _tcDelete()
     return 0
 }
 
+_tcExport()
+{
+    local cur prev opts base
+    COMPREPLY=()
+    cur="${COMP_WORDS[COMP_CWORD]}"
+    prev="${COMP_WORDS[COMP_CWORD-1]}"
+
+    opts="-c --columnar -d --dump -h --help"
+
+    if [[ ${cur} == -* ]] ; then
+        COMPREPLY=( $(compgen -W "${opts}" -- ${cur}) )
+        return 0
+    fi
+
+    COMPREPLY=( $(compgen -f -- ${cur}) )
+    return 0
+}
+
 complete -F _tcBase tcatch
 
 
@@ -0,0 +1,273 @@
+#define _POSIX_C_SOURCE 200112L
+
+/* Analytics kernel benchmark:
+ *   make analyticsbench && ./analyticsbench [intervals] [repetitions] > results.json
+ * Fills interval columns with intervals (100 million by default, about 2GB)
+ * from synthetic tasks of BENCH_RUN intervals each spread over a year, then
+ * times every kernel in tc-analytics.h next to the same loop kept scalar,
+ * and checks the two agree. The best repetition of each is summarised as
+ * JSON on stdout, in intervals and column bytes a second, progress goes to
+ * stderr.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tc-analytics.h"
+
+#define BENCH_INTERVALS 100000000L
+#define BENCH_REPETITIONS 5
+#define BENCH_RUN 1000				/* Intervals per task */
+#define BENCH_FROM 1400000000L
+#define BENCH_DAYS 365
+
+/* The reference loops must stay one element at a time */
+#if defined(__GNUC__) && !defined(__clang__)
+	#define BENCH_SCALAR __attribute__((optimize("no-tree-vectorize")))
+#else
+	#define BENCH_SCALAR
+#endif
+
+struct bench_columns {
+	uint32_t * taskIds;
+	int64_t * starts;
+	int64_t * ends;
+	size_t count;
+	size_t taskCount;
+	int64_t from;				/* The window clipped to, the middle of the year */
+	int64_t to;
+	int64_t edges[BENCH_DAYS + 1];
+	int64_t * sums;
+	int64_t * days;
+};
+
+/* Everything measured lands here so nothing gets optimised away */
+static volatile int64_t _bench_sink;
+
+static double _bench_now(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return now.tv_sec + now.tv_nsec/1e9;
+}
+
+BENCH_SCALAR
+static int64_t _bench_scalar_clipped(struct bench_columns * columns){
+	int64_t total, start, end;
+	size_t i;
+
+	total = 0;
+	for(i = 0; i < columns->count; ++i){
+		start = columns->starts[i] > columns->from ? columns->starts[i] : columns->from;
+		end = columns->ends[i] < columns->to ? columns->ends[i] : columns->to;
+		if(end > start)
+			total += end - start;
+	}
+	return total;
+}
+
+BENCH_SCALAR
+static int64_t _bench_scalar_sum_by(struct bench_columns * columns){
+	/* Straight into the task's slot, interval by interval */
+	int64_t start, end;
+	size_t i;
+
+	memset(columns->sums,0,columns->taskCount*sizeof(*columns->sums));
+	for(i = 0; i < columns->count; ++i){
+		start = columns->starts[i] > columns->from ? columns->starts[i] : columns->from;
+		end = columns->ends[i] < columns->to ? columns->ends[i] : columns->to;
+		if(end > start)
+			columns->sums[columns->taskIds[i]] += end - start;
+	}
+	return columns->sums[columns->taskCount/2];
+}
+
+BENCH_SCALAR
+static int64_t _bench_scalar_range(struct bench_columns * columns){
+	int64_t first, last;
+	size_t i;
+
+	first = columns->starts[0];
+	last = columns->ends[0];
+	for(i = 0; i < columns->count; ++i){
+		if(columns->starts[i] < first)
+			first = columns->starts[i];
+		if(columns->ends[i] > last)
+			last = columns->ends[i];
+	}
+	return last - first;
+}
+
+BENCH_SCALAR
+static int64_t _bench_scalar_spread(struct bench_columns * columns){
+	/* Every interval against every day */
+	int64_t start, end;
+	size_t i, d;
+
+	memset(columns->days,0,BENCH_DAYS*sizeof(*columns->days));
+	for(i = 0; i < columns->count; ++i)
+		for(d = 0; d < BENCH_DAYS; ++d){
+			start = columns->starts[i] > columns->edges[d] ? columns->starts[i] : columns->edges[d];
+			end = columns->ends[i] < columns->edges[d+1] ? columns->ends[i] : columns->edges[d+1];
+			if(end > start)
+				columns->days[d] += end - start;
+		}
+	return columns->days[BENCH_DAYS/2];
+}
+
+static int64_t _bench_clipped(struct bench_columns * columns){
+	return tc_analytics_clipped(columns->starts,columns->ends,columns->count,columns->from,columns->to);
+}
+
+static int64_t _bench_sum_by(struct bench_columns * columns){
+	memset(columns->sums,0,columns->taskCount*sizeof(*columns->sums));
+	tc_analytics_sum_by(columns->taskIds,columns->starts,columns->ends,columns->count,columns->from,columns->to,columns->sums);
+	return columns->sums[columns->taskCount/2];
+}
+
+static int64_t _bench_range(struct bench_columns * columns){
+	int64_t first, last;
+
+	tc_analytics_range(columns->starts,columns->ends,columns->count,&first,&last);
+	return last - first;
+}
+
+static int64_t _bench_spread(struct bench_columns * columns){
+	memset(columns->days,0,BENCH_DAYS*sizeof(*columns->days));
+	tc_analytics_spread(columns->starts,columns->ends,columns->count,columns->edges,BENCH_DAYS + 1,columns->days);
+	return columns->days[BENCH_DAYS/2];
+}
+
+struct bench_case {
+	const char * name;
+	const char * about;
+	size_t bytes;				/* Column bytes read per interval */
+	int64_t (*run)(struct bench_columns * columns);
+	int64_t (*scalar)(struct bench_columns * columns);
+	size_t scalarShare;			/* The scalar loop runs over count/scalarShare intervals */
+};
+
+static const struct bench_case _bench_cases[] = {
+	{"clipped", "seconds of every interval inside a window", 16, _bench_clipped, _bench_scalar_clipped, 1},
+	{"sum_by", "seconds inside a window summed per task", 20, _bench_sum_by, _bench_scalar_sum_by, 1},
+	{"range", "earliest start and latest end", 16, _bench_range, _bench_scalar_range, 1},
+	{"spread", "seconds per day over a year of days", 16, _bench_spread, _bench_scalar_spread, BENCH_DAYS},
+	{NULL, NULL, 0, NULL, NULL, 0}
+};
+
+static int _bench_fill(struct bench_columns * columns, size_t count){
+	/* Tasks of BENCH_RUN intervals, each starting somewhere in the year and
+	 * working 5 minutes to 2 hours at a time with gaps in between */
+	unsigned long seed;
+	int64_t when;
+	size_t i;
+	int d;
+
+	columns->count = count;
+	columns->taskCount = (count + BENCH_RUN - 1)/BENCH_RUN;
+	columns->taskIds = malloc(count*sizeof(*columns->taskIds));
+	columns->starts = malloc(count*sizeof(*columns->starts));
+	columns->ends = malloc(count*sizeof(*columns->ends));
+	columns->sums = malloc(columns->taskCount*sizeof(*columns->sums));
+	columns->days = malloc(BENCH_DAYS*sizeof(*columns->days));
+	if(columns->taskIds == NULL || columns->starts == NULL || columns->ends == NULL || columns->sums == NULL || columns->days == NULL)
+		return 0;
+
+	seed = 12345;
+	when = BENCH_FROM;
+	for(i = 0; i < count; ++i){
+		seed = seed*1103515245UL + 12345UL;
+		if(i % BENCH_RUN == 0)
+			when = BENCH_FROM + (int64_t)((seed >> 8) % (BENCH_DAYS*86400L/2));
+		columns->taskIds[i] = i/BENCH_RUN;
+		columns->starts[i] = when;
+		columns->ends[i] = when + 300 + (int64_t)((seed >> 16) % 6900);
+		when = columns->ends[i] + (int64_t)((seed >> 4) % 14400);
+	}
+	for(d = 0; d <= BENCH_DAYS; ++d)
+		columns->edges[d] = BENCH_FROM + d*86400L;
+	columns->from = BENCH_FROM + BENCH_DAYS/4*86400L;
+	columns->to = BENCH_FROM + 3*BENCH_DAYS/4*86400L;
+	return 1;
+}
+
+static double _bench_best(int64_t (*run)(struct bench_columns * columns), struct bench_columns * columns, int repetitions, int64_t * result){
+	double began, elapsed, best;
+	int r;
+
+	best = 0;
+	for(r = 0; r < repetitions; ++r){
+		began = _bench_now();
+		*result = run(columns);
+		elapsed = _bench_now() - began;
+		_bench_sink += *result;
+		if(r == 0 || elapsed < best)
+			best = elapsed;
+	}
+	return best;
+}
+
+static int _bench_run(const struct bench_case * bench, struct bench_columns * columns, int repetitions, int first){
+	double seconds, scalarSeconds;
+	int64_t result, scalarResult;
+	size_t count;
+	int agree;
+
+	seconds = _bench_best(bench->run,columns,repetitions,&result);
+
+	/* The scalar spread is quadratic, so the two run over a slice to be
+	 * compared and its time is scaled up to the whole */
+	count = columns->count;
+	columns->count = count/bench->scalarShare;
+	scalarSeconds = _bench_best(bench->scalar,columns,bench->scalarShare > 1 ? 1 : repetitions,&scalarResult)*bench->scalarShare;
+	if(bench->scalarShare > 1)
+		result = bench->run(columns);
+	agree = result == scalarResult;
+	columns->count = count;
+
+	fprintf(stderr, "%-8s %8.1f ms %8.1f M intervals/s %6.2f GB/s  scalar %8.1f ms  %5.1fx%s\n", bench->name,
+		seconds*1e3, count/seconds/1e6, count*bench->bytes/seconds/1e9, scalarSeconds*1e3, scalarSeconds/seconds,
+		agree ? "" : "  MISMATCH");
+	printf("%s\n    {\"name\": \"%s\", \"about\": \"%s\", \"intervals\": %lu, \"agree\": %s,\n", first ? "" : ",",
+		bench->name, bench->about, (unsigned long)count, agree ? "true" : "false");
+	printf("     \"seconds\": %.6f, \"m_intervals_per_second\": %.1f, \"gb_per_second\": %.2f,\n",
+		seconds, count/seconds/1e6, count*bench->bytes/seconds/1e9);
+	printf("     \"scalar_seconds\": %.6f, \"speedup\": %.2f}", scalarSeconds, scalarSeconds/seconds);
+	return agree;
+}
+
+int main(int argc, char const * argv[]){
+	struct bench_columns columns;
+	long intervals;
+	int repetitions, first, agree, i;
+
+	intervals = argc > 1 ? atol(argv[1]) : BENCH_INTERVALS;
+	repetitions = argc > 2 ? atoi(argv[2]) : BENCH_REPETITIONS;
+	if(intervals < BENCH_DAYS || repetitions < 1){
+		fprintf(stderr, "%s\n", "usage: analyticsbench [intervals] [repetitions]");
+		return 1;
+	}
+	memset(&columns,0,sizeof(columns));
+	fprintf(stderr, "Filling %ld intervals\n", intervals);
+	if(!_bench_fill(&columns,intervals)){
+		fprintf(stderr, "%s\n", "Could not allocate the interval columns.");
+		return 1;
+	}
+
+	printf("{\"benchmark\": \"tcatch-analyticsbench\", \"version\": 1, \"timestamp\": %ld, \"intervals\": %ld, \"repetitions\": %i,\n \"results\": [",
+		(long)time(0), intervals, repetitions);
+	first = 1;
+	agree = 1;
+	for(i = 0; _bench_cases[i].name != NULL; ++i){
+		agree = _bench_run(_bench_cases + i,&columns,repetitions,first) && agree;
+		first = 0;
+	}
+	printf("\n ]}\n");
+
+	free(columns.taskIds);
+	free(columns.starts);
+	free(columns.ends);
+	free(columns.sums);
+	free(columns.days);
+	return agree ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+#define _XOPEN_SOURCE 700
+
+/* Storage backend check:
+ *   make backendcheck && ./backendcheck [tasks] > results.json
+ * Runs the same script of starts, switches, multi-timer starts, pauses,
+ * finishes, notes and status reads through libtimecatcher.a on a scratch
+ * directory store and on the in-memory store, with a clock that moves a
+ * minute per call, and compares every result code and status the two
+ * return. Then times start, pause, status and finish over that many tasks
+ * (1000 by default) on each, so the cost of the bookkeeping can be told
+ * apart from the cost of the disk. Differences and progress go to stderr,
+ * the timings as JSON on stdout. Exits 1 when the backends disagree.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ftw.h>
+
+#include "timecatcher.h"
+
+#define CHECK_TASKS 1000
+#define CHECK_CLOCK 1400000000L
+#define CHECK_STEPS 64
+
+enum check_call { CHECK_START, CHECK_PAUSE, CHECK_FINISH, CHECK_INFO, CHECK_STATUS };
+
+struct check_step {
+	enum check_call call;
+	const char * taskName;		/* NULL for the current task where the call allows it */
+	int flags;
+};
+
+/* What one step gave back */
+struct check_result {
+	int code;
+	struct tc_status status;
+};
+
+static const struct check_step _check_script[] = {
+	{CHECK_STATUS, NULL, 0},
+	{CHECK_START, "write the report", 0},
+	{CHECK_START, "write the report", 0},
+	{CHECK_START, "review", 0},
+	{CHECK_STATUS, NULL, 0},
+	{CHECK_INFO, "first draft done", 0},
+	{CHECK_START, "review", TC_START_SWITCH},
+	{CHECK_STATUS, "write the report", 0},
+	{CHECK_STATUS, "review", 0},
+	{CHECK_PAUSE, NULL, 0},
+	{CHECK_PAUSE, NULL, 0},
+	{CHECK_START, "write the report", 0},
+	{CHECK_FINISH, "write the report", 0},
+	{CHECK_FINISH, "write the report", 0},
+	{CHECK_START, "client/site/bug", TC_START_MULTI},
+	{CHECK_START, "client/site/deploy", TC_START_MULTI},
+	{CHECK_START, "review", TC_START_MULTI},
+	{CHECK_PAUSE, "client/site/bug", 0},
+	{CHECK_STATUS, "client/site/bug", 0},
+	{CHECK_FINISH, "client/site/deploy", 0},
+	{CHECK_STATUS, NULL, 0},
+	{CHECK_START, "write the report", TC_START_SWITCH},
+	{CHECK_STATUS, "write the report", 0},
+	{CHECK_PAUSE, "nothing like it", 0},
+	{CHECK_FINISH, "nothing like it", 0},
+	{CHECK_STATUS, "nothing like it", 0},
+	{CHECK_START, "", 0},
+	{CHECK_FINISH, "review", 0},
+	{CHECK_STATUS, "review", 0},
+	{CHECK_STATUS, NULL, 0}
+};
+
+static const char * _check_names[] = {"start", "pause", "finish", "add-info", "status"};
+
+/* Everything measured lands here so nothing gets optimised away */
+static volatile long _check_sink;
+
+static double _check_now(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return now.tv_sec + now.tv_nsec/1e9;
+}
+
+static time_t _check_clock(void * clockData){
+	/* A minute passes between any two calls */
+	time_t * now = clockData;
+	*now += 60;
+	return *now;
+}
+
+static int _check_call(struct tc_context * context, const struct check_step * step, struct tc_status * status){
+	switch(step->call){
+		case CHECK_START:
+			return tc_lib_start(context,step->taskName,step->flags);
+		case CHECK_PAUSE:
+			return tc_lib_pause(context,step->taskName);
+		case CHECK_FINISH:
+			return tc_lib_finish(context,step->taskName,status);
+		case CHECK_INFO:
+			return tc_lib_add_info(context,step->taskName);
+		case CHECK_STATUS:
+			return tc_lib_status(context,step->taskName,status);
+	}
+	return TC_ERR_ARGS;
+}
+
+static int _check_open(struct tc_context ** context, int backend, const char * storeRoot, time_t * now){
+	struct tc_options options;
+
+	options.storeRoot = storeRoot;
+	options.backend = backend;
+	options.clock = _check_clock;
+	options.clockData = now;
+	options.output = NULL;
+	options.outputData = NULL;
+	return tc_lib_open(context,&options);
+}
+
+static int _check_script_run(int backend, const char * storeRoot, struct check_result * results, size_t count){
+	struct tc_context * context;
+	time_t now;
+	size_t i;
+
+	now = CHECK_CLOCK;
+	if(_check_open(&context,backend,storeRoot,&now) != TC_OK)
+		return 0;
+	for(i = 0; i < count; ++i){
+		memset(&results[i],0,sizeof(results[i]));
+		results[i].code = _check_call(context,_check_script + i,&results[i].status);
+	}
+	tc_lib_close(context);
+	return 1;
+}
+
+static int _check_same(const struct check_result * left, const struct check_result * right){
+	return left->code == right->code && strcmp(left->status.taskName,right->status.taskName) == 0
+		&& strcmp(left->status.taskHash,right->status.taskHash) == 0 && left->status.state == right->status.state
+		&& left->status.seqNum == right->status.seqNum && left->status.startTime == right->status.startTime
+		&& left->status.lastUpdate == right->status.lastUpdate && left->status.worked == right->status.worked;
+}
+
+static void _check_show(const char * backend, const struct check_result * result){
+	fprintf(stderr, "    %-9s %s, %s state %i seq %i started %ld updated %ld worked %ld\n", backend,
+		tc_lib_strerror(result->code), result->status.taskName, result->status.state, result->status.seqNum,
+		(long)result->status.startTime, (long)result->status.lastUpdate, (long)result->status.worked);
+}
+
+static int _check_compare(const char * storeRoot){
+	struct check_result directory[CHECK_STEPS], memory[CHECK_STEPS];
+	size_t count, i, differences;
+
+	count = sizeof(_check_script)/sizeof(*_check_script);
+	if(!_check_script_run(TC_BACKEND_DIRECTORY,storeRoot,directory,count) || !_check_script_run(TC_BACKEND_MEMORY,NULL,memory,count)){
+		fprintf(stderr, "%s\n", "Could not open a store to check.");
+		return 0;
+	}
+	differences = 0;
+	for(i = 0; i < count; ++i){
+		if(_check_same(directory + i,memory + i))
+			continue;
+		fprintf(stderr, "Step %lu, %s %s: the backends disagree\n", (unsigned long)i + 1, _check_names[_check_script[i].call],
+			_check_script[i].taskName == NULL ? "(current)" : _check_script[i].taskName);
+		_check_show("directory",directory + i);
+		_check_show("memory",memory + i);
+		++differences;
+	}
+	fprintf(stderr, "%lu steps, %lu differences\n", (unsigned long)count, (unsigned long)differences);
+	return differences == 0;
+}
+
+static double _check_time(int backend, const char * storeRoot, long tasks){
+	/* Every task is started, paused, read back and finished */
+	struct tc_context * context;
+	struct tc_status status;
+	char taskName[64];
+	double began;
+	time_t now;
+	long i;
+
+	now = CHECK_CLOCK;
+	if(_check_open(&context,backend,storeRoot,&now) != TC_OK)
+		return -1;
+	began = _check_now();
+	for(i = 0; i < tasks; ++i){
+		sprintf(taskName,"timed/task %ld",i);
+		_check_sink += tc_lib_start(context,taskName,TC_START_SWITCH);
+		_check_sink += tc_lib_pause(context,taskName);
+		_check_sink += tc_lib_status(context,taskName,&status);
+		_check_sink += tc_lib_finish(context,taskName,&status);
+	}
+	began = _check_now() - began;
+	tc_lib_close(context);
+	return began;
+}
+
+static int _check_remove(const char * path, const struct stat * info, int type, struct FTW * walk){
+	(void)info;
+	(void)type;
+	(void)walk;
+	return remove(path);
+}
+
+int main(int argc, char const * argv[]){
+	char storeRoot[] = "/tmp/tcatch-backendcheck-XXXXXX";
+	double directorySeconds, memorySeconds;
+	long tasks;
+	int agree;
+
+	tasks = argc > 1 ? atol(argv[1]) : CHECK_TASKS;
+	if(tasks < 1){
+		fprintf(stderr, "%s\n", "usage: backendcheck [tasks]");
+		return 1;
+	}
+	if(mkdtemp(storeRoot) == NULL){
+		fprintf(stderr, "%s\n", "Could not create a scratch store.");
+		return 1;
+	}
+
+	agree = _check_compare(storeRoot);
+	fprintf(stderr, "Timing %ld tasks on each backend\n", tasks);
+	directorySeconds = _check_time(TC_BACKEND_DIRECTORY,storeRoot,tasks);
+	memorySeconds = _check_time(TC_BACKEND_MEMORY,NULL,tasks);
+	nftw(storeRoot,_check_remove,16,FTW_DEPTH | FTW_PHYS);
+	if(directorySeconds < 0 || memorySeconds < 0){
+		fprintf(stderr, "%s\n", "Could not open a store to time.");
+		return 1;
+	}
+
+	fprintf(stderr, "directory %8.2f us/task  memory %8.2f us/task  %.1fx\n", directorySeconds/tasks*1e6, memorySeconds/tasks*1e6,
+		memorySeconds > 0 ? directorySeconds/memorySeconds : 0);
+	printf("{\"benchmark\": \"tcatch-backendcheck\", \"version\": 1, \"timestamp\": %ld, \"tasks\": %ld, \"agree\": %s,\n", (long)time(0), tasks, agree ? "true" : "false");
+	printf(" \"directory_seconds\": %.6f, \"memory_seconds\": %.6f,\n", directorySeconds, memorySeconds);
+	printf(" \"directory_us_per_task\": %.2f, \"memory_us_per_task\": %.2f}\n", directorySeconds/tasks*1e6, memorySeconds/tasks*1e6);
+	return agree ? 0 : 1;
+}
@@ -0,0 +1,289 @@
+#define _XOPEN_SOURCE 700
+
+/* Columnar export round trip check:
+ *   make exportcheck && ./exportcheck
+ * Writes a scratch directory store through libtimecatcher.a with a clock
+ * that moves a minute per call: finished, paused, switched, multi-timer
+ * and still running tasks. Exports it with _tc_export_collect and
+ * _tc_export_write, once to a short path and once to one longer than
+ * TC_MAX_BUFF, and reads both back through the columnar reader. Every interval in the file has to match the one
+ * replayed from the store's own history, and every task's intervals have
+ * to add up to what tc_lib_status (and so tcatch view) says it worked.
+ * Differences go to stderr, exits 1 when there are any.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ftw.h>
+#include <sys/stat.h>
+
+#include "timecatcher.h"
+#include "tc-store.h"
+#include "tc-export.h"
+#include "tc-columnar.h"
+
+#define CHECK_CLOCK 1400000000L
+#define CHECK_INTERVALS 256
+
+enum check_call { CHECK_START, CHECK_PAUSE, CHECK_FINISH };
+
+struct check_step {
+	enum check_call call;
+	const char * taskName;		/* NULL for the current task */
+	int flags;
+};
+
+static const struct check_step _check_script[] = {
+	{CHECK_START, "write the report", 0},
+	{CHECK_PAUSE, NULL, 0},
+	{CHECK_START, "write the report", 0},
+	{CHECK_START, "review", TC_START_SWITCH},
+	{CHECK_FINISH, "review", 0},
+	{CHECK_START, "client/site/bug", TC_START_MULTI},
+	{CHECK_START, "client/site/deploy", TC_START_MULTI},
+	{CHECK_PAUSE, "client/site/bug", 0},
+	{CHECK_START, "client/site/bug", TC_START_MULTI},
+	{CHECK_FINISH, "client/site/deploy", 0},
+	{CHECK_START, "write the report", TC_START_SWITCH},
+	{CHECK_FINISH, "write the report", 0},
+	{CHECK_START, "started once", 0}
+};
+
+/* One interval as replayed from the store */
+struct check_interval {
+	char taskName[TC_MAX_BUFF];
+	time_t start;
+	time_t end;
+	int state;
+};
+
+struct check_replay {
+	struct check_interval intervals[CHECK_INTERVALS];
+	size_t count;
+	time_t exportTime;
+	const char * taskName;
+	int openState;
+	time_t openStart;
+	int overflow;
+};
+
+static time_t _check_clock(void * clockData){
+	/* A minute passes between any two calls */
+	time_t * now = clockData;
+	*now += 60;
+	return *now;
+}
+
+static void _check_push(struct check_replay * replay, time_t start, time_t end, int state){
+	struct check_interval * interval;
+
+	if(replay->count == CHECK_INTERVALS){
+		replay->overflow = 1;
+		return;
+	}
+	interval = &replay->intervals[replay->count++];
+	strcpy(interval->taskName,replay->taskName);
+	interval->start = start;
+	interval->end = end;
+	interval->state = state;
+}
+
+static void _check_record(int seqNum, int state, time_t eventTime, void * data){
+	/* A start opens an interval unless one is open, a pause or finish closes it */
+	struct check_replay * replay = data;
+	(void)seqNum;
+
+	if(state == TC_TASK_STARTED && replay->openState != TC_TASK_STARTED){
+		replay->openState = TC_TASK_STARTED;
+		replay->openStart = eventTime;
+	}else if((state == TC_TASK_PAUSED || state == TC_TASK_FINISHED) && replay->openState == TC_TASK_STARTED){
+		_check_push(replay,replay->openStart,eventTime,state);
+		replay->openState = state;
+	}
+}
+
+static void _check_task(const char * taskHash, const char * taskName, void * data){
+	struct tc_store * store = ((void **)data)[0];
+	struct check_replay * replay = ((void **)data)[1];
+
+	replay->taskName = taskName;
+	replay->openState = TC_TASK_NOT_FOUND;
+	store->ops->history(store,taskHash,_check_record,replay);
+	if(replay->openState == TC_TASK_STARTED)
+		_check_push(replay,replay->openStart,replay->exportTime,TC_TASK_STARTED);
+}
+
+static int _check_script_run(const char * storeRoot, time_t * now){
+	struct tc_context * context;
+	struct tc_options options;
+	struct tc_status status;
+	size_t i;
+	int code;
+
+	options.storeRoot = storeRoot;
+	options.backend = TC_BACKEND_DIRECTORY;
+	options.clock = _check_clock;
+	options.clockData = now;
+	options.output = NULL;
+	options.outputData = NULL;
+	if(tc_lib_open(&context,&options) != TC_OK)
+		return 0;
+	for(i = 0; i < sizeof(_check_script)/sizeof(*_check_script); ++i){
+		switch(_check_script[i].call){
+			case CHECK_START:
+				code = tc_lib_start(context,_check_script[i].taskName,_check_script[i].flags);
+				break;
+			case CHECK_PAUSE:
+				code = tc_lib_pause(context,_check_script[i].taskName);
+				break;
+			default:
+				code = tc_lib_finish(context,_check_script[i].taskName,&status);
+				break;
+		}
+		if(code != TC_OK)
+			fprintf(stderr, "Step %lu, %s: %s\n", (unsigned long)i + 1, _check_script[i].taskName == NULL ? "(current)" : _check_script[i].taskName, tc_lib_strerror(code));
+	}
+	tc_lib_close(context);
+	return 1;
+}
+
+static size_t _check_worked(const char * storeRoot, time_t * now, const struct tc_columnar * columns){
+	/* Each task's intervals against the time tc_lib_status says it worked.
+	 * A running task's last interval ends at the export, its status at the
+	 * clock of the status call */
+	struct tc_context * context;
+	struct tc_options options;
+	struct tc_status status;
+	const char * taskName;
+	uint64_t task, i;
+	time_t summed, expected;
+	size_t differences;
+
+	options.storeRoot = storeRoot;
+	options.backend = TC_BACKEND_DIRECTORY;
+	options.clock = _check_clock;
+	options.clockData = now;
+	options.output = NULL;
+	options.outputData = NULL;
+	if(tc_lib_open(&context,&options) != TC_OK)
+		return 1;
+	differences = 0;
+	for(task = 0; task < columns->taskCount; ++task){
+		taskName = tc_columnar_taskName(columns,(uint32_t)task);
+		summed = 0;
+		for(i = 0; i < columns->intervalCount; ++i)
+			if(columns->taskIds[i] == task)
+				summed += (time_t)(columns->ends[i] - columns->starts[i]);
+		if(taskName == NULL || tc_lib_status(context,taskName,&status) != TC_OK){
+			fprintf(stderr, "Task %lu of the export is not in the store\n", (unsigned long)task);
+			++differences;
+			continue;
+		}
+		expected = status.worked - (status.state == TC_TASK_STARTED ? *now - (time_t)columns->exportTime : 0);
+		if(summed != expected){
+			fprintf(stderr, "%s: the export adds up to %lds, the store to %lds\n", taskName, (long)summed, (long)expected);
+			++differences;
+		}
+	}
+	tc_lib_close(context);
+	return differences;
+}
+
+static size_t _check_file(const char * storeRoot, const char * exportPath, struct check_replay * replay, time_t * now){
+	/* Read the file back and hold it up to the store, interval by interval */
+	struct tc_columnar columns;
+	const char * taskName;
+	size_t i, differences;
+
+	if(!tc_columnar_open(exportPath,&columns)){
+		fprintf(stderr, "%s\n", "Could not read the export back.");
+		return 1;
+	}
+	differences = 0;
+	if(columns.intervalCount != replay->count){
+		fprintf(stderr, "The export has %lu intervals, the store %lu\n", (unsigned long)columns.intervalCount, (unsigned long)replay->count);
+		++differences;
+	}
+	for(i = 0; i < columns.intervalCount && i < replay->count; ++i){
+		taskName = tc_columnar_taskName(&columns,columns.taskIds[i]);
+		if(taskName != NULL && strcmp(taskName,replay->intervals[i].taskName) == 0 && columns.starts[i] == (int64_t)replay->intervals[i].start
+			&& columns.ends[i] == (int64_t)replay->intervals[i].end && columns.states[i] == (uint32_t)replay->intervals[i].state)
+			continue;
+		fprintf(stderr, "Interval %lu: export %s %ld-%ld state %lu, store %s %ld-%ld state %i\n", (unsigned long)i + 1,
+			taskName == NULL ? "?" : taskName, (long)columns.starts[i], (long)columns.ends[i], (unsigned long)columns.states[i],
+			replay->intervals[i].taskName, (long)replay->intervals[i].start, (long)replay->intervals[i].end, replay->intervals[i].state);
+		++differences;
+	}
+	differences += _check_worked(storeRoot,now,&columns);
+	fprintf(stderr, "%s: %lu intervals from %lu tasks, %lu differences\n", exportPath,
+		(unsigned long)columns.intervalCount, (unsigned long)columns.taskCount, (unsigned long)differences);
+	tc_columnar_close(&columns);
+	return differences;
+}
+
+static int _check_long_path(const char * storeRoot, char * exportPath){
+	/* A path well past TC_MAX_BUFF, made of directories short enough to create */
+	size_t i;
+
+	strcpy(exportPath,storeRoot);
+	for(i = 0; i < 3; ++i){
+		strcat(exportPath,"/");
+		memset(exportPath + strlen(exportPath),'d',120);
+		exportPath[strlen(storeRoot) + (i+1)*121] = '\0';
+		if(mkdir(exportPath,0700) != 0)
+			return 0;
+	}
+	strcat(exportPath,"/export.col");
+	return 1;
+}
+
+static int _check_remove(const char * path, const struct stat * info, int type, struct FTW * walk){
+	(void)info;
+	(void)type;
+	(void)walk;
+	return remove(path);
+}
+
+int main(void){
+	char storeRoot[] = "/tmp/tcatch-exportcheck-XXXXXX";
+	char shortPath[64];
+	char longPath[512];
+	struct tc_export_columns columns;
+	struct check_replay * replay;
+	struct tc_store * store;
+	void * walk[2];
+	size_t differences;
+	time_t now;
+
+	if(mkdtemp(storeRoot) == NULL || (replay = calloc(1,sizeof(*replay))) == NULL){
+		fprintf(stderr, "%s\n", "Could not create a scratch store.");
+		return 1;
+	}
+	now = CHECK_CLOCK;
+	differences = 1;
+	if(_check_script_run(storeRoot,&now) && _tc_store_open_directory(&store,storeRoot) == TC_OK){
+		memset(&columns,0,sizeof(columns));
+		columns.exportTime = _check_clock(&now);
+		replay->exportTime = columns.exportTime;
+		walk[0] = store;
+		walk[1] = replay;
+		store->ops->list(store,_check_task,walk);
+		sprintf(shortPath,"%s/export.col",storeRoot);
+		if(replay->overflow || !_tc_export_collect(store,&columns) || !_check_long_path(storeRoot,longPath)
+			|| !_tc_export_write(shortPath,&columns) || !_tc_export_write(longPath,&columns))
+			fprintf(stderr, "%s\n", "Could not export the scratch store.");
+		else
+			differences = _check_file(storeRoot,shortPath,replay,&now) + _check_file(storeRoot,longPath,replay,&now);
+		free(columns.taskIds);
+		free(columns.starts);
+		free(columns.ends);
+		free(columns.states);
+		free(columns.nameOffsets);
+		free(columns.names);
+		_tc_store_close(store);
+	}
+	nftw(storeRoot,_check_remove,16,FTW_DEPTH | FTW_PHYS);
+	free(replay);
+	return differences == 0 ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+#define _POSIX_C_SOURCE 200112L
+
+/* Core primitive microbenchmarks:
+ *   make microbench && ./microbench [repetitions] [name] > results.json
+ * Times the helpers every command runs through, one at a time and in
+ * process, so changes to them show up without process startup in the way.
+ * Each benchmark is warmed up, sized so one repetition takes about
+ * BENCH_TARGET seconds, then repeated. The nanoseconds per call of each
+ * repetition are summarised as JSON on stdout, progress goes to stderr.
+ * Pass a name to run only the benchmarks starting with it.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "tc-task.h"
+#include "tc-directory.h"
+#include "tc-init.h"
+
+#define BENCH_TARGET 0.02
+#define BENCH_WARMUP 2
+#define BENCH_REPETITIONS 15
+#define BENCH_NAMES 64
+#define BENCH_EVENTS 2000
+
+struct bench_inputs {
+	char names[BENCH_NAMES][TC_MAX_BUFF];
+	char padded[BENCH_NAMES][TC_MAX_BUFF];
+	char * seqText;
+	size_t seqLength;
+};
+
+struct bench_case {
+	const char * name;
+	const char * about;
+	/* Runs the primitive iterations times, returns bytes handled per call */
+	size_t (*run)(struct bench_inputs * inputs, long iterations);
+};
+
+/* Everything measured lands here so nothing gets optimised away */
+static volatile unsigned long _bench_sink;
+
+static double _bench_now(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return now.tv_sec + now.tv_nsec/1e9;
+}
+
+static size_t _bench_hash(struct bench_inputs * inputs, long iterations){
+	char taskHash[TC_MAX_BUFF];
+	long i;
+
+	for(i = 0; i < iterations; ++i){
+		_tc_taskName_to_Hash(inputs->names[i % BENCH_NAMES],taskHash);
+		_bench_sink += (unsigned char)taskHash[0];
+	}
+	return strlen(inputs->names[0]);
+}
+
+static size_t _bench_trim(struct bench_inputs * inputs, long iterations){
+	/* trim works in place, the copy back is part of every call */
+	char buffer[TC_MAX_BUFF];
+	long i;
+
+	for(i = 0; i < iterations; ++i){
+		strcpy(buffer,inputs->padded[i % BENCH_NAMES]);
+		_bench_sink += (unsigned char)trim(buffer)[0];
+	}
+	return strlen(inputs->padded[0]);
+}
+
+static size_t _bench_resolve(struct bench_inputs * inputs, long iterations){
+	/* tcatch start -s fix the login bug -v, as the shell splits it */
+	static char const * argv[] = {"tcatch", "start", "-s", "fix", "the", "login", "bug", "on", "the", "client", "site", "-v"};
+	char taskName[TC_MAX_BUFF];
+	long i;
+	(void)inputs;
+
+	for(i = 0; i < iterations; ++i){
+		_resolve_taskName_from_args(sizeof(argv)/sizeof(*argv),argv,taskName);
+		_bench_sink += (unsigned char)taskName[0];
+	}
+	return 0;
+}
+
+static size_t _bench_flag(struct bench_inputs * inputs, long iterations){
+	/* A miss walks every argument, which is what most checks do */
+	static char const * argv[] = {"tcatch", "view", "--all", "--include-archived", "-p", "client/site", "--depth", "2"};
+	long i;
+	(void)inputs;
+
+	for(i = 0; i < iterations; ++i)
+		_bench_sink += _tc_args_flag_check(sizeof(argv)/sizeof(*argv),argv,TC_VERBOSE_LONG,TC_VERBOSE_SHORT);
+	return 0;
+}
+
+static size_t _bench_replay(struct bench_inputs * inputs, long iterations){
+	/* A long lived task's whole history into its summary, as view does */
+	struct tc_task_summary summary;
+	long i;
+
+	for(i = 0; i < iterations; ++i){
+		_tc_task_summary_init(&summary);
+		_tc_seq_parse(inputs->seqText,inputs->seqLength,_tc_task_summary_record,&summary);
+		_bench_sink += (unsigned long)summary.accumulated;
+	}
+	return inputs->seqLength;
+}
+
+static const struct bench_case _bench_cases[] = {
+	{"taskName_to_Hash", "sha-1 of a task name into its file name", _bench_hash},
+	{"trim", "strip a padded task name, strcpy included", _bench_trim},
+	{"resolve_taskName_from_args", "join the words of a 12 argument command line", _bench_resolve},
+	{"args_flag_check", "look for a flag missing from 8 arguments", _bench_flag},
+	{"seq_replay", "parse and summarise a 2000 event sequence", _bench_replay},
+	{NULL, NULL, NULL}
+};
+
+static int _bench_inputs(struct bench_inputs * inputs){
+	/* Names shaped like the ones in real stores, projects and all */
+	static char const * projects[] = {"client", "client/site", "internal/tools", "", "ops/oncall", "reading"};
+	size_t capacity;
+	long i;
+
+	for(i = 0; i < BENCH_NAMES; ++i){
+		sprintf(inputs->names[i],"%s%sfix issue %ld in the login flow",projects[i % 6],projects[i % 6][0] ? "/" : "",i*37);
+		sprintf(inputs->padded[i]," \t %s  \n",inputs->names[i]);
+	}
+
+	capacity = BENCH_EVENTS*40 + 1;
+	inputs->seqText = malloc(capacity);
+	if(inputs->seqText == NULL)
+		return FALSE;
+	inputs->seqLength = 0;
+	for(i = 0; i < BENCH_EVENTS; ++i)
+		inputs->seqLength += sprintf(inputs->seqText + inputs->seqLength, "%ld %i %ld\n", i,
+			i == BENCH_EVENTS - 1 ? TC_TASK_FINISHED : i % 2 ? TC_TASK_PAUSED : TC_TASK_STARTED, 1400000000L + i*317);
+	return TRUE;
+}
+
+static int _bench_compare(const void * left, const void * right){
+	double a = *(const double *)left, b = *(const double *)right;
+	return a < b ? -1 : a > b;
+}
+
+static void _bench_run(const struct bench_case * bench, struct bench_inputs * inputs, int repetitions, int first){
+	double * samples;
+	double began, elapsed, mean, variance;
+	long iterations;
+	size_t bytes;
+	int r;
+
+	samples = malloc(repetitions*sizeof(*samples));
+	if(samples == NULL){
+		fprintf(stderr, "%s\n", "Could not allocate the samples.");
+		exit(1);
+	}
+
+	/* Double the calls until one repetition is long enough to time */
+	for(iterations = 1;; iterations *= 2){
+		began = _bench_now();
+		bench->run(inputs,iterations);
+		if(_bench_now() - began >= BENCH_TARGET/4)
+			break;
+	}
+	iterations = (long)(iterations*BENCH_TARGET/(_bench_now() - began)) + 1;
+	for(r = 0; r < BENCH_WARMUP; ++r)
+		bench->run(inputs,iterations);
+
+	bytes = 0;
+	for(r = 0; r < repetitions; ++r){
+		began = _bench_now();
+		bytes = bench->run(inputs,iterations);
+		elapsed = _bench_now() - began;
+		samples[r] = elapsed*1e9/iterations;
+	}
+
+	for(mean = 0, r = 0; r < repetitions; ++r)
+		mean += samples[r];
+	mean /= repetitions;
+	for(variance = 0, r = 0; r < repetitions; ++r)
+		variance += (samples[r] - mean)*(samples[r] - mean);
+	variance = repetitions > 1 ? variance/(repetitions - 1) : 0;
+	qsort(samples,repetitions,sizeof(*samples),_bench_compare);
+
+	fprintf(stderr, "%-28s %12.1f ns/call\n", bench->name, samples[repetitions/2]);
+	printf("%s\n    {\"name\": \"%s\", \"about\": \"%s\", \"iterations\": %ld, \"bytes_per_call\": %lu,\n",
+		first ? "" : ",", bench->name, bench->about, iterations, (unsigned long)bytes);
+	printf("     \"ns_per_call\": {\"min\": %.2f, \"median\": %.2f, \"mean\": %.2f, \"max\": %.2f, \"stddev\": %.2f}",
+		samples[0], samples[repetitions/2], mean, samples[repetitions-1], sqrt(variance));
+	if(bytes > 0)
+		printf(",\n     \"mb_per_second\": %.1f", bytes*1e3/samples[repetitions/2]);
+	printf("}");
+	free(samples);
+}
+
+int main(int argc, char const * argv[]){
+	struct bench_inputs * inputs;
+	char const * only;
+	int repetitions, first, i;
+
+	repetitions = argc > 1 ? atoi(argv[1]) : BENCH_REPETITIONS;
+	only = argc > 2 ? argv[2] : "";
+	if(repetitions < 1){
+		fprintf(stderr, "%s\n", "usage: microbench [repetitions] [name]");
+		return 1;
+	}
+	inputs = malloc(sizeof(*inputs));
+	if(inputs == NULL || _bench_inputs(inputs) == FALSE){
+		fprintf(stderr, "%s\n", "Could not build the benchmark inputs.");
+		return 1;
+	}
+
+	printf("{\"benchmark\": \"tcatch-microbench\", \"version\": 1, \"timestamp\": %ld, \"repetitions\": %i, \"warmup\": %i, \"target_seconds\": %.3f,\n \"results\": [",
+		(long)time(0), repetitions, BENCH_WARMUP, BENCH_TARGET);
+	first = TRUE;
+	for(i = 0; _bench_cases[i].name != NULL; ++i){
+		if(strncmp(_bench_cases[i].name,only,strlen(only)) != 0)
+			continue;
+		_bench_run(_bench_cases + i,inputs,repetitions,first);
+		first = FALSE;
+	}
+	printf("\n ]}\n");
+
+	free(inputs->seqText);
+	free(inputs);
+	return 0;
+}
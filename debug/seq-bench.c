@@ -0,0 +1,112 @@
+#define _XOPEN_SOURCE 500
+
+/* Sequence parser microbenchmark:
+ *   make seqbench && ./seqbench [records] [repetitions]
+ * Writes a synthetic history of records events, then times the in-memory
+ * parser, the mmap walk and the old fscanf loop over it. Each is run
+ * repetitions times (5 by default) and the fastest run is reported, so a
+ * busy machine shows less in the numbers.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tc-task.h"
+
+static double _bench_now(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return now.tv_sec + now.tv_nsec/1e9;
+}
+
+static void _bench_record(int seqNum, int seqState, time_t seqTime, void * data){
+	/* Touch every field so nothing gets optimised away */
+	*(long *)data += seqNum + seqState + (long)seqTime;
+}
+
+static void _bench_report(const char * name, double seconds, size_t bytes, long records){
+	printf("%-8s %8.1f ms %10.1f MB/s %8.1f M records/s\n", name, seconds*1e3,
+		bytes/seconds/1e6, records/seconds/1e6);
+}
+
+int main(int argc, char const * argv[]){
+	long records, repetitions, run, i, checksum, parsed;
+	char * text;
+	size_t length, capacity;
+	char path[] = "/tmp/tc-seq-bench-XXXXXX";
+	double began, ended, best;
+	int fd, seqNum, seqState;
+	time_t seqTime;
+	FILE * fp;
+
+	records = argc > 1 ? atol(argv[1]) : 5000000L;
+	repetitions = argc > 2 ? atol(argv[2]) : 5;
+	if(records < 1 || repetitions < 1){
+		fprintf(stderr, "%s\n", "usage: seqbench [records] [repetitions]");
+		return 1;
+	}
+	capacity = records*40 + 1;
+	text = malloc(capacity);
+	if(text == NULL){
+		fprintf(stderr, "%s\n", "Could not allocate the synthetic history.");
+		return 1;
+	}
+
+	/* Alternating starts and pauses a few minutes apart, like a long lived task */
+	length = 0;
+	for(i = 0; i < records; ++i)
+		length += sprintf(text + length, "%ld %i %ld\n", i, i % 2 ? TC_TASK_PAUSED : TC_TASK_STARTED, 1400000000L + i*317);
+
+	fd = mkstemp(path);
+	if(fd == -1 || write(fd,text,length) != (ssize_t)length){
+		fprintf(stderr, "%s\n", "Could not write the synthetic history.");
+		return 1;
+	}
+	close(fd);
+	printf("%ld records, %lu bytes\n", records, (unsigned long)length);
+
+	best = 0;
+	for(run = 0; run < repetitions; ++run){
+		checksum = 0;
+		began = _bench_now();
+		parsed = _tc_seq_parse(text,length,_bench_record,&checksum);
+		ended = _bench_now();
+		if(run == 0 || ended - began < best)
+			best = ended - began;
+	}
+	_bench_report("memory",best,length,parsed);
+
+	for(run = 0; run < repetitions; ++run){
+		checksum = 0;
+		began = _bench_now();
+		parsed = _tc_seq_foreach(path,_bench_record,&checksum);
+		ended = _bench_now();
+		if(run == 0 || ended - began < best)
+			best = ended - began;
+	}
+	_bench_report("mmap",best,length,parsed);
+
+	/* The loop every reader used before */
+	for(run = 0; run < repetitions; ++run){
+		checksum = 0;
+		parsed = 0;
+		began = _bench_now();
+		fp = fopen(path,"r");
+		while(fp && fscanf(fp, "%i %i %ld\n", &seqNum, &seqState, &seqTime) == 3){
+			_bench_record(seqNum,seqState,seqTime,&checksum);
+			++parsed;
+		}
+		if(fp)
+			fclose(fp);
+		ended = _bench_now();
+		if(run == 0 || ended - began < best)
+			best = ended - began;
+	}
+	_bench_report("fscanf",best,length,parsed);
+
+	unlink(path);
+	free(text);
+	return 0;
+}
@@ -0,0 +1,73 @@
+#!/bin/sh
+#parallel writer stress script:
+#  sh debug/stress.sh [writers] [rounds]
+#Runs the writers against a scratch store at the same time, then checks that
+#every sequence file and the current file are still consistent.
+
+WRITERS=${1:-8}
+ROUNDS=${2:-25}
+TCATCH=${TCATCH:-$(pwd)/tcatch}
+STORE=$(mktemp -d)
+export HOME=$STORE
+
+writer(){
+	round=0
+	while [ $round -lt $ROUNDS ]; do
+		#Everybody fights over a few shared tasks, the current file and the
+		#totals of their project
+		$TCATCH start -s team/shared$(( (round + $1) % 3 )) > /dev/null 2>&1
+		$TCATCH add-info writer $1 round $round > /dev/null 2>&1
+		$TCATCH pause > /dev/null 2>&1
+		#and works on a task nobody else touches
+		$TCATCH start team/own$1 > /dev/null 2>&1
+		$TCATCH finish team/own$1 > /dev/null 2>&1
+		round=$((round + 1))
+	done
+}
+
+echo "Running $WRITERS writers for $ROUNDS rounds each in $STORE"
+began=$(date +%s.%N)
+w=0
+while [ $w -lt $WRITERS ]; do
+	writer $w &
+	w=$((w + 1))
+done
+wait
+ended=$(date +%s.%N)
+echo "$WRITERS $ROUNDS $began $ended" | awk '{ ops = $1 * $2 * 5; s = $4 - $3; printf "%d commands in %.2f seconds (%.0f commands/s)\n", ops, s, ops / s }'
+
+failed=0
+
+echo "Every sequence file counts up from 0 with well formed, ordered records"
+for seq in $STORE/.tc/tasks/*.seq; do
+	awk -v file="$seq" '
+		NF != 3 || $1 != NR - 1 || ($2 != 8 && $2 != 16 && $2 != 32) || $3 < last { print file ": bad record on line " NR ": " $0; bad = 1 }
+		{ last = $3 }
+		END { exit bad }' "$seq" || failed=1
+done
+
+echo "Only the current task may be left running"
+started=$(for seq in $STORE/.tc/tasks/*.seq; do tail -n 1 "$seq" | awk -v hash=$(basename "$seq" .seq) '$2 == 8 { print hash }'; done)
+current=""
+if [ -f $STORE/.tc/current ]; then
+	current=$(sed -n 2p $STORE/.tc/current)
+fi
+if [ "$started" != "$current" ]; then
+	echo "running tasks [$started] but current is [$current]"
+	failed=1
+fi
+
+echo "fsck agrees, index segments, manifest, journal, project totals, counters and sessions included"
+$TCATCH fsck > $STORE/fsck.out
+if ! tail -n 1 $STORE/fsck.out | grep -q ": 0 problems"; then
+	cat $STORE/fsck.out
+	failed=1
+fi
+
+rm -Rf $STORE
+if [ $failed -eq 0 ]; then
+	echo "Store is consistent"
+else
+	echo "Store is CORRUPT"
+fi
+exit $failed
@@ -58,9 +58,17 @@ valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20
 echo "Add some information to the task"
 valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch add-info This is some summary information
 
+echo "Pipe a long note in through standard input"
+seq 1 20000 | valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch add-info -
+
 echo "Show all tasks"
 valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view --all
 
+echo "Show the top tasks by time, by last update and by sessions"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view --top 2
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view --top 2 --by updated
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view --top 5 --by sessions
+
 echo "Show all tasks verbosely"
 valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view --all --verbose
 
@@ -76,6 +84,138 @@ valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20
 echo "Pause the task with arguments (which doesn't do anything)"
 valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch pause arguments arguments
 
+echo "Run several timers at once in multi-timer mode"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch start --multi incident
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch start --multi deploy
+
+echo "Both timers (and the current task if there was one) are listed as running"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view --multi
+
+echo "Pause one timer by name, finish the other"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch pause --multi incident
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch finish deploy
+
+echo "Tasks named with slashes roll up into their projects as intervals close"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch start --multi client/feature/ticket
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch start --multi client/bugs/crash
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch pause --multi client/feature/ticket
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch finish client/bugs/crash
+
+echo "Show every project, then client one level down, answered from the rollups"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view --project
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view --project client --depth 1
+
+echo "Export every task's intervals to a columnar file"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch export --columnar /tmp/tcatch-validate.col
+
+echo "Read the columnar file back through the reader, every interval should be listed"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch export --dump /tmp/tcatch-validate.col
+rm -f /tmp/tcatch-validate.col
+
+echo "Round trip a scratch store through the columnar file, there should be no differences"
+make exportcheck && valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./exportcheck
+
+echo "Import history from a csv file, the bad row should be reported and skipped"
+printf 'task,state,timestamp,note\nimported,started,1000,first\n"imported, too",started,1100\nimported,paused,2000,"lunch, then more"\nnot a row\n"imported, too",finished,1800\n' > /tmp/tcatch-validate.csv
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch import --csv /tmp/tcatch-validate.csv
+
+echo "Time worked inside a window, for one task and then for all of them"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view imported --between 1500 1900
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view --all --between 19700101 19700101
+
+echo "Importing the same file again skips every row"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch import --csv /tmp/tcatch-validate.csv
+rm -f /tmp/tcatch-validate.csv
+
+echo "List the index segments, the imported days should each have one"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch index
+
+echo "Merge the days of past months into month segments and list them again"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch index --merge
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch index 19700101 19701231
+
+echo "Archive the finished tasks, the imported ones finished long ago"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch archive --finished-before 20000101
+
+echo "An archived task is still found by name, and listed when asked for"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view -v "imported, too"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view --all --include-archived
+
+echo "Check the store, archived tasks included, then repair it after losing an index segment"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch fsck
+rm -f ~/.tc/indexes/1970*.index
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch fsck --repair
+
+echo "Importing into an archived task brings it back and continues its history, then archive it again"
+printf 'task,state,timestamp\n"imported, too",started,1900\n"imported, too",finished,1950\n' > /tmp/tcatch-validate.csv
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch import --csv /tmp/tcatch-validate.csv
+rm -f /tmp/tcatch-validate.csv
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view -v "imported, too"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch archive --finished-before 20000101
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch fsck
+
+echo "Starting an archived task resumes its history, finishing it again leaves it hot"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch start -s "imported, too"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch finish "imported, too"
+
+echo "It is back in the tasks directory only, listed once and checked without problems"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch view --all --include-archived
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch fsck
+
+echo "Write the metrics textfile from the counters fsck just checked"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch metrics
+cat ~/.tc/metrics.prom
+
+echo "Show the journal: today's events, the last three, and everything since the epoch"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch log
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch log --tail 3
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch log --since 0
+
+echo "Chart today and this week, narrow enough to crowd the axis"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch timeline
+COLUMNS=40 valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch timeline --week
+
+echo "The prompt record, with a task current and without one"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch start -s prompted
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch prompt
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch finish prompted
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch prompt
+
+echo "Session percentiles: the whole store, a task, a project and a window of days"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch stats
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch stats imported
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch stats --project client --include-archived
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch stats --between 19700101 $(date +%Y%m%d)
+
+echo "Reports per task, per day and per hour of the week, over everything and a window of days"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch report
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch report --by day
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch report --by hour --between 19700101 $(date +%Y%m%d)
+
+echo "Merge a second store in twice, the second merge should add nothing, then check the store"
+rm -rf /tmp/tcatch-validate-home && mkdir -p /tmp/tcatch-validate-home
+HOME=/tmp/tcatch-validate-home ./tcatch start task1
+HOME=/tmp/tcatch-validate-home ./tcatch add-info written in the other store
+HOME=/tmp/tcatch-validate-home ./tcatch finish task1
+HOME=/tmp/tcatch-validate-home ./tcatch start mergedTask
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch merge /tmp/tcatch-validate-home
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch merge /tmp/tcatch-validate-home/.tc
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch fsck
+rm -rf /tmp/tcatch-validate-home
+
+echo "Archive two old tasks, delete one of them by name from the archive and check the store"
+printf 'task,state,timestamp\nlong gone,started,3000\nlong gone,finished,3600\nclient/old,started,3100\nclient/old,finished,3500\n' > /tmp/tcatch-validate.csv
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch import --csv /tmp/tcatch-validate.csv
+rm -f /tmp/tcatch-validate.csv
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch archive --finished-before 20000101
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch delete "long gone" --yes
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch fsck
+
+echo "Delete the finished tasks in bulk, the archived one included: list them, delete them without asking, then check the store"
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch delete --state finished --dry-run
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch delete --state finished --older-than $(( $(date +%s) + 1 )) --yes
+valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch fsck
+
 #echo "Delete a task"
 #This is commented out because I don't care to enter y or n while running this script. I HAVE tested the deletion though and it is leak free
 #valgrind --tool=memcheck --leak-check=yes --show-reachable=yes --num-callers=20 --track-fds=yes ./tcatch delete pauseTest
@@ -0,0 +1,48 @@
+#ifndef __TC_ACTIVE_H__
+	#define __TC_ACTIVE_H__
+
+	/* Active task table for multi-timer mode (start --multi)
+	 *
+	 * <tc home>/active is a header followed by TC_ACTIVE_SLOTS fixed size slots.
+	 * A task lives in the slot its hash points at, or the next free one after
+	 * it, so looking a running task up reads one or two slots instead of
+	 * replaying its .seq file. Slots carry everything view, pause and finish
+	 * need. A task leaves the table when it is paused, finished or deleted.
+	 * The table's own lock is a leaf: nothing else is locked while holding it.
+	*/
+	#include <stdint.h>
+	#include "tc-task.h"
+	#include "tc-directory.h"
+
+	#define TC_ACTIVE_FILE "active"
+	#define TC_ACTIVE_LOCK "active"
+	#define TC_ACTIVE_MAGIC "TCACTIVE"
+	#define TC_ACTIVE_SLOTS 64
+
+	#define TC_ACTIVE_EMPTY 0
+	#define TC_ACTIVE_USED 1
+	#define TC_ACTIVE_REMOVED 2
+
+	struct tc_active_header {
+		char magic[8];
+		uint32_t slotCount;
+		uint32_t slotSize;
+	};
+
+	struct tc_active_slot {
+		int32_t used;
+		int32_t seqNum;			/* Next sequence number to write */
+		int64_t startTime;		/* First start of the task */
+		int64_t lastStart;		/* Start of the running interval */
+		int64_t accumulated;	/* Time worked in closed intervals */
+		char taskHash[24];
+		char taskName[TC_MAX_BUFF+1];
+	};
+
+	int _tc_active_find(char const * tcHomeDirectory, char const * taskHash, struct tc_active_slot * slot);
+	int _tc_active_insert(char const * tcHomeDirectory, struct tc_active_slot * slot);
+	int _tc_active_remove(char const * tcHomeDirectory, char const * taskHash);
+	int _tc_active_list(char const * tcHomeDirectory, struct tc_active_slot slots[], int maxSlots);
+	int _tc_active_fill(char const * tcHomeDirectory, char const * taskName, struct tc_task * structToFill);
+
+#endif
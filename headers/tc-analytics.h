@@ -0,0 +1,37 @@
+#ifndef __TC_ANALYTICS_H__
+	#define __TC_ANALYTICS_H__
+
+	/* Kernels over interval columns (tcatch report)
+	 *
+	 * Intervals are kept as a structure of arrays, a start, an end and a
+	 * task id column, the layout tcatch export --columnar writes and
+	 * tc_columnar_open maps back. The clipping and range kernels are one
+	 * flat loop over those columns with no branches in the body, so the
+	 * compiler turns them into vector code. On x86-64 with gcc they are
+	 * also built for AVX2 and SSE4.2, and the loader picks the widest copy
+	 * the processor runs. Built anywhere else the same loops are the
+	 * scalar fallback.
+	 *
+	 * An interval counts for the part of it inside a window [from, to).
+	 * Group by sums walk the task ids in runs, and the intervals of a task
+	 * are next to each other when they come from a replay, so each run is
+	 * one vector reduction. Spreading over days or hours searches for the
+	 * first bucket of each interval and walks on from there.
+	 *
+	 * tc-analytics.c only depends on libc so analysis tools can compile it
+	 * in directly or link libtcanalytics.a
+	*/
+	#include <stddef.h>
+	#include <stdint.h>
+
+	/* Seconds of every interval that fall inside [from, to) */
+	int64_t tc_analytics_clipped(const int64_t * starts, const int64_t * ends, size_t count, int64_t from, int64_t to);
+	/* sums[keys[i]] gets the seconds of interval i inside [from, to) */
+	void tc_analytics_sum_by(const uint32_t * keys, const int64_t * starts, const int64_t * ends, size_t count, int64_t from, int64_t to, int64_t * sums);
+	/* Earliest start and latest end, count must not be 0 */
+	void tc_analytics_range(const int64_t * starts, const int64_t * ends, size_t count, int64_t * first, int64_t * last);
+	/* sums[b] gets the seconds of every interval inside [edges[b], edges[b+1]),
+	 * edges sorted and edgeCount - 1 buckets */
+	void tc_analytics_spread(const int64_t * starts, const int64_t * ends, size_t count, const int64_t * edges, size_t edgeCount, int64_t * sums);
+
+#endif
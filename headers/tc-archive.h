@@ -0,0 +1,59 @@
+#ifndef __TC_ARCHIVE_H__
+	#define __TC_ARCHIVE_H__
+
+	/* Archive of finished tasks
+	 *
+	 * tcatch archive moves finished tasks out of the tasks directory into
+	 * <tc home>/archive. One run at a time, under the archive run lock taken
+	 * before any task lock. Each run writes its own segment,
+	 * <YYYYMMDDHHMMSS>-<pid>.tca, holding every task it packed as its own zlib
+	 * stream: the task's .seq text followed by its .info text, so one task
+	 * is read back without touching the rest of the segment.
+	 *
+	 * <tc home>/archive/index has a line per archived task, in hash order so
+	 * a task is found with a binary search over the file:
+	 *	<hash> <segment> <offset> <packed size> <seq size> <info size> <finish time> <name>
+	 * It is only ever rewritten whole by _tc_archive_update, under the
+	 * archive lock. A task is in the index before its hot files are removed,
+	 * so it can always be found in one place or the other. Bringing an
+	 * archived task back (starting it, importing or merging into it) unpacks
+	 * it into the tasks directory and then drops its line, and deleting a
+	 * task drops its line too. While a task has both, its hot files win.
+	*/
+	#include <time.h>
+	#include "tc-task.h"
+	#include "tc-directory.h"
+
+	#define TC_ARCHIVE_DIR "archive"
+	#define TC_ARCHIVE_INDEX "index"
+	#define TC_ARCHIVE_EXT "tca"
+	#define TC_LOCK_ARCHIVE "archive"
+	#define TC_LOCK_ARCHIVE_RUN "archive-run"
+
+	struct tc_archive_entry {
+		char taskHash[48];
+		char taskName[TC_MAX_BUFF];
+		char segment[32];
+		long offset;
+		long packedSize;
+		long seqSize;
+		long infoSize;
+		time_t finishTime;
+	};
+
+	/* Called once per index line by _tc_archive_each */
+	typedef void (*tc_archive_callback)(struct tc_archive_entry * entry, void * data);
+	/* FALSE to leave an entry out of the index _tc_archive_update writes */
+	typedef int (*tc_archive_keep)(struct tc_archive_entry const * entry, void * data);
+
+	void tc_archive(int argc, char const *argv[]);
+	int _tc_archive_finished(char const * tcHomeDirectory, time_t finishedBefore);
+	int _tc_archive_each(char const * tcHomeDirectory, tc_archive_callback callback, void * data);
+	int _tc_archive_find(char const * tcHomeDirectory, char const * taskHash, struct tc_archive_entry * entry);
+	char * _tc_archive_unpack(char const * tcHomeDirectory, struct tc_archive_entry * entry);
+	int _tc_archive_fill(char const * tcHomeDirectory, struct tc_archive_entry * entry, struct tc_task * structToFill, char ** taskInfo);
+	int _tc_archive_update(char const * tcHomeDirectory, struct tc_archive_entry * added, size_t addedCount, tc_archive_keep keep, void * data);
+	int _tc_archive_drop(char const * tcHomeDirectory, char const * taskHash);
+	int _tc_archive_restore(char const * tcHomeDirectory, char const * taskHash);
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef __TC_COLUMNAR_H__
+	#define __TC_COLUMNAR_H__
+
+	/* Columnar interval file written by tcatch export --columnar
+	 *
+	 * The file is a header, a section directory and then one contiguous
+	 * 8 byte aligned array per section. All integers are in the byte order
+	 * of the machine that wrote the file (see byteOrder). Sections:
+	 *
+	 *	taskid	uint32_t per interval, index into the task sections
+	 *	start	int64_t per interval, epoch seconds the interval began
+	 *	end	int64_t per interval, epoch seconds the interval closed
+	 *	state	uint32_t per interval, state that closed it (8 if still running)
+	 *	nameoff	uint32_t per task, offset of the task name in names
+	 *	names	char, NUL terminated task names back to back
+	 *
+	 * tc-columnar.c only depends on libc so analysis tools can compile it in
+	 * directly or link libtccolumnar.a
+	*/
+	#include <stddef.h>
+	#include <stdint.h>
+
+	#define TC_COLUMNAR_MAGIC "TCCOLUMN"
+	#define TC_COLUMNAR_VERSION 1
+	#define TC_COLUMNAR_BYTE_ORDER 0x01020304
+	#define TC_COLUMNAR_ALIGN 8
+
+	#define TC_COLUMNAR_SEC_TASKID "taskid"
+	#define TC_COLUMNAR_SEC_START "start"
+	#define TC_COLUMNAR_SEC_END "end"
+	#define TC_COLUMNAR_SEC_STATE "state"
+	#define TC_COLUMNAR_SEC_NAMEOFF "nameoff"
+	#define TC_COLUMNAR_SEC_NAMES "names"
+	#define TC_COLUMNAR_SECTIONS 6
+
+	struct tc_columnar_header {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrder;
+		uint32_t sectionCount;
+		uint32_t reserved;
+		int64_t exportTime;
+	};
+
+	struct tc_columnar_section {
+		char name[8];
+		uint64_t offset;
+		uint64_t count;
+		uint32_t elemSize;
+		uint32_t reserved;
+	};
+
+	/* A mapped file, every pointer points into the mapping */
+	struct tc_columnar {
+		void * base;
+		size_t size;
+		int64_t exportTime;
+		uint64_t intervalCount;
+		uint64_t taskCount;
+		uint64_t namesSize;
+		const uint32_t * taskIds;
+		const int64_t * starts;
+		const int64_t * ends;
+		const uint32_t * states;
+		const uint32_t * nameOffsets;
+		const char * names;
+	};
+
+	int tc_columnar_open(const char * path, struct tc_columnar * columns);
+	const char * tc_columnar_taskName(const struct tc_columnar * columns, uint32_t taskId);
+	void tc_columnar_close(struct tc_columnar * columns);
+	size_t _tc_columnar_align(size_t offset);
+
+#endif
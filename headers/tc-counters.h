@@ -0,0 +1,56 @@
+#ifndef __TC_COUNTERS_H__
+	#define __TC_COUNTERS_H__
+
+	/* Store counters and the metrics textfile
+	 *
+	 * <tc home>/counters keeps everything a metrics scrape needs so that
+	 * nothing ever scans the store: how many tasks in the tasks directory
+	 * were last started, paused or finished, the bytes of their .seq and
+	 * .info files, and a histogram of recent command latencies. Writers add
+	 * to it as they go under the counters lock, which like the index lock is
+	 * a leaf, and every update rewrites the Prometheus textfile beside
+	 * itself with rename(). tcatch fsck --repair counts the tasks again.
+	 *
+	 * Latencies land in power of two buckets of microseconds. Once the
+	 * buckets hold TC_LATENCY_WINDOW commands they are all halved, so the
+	 * quantiles follow the recent invocations. A finishing command does not
+	 * take the lock for its latency, readers included: it appends one line
+	 * to <tc home>/latency with O_APPEND, and whoever next opens the
+	 * counters for writing (a writer, tcatch metrics) folds those lines into
+	 * the buckets.
+	*/
+	#include "timecatcher.h"
+	#include "tc-directory.h"
+
+	#define TC_COUNTERS_FILE "counters"
+	#define TC_LOCK_COUNTERS "counters"
+	#define TC_METRICS_FILE "metrics.prom"
+	#define TC_LATENCY_FILE "latency"
+	#define TC_LATENCY_BUCKETS 32
+	#define TC_LATENCY_WINDOW 1024
+
+	struct tc_counters {
+		char root[TC_MAX_BUFF];
+		char textfile[TC_MAX_BUFF];		/* "" for <tc home>/metrics.prom */
+		long started;
+		long paused;
+		long finished;
+		long bytes;
+		unsigned long commands;
+		unsigned long latency[TC_LATENCY_BUCKETS];
+		int lock;						/* -1 unless opened with _tc_counters_begin */
+	};
+
+	void _tc_counters_init(struct tc_counters * counters);
+	int _tc_counters_load(char const * tcHomeDirectory, struct tc_counters * counters);
+	int _tc_counters_begin(char const * tcHomeDirectory, struct tc_counters * counters);
+	int _tc_counters_commit(struct tc_counters * counters);
+	void _tc_counters_tally(struct tc_counters * counters, int priorState, int state, long bytes);
+	void _tc_counters_merge(struct tc_counters * counters, struct tc_counters * delta);
+	int _tc_counters_record(char const * tcHomeDirectory, int priorState, int state, long bytes);
+	int _tc_counters_sample(char const * tcHomeDirectory, long micros);
+	double _tc_counters_quantile(struct tc_counters * counters, double quantile);
+	void _tc_counters_textfile_path(struct tc_counters * counters, char * textfilePath);
+	int _tc_counters_textfile(struct tc_counters * counters, char * textfilePath);
+
+#endif
@@ -6,6 +6,8 @@
 	#define TC_INDEX_DIR "indexes"
 	#define TC_CURRENT_TASK "current"
 	#define TC_TASK_DIR "tasks"	
+	#define TC_SEQ_EXT "seq"
+	#define TC_INFO_EXT "info"
 
 	/* Prototypes */
 	const char * _tc_getHomePath();
@@ -13,5 +15,7 @@
 	int _tc_file_exists(const char * filename);
 	void _tc_getCurrentTaskPath(char * currentTaskPath);
 	void _tc_getTasksDir(char * tasksDir);
+	void _tc_getTaskFilePath(char * taskFilePath, char const * tcHomeDirectory, char const * taskHash, char const * extension);
+	int _tc_store_create(char const * tcHomeDirectory);
 
 #endif
\ No newline at end of file
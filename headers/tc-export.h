@@ -0,0 +1,39 @@
+#ifndef __TC_EXPORT_H__
+	#define __TC_EXPORT_H__
+
+	#include <stdint.h>
+	#include <time.h>
+	#include <stddef.h>
+
+	struct tc_store;
+
+	/* Growable column buffers filled while replaying every task of a store */
+	struct tc_export_columns {
+		uint32_t * taskIds;
+		int64_t * starts;
+		int64_t * ends;
+		uint32_t * states;
+		size_t intervalCount;
+		size_t intervalCapacity;
+		uint32_t * nameOffsets;
+		size_t taskCount;
+		size_t taskCapacity;
+		char * names;
+		size_t namesSize;
+		size_t namesCapacity;
+		time_t exportTime;
+		int failed;
+		/* Replay state of the task being collected */
+		struct tc_store * store;
+		uint32_t taskId;
+		int priorState;
+		time_t priorTime;
+	};
+
+	void tc_export(int argc, char const *argv[]);
+	void _tc_export_columnar(char * tcHomeDirectory, char const * exportPath);
+	void _tc_export_dump(char const * exportPath);
+	int _tc_export_collect(struct tc_store * store, struct tc_export_columns * columns);
+	int _tc_export_write(char const * exportPath, struct tc_export_columns * columns);
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef __TC_FSCK_H__
+	#define __TC_FSCK_H__
+
+	/* Store checks (tcatch fsck)
+	 *
+	 * The .seq files are the source of truth. Everything else, the .info
+	 * names, current, the active table, the index segments and their
+	 * manifest, the journal, the project totals, the store counters, the
+	 * session sketches of each day, is derived from them and can drift:
+	 * interrupted writes, hand edits, deletes that leave their index
+	 * entries and journal records behind.
+	 *
+	 * Tasks are split between one worker thread per core. Each replays its
+	 * tasks' sequences, checks them and the names in their info files, and
+	 * counts (or with --repair, keeps) the index entries the events imply
+	 * and the sessions they close. The derived files are then checked, and
+	 * repaired, on the main thread.
+	*/
+	#include <stdint.h>
+	#include <pthread.h>
+	#include "tc-task.h"
+	#include "tc-archive.h"
+	#include "tc-sketch.h"
+
+	#define TC_FSCK_THREADS_MAX 64
+	#define TC_FSCK_CHUNK 64
+
+	/* What can be wrong with one task */
+	#define TC_FSCK_SEQ_MISSING 1
+	#define TC_FSCK_SEQ_MALFORMED 2
+	#define TC_FSCK_SEQ_NUMBERS 4
+	#define TC_FSCK_SEQ_TIMES 8
+	#define TC_FSCK_SEQ_STATES 16
+	#define TC_FSCK_INFO_MISSING 32
+	#define TC_FSCK_INFO_NAME 64
+	#define TC_FSCK_ARCHIVE 128		/* The archive segment can't be read back */
+
+	struct tc_fsck_task {
+		char taskHash[48];
+		char taskName[TC_MAX_BUFF];
+		int hasSeq;
+		int hasInfo;
+		struct tc_archive_entry * archived;	/* NULL for tasks in the tasks directory */
+		int problems;
+		int repaired;
+		long records;
+		struct tc_task_summary summary;
+	};
+
+	/* One index entry implied by an event, kept when repairing */
+	struct tc_fsck_event {
+		uint32_t task;
+		int32_t state;
+		int32_t day;		/* YYYYMMDD, local time */
+		int32_t seqNum;
+		time_t eventTime;
+	};
+
+	/* Index entries per day, open addressed on the day */
+	struct tc_fsck_days {
+		int32_t * days;
+		long * counts;
+		size_t capacity;
+		size_t count;
+	};
+
+	struct tc_fsck;
+
+	struct tc_fsck_worker {
+		pthread_t thread;
+		struct tc_fsck * fsck;
+		struct tc_fsck_days days;
+		struct tc_sessions sessions;
+		struct tc_fsck_event * events;
+		size_t eventCount;
+		size_t eventCapacity;
+		char * buffer;
+		size_t bufferCapacity;
+		time_t dayFrom;			/* Every time in [dayFrom, dayTo] is on day */
+		time_t dayTo;
+		int32_t day;
+		int failed;
+	};
+
+	struct tc_fsck {
+		char root[TC_MAX_BUFF];
+		int repair;
+		struct tc_fsck_task * tasks;	/* Sorted by hash */
+		size_t taskCount;
+		size_t taskCapacity;
+		struct tc_archive_entry * archived;
+		size_t archivedCount;
+		size_t archivedCapacity;
+		pthread_mutex_t lock;
+		size_t next;			/* Next task a worker picks up, under lock */
+		unsigned long problems;
+		unsigned long repaired;
+	};
+
+	void tc_fsck(int argc, char const *argv[]);
+	int _tc_fsck_run(char const * tcHomeDirectory, int repair);
+	int _tc_fsck_transition(int from, int to);
+
+#endif
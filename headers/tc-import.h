@@ -0,0 +1,37 @@
+#ifndef __TC_IMPORT_H__
+	#define __TC_IMPORT_H__
+
+	#include <stdio.h>
+	#include <time.h>
+	#include "tc-project.h"
+	#include "tc-counters.h"
+	#include "tc-sketch.h"
+	#include "tc-store.h"
+
+	/* One parsed csv row, the strings point into the slurped file */
+	struct tc_import_row {
+		char * taskName;
+		char * note;
+		time_t seqTime;
+		int state;
+		int seqNum;				/* Set once the row is imported */
+		unsigned long line;
+		int imported;
+	};
+
+	struct tc_import_stats {
+		unsigned long events;
+		unsigned long tasks;
+		unsigned long skipped;
+		unsigned long failed;		/* Tasks that could not be written */
+		struct tc_projects projects;	/* What the imported intervals add to the rollups */
+		struct tc_counters counters;	/* ...and the tasks and bytes to the store counters */
+		struct tc_sessions sessions;	/* ...and the sessions they close to their days */
+	};
+
+	void tc_import(int argc, char const *argv[]);
+	void _tc_import_csv(char * tcHomeDirectory, char const * importPath);
+	int _tc_import_task(struct tc_store * store, struct tc_import_row * rows, size_t count, struct tc_import_stats * stats);
+	int _tc_import_state(char const * state);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef __TC_INDEX_H__
+	#define __TC_INDEX_H__
+
+	#include "tc-manifest.h"
+
+	void tc_index(int argc, char const *argv[]);
+	void _tc_index_list(struct tc_manifest * manifest, char const * fromDate, char const * toDate);
+
+#endif
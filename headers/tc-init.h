@@ -1,11 +1,18 @@
 #ifndef __TC_INIT_H__
 	#define __TC_INIT_H__
 
+	#include "timecatcher.h"
+
 	int main(int argc, char const * argv[]); 
 	const char * tc_init(char taskParentDirectory[]);
 	void _tc_display_usage(const char * command);
 	void _tc_help_check(int argc, char const *argv[]);
 	int _tc_args_flag_check(int argc, char const *argv[], char const * longFlag, char const * shortFlag);
+	int _tc_args_flag_index(int argc, char const *argv[], char const * longFlag, char const * shortFlag);
+	char const * _tc_args_flag_value(int argc, char const *argv[], char const * longFlag, char const * shortFlag);
+	struct tc_context * _tc_cli_context();
+	void _tc_cli_done(struct tc_context * context, int result);
+	void _tc_cli_task_name(int argc, char const *argv[], char * taskName);
 
 	#define TC_VIEW_COMMAND "view"
 	#define TC_HELP_LONG "--help"
@@ -16,12 +23,71 @@
 	#define TC_VERBOSE_SHORT "-v"
 	#define TC_VERBOSE_LONG "--verbose"
 	#define TC_ADD_INFO_COMMAND "add-info"
+	#define TC_STDIN_ARG "-"
 	#define TC_START_COMMAND "start"
 	#define TC_FINISH_COMMAND "finish"
 	#define TC_SWITCH_LONG "--switch"
 	#define TC_SWITCH_SHORT "-s"
 	#define TC_PAUSE_COMMAND "pause"
+	#define TC_MULTI_LONG "--multi"
+	#define TC_MULTI_SHORT "-m"
 	#define TC_DELETE_COMMAND "delete"
+	#define TC_EXPORT_COMMAND "export"
+	#define TC_COLUMNAR_LONG "--columnar"
+	#define TC_COLUMNAR_SHORT "-c"
+	#define TC_DUMP_LONG "--dump"
+	#define TC_DUMP_SHORT "-d"
+	#define TC_IMPORT_COMMAND "import"
+	#define TC_CSV_LONG "--csv"
+	#define TC_CSV_SHORT "-c"
+	#define TC_INDEX_COMMAND "index"
+	#define TC_MERGE_LONG "--merge"
+	#define TC_MERGE_SHORT "-m"
+	#define TC_REBUILD_LONG "--rebuild"
+	#define TC_REBUILD_SHORT "-r"
+	#define TC_ARCHIVE_COMMAND "archive"
+	#define TC_FINISHED_BEFORE_LONG "--finished-before"
+	#define TC_FINISHED_BEFORE_SHORT "-f"
+	#define TC_INCLUDE_ARCHIVED_LONG "--include-archived"
+	#define TC_INCLUDE_ARCHIVED_SHORT "-i"
+	#define TC_FSCK_COMMAND "fsck"
+	#define TC_REPAIR_LONG "--repair"
+	#define TC_REPAIR_SHORT "-r"
+	#define TC_PROJECT_LONG "--project"
+	#define TC_PROJECT_SHORT "-p"
+	#define TC_DEPTH_LONG "--depth"
+	#define TC_DEPTH_SHORT "-d"
+	#define TC_BETWEEN_LONG "--between"
+	#define TC_BETWEEN_SHORT "-b"
+	#define TC_METRICS_COMMAND "metrics"
+	#define TC_TEXTFILE_LONG "--textfile"
+	#define TC_TEXTFILE_SHORT "-t"
+	#define TC_MERGE_COMMAND "merge"
+	#define TC_LOG_COMMAND "log"
+	#define TC_TAIL_LONG "--tail"
+	#define TC_TAIL_SHORT "-n"
+	#define TC_SINCE_LONG "--since"
+	#define TC_SINCE_SHORT "-s"
+	#define TC_TIMELINE_COMMAND "timeline"
+	#define TC_DAY_LONG "--day"
+	#define TC_DAY_SHORT "-d"
+	#define TC_WEEK_LONG "--week"
+	#define TC_WEEK_SHORT "-w"
+	#define TC_STATE_LONG "--state"
+	#define TC_STATE_SHORT "-s"
+	#define TC_OLDER_THAN_LONG "--older-than"
+	#define TC_OLDER_THAN_SHORT "-o"
+	#define TC_YES_LONG "--yes"
+	#define TC_YES_SHORT "-y"
+	#define TC_DRY_RUN_LONG "--dry-run"
+	#define TC_DRY_RUN_SHORT "-n"
+	#define TC_STATS_COMMAND "stats"
+	#define TC_PROMPT_COMMAND "prompt"
+	#define TC_REPORT_COMMAND "report"
+	#define TC_BY_LONG "--by"
+	#define TC_BY_SHORT "-y"
+	#define TC_TOP_LONG "--top"
+	#define TC_TOP_SHORT "-t"
 	#ifndef TRUE
 		#define TRUE 1
 	#endif
@@ -0,0 +1,63 @@
+#ifndef __TC_INTERVAL_H__
+	#define __TC_INTERVAL_H__
+
+	/* Interval index for time worked inside a window
+	 *
+	 * tasks/<hash>.span holds a task's closed STARTED to PAUSED/FINISHED
+	 * intervals in time order, each with the seconds of every interval
+	 * before it. The time worked between two instants is then two binary
+	 * searches, a subtraction of prefix sums and clipping the intervals at
+	 * either edge, with the running interval (if any) added on top.
+	 *
+	 * The file is a cache of the .seq file. Its header remembers how many
+	 * bytes of the sequence it covers, and opening it first catches up on
+	 * whatever was appended since, replaced beside itself with rename() so
+	 * readers never lock. All integers are in the byte order of the machine
+	 * that wrote the file, a file from another machine is just rebuilt.
+	*/
+	#include <stddef.h>
+	#include <stdint.h>
+	#include <time.h>
+
+	#define TC_SPAN_EXT "span"
+	#define TC_SPAN_MAGIC "TCSPANS"
+	#define TC_SPAN_VERSION 1
+	#define TC_SPAN_BYTE_ORDER 0x01020304
+
+	struct tc_span_header {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrder;
+		int64_t seqBytes;		/* Bytes of the .seq file covered, whole lines only */
+		int64_t count;
+		int32_t state;			/* Last state seen, TC_TASK_NOT_FOUND before any */
+		int32_t reserved;
+		int64_t openStart;		/* Start of the running interval when state is STARTED */
+	};
+
+	struct tc_span {
+		int64_t start;
+		int64_t end;
+		int64_t before;			/* Seconds of every interval ahead of this one */
+	};
+
+	/* A task's intervals, in a mapped file or built in memory */
+	struct tc_spans {
+		struct tc_span * spans;
+		size_t count;
+		size_t capacity;		/* 0 while spans points into the mapping */
+		void * base;
+		size_t size;
+		int state;
+		time_t openStart;
+		int failed;				/* Ran out of memory building it */
+	};
+
+	void _tc_spans_reset(struct tc_spans * spans);
+	void _tc_spans_record(int seqNum, int seqState, time_t seqTime, void * data);
+	int _tc_spans_open(char const * tcHomeDirectory, char const * taskHash, struct tc_spans * spans);
+	void _tc_spans_from_text(char const * text, size_t length, struct tc_spans * spans);
+	time_t _tc_spans_between(struct tc_spans * spans, time_t from, time_t to, time_t now);
+	void _tc_spans_free(struct tc_spans * spans);
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef __TC_JOURNAL_H__
+	#define __TC_JOURNAL_H__
+
+	/* The event journal (tcatch log)
+	 *
+	 * <tc home>/journal gets one fixed size record per event, whatever task
+	 * it belongs to, in the order they were written: the time, the task's
+	 * hash, the state and its sequence number. The last N events are then
+	 * a single seek from the end.
+	 *
+	 * <tc home>/journal.marks holds one 64 bit time for every
+	 * TC_JOURNAL_STRIDE records, the latest event time from the start of the
+	 * journal up to the end of that stretch. Those only grow, so the first
+	 * record at or after a time is a binary search of the marks away, and
+	 * events written out of order (imports, merges) are still found by the
+	 * scan from there.
+	 *
+	 * Writers take the journal lock, which like the index lock is a leaf,
+	 * and only append, but for tcatch delete which slides the records it
+	 * keeps down over the ones it drops. Readers never lock and only use
+	 * whole records. Both
+	 * files are in the byte order of the machine that wrote them, and are
+	 * derived from the .seq files: tcatch fsck --repair rewrites them.
+	*/
+	#include <stdio.h>
+	#include <stdint.h>
+	#include <time.h>
+	#include "timecatcher.h"
+	#include "tc-directory.h"
+
+	#define TC_JOURNAL_FILE "journal"
+	#define TC_JOURNAL_MARKS "journal.marks"
+	#define TC_LOCK_JOURNAL "journal"
+	#define TC_JOURNAL_MAGIC "TCJRNL"
+	#define TC_JOURNAL_VERSION 1
+	#define TC_JOURNAL_BYTE_ORDER 0x01020304
+	#define TC_JOURNAL_STRIDE 256
+
+	struct tc_journal_header {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrder;
+	};
+
+	struct tc_journal_record {
+		int64_t eventTime;
+		int32_t state;
+		int32_t seqNum;
+		char taskHash[24];
+	};
+
+	struct tc_journal {
+		char root[TC_MAX_BUFF];
+		FILE * records;
+		FILE * marks;
+		int64_t count;			/* Whole records in the journal */
+		int64_t latest;			/* Latest event time among them */
+		int lock;				/* -1 unless opened with _tc_journal_begin */
+	};
+
+	/* Called once per record by the readers, in journal order */
+	typedef void (*tc_journal_callback)(struct tc_journal_record * record, void * data);
+	/* Called by _tc_journal_drop for each record, TRUE drops it */
+	typedef int (*tc_journal_filter)(struct tc_journal_record * record, void * data);
+
+	int _tc_journal_begin(char const * tcHomeDirectory, struct tc_journal * journal);
+	int _tc_journal_write(struct tc_journal * journal, time_t eventTime, char const * taskHash, int state, int seqNum);
+	int _tc_journal_reset(struct tc_journal * journal);
+	int _tc_journal_commit(struct tc_journal * journal);
+	long _tc_journal_drop(struct tc_journal * journal, tc_journal_filter drop, void * data);
+	int _tc_journal_append(char const * tcHomeDirectory, time_t eventTime, char const * taskHash, int state, int seqNum);
+	long _tc_journal_count(char const * tcHomeDirectory);
+	long _tc_journal_tail(char const * tcHomeDirectory, long count, tc_journal_callback callback, void * data);
+	long _tc_journal_since(char const * tcHomeDirectory, time_t since, tc_journal_callback callback, void * data);
+
+#endif
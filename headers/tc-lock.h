@@ -0,0 +1,46 @@
+#ifndef __TC_LOCK_H__
+	#define __TC_LOCK_H__
+
+	/* Advisory flock() locks kept in <tc home>/locks
+	 *
+	 * Every task has its own lock file named after its hash, and current has
+	 * one more. Writers take the locks of the tasks they touch first, sorted by
+	 * hash, and the current lock last, so two commands can never wait on each
+	 * other. Only the archive run lock (tc-archive.h) comes before them, and
+	 * only tcatch archive takes it. The index lock (tc-manifest.h), the journal lock
+	 * (tc-journal.h), the projects lock (tc-project.h), the counters lock
+	 * (tc-counters.h), the sessions lock (tc-sketch.h) and the archive lock
+	 * (tc-archive.h) come after all of them and are only held around their own writes. Readers never lock:
+	 * current is replaced with rename(), the prompt record is a seqlock (see
+	 * tc-prompt.h) and events are single appended lines, so a reader sees
+	 * either the old or new state.
+	 *
+	 * Deleting a task removes its lock file while holding it. A lock is only
+	 * taken once the file locked is still the one at the path, so whoever
+	 * waited on the removed file opens the path again.
+	 *
+	 * A lock is just the open descriptor, there is no bookkeeping in the
+	 * process. flock() locks belong to the open file, so taking a lock that is
+	 * already held through another descriptor blocks: a command takes all of
+	 * its locks once, up front, and the writes below it never lock.
+	*/
+	#define TC_LOCK_DIR "locks"
+	#define TC_LOCK_CURRENT "current"
+	#define TC_LOCK_RETRIES 16
+
+	/* The locks one command holds, released in reverse */
+	struct tc_lockset {
+		int handles[3];
+		int count;
+	};
+
+	int _tc_lock_acquire(char const * tcHomeDirectory, char const * lockName);
+	void _tc_lock_release(int lock);
+	void _tc_lock_remove(char const * tcHomeDirectory, char const * lockName);
+	int _tc_lock_task(char const * tcHomeDirectory, char const * taskName);
+	int _tc_lock_current(char const * tcHomeDirectory);
+	int _tc_lock_command(char const * tcHomeDirectory, char const * taskName, int withCurrentTask, char * currentTaskName, struct tc_lockset * locks);
+	void _tc_unlock_command(struct tc_lockset * locks);
+	void _tc_unlock_current(struct tc_lockset * locks);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef __TC_LOG_H__
+	#define __TC_LOG_H__
+
+	#include "tc-journal.h"
+
+	/* The records a log prints, gathered so they can be put in time order */
+	struct tc_log_line {
+		struct tc_journal_record record;
+		size_t position;		/* In the journal, for events of the same second */
+	};
+
+	struct tc_log_lines {
+		struct tc_log_line * lines;
+		size_t count;
+		size_t capacity;
+		int failed;
+	};
+
+	void tc_log(int argc, char const *argv[]);
+	int _tc_log_name(char const * tcHomeDirectory, char const * taskHash, char * taskName);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef __TC_MANIFEST_H__
+	#define __TC_MANIFEST_H__
+
+	/* Index segments and their manifest
+	 *
+	 * Every event also lands as "<hash> <name> <state>" in an index segment:
+	 * <YYYYMMDD>.index for the day it happened on, or <YYYYMM>.index once a
+	 * finished month has been merged. Segments are only created by their
+	 * first write.
+	 *
+	 * <tc home>/indexes/manifest lists every segment, one per line:
+	 *	<segment> <first date> <last date> <entries> <bytes>
+	 * sorted by segment, so readers pick segments by date without a readdir.
+	 * It is rewritten beside itself and renamed into place while holding the
+	 * index lock. That lock is always the last one a writer takes and it is
+	 * only held around index writes. A store without a manifest gets one
+	 * built from its directory the first time it is loaded.
+	*/
+	#include <stdio.h>
+	#include <stddef.h>
+	#include "timecatcher.h"
+	#include "tc-directory.h"
+
+	#define TC_INDEX_MANIFEST "manifest"
+	#define TC_INDEX_EXT "index"
+	#define TC_LOCK_INDEX "index"
+
+	struct tc_segment {
+		char name[16];		/* YYYYMMDD for a day, YYYYMM for a merged month */
+		char firstDate[16];
+		char lastDate[16];
+		long entries;
+		long bytes;
+	};
+
+	struct tc_manifest {
+		char root[TC_MAX_BUFF];
+		struct tc_segment * segments;
+		size_t count;
+		size_t capacity;
+		int lock;		/* -1 unless opened with _tc_manifest_begin */
+		int changed;
+		FILE * segmentFile;	/* The segment written last stays open */
+		char segmentOpen[16];
+	};
+
+	/* Called by _tc_manifest_select for each segment overlapping the dates */
+	typedef void (*tc_manifest_callback)(struct tc_manifest * manifest, struct tc_segment * segment, void * data);
+	/* Called by _tc_manifest_drop for each entry, TRUE drops it */
+	typedef int (*tc_manifest_filter)(char const * taskHash, void * data);
+
+	int _tc_manifest_load(char const * tcHomeDirectory, struct tc_manifest * manifest);
+	int _tc_manifest_rebuild(struct tc_manifest * manifest);
+	void _tc_manifest_free(struct tc_manifest * manifest);
+	int _tc_manifest_begin(char const * tcHomeDirectory, struct tc_manifest * manifest);
+	size_t _tc_manifest_route(struct tc_manifest * manifest, char const * date, int * found);
+	int _tc_manifest_write(struct tc_manifest * manifest, char const * date, char const * taskHash, char const * taskName, int state);
+	int _tc_manifest_commit(struct tc_manifest * manifest);
+	int _tc_manifest_append(char const * tcHomeDirectory, char const * date, char const * taskHash, char const * taskName, int state);
+	int _tc_manifest_select(struct tc_manifest * manifest, char const * fromDate, char const * toDate, tc_manifest_callback callback, void * data);
+	void _tc_manifest_segment_path(struct tc_manifest * manifest, struct tc_segment * segment, char * segmentPath);
+	int _tc_manifest_merge(struct tc_manifest * manifest, char const * beforeMonth);
+	int _tc_manifest_reset(struct tc_manifest * manifest);
+	void _tc_manifest_prune(struct tc_manifest * manifest);
+	int _tc_manifest_drop(struct tc_manifest * manifest, size_t position, tc_manifest_filter drop, void * data);
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef __TC_MERGE_H__
+	#define __TC_MERGE_H__
+
+	/* Merging other stores into this one (tcatch merge)
+	 *
+	 * Tasks are matched by hash and merged one at a time under their lock.
+	 * The .seq files of every store holding a task are read side by side as
+	 * a k-way merge on event time: an event found in several of them is
+	 * written once, and the result is numbered from 0 again and renamed
+	 * over the local sequence. Local events are always kept. An event from
+	 * another store is left out when it would make a state change tcatch
+	 * never makes, before or after it, such as two starts in a row from
+	 * histories that went their own ways. The .info lines missing locally are appended,
+	 * a line kept n times in another store being found n times here.
+	 *
+	 * Only the task being merged is ever in memory, and only the hashes of
+	 * its local info lines at that. Index entries and journal records for
+	 * the events that came in are spilled to a temporary file and written
+	 * once the task locks are released, the project totals, counters and
+	 * session sketches of each day as one delta each.
+	 * Archived tasks of the other stores are left where they are.
+	*/
+	#include <stdio.h>
+	#include <stdint.h>
+	#include <time.h>
+	#include "tc-project.h"
+	#include "tc-counters.h"
+	#include "tc-sketch.h"
+
+	#define TC_MERGE_STORES 16
+	#define TC_MERGE_EXT "merge"
+
+	/* One store's sequence of the task being merged */
+	struct tc_merge_stream {
+		FILE * fp;
+		int seqNum;
+		int state;
+		time_t eventTime;
+		int valid;				/* FALSE once the sequence is used up */
+	};
+
+	/* Local info lines by hash, how often each is there and how many of
+	 * them the store being merged matched */
+	struct tc_merge_lines {
+		uint64_t * keys;
+		long * counts;
+		long * used;
+		size_t capacity;
+		size_t count;
+	};
+
+	struct tc_merge_stats {
+		unsigned long tasks;
+		unsigned long created;
+		unsigned long events;
+		unsigned long skipped;
+		unsigned long conflicts;	/* Events left out, see above */
+		FILE * indexes;			/* "<date> <time> <hash> <state> <seq num> <name>" per event merged in */
+		struct tc_projects projects;
+		struct tc_counters counters;
+		struct tc_sessions sessions;
+		int sessionsLost;		/* Ran out of memory building the sessions delta */
+	};
+
+	void tc_merge(int argc, char const *argv[]);
+	int _tc_merge_stores(char const * tcHomeDirectory, char const * others[], int count);
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef __TC_METRICS_H__
+	#define __TC_METRICS_H__
+
+	void tc_metrics(int argc, char const *argv[]);
+
+#endif
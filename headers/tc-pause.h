@@ -3,4 +3,4 @@
 
 	void tc_pause(int argc, char const *argv[] );
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,54 @@
+#ifndef __TC_PROJECT_H__
+	#define __TC_PROJECT_H__
+
+	/* Project rollups
+	 *
+	 * A task named with slashes sits in a project hierarchy: client/feature/ticket
+	 * is a task under the projects client and client/feature. Every project
+	 * keeps how many tasks are below it and the time worked in their closed
+	 * intervals. Writers add to them as intervals close, so a project's total
+	 * is read without replaying any task. Running intervals are not included.
+	 *
+	 * <tc home>/projects has a line per project:
+	 *	<seconds> <tasks> <path>
+	 * ordered so each project's subtree follows it. It is replaced beside
+	 * itself under the projects lock which, like the index lock, is a leaf.
+	*/
+	#include "timecatcher.h"
+	#include "tc-directory.h"
+
+	#define TC_PROJECTS_FILE "projects"
+	#define TC_LOCK_PROJECTS "projects"
+	#define TC_PROJECT_SEPARATOR '/'
+
+	struct tc_project {
+		char path[TC_MAX_BUFF];
+		int depth;			/* 1 for a top level project */
+		long tasks;			/* Tasks anywhere below it */
+		long accumulated;	/* Seconds worked in their closed intervals */
+	};
+
+	struct tc_projects {
+		char root[TC_MAX_BUFF];		/* "" for a tree that only lives in memory */
+		struct tc_project * nodes;	/* A project's subtree follows it */
+		size_t count;
+		size_t capacity;
+		int lock;					/* -1 unless opened with _tc_projects_begin */
+		int changed;
+	};
+
+	/* Called by _tc_projects_select, depth is relative to the selected project */
+	typedef void (*tc_project_callback)(struct tc_project * project, int depth, void * data);
+
+	int _tc_projects_order(char const * left, char const * right);
+	void _tc_projects_init(struct tc_projects * projects);
+	int _tc_projects_load(char const * tcHomeDirectory, struct tc_projects * projects);
+	int _tc_projects_begin(char const * tcHomeDirectory, struct tc_projects * projects);
+	int _tc_projects_commit(struct tc_projects * projects);
+	void _tc_projects_free(struct tc_projects * projects);
+	int _tc_projects_add(struct tc_projects * projects, char const * taskName, long seconds, long tasks);
+	int _tc_projects_merge(struct tc_projects * projects, struct tc_projects * delta);
+	int _tc_projects_record(char const * tcHomeDirectory, char const * taskName, long seconds, long tasks);
+	int _tc_projects_select(struct tc_projects * projects, char const * path, int maxDepth, tc_project_callback callback, void * data);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef __TC_PROMPT_H__
+	#define __TC_PROMPT_H__
+
+	/* Status record for shell prompts (tcatch prompt)
+	 *
+	 * <tc home>/prompt is a single fixed layout record holding the current
+	 * task and how long it has been worked on. It is rewritten in place
+	 * whenever current changes, so a prompt or status bar reads it with one
+	 * read() and no parsing, and never replays a history or loads libcrypto.
+	 * tc-prompt.c only depends on libc so prompt tools can compile it in
+	 * directly or link libtcprompt.a.
+	 *
+	 * Writers are already serialized by the current lock. Readers take no
+	 * lock, the record is a seqlock instead: a writer bumps check, at the
+	 * end of the record, before it touches anything and sequence, at the
+	 * start, after it is done. A read is whole when the two agree, a read
+	 * that overlapped a write sees them differ and goes again.
+	 *
+	 * To keep the record in shared memory make <tc home>/prompt a symlink
+	 * to a file under /dev/shm, writers follow the link.
+	*/
+	#include <stdint.h>
+	#include <time.h>
+
+	#define TC_PROMPT_FILE "prompt"
+	#define TC_PROMPT_MAGIC "TCPROMPT"
+	#define TC_PROMPT_VERSION 1
+	#define TC_PROMPT_NAME 256			/* TC_MAX_BUFF and its terminator */
+	#define TC_PROMPT_RETRIES 64
+
+	struct tc_prompt {
+		uint32_t sequence;			/* Written last, read first */
+		uint32_t version;
+		char magic[8];
+		int32_t state;				/* TC_TASK_NOT_FOUND when nothing is current */
+		int32_t reserved;
+		int64_t startTime;			/* First start */
+		int64_t lastStart;			/* Start of the running interval */
+		int64_t accumulated;		/* Time worked in closed intervals */
+		char taskName[TC_PROMPT_NAME];
+		uint32_t check;				/* Written first, read last */
+		uint32_t padding;
+	};
+
+	/* 1 with a whole record in prompt, 0 when there is none or it is never
+	 * still long enough to read */
+	int tc_prompt_read(const char * path, struct tc_prompt * prompt);
+	/* Seconds worked at now, the running interval included */
+	int64_t tc_prompt_worked(const struct tc_prompt * prompt, time_t now);
+	/* taskName NULL when nothing is current */
+	int _tc_prompt_write(const char * path, const char * taskName, int state, time_t startTime, time_t lastStart, time_t accumulated);
+
+#endif
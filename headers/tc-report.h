@@ -0,0 +1,30 @@
+#ifndef __TC_REPORT_H__
+	#define __TC_REPORT_H__
+
+	/* Time worked per task, per day or per hour of the week (tcatch report)
+	 *
+	 * Every task is replayed once into interval columns, the same ones
+	 * tcatch export --columnar writes, and the totals are then sums over
+	 * those columns with the kernels in tc-analytics.h. Nothing is added up
+	 * task by task. A running timer counts up to now and archived tasks are
+	 * left out.
+	*/
+	#include <time.h>
+	#include "tc-export.h"
+
+	#define TC_REPORT_BY_TASK "task"
+	#define TC_REPORT_BY_DAY "day"
+	#define TC_REPORT_BY_HOUR "hour"
+
+	struct tc_report {
+		time_t from;
+		time_t to;
+		struct tc_export_columns columns;
+		int64_t * edges;		/* Bucket boundaries for days and hours */
+		size_t edgeCount;
+		int64_t * sums;
+	};
+
+	void tc_report(int argc, char const *argv[]);
+
+#endif
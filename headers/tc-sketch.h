@@ -0,0 +1,95 @@
+#ifndef __TC_SKETCH_H__
+	#define __TC_SKETCH_H__
+
+	/* Session length sketches
+	 *
+	 * A session is one closed STARTED to PAUSED/FINISHED interval. A sketch
+	 * counts sessions into log spaced buckets: a bucket per second below
+	 * 64 seconds, then 32 per power of two, so a quantile read back is within
+	 * about 1.6% of the true length. Only the buckets used are kept, and two
+	 * sketches merge by adding their counts, so tasks, projects and days add
+	 * up to the sketch of all of them.
+	 *
+	 * tasks/<hash>.sketch is a cache of the .seq file like the .span file:
+	 *	<seq bytes covered> <last state> <start of the running interval>
+	 *	<sessions> <seconds> <bucket>:<count> ...
+	 * Opening it first catches up on whatever was appended since.
+	 *
+	 * <tc home>/sessions/<YYYYMM> has a line per day of the month,
+	 *	<YYYYMMDD> <sessions> <seconds> <bucket>:<count> ...
+	 * with the sessions of every task that closed on that day, archived
+	 * and all. Writers add to it under the sessions lock which, like the
+	 * index lock, is a leaf. tcatch fsck --repair counts the days again.
+	*/
+	#include <stdio.h>
+	#include <stdint.h>
+	#include <time.h>
+	#include "timecatcher.h"
+	#include "tc-directory.h"
+
+	#define TC_SKETCH_EXT "sketch"
+	#define TC_SESSIONS_DIR "sessions"
+	#define TC_LOCK_SESSIONS "sessions"
+	#define TC_SKETCH_LINEAR 64			/* Lengths below this get a bucket each */
+	#define TC_SKETCH_SUBBUCKETS 32		/* Buckets per power of two above it */
+	#define TC_SKETCH_MAX 2147483647L	/* Longer sessions are counted as this long */
+
+	struct tc_sketch_bucket {
+		int bucket;
+		long count;
+	};
+
+	struct tc_sketch {
+		long sessions;
+		long seconds;					/* Exact, for the mean */
+		struct tc_sketch_bucket * buckets;	/* Sorted, no empty ones */
+		size_t count;
+		size_t capacity;
+		int failed;						/* Ran out of memory building it */
+	};
+
+	/* One day of closed sessions */
+	struct tc_sessions_day {
+		int32_t day;					/* YYYYMMDD, local time */
+		struct tc_sketch sketch;
+	};
+
+	struct tc_sessions {
+		struct tc_sessions_day * days;	/* Sorted by day */
+		size_t count;
+		size_t capacity;
+	};
+
+	/* Pairs a task's events into sessions for _tc_sketch_record */
+	struct tc_sketch_replay {
+		struct tc_sketch * sketch;		/* NULL to leave out */
+		struct tc_sessions * days;		/* NULL to leave out */
+		long weight;					/* 1 to add the sessions, -1 to take them out */
+		int state;
+		time_t openStart;
+		int failed;
+	};
+
+	void _tc_sketch_init(struct tc_sketch * sketch);
+	void _tc_sketch_free(struct tc_sketch * sketch);
+	int _tc_sketch_add(struct tc_sketch * sketch, long seconds, long weight);
+	int _tc_sketch_merge(struct tc_sketch * into, struct tc_sketch const * from, long weight);
+	int _tc_sketch_equal(struct tc_sketch const * left, struct tc_sketch const * right);
+	long _tc_sketch_quantile(struct tc_sketch const * sketch, double quantile);
+	void _tc_sketch_replay_init(struct tc_sketch_replay * replay, struct tc_sketch * sketch, struct tc_sessions * days, long weight);
+	void _tc_sketch_record(int seqNum, int seqState, time_t seqTime, void * data);
+	int _tc_sketch_open(char const * tcHomeDirectory, char const * taskHash, struct tc_sketch * sketch);
+	int _tc_sketch_from_text(char const * text, size_t length, struct tc_sketch * sketch);
+
+	void _tc_sessions_init(struct tc_sessions * sessions);
+	void _tc_sessions_free(struct tc_sessions * sessions);
+	int32_t _tc_sessions_day(time_t closedAt);
+	int _tc_sessions_add(struct tc_sessions * sessions, int32_t day, long seconds, long weight);
+	int _tc_sessions_merge(struct tc_sessions * into, struct tc_sessions const * from, long weight);
+	int _tc_sessions_load(char const * tcHomeDirectory, int32_t fromDay, int32_t toDay, struct tc_sessions * sessions);
+	int _tc_sessions_total(struct tc_sessions const * sessions, int32_t fromDay, int32_t toDay, struct tc_sketch * total);
+	int _tc_sessions_commit(char const * tcHomeDirectory, struct tc_sessions * delta);
+	int _tc_sessions_replace(char const * tcHomeDirectory, struct tc_sessions * sessions);
+	int _tc_sessions_record(char const * tcHomeDirectory, time_t closedAt, long seconds);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef __TC_STATS_H__
+	#define __TC_STATS_H__
+
+	/* Session length percentiles (tcatch stats)
+	 *
+	 * Nothing is replayed to answer. The whole store, or a window of days,
+	 * is the day sketches under <tc home>/sessions merged together. A task
+	 * is its own .sketch file caught up with its sequence, and a project
+	 * the sketches of the tasks below it merged. Archived tasks are in the
+	 * days they closed on, and in a task or project only when asked for,
+	 * as their sketches come from unpacking them. See tc-sketch.h.
+	*/
+	#include "tc-sketch.h"
+	#include "tc-store.h"
+
+	/* A project's tasks being merged into one sketch */
+	struct tc_stats_project {
+		char root[TC_MAX_BUFF];
+		char const * path;
+		size_t length;
+		struct tc_sketch * sketch;
+		long tasks;
+		int failed;
+	};
+
+	void tc_stats(int argc, char const *argv[]);
+	void _tc_stats_print(struct tc_sketch const * sketch);
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef __TC_STORE_H__
+	#define __TC_STORE_H__
+
+	/* Storage backends
+	 *
+	 * Everything a command reads or writes about tasks goes through the
+	 * tc_store_ops table of the store it opened, so commands never build
+	 * paths themselves. The directory backend is the ~/.tc layout from the
+	 * readme. The memory backend keeps the same data in the process, for
+	 * benchmarks and tests that want to leave the disk out of it.
+	 *
+	 * Calls return TC_OK or a TC_ERR code from timecatcher.h unless noted.
+	 * Writers call lock first and unlock when done, see tc-lock.h.
+	*/
+	#include <time.h>
+	#include "timecatcher.h"
+	#include "tc-task.h"
+	#include "tc-lock.h"
+	#include "tc-active.h"
+	#include "tc-project.h"
+	#include "tc-counters.h"
+	#include "tc-sketch.h"
+	#include "tc-interval.h"
+
+	#define TC_STREAM_BLOCK 65536
+
+	struct tc_store;
+
+	/* Called once per task by list */
+	typedef void (*tc_store_task_callback)(const char * taskHash, const char * taskName, void * data);
+
+	/* One event for append_events, with the note that follows it onto the
+	 * task's information or NULL */
+	struct tc_store_event {
+		int seqNum;
+		int state;
+		time_t eventTime;
+		const char * note;
+	};
+
+	struct tc_store_ops {
+		const char * name;
+		/* TC_ERR_NOT_FOUND for a task that was never written, unless create is set */
+		int (*task_open)(struct tc_store * store, const char * taskHash, const char * taskName, int create);
+		int (*task_name)(struct tc_store * store, const char * taskHash, char * taskName);
+		int (*append)(struct tc_store * store, const char * taskHash, const char * taskName, int seqNum, int state, time_t eventTime);
+		/* Replays a task's events in order, returns how many there were */
+		int (*history)(struct tc_store * store, const char * taskHash, tc_seq_callback callback, void * data);
+		/* Replays only the last event, returns 1, or 0 when there is none */
+		int (*last)(struct tc_store * store, const char * taskHash, tc_seq_callback callback, void * data);
+		/* A task's intervals (see tc-interval.h), archived tasks' included.
+		 * The caller frees them with _tc_spans_free */
+		int (*spans)(struct tc_store * store, const char * taskHash, struct tc_spans * spans);
+		/* Appends events and their notes, all of them or none, creating the
+		 * task as taskName if it has no history. Unlike append nothing is
+		 * indexed or journalled, a caller appending many batches that.
+		 * bytes gets what was added */
+		int (*append_events)(struct tc_store * store, const char * taskHash, const char * taskName, const struct tc_store_event * events, size_t count, long * bytes);
+		/* The task's history and then its information, as the text the
+		 * directory backend keeps them in, in one buffer the caller frees.
+		 * seqSize and infoSize get the length of each */
+		int (*serialize)(struct tc_store * store, const char * taskHash, char ** text, size_t * seqSize, size_t * infoSize);
+		int (*add_info)(struct tc_store * store, const char * taskHash, const char * text);
+		/* Copies fd to its end onto the task's information in TC_STREAM_BLOCK
+		 * blocks, ending it with a newline. bytes gets what was added, even on
+		 * a failure part way */
+		int (*add_info_stream)(struct tc_store * store, const char * taskHash, int fd, long * bytes);
+		/* Returns how many tasks were listed */
+		int (*list)(struct tc_store * store, tc_store_task_callback callback, void * data);
+		/* "" and TC_ERR_NO_CURRENT when nothing is current */
+		int (*current_get)(struct tc_store * store, char * taskName);
+		/* summary is where the task stands after its last event */
+		int (*current_set)(struct tc_store * store, const char * taskName, const char * taskHash, const struct tc_task_summary * summary);
+		/* The current task and where it stands, from the record in current
+		 * while it is in step and from a replay otherwise. TC_ERR_NO_CURRENT
+		 * when nothing is current */
+		int (*current_summary)(struct tc_store * store, char * taskName, char * taskHash, struct tc_task_summary * summary);
+		int (*current_clear)(struct tc_store * store);
+		int (*remove)(struct tc_store * store, const char * taskHash);
+		/* Brings back a task that was archived, so its history goes on.
+		 * TC_ERR_NOT_FOUND when there is nothing archived under taskHash.
+		 * The caller holds the task's lock */
+		int (*restore)(struct tc_store * store, const char * taskHash);
+		/* Adds closed interval time and new (or, negative, deleted) tasks to
+		 * the projects above taskName, see tc-project.h */
+		int (*rollup)(struct tc_store * store, const char * taskName, long seconds, long tasks);
+		/* A task went from priorState to state and its files grew by bytes,
+		 * for the store counters, see tc-counters.h. remove tallies itself */
+		int (*tally)(struct tc_store * store, int priorState, int state, long bytes);
+		/* A task's running interval closed at closedAt after seconds, for the
+		 * session sketches, see tc-sketch.h. Called after the event is appended */
+		int (*session)(struct tc_store * store, const char * taskHash, long seconds, time_t closedAt);
+		int (*lock)(struct tc_store * store, const char * taskName, int withCurrentTask, char * currentTaskName, struct tc_lockset * locks);
+		void (*unlock)(struct tc_store * store, struct tc_lockset * locks);
+		/* The multi-timer table, see tc-active.h */
+		int (*active_find)(struct tc_store * store, const char * taskHash, struct tc_active_slot * slot);
+		int (*active_insert)(struct tc_store * store, struct tc_active_slot * slot);
+		int (*active_remove)(struct tc_store * store, const char * taskHash);
+		void (*close)(struct tc_store * store);
+	};
+
+	struct tc_store {
+		const struct tc_store_ops * ops;
+		char root[TC_MAX_BUFF];		/* "" for stores that are not on disk */
+		void * data;
+	};
+
+	int _tc_store_open_directory(struct tc_store ** store, const char * tcHomeDirectory);
+	int _tc_store_open_memory(struct tc_store ** store);
+	void _tc_store_close(struct tc_store * store);
+	int _tc_store_summarize(struct tc_store * store, const char * taskHash, struct tc_task_summary * summary);
+
+#endif
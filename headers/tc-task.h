@@ -1,19 +1,16 @@
 #ifndef __TC_TASK_H__
 	#define __TC_TASK_H__
-	#define TC_TASK_NOT_FOUND 2
-	#define TC_TASK_FOUND 4
-	#define TC_TASK_STARTED 8
-	#define TC_TASK_FINISHED 16
-	#define TC_TASK_PAUSED 32
-	
-
-	
+	#include "timecatcher.h"
+	#include "tc-directory.h"
+
 	#include <time.h>
 	#include <openssl/sha.h>
 	#include <stdio.h>
 	#include <string.h>
 	#include <stdlib.h>
 
+	#define TC_SEQ_TAIL 128		/* Bytes read back for the last record, a few of them */
+
 	struct tc_task {
 		time_t startTime;
 		time_t pauseTime;
@@ -25,13 +22,49 @@
 
 	};
 
-	void _tc_task_read(char const * taskName, struct tc_task * structToFill);
-	void _tc_task_write(struct tc_task structToWrite, char taskParentDirectory[]);
-	void _find_current_task(struct tc_task * taskStruct);
+	/* Where a task stands after replaying its .seq file */
+	struct tc_task_summary {
+		int state;				/* Last state, TC_TASK_NOT_FOUND without records */
+		int seqNum;				/* Next sequence number */
+		time_t startTime;		/* First start */
+		time_t lastStart;		/* Start of the latest running interval */
+		time_t lastTime;		/* Time of the last event */
+		time_t accumulated;		/* Time worked in closed intervals */
+	};
+
+	/* current holds the current task and where it stood after its last
+	 * event, so the current task's status is one small read:
+	 *	<task name>
+	 *	<task hash>
+	 *	<sequence number> <state> <time> of the last event
+	 *	<first start> <latest start> <time worked> <.seq size> <.seq mtime>
+	 * The last line is only trusted while the .seq file still has that size
+	 * and modification time. Anything else that writes the sequence, an
+	 * import, a merge, a hand edit, leaves it stale and readers replay. */
+	struct tc_current {
+		char taskName[TC_MAX_BUFF];
+		char taskHash[TC_MAX_BUFF];
+		struct tc_task_summary summary;
+	};
+
+	/* Called once per record of a .seq file, in file order */
+	typedef void (*tc_seq_callback)(int seqNum, int seqState, time_t seqTime, void * data);
+
+	int _tc_task_replay(char const * taskSequencePath, struct tc_task * structToFill);
+	void _tc_task_replay_text(const char * text, size_t length, struct tc_task * structToFill);
+	void _tc_task_summary_init(struct tc_task_summary * summary);
+	void _tc_task_summary_record(int seqNum, int seqState, time_t seqTime, void * data);
+	void _tc_current_task_name(char const * tcHomeDirectory, char * currentTaskName);
+	int _tc_current_read(char const * tcHomeDirectory, struct tc_current * current);
 	char * _tc_stateToString(int state);
 	void _tc_taskName_to_Hash(char * taskName, char  * fileHashName);
-	void _resolve_taskName_from_args(int argc, char const *argv[],char * taskName);
+	char * _tc_args_join(int argc, char const *argv[]);
+	int _resolve_taskName_from_args(int argc, char const *argv[],char * taskName);
 	char *trim(char *str);
+	int _tc_seq_foreach(char const * taskSequencePath, tc_seq_callback callback, void * data);
+	int _tc_seq_parse(const char * text, size_t length, tc_seq_callback callback, void * data);
+	int _tc_seq_last(char const * taskSequencePath, tc_seq_callback callback, void * data);
+	int _tc_task_name_from_info(char const * taskInfoPath, char * taskName);
 
 	#ifndef TRUE
 		#define TRUE 1
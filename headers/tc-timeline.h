@@ -0,0 +1,64 @@
+#ifndef __TC_TIMELINE_H__
+	#define __TC_TIMELINE_H__
+
+	/* Gantt chart of a day or a week (tcatch timeline)
+	 *
+	 * The events come from the journal, read from the start of the window
+	 * on, with a start added for every timer still running from before it.
+	 * Sorted by task and time they pair up into intervals, one pass over
+	 * all of them, and no .seq file is read. The intervals sorted by start
+	 * give the rows, in the order work began on them. Their ends, sorted
+	 * with them, are then swept once from left to right: how many tasks run
+	 * between each pair of neighbouring ends gives the busy, idle and
+	 * overlapping time, and the most running at once in every column.
+	*/
+	#include <time.h>
+	#include "tc-journal.h"
+
+	#define TC_TIMELINE_LABEL 16
+	#define TC_TIMELINE_TOTAL 8
+	#define TC_TIMELINE_COLUMNS 80
+	#define TC_TIMELINE_MIN_WIDTH 12
+
+	struct tc_timeline_interval {
+		size_t row;
+		time_t start;
+		time_t end;
+	};
+
+	struct tc_timeline_row {
+		char taskHash[24];
+		char taskName[TC_MAX_BUFF];
+		time_t first;			/* Start of its first interval in the window */
+		time_t worked;
+	};
+
+	/* One side of an interval, for the sweep */
+	struct tc_timeline_edge {
+		time_t when;
+		int change;				/* +1 for a start, -1 for an end */
+	};
+
+	struct tc_timeline {
+		time_t from;
+		time_t to;
+		time_t now;
+		int width;				/* Columns of the chart */
+		int byDay;				/* Ticks on days, for a week */
+		struct tc_journal_record * records;
+		size_t recordCount;
+		size_t recordCapacity;
+		struct tc_timeline_interval * intervals;
+		size_t intervalCount;
+		size_t intervalCapacity;
+		struct tc_timeline_row * rows;
+		size_t rowCount;
+		int failed;
+	};
+
+	void tc_timeline(int argc, char const *argv[]);
+	int _tc_timeline_build(char const * tcHomeDirectory, struct tc_timeline * timeline);
+	void _tc_timeline_render(struct tc_timeline * timeline);
+	void _tc_timeline_free(struct tc_timeline * timeline);
+
+#endif
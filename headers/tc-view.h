@@ -4,13 +4,45 @@
 	#include <stdlib.h>
 	#include <stdio.h>
 	#include "tc-task.h"
+	#include "tc-store.h"
+
+	#define TC_VIEW_TOP_TIME "time"
+	#define TC_VIEW_TOP_UPDATED "updated"
+	#define TC_VIEW_TOP_SESSIONS "sessions"
+
+	/* One task kept by view --top, named once it is known to be kept */
+	struct tc_view_top_entry {
+		long value;
+		char taskHash[48];
+	};
+
+	/* The K tasks with the highest values so far, as a min heap so the one
+	 * to drop when a higher value comes along is always at the root */
+	struct tc_view_top {
+		struct tc_store * store;
+		char const * by;
+		time_t now;
+		struct tc_view_top_entry * heap;
+		size_t count;
+		size_t capacity;		/* K */
+	};
 
 	void tc_view(int argc, char const *argv[]);
+	void tc_prompt(int argc, char const *argv[]);
 
 	/*These are 'private' methods called by the subroutine of tc_view */
 	void _tc_displayView(struct tc_task working_task,int verbose,int finishFlag);
 	void _tc_view_no_args(struct tc_task working_task);
 	void _tc_view_with_args(struct tc_task working_task, int verboseFlag, int argc, char const *argv[], char * taskName);
+	void _tc_view_active(struct tc_task working_task, int verboseFlag);
+	int _tc_view_archived(char const * tcHomeDirectory, char const * taskName, struct tc_task working_task, int verboseFlag);
+	void _tc_view_between(char const * tcHomeDirectory, int argc, char const *argv[]);
+	int _tc_view_when(char const * text, int endOfWindow, time_t * when);
+	void _tc_view_top(char const * tcHomeDirectory, int argc, char const *argv[]);
+	void _tc_view_projects(char const * tcHomeDirectory, char const * path, char const * depth);
+	void _tc_view_archived_all(char const * tcHomeDirectory, struct tc_task working_task, int verboseFlag);
 	int _getAllTasks(struct tc_task allTasks[]);
+	void _tc_task_read(char const * taskName, struct tc_task * structToFill);
 	void _tc_task_read_byHashPath(char const * taskHash, struct tc_task * structToFill);
+	void _find_current_task(struct tc_task * taskStruct);
 #endif
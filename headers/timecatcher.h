@@ -0,0 +1,88 @@
+#ifndef __TIMECATCHER_H__
+	#define __TIMECATCHER_H__
+
+	/* libtimecatcher, the event recording side of tcatch as a library
+	 *
+	 * Everything goes through a context opened on a store, the .tc directory
+	 * or an in-memory one. The context carries the clock events are stamped
+	 * with and where messages go, so nothing prints or exits on its own.
+	 * Every call returns TC_OK or one of the TC_ERR codes below.
+	 *
+	 * The library keeps no state outside the context. Stores are shared with
+	 * other processes (and the tcatch binary) through the same flock() locks,
+	 * so separate contexts may be used from separate threads. One context
+	 * must not be used by two threads at once.
+	*/
+	#include <time.h>
+
+	/* Task states, as stored in .seq files */
+	#define TC_TASK_NOT_FOUND 2
+	#define TC_TASK_FOUND 4
+	#define TC_TASK_STARTED 8
+	#define TC_TASK_FINISHED 16
+	#define TC_TASK_PAUSED 32
+
+	#define TC_OK 0
+	#define TC_ERR_IO -1			/* A store file could not be read or written */
+	#define TC_ERR_NOMEM -2
+	#define TC_ERR_ARGS -3			/* Missing or too long task name or text */
+	#define TC_ERR_TIME -4			/* The clock failed */
+	#define TC_ERR_NOT_FOUND -5		/* No such task */
+	#define TC_ERR_NO_CURRENT -6	/* The call needs a current task and there is none */
+	#define TC_ERR_BUSY -7			/* Another task is current, switch instead */
+	#define TC_ERR_ALREADY -8		/* The task is already running */
+	#define TC_ERR_FINISHED -9		/* The task is already finished */
+	#define TC_ERR_FULL -10			/* Every multi-timer slot is taken */
+
+	/* tc_lib_start flags */
+	#define TC_START_SWITCH 1		/* Pause the current task first */
+	#define TC_START_MULTI 2		/* Run beside every other timer */
+
+	/* Where a context keeps its tasks */
+	#define TC_BACKEND_DIRECTORY 0	/* The .tc directory tcatch uses */
+	#define TC_BACKEND_MEMORY 1		/* In the process only, gone on close */
+
+	#define TC_OUTPUT_INFO 0
+	#define TC_OUTPUT_ERROR 1
+
+	typedef time_t (*tc_clock_fn)(void * clockData);
+	typedef void (*tc_output_fn)(int level, const char * message, void * outputData);
+
+	struct tc_options {
+		const char * storeRoot;		/* NULL for $HOME/.tc */
+		int backend;				/* TC_BACKEND_DIRECTORY unless asked otherwise */
+		tc_clock_fn clock;			/* NULL for time() */
+		void * clockData;
+		tc_output_fn output;		/* NULL to stay quiet */
+		void * outputData;
+	};
+
+	/* What a task looks like right now */
+	struct tc_status {
+		char taskName[256];
+		char taskHash[24];
+		int state;
+		int seqNum;					/* Next sequence number */
+		time_t startTime;			/* First start */
+		time_t lastUpdate;			/* Time of the last event */
+		time_t worked;				/* Seconds worked, the running interval included */
+	};
+
+	struct tc_context;
+
+	int tc_lib_open(struct tc_context ** context, const struct tc_options * options);
+	void tc_lib_close(struct tc_context * context);
+	const char * tc_lib_root(const struct tc_context * context);
+	time_t tc_lib_now(struct tc_context * context);
+
+	int tc_lib_start(struct tc_context * context, const char * taskName, int flags);
+	int tc_lib_pause(struct tc_context * context, const char * taskName);
+	int tc_lib_finish(struct tc_context * context, const char * taskName, struct tc_status * finished);
+	int tc_lib_add_info(struct tc_context * context, const char * text);
+	/* Reads fd to its end, in constant memory */
+	int tc_lib_add_info_fd(struct tc_context * context, int fd);
+	int tc_lib_status(struct tc_context * context, const char * taskName, struct tc_status * status);
+
+	const char * tc_lib_strerror(int code);
+
+#endif
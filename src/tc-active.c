@@ -0,0 +1,189 @@
+#define _XOPEN_SOURCE 500
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "tc-active.h"
+#include "tc-lock.h"
+
+static int _tc_active_open(char const * tcHomeDirectory, int create){
+	/* Open the table, laying out an empty one the first time it is written to */
+	char activePath[TC_MAX_BUFF];
+	struct tc_active_header header;
+	struct stat fileStat;
+	int fd;
+
+	sprintf(activePath,"%s/%s",tcHomeDirectory,TC_ACTIVE_FILE);
+	fd = open(activePath, create ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+	if(fd == -1)
+		return -1;
+
+	if(fstat(fd,&fileStat) == -1){
+		close(fd);
+		return -1;
+	}
+	if(fileStat.st_size == 0 && create){
+		memset(&header,0,sizeof(header));
+		memcpy(header.magic,TC_ACTIVE_MAGIC,sizeof(header.magic));
+		header.slotCount = TC_ACTIVE_SLOTS;
+		header.slotSize = sizeof(struct tc_active_slot);
+		if(pwrite(fd,&header,sizeof(header),0) != sizeof(header)
+			|| ftruncate(fd,sizeof(header) + TC_ACTIVE_SLOTS*sizeof(struct tc_active_slot)) == -1){
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	if(pread(fd,&header,sizeof(header),0) != sizeof(header)
+		|| memcmp(header.magic,TC_ACTIVE_MAGIC,sizeof(header.magic)) != 0
+		|| header.slotCount != TC_ACTIVE_SLOTS
+		|| header.slotSize != sizeof(struct tc_active_slot)){
+		/* Not a table this build can read, treat it like a missing one */
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static int _tc_active_home(char const * taskHash){
+	/* The first 8 hex digits of the hash pick the slot */
+	unsigned long home;
+	int i;
+
+	home = 0;
+	for(i = 0; i < 8 && taskHash[i] != '\0'; ++i)
+		home = home*16 + (taskHash[i] <= '9' ? taskHash[i] - '0' : (taskHash[i] | 0x20) - 'a' + 10);
+	return home % TC_ACTIVE_SLOTS;
+}
+
+static int _tc_active_read(int fd, int index, struct tc_active_slot * slot){
+	off_t offset = sizeof(struct tc_active_header) + (off_t)index*sizeof(*slot);
+	return pread(fd,slot,sizeof(*slot),offset) == sizeof(*slot);
+}
+
+static int _tc_active_write(int fd, int index, struct tc_active_slot * slot){
+	off_t offset = sizeof(struct tc_active_header) + (off_t)index*sizeof(*slot);
+	return pwrite(fd,slot,sizeof(*slot),offset) == sizeof(*slot);
+}
+
+static int _tc_active_probe(int fd, char const * taskHash, struct tc_active_slot * slot, int * freeIndex){
+	/* Walk from the task's home slot until it or an empty slot turns up.
+	 * Returns the task's index or -1, and the first reusable slot in freeIndex.
+	*/
+	int home, i, index;
+
+	home = _tc_active_home(taskHash);
+	if(freeIndex != NULL)
+		*freeIndex = -1;
+	for(i = 0; i < TC_ACTIVE_SLOTS; ++i){
+		index = (home + i) % TC_ACTIVE_SLOTS;
+		if(!_tc_active_read(fd,index,slot))
+			return -1;
+		if(slot->used == TC_ACTIVE_USED && strncmp(slot->taskHash,taskHash,sizeof(slot->taskHash)) == 0)
+			return index;
+		if(slot->used != TC_ACTIVE_USED && freeIndex != NULL && *freeIndex == -1)
+			*freeIndex = index;
+		if(slot->used == TC_ACTIVE_EMPTY)
+			return -1;
+	}
+	return -1;
+}
+
+int _tc_active_find(char const * tcHomeDirectory, char const * taskHash, struct tc_active_slot * slot){
+	/* TRUE and the slot filled in if the task is running in the table */
+	int fd, index;
+
+	fd = _tc_active_open(tcHomeDirectory,FALSE);
+	if(fd == -1)
+		return FALSE;
+	index = _tc_active_probe(fd,taskHash,slot,NULL);
+	close(fd);
+	return index != -1;
+}
+
+int _tc_active_insert(char const * tcHomeDirectory, struct tc_active_slot * slot){
+	/* TC_OK, TC_ERR_FULL when every slot is taken or TC_ERR_IO */
+	struct tc_active_slot probed;
+	int fd, index, freeIndex, lock, success;
+
+	lock = _tc_lock_acquire(tcHomeDirectory,TC_ACTIVE_LOCK);
+	fd = _tc_active_open(tcHomeDirectory,TRUE);
+	if(fd == -1){
+		_tc_lock_release(lock);
+		return TC_ERR_IO;
+	}
+
+	index = _tc_active_probe(fd,slot->taskHash,&probed,&freeIndex);
+	if(index == -1)
+		index = freeIndex;
+	if(index == -1){
+		success = TC_ERR_FULL;
+	}else{
+		slot->used = TC_ACTIVE_USED;
+		success = _tc_active_write(fd,index,slot) ? TC_OK : TC_ERR_IO;
+	}
+
+	close(fd);
+	_tc_lock_release(lock);
+	return success;
+}
+
+int _tc_active_remove(char const * tcHomeDirectory, char const * taskHash){
+	struct tc_active_slot slot;
+	int fd, index, lock;
+
+	/* Nothing to do for stores that never ran in multi-timer mode */
+	fd = _tc_active_open(tcHomeDirectory,FALSE);
+	if(fd == -1)
+		return FALSE;
+	close(fd);
+
+	lock = _tc_lock_acquire(tcHomeDirectory,TC_ACTIVE_LOCK);
+	fd = _tc_active_open(tcHomeDirectory,TRUE);
+	index = fd == -1 ? -1 : _tc_active_probe(fd,taskHash,&slot,NULL);
+	if(index != -1){
+		slot.used = TC_ACTIVE_REMOVED;
+		_tc_active_write(fd,index,&slot);
+	}
+	if(fd != -1)
+		close(fd);
+	_tc_lock_release(lock);
+	return index != -1;
+}
+
+int _tc_active_list(char const * tcHomeDirectory, struct tc_active_slot slots[], int maxSlots){
+	/* Copy every running task into slots, returns how many there were */
+	struct tc_active_slot slot;
+	int fd, i, count;
+
+	fd = _tc_active_open(tcHomeDirectory,FALSE);
+	if(fd == -1)
+		return 0;
+	count = 0;
+	for(i = 0; i < TC_ACTIVE_SLOTS && count < maxSlots; ++i)
+		if(_tc_active_read(fd,i,&slot) && slot.used == TC_ACTIVE_USED)
+			slots[count++] = slot;
+	close(fd);
+	return count;
+}
+
+int _tc_active_fill(char const * tcHomeDirectory, char const * taskName, struct tc_task * structToFill){
+	/* Fill a task the way _tc_task_read would, straight from its slot */
+	struct tc_active_slot slot;
+	char taskHash[TC_MAX_BUFF];
+
+	_tc_taskName_to_Hash((char *)taskName,taskHash);
+	if(!_tc_active_find(tcHomeDirectory,taskHash,&slot))
+		return FALSE;
+
+	strcpy(structToFill->taskName,slot.taskName);
+	structToFill->startTime = slot.startTime;
+	structToFill->endTime = slot.lastStart;
+	structToFill->pauseTime = slot.accumulated;
+	structToFill->seqNum = slot.seqNum;
+	structToFill->state = TC_TASK_STARTED;
+	_tc_getTaskFilePath(structToFill->taskInfo,tcHomeDirectory,taskHash,TC_INFO_EXT);
+	return TRUE;
+}
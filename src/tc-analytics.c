@@ -0,0 +1,94 @@
+#include "tc-analytics.h"
+
+/* AVX2 and SSE4.2 copies of each kernel next to the default one, chosen
+ * at load time. Plain SSE2 has no 64 bit compare to select with */
+#if defined(__x86_64__) && defined(__GNUC__) && __GNUC__ >= 6
+	#define TC_ANALYTICS_KERNEL __attribute__((target_clones("avx2","sse4.2","default")))
+#else
+	#define TC_ANALYTICS_KERNEL
+#endif
+
+TC_ANALYTICS_KERNEL
+int64_t tc_analytics_clipped(const int64_t * starts, const int64_t * ends, size_t count, int64_t from, int64_t to){
+	/* Selects rather than branches, an interval outside the window adds 0 */
+	int64_t total, start, end;
+	size_t i;
+
+	total = 0;
+	for(i = 0; i < count; ++i){
+		start = starts[i] > from ? starts[i] : from;
+		end = ends[i] < to ? ends[i] : to;
+		total += end > start ? end - start : 0;
+	}
+	return total;
+}
+
+void tc_analytics_sum_by(const uint32_t * keys, const int64_t * starts, const int64_t * ends, size_t count, int64_t from, int64_t to, int64_t * sums){
+	/* Any order works, runs of one key just make it cheap */
+	size_t i, run;
+
+	for(i = 0; i < count; i = run){
+		for(run = i + 1; run < count && keys[run] == keys[i]; ++run)
+			;
+		sums[keys[i]] += tc_analytics_clipped(starts + i, ends + i, run - i, from, to);
+	}
+}
+
+TC_ANALYTICS_KERNEL
+void tc_analytics_range(const int64_t * starts, const int64_t * ends, size_t count, int64_t * first, int64_t * last){
+	int64_t earliest, latest;
+	size_t i;
+
+	earliest = starts[0];
+	latest = ends[0];
+	for(i = 0; i < count; ++i){
+		earliest = starts[i] < earliest ? starts[i] : earliest;
+		latest = ends[i] > latest ? ends[i] : latest;
+	}
+	*first = earliest;
+	*last = latest;
+}
+
+static size_t _tc_analytics_bucket(const int64_t * edges, size_t edgeCount, int64_t when){
+	/* The last edge at or before when, 0 when there is none */
+	size_t low, high, middle;
+
+	low = 0;
+	high = edgeCount;
+	while(high - low > 1){
+		middle = low + (high - low)/2;
+		if(edges[middle] <= when)
+			low = middle;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+void tc_analytics_spread(const int64_t * starts, const int64_t * ends, size_t count, const int64_t * edges, size_t edgeCount, int64_t * sums){
+	/* Most intervals fit in one bucket or two, so once the first is found
+	 * the walk forward is short. A task's intervals come in order, so the
+	 * next one mostly starts where the last did or in the bucket after */
+	int64_t start, end;
+	size_t i, bucket, first;
+
+	if(edgeCount < 2)
+		return;
+	first = 0;
+	for(i = 0; i < count; ++i){
+		if(ends[i] <= edges[0] || starts[i] >= edges[edgeCount-1])
+			continue;
+		if(starts[i] < edges[first] || starts[i] >= edges[first+1]){
+			if(first + 2 < edgeCount && edges[first+1] <= starts[i] && starts[i] < edges[first+2])
+				++first;
+			else
+				first = _tc_analytics_bucket(edges,edgeCount,starts[i]);
+		}
+		for(bucket = first; bucket + 1 < edgeCount && edges[bucket] < ends[i]; ++bucket){
+			start = starts[i] > edges[bucket] ? starts[i] : edges[bucket];
+			end = ends[i] < edges[bucket+1] ? ends[i] : edges[bucket+1];
+			if(end > start)
+				sums[bucket] += end - start;
+		}
+	}
+}
@@ -0,0 +1,293 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "tc-archive.h"
+#include "tc-lock.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+/* Reading the archive back and keeping its index, the half of it
+ * libtimecatcher.a links so an archived task can be started again.
+ * Packing lives in tc-archive.c */
+
+static int _tc_archive_parse(char const * line, struct tc_archive_entry * entry){
+	/* One index line into entry, FALSE if it isn't one */
+	long finishTime;
+	int nameAt;
+
+	nameAt = 0;
+	if(sscanf(line,"%47s %31s %ld %ld %ld %ld %ld %n",entry->taskHash,entry->segment,&entry->offset,
+		&entry->packedSize,&entry->seqSize,&entry->infoSize,&finishTime,&nameAt) != 7 || nameAt == 0)
+		return FALSE;
+	strncpy(entry->taskName,line + nameAt,TC_MAX_BUFF-1);
+	entry->taskName[TC_MAX_BUFF-1] = '\0';
+	entry->taskName[strcspn(entry->taskName,"\n")] = '\0';
+	entry->finishTime = (time_t)finishTime;
+	return TRUE;
+}
+
+int _tc_archive_each(char const * tcHomeDirectory, tc_archive_callback callback, void * data){
+	/* Hand every index line to callback in hash order. Returns how many there were */
+	struct tc_archive_entry entry;
+	char indexPath[TC_MAX_BUFF*2+16];
+	char line[TC_MAX_BUFF*2];
+	int count;
+	FILE * fp;
+
+	sprintf(indexPath,"%s/%s/%s",tcHomeDirectory,TC_ARCHIVE_DIR,TC_ARCHIVE_INDEX);
+	fp = fopen(indexPath,"r");
+	if(!fp)
+		return 0;
+
+	count = 0;
+	while(fgets(line,sizeof(line),fp) != NULL){
+		if(_tc_archive_parse(line,&entry) == FALSE)
+			continue;
+		callback(&entry,data);
+		++count;
+	}
+	fclose(fp);
+	return count;
+}
+
+static long _tc_archive_line_at(FILE * fp, long at, char * line, size_t size, long * next){
+	/* Read the first whole line starting at or after at. Returns where it
+	 * starts, with next just past it, or -1 when there is none */
+	long start;
+	int c;
+
+	if(fseek(fp,at > 0 ? at - 1 : 0,SEEK_SET) != 0)
+		return -1;
+	/* The byte before at ends a line, or at is inside one to skip */
+	if(at > 0)
+		while((c = getc(fp)) != EOF && c != '\n')
+			;
+	if((start = ftell(fp)) < 0 || fgets(line,size,fp) == NULL)
+		return -1;
+	*next = ftell(fp);
+	return start;
+}
+
+int _tc_archive_find(char const * tcHomeDirectory, char const * taskHash, struct tc_archive_entry * entry){
+	/* TRUE with entry filled when the task is archived. The index is kept
+	 * in hash order, so this halves the bytes left to search each step:
+	 * low is always the start of a line and every line before it has a
+	 * smaller hash, every line starting at high or after it is not smaller.
+	*/
+	char indexPath[TC_MAX_BUFF*2+16];
+	char line[TC_MAX_BUFF*2];
+	long low, middle, high, start, next;
+	int found;
+	FILE * fp;
+
+	sprintf(indexPath,"%s/%s/%s",tcHomeDirectory,TC_ARCHIVE_DIR,TC_ARCHIVE_INDEX);
+	fp = fopen(indexPath,"r");
+	if(!fp)
+		return FALSE;
+	low = 0;
+	high = fseek(fp,0,SEEK_END) == 0 ? ftell(fp) : -1;
+	while(low < high){
+		middle = low + (high - low)/2;
+		start = _tc_archive_line_at(fp,middle,line,sizeof(line),&next);
+		if(start < 0 || start >= high)
+			high = middle;
+		else if(_tc_archive_parse(line,entry) == TRUE && strcmp(entry->taskHash,taskHash) < 0)
+			low = next;
+		else
+			high = start;
+	}
+
+	found = high >= 0 && _tc_archive_line_at(fp,low,line,sizeof(line),&next) == low
+		&& _tc_archive_parse(line,entry) == TRUE && strcmp(entry->taskHash,taskHash) == 0;
+	fclose(fp);
+	return found;
+}
+
+static int _tc_archive_entry_compare(const void * left, const void * right){
+	return strcmp(((const struct tc_archive_entry *)left)->taskHash,((const struct tc_archive_entry *)right)->taskHash);
+}
+
+static int _tc_archive_print(FILE * fp, struct tc_archive_entry const * entry, tc_archive_keep keep, void * data){
+	/* One index line, unless keep turns the entry down */
+	if(keep != NULL && keep(entry,data) == FALSE)
+		return TRUE;
+	return fprintf(fp, "%s %s %ld %ld %ld %ld %ld %s\n", entry->taskHash, entry->segment, entry->offset,
+		entry->packedSize, entry->seqSize, entry->infoSize, (long)entry->finishTime, entry->taskName) > 0;
+}
+
+int _tc_archive_update(char const * tcHomeDirectory, struct tc_archive_entry * added, size_t addedCount, tc_archive_keep keep, void * data){
+	/* Merge added (sorted here by hash) into the index, replacing the lines
+	 * of the same tasks, and leave out every entry keep turns down. One pass
+	 * over the old index into a temporary file renamed over it, so readers
+	 * see the old index or the new one. The archive lock is a leaf, taken
+	 * after any task lock and holding nothing else.
+	*/
+	struct tc_archive_entry entry;
+	char indexPath[TC_MAX_BUFF*2+16];
+	char indexTempPath[TC_MAX_BUFF*2+24];
+	char line[TC_MAX_BUFF*2];
+	FILE * in, * out;
+	size_t i;
+	int lock, have, order, written;
+
+	if(addedCount > 1)
+		qsort(added,addedCount,sizeof(*added),_tc_archive_entry_compare);
+	sprintf(indexPath,"%s/%s/%s",tcHomeDirectory,TC_ARCHIVE_DIR,TC_ARCHIVE_INDEX);
+	sprintf(indexTempPath,"%s.tmp",indexPath);
+	/* Nothing to drop from an archive that was never written */
+	if(addedCount == 0 && _tc_file_exists(indexPath) == FALSE)
+		return TC_OK;
+	if((lock = _tc_lock_acquire(tcHomeDirectory,TC_LOCK_ARCHIVE)) == -1)
+		return TC_ERR_IO;
+	if((out = fopen(indexTempPath,"w")) == NULL){
+		_tc_lock_release(lock);
+		return TC_ERR_IO;
+	}
+
+	in = fopen(indexPath,"r");
+	have = FALSE;
+	written = TRUE;
+	i = 0;
+	while(written){
+		while(have == FALSE && in != NULL && fgets(line,sizeof(line),in) != NULL)
+			have = _tc_archive_parse(line,&entry);
+		if(have == FALSE && i == addedCount)
+			break;
+		order = have == FALSE ? 1 : i == addedCount ? -1 : strcmp(entry.taskHash,added[i].taskHash);
+		if(order < 0)
+			written = _tc_archive_print(out,&entry,keep,data);
+		else
+			written = _tc_archive_print(out,added + i++,keep,data);
+		/* An added line takes the place of the old one */
+		if(order <= 0)
+			have = FALSE;
+	}
+	if(in != NULL && ferror(in))
+		written = FALSE;
+	if(in != NULL)
+		fclose(in);
+	if(fclose(out) != 0 || written == FALSE || rename(indexTempPath,indexPath) != 0){
+		remove(indexTempPath);
+		_tc_lock_release(lock);
+		return TC_ERR_IO;
+	}
+	_tc_lock_release(lock);
+	return TC_OK;
+}
+
+char * _tc_archive_unpack(char const * tcHomeDirectory, struct tc_archive_entry * entry){
+	/* The task's .seq text followed by its .info text, NUL terminated.
+	 * NULL if the segment can't be read. The caller frees it.
+	*/
+	char segmentPath[TC_MAX_BUFF*2+48];
+	unsigned char * packed;
+	char * raw;
+	uLongf rawSize;
+	FILE * fp;
+	int result;
+
+	if(entry->offset < 0 || entry->packedSize <= 0 || entry->seqSize < 0 || entry->infoSize < 0)
+		return NULL;
+	sprintf(segmentPath,"%s/%s/%s.%s",tcHomeDirectory,TC_ARCHIVE_DIR,entry->segment,TC_ARCHIVE_EXT);
+	fp = fopen(segmentPath,"rb");
+	if(!fp)
+		return NULL;
+	packed = malloc(entry->packedSize);
+	raw = malloc(entry->seqSize + entry->infoSize + 1);
+	result = packed && raw && fseek(fp,entry->offset,SEEK_SET) == 0
+		&& fread(packed,1,entry->packedSize,fp) == (size_t)entry->packedSize;
+	fclose(fp);
+
+	rawSize = entry->seqSize + entry->infoSize;
+	if(result)
+		result = uncompress((unsigned char *)raw,&rawSize,packed,entry->packedSize) == Z_OK
+			&& rawSize == (uLongf)(entry->seqSize + entry->infoSize);
+	free(packed);
+	if(!result){
+		free(raw);
+		return NULL;
+	}
+	raw[rawSize] = '\0';
+	return raw;
+}
+
+int _tc_archive_fill(char const * tcHomeDirectory, struct tc_archive_entry * entry, struct tc_task * structToFill, char ** taskInfo){
+	/* Replay an archived task into structToFill. taskInfo, when given, gets
+	 * the task's info text to free afterwards. FALSE if it can't be read.
+	*/
+	char * raw;
+
+	if((raw = _tc_archive_unpack(tcHomeDirectory,entry)) == NULL)
+		return FALSE;
+	strcpy(structToFill->taskName,entry->taskName);
+	_tc_task_replay_text(raw,entry->seqSize,structToFill);
+
+	if(taskInfo == NULL){
+		free(raw);
+		return TRUE;
+	}
+	memmove(raw,raw + entry->seqSize,entry->infoSize + 1);
+	*taskInfo = raw;
+	return TRUE;
+}
+
+static int _tc_archive_write(char const * path, const char * text, size_t size){
+	/* The whole of text into path, through a temporary file renamed over it */
+	char tempPath[TC_MAX_BUFF+8];
+	FILE * fp;
+	int written;
+
+	sprintf(tempPath,"%s.tmp",path);
+	if((fp = fopen(tempPath,"wb")) == NULL)
+		return FALSE;
+	written = fwrite(text,1,size,fp) == size;
+	if(fclose(fp) != 0 || written == FALSE || rename(tempPath,path) != 0){
+		remove(tempPath);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static int _tc_archive_other(struct tc_archive_entry const * entry, void * data){
+	return strcmp(entry->taskHash,(char const *)data) != 0;
+}
+
+int _tc_archive_drop(char const * tcHomeDirectory, char const * taskHash){
+	/* Take taskHash's line out of the index, its segment bytes are left */
+	return _tc_archive_update(tcHomeDirectory,NULL,0,_tc_archive_other,(void *)taskHash);
+}
+
+int _tc_archive_restore(char const * tcHomeDirectory, char const * taskHash){
+	/* Put an archived task's .seq and .info back in the tasks directory, the
+	 * .info first as the .seq is what makes it a task again, and then drop
+	 * its index line so the archived copy can't outlive it. Until the line
+	 * is gone the files in the tasks directory win over it. TC_ERR_NOT_FOUND
+	 * when it is not in the archive either. The caller holds the task's lock.
+	*/
+	struct tc_archive_entry entry;
+	char taskSequencePath[TC_MAX_BUFF];
+	char taskInfoPath[TC_MAX_BUFF];
+	char * raw;
+	int result;
+
+	if(_tc_archive_find(tcHomeDirectory,taskHash,&entry) == FALSE)
+		return TC_ERR_NOT_FOUND;
+	if((raw = _tc_archive_unpack(tcHomeDirectory,&entry)) == NULL)
+		return TC_ERR_IO;
+	_tc_getTaskFilePath(taskSequencePath,tcHomeDirectory,taskHash,TC_SEQ_EXT);
+	_tc_getTaskFilePath(taskInfoPath,tcHomeDirectory,taskHash,TC_INFO_EXT);
+	result = TC_OK;
+	if(_tc_archive_write(taskInfoPath,raw + entry.seqSize,entry.infoSize) == FALSE)
+		result = TC_ERR_IO;
+	else if(_tc_archive_write(taskSequencePath,raw,entry.seqSize) == FALSE){
+		remove(taskInfoPath);
+		result = TC_ERR_IO;
+	}else if((result = _tc_archive_drop(tcHomeDirectory,taskHash)) != TC_OK){
+		/* Still archived then, and nowhere else */
+		remove(taskSequencePath);
+		remove(taskInfoPath);
+	}
+	free(raw);
+	return result;
+}
@@ -0,0 +1,259 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "tc-archive.h"
+#include "tc-store.h"
+#include "tc-init.h"
+#include "tc-lock.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+void tc_archive(int argc, char const *argv[]){
+	char tcHomeDirectory[TC_MAX_BUFF];
+	char date[TC_MAX_BUFF];
+	struct tm cutoff;
+	time_t finishedBefore;
+	int i, archived;
+
+	/* Usage has already been shown by the help check */
+	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
+		return;
+
+	tc_init(tcHomeDirectory);
+	_tc_cli_task_name(argc,argv,date);
+
+	for(i = 0; isdigit((unsigned char)date[i]); ++i)
+		;
+	if(i != 8 || date[i] != '\0' || _tc_args_flag_check(argc,argv,TC_FINISHED_BEFORE_LONG,TC_FINISHED_BEFORE_SHORT) == FALSE){
+		_tc_display_usage(TC_ARCHIVE_COMMAND);
+		return;
+	}
+
+	/* Tasks finished before local midnight starting that day */
+	memset(&cutoff,0,sizeof(cutoff));
+	sscanf(date,"%4d%2d%2d",&cutoff.tm_year,&cutoff.tm_mon,&cutoff.tm_mday);
+	cutoff.tm_year -= 1900;
+	cutoff.tm_mon -= 1;
+	cutoff.tm_isdst = -1;
+	if((finishedBefore = mktime(&cutoff)) == -1){
+		fprintf(stderr, "%s\n", "Could not determine time.");
+		return;
+	}
+
+	archived = _tc_archive_finished(tcHomeDirectory,finishedBefore);
+	if(archived < 0)
+		fprintf(stderr, "%s\n", "Could not write the archive. Please check permissions");
+	else
+		fprintf(stdout, "Archived %i finished tasks\n", archived);
+}
+
+/* A finished task found while listing the store */
+struct tc_archive_candidate {
+	char taskHash[48];
+	char taskName[TC_MAX_BUFF];
+	struct tc_task_summary summary;		/* Where it stood when it was packed */
+	int packed;
+};
+
+struct tc_archive_run {
+	struct tc_store * store;
+	time_t finishedBefore;
+	struct tc_archive_candidate * candidates;
+	size_t count;
+	size_t capacity;
+	int failed;
+	FILE * segmentFile;
+	char segment[32];
+};
+
+static int _tc_archive_due(struct tc_archive_run * run, char const * taskHash, struct tc_task_summary * summary){
+	return _tc_store_summarize(run->store,taskHash,summary) == TC_TASK_FINISHED && summary->lastTime < run->finishedBefore;
+}
+
+static void _tc_archive_consider(const char * taskHash, const char * taskName, void * data){
+	struct tc_archive_run * run = data;
+	struct tc_archive_candidate * grown;
+	struct tc_task_summary summary;
+
+	if(run->failed || strlen(taskHash) >= sizeof(grown->taskHash) || _tc_archive_due(run,taskHash,&summary) == FALSE)
+		return;
+	if(run->count == run->capacity){
+		grown = realloc(run->candidates,(run->capacity ? run->capacity*2 : 64)*sizeof(*grown));
+		if(grown == NULL){
+			run->failed = TRUE;
+			return;
+		}
+		run->candidates = grown;
+		run->capacity = run->capacity ? run->capacity*2 : 64;
+	}
+	memset(run->candidates + run->count,0,sizeof(*grown));
+	strcpy(run->candidates[run->count].taskHash,taskHash);
+	strcpy(run->candidates[run->count].taskName,taskName);
+	++run->count;
+}
+
+static int _tc_archive_pack(struct tc_store * store, struct tc_archive_candidate * candidate, FILE * segmentFile, struct tc_archive_entry * entry){
+	/* Compress one task onto the end of the segment, filling in its index entry */
+	char * raw;
+	unsigned char * packed;
+	size_t seqSize, infoSize;
+	uLongf packedSize;
+	long offset;
+	int result;
+
+	if(store->ops->serialize(store,candidate->taskHash,&raw,&seqSize,&infoSize) != TC_OK)
+		return FALSE;
+	packedSize = compressBound(seqSize + infoSize);
+	if((packed = malloc(packedSize)) == NULL){
+		free(raw);
+		return FALSE;
+	}
+
+	result = FALSE;
+	if(compress2(packed,&packedSize,(unsigned char *)raw,seqSize + infoSize,Z_BEST_COMPRESSION) == Z_OK
+		&& fseek(segmentFile,0,SEEK_END) == 0 && (offset = ftell(segmentFile)) >= 0
+		&& fwrite(packed,1,packedSize,segmentFile) == packedSize && fflush(segmentFile) == 0){
+		strcpy(entry->taskHash,candidate->taskHash);
+		strcpy(entry->taskName,candidate->taskName);
+		entry->offset = offset;
+		entry->packedSize = (long)packedSize;
+		entry->seqSize = (long)seqSize;
+		entry->infoSize = (long)infoSize;
+		entry->finishTime = candidate->summary.lastTime;
+		result = TRUE;
+	}
+	free(raw);
+	free(packed);
+	return result;
+}
+
+static int _tc_archive_packed(struct tc_archive_run * run, struct tc_archive_candidate * candidate, struct tc_archive_entry * entry){
+	/* Pack one candidate under its lock, looking again first: it may have
+	 * been started since it was listed. FALSE on a failure, a task that is
+	 * no longer due is just left */
+	char currentTaskName[TC_MAX_BUFF];
+	int lock, result;
+
+	if((lock = _tc_lock_acquire(run->store->root,candidate->taskHash)) == -1)
+		return FALSE;
+	run->store->ops->current_get(run->store,currentTaskName);
+	result = TRUE;
+	if(_tc_archive_due(run,candidate->taskHash,&candidate->summary) && strcmp(currentTaskName,candidate->taskName) != 0){
+		strcpy(entry->segment,run->segment);
+		candidate->packed = result = _tc_archive_pack(run->store,candidate,run->segmentFile,entry);
+	}
+	_tc_lock_release(lock);
+	return result;
+}
+
+static int _tc_archive_unchanged(struct tc_archive_run * run, struct tc_archive_candidate * candidate){
+	/* Still finished with no event since it was packed */
+	struct tc_task_summary summary;
+
+	return _tc_archive_due(run,candidate->taskHash,&summary) && summary.seqNum == candidate->summary.seqNum
+		&& summary.lastTime == candidate->summary.lastTime;
+}
+
+static int _tc_archive_left(struct tc_archive_entry const * entry, void * data){
+	/* Drop the lines this run wrote for tasks it could not take out */
+	struct tc_archive_run * run = data;
+	size_t i;
+
+	if(strcmp(entry->segment,run->segment) != 0)
+		return TRUE;
+	for(i = 0; i < run->count; ++i)
+		if(run->candidates[i].packed == FALSE && strcmp(run->candidates[i].taskHash,entry->taskHash) == 0)
+			return FALSE;
+	return TRUE;
+}
+
+int _tc_archive_finished(char const * tcHomeDirectory, time_t finishedBefore){
+	/* Archive every task finished before finishedBefore. Each task is packed
+	 * into this run's segment under its own lock, then every packed task is
+	 * indexed at once, and only then is each removed from the tasks
+	 * directory, under its lock again and only if nothing happened to it in
+	 * between. Returns how many were archived, -1 on failure.
+	*/
+	struct tc_archive_run run;
+	struct tc_archive_entry * entries;
+	char archivePath[TC_MAX_BUFF*2];
+	char segmentPath[TC_MAX_BUFF*2+48];
+	time_t now;
+	size_t i, packedCount;
+	int runLock, lock, archived, left, indexed;
+
+	/* Two runs packing the same task would each index it, and the one that
+	 * finds it already gone would drop the other's line */
+	if((runLock = _tc_lock_acquire(tcHomeDirectory,TC_LOCK_ARCHIVE_RUN)) == -1)
+		return -1;
+	memset(&run,0,sizeof(run));
+	run.finishedBefore = finishedBefore;
+	if(_tc_store_open_directory(&run.store,tcHomeDirectory) != TC_OK){
+		_tc_lock_release(runLock);
+		return -1;
+	}
+	run.store->ops->list(run.store,_tc_archive_consider,&run);
+	entries = run.count > 0 ? malloc(run.count*sizeof(*entries)) : NULL;
+	sprintf(archivePath,"%s/%s",tcHomeDirectory,TC_ARCHIVE_DIR);
+	if(run.failed || run.count == 0 || entries == NULL
+		|| (_tc_directoryExists(archivePath) == 0 && mkdir(archivePath,TC_DIR_PERM) == -1)){
+		_tc_store_close(run.store);
+		_tc_lock_release(runLock);
+		free(run.candidates);
+		free(entries);
+		return run.failed || run.count > 0 ? -1 : 0;
+	}
+
+	/* One segment per run, named after when and by whom it was written so
+	 * two runs never share one */
+	now = time(0);
+	strftime(run.segment,sizeof(run.segment),"%Y%m%d%H%M%S",localtime(&now));
+	sprintf(run.segment + strlen(run.segment),"-%ld",(long)getpid());
+	sprintf(segmentPath,"%s/%s.%s",archivePath,run.segment,TC_ARCHIVE_EXT);
+	run.segmentFile = fopen(segmentPath,"ab");
+
+	packedCount = 0;
+	archived = run.segmentFile ? 0 : -1;
+	for(i = 0; i < run.count && archived >= 0; ++i)
+		if(_tc_archive_packed(&run,run.candidates + i,entries + packedCount) == FALSE)
+			archived = -1;
+		else if(run.candidates[i].packed)
+			++packedCount;
+	if(run.segmentFile && fclose(run.segmentFile) != 0)
+		archived = -1;
+
+	/* Indexed before any hot file goes, so every task is always somewhere */
+	indexed = archived >= 0 && packedCount > 0 && _tc_archive_update(tcHomeDirectory,entries,packedCount,NULL,NULL) == TC_OK;
+	if(packedCount > 0 && indexed == FALSE)
+		archived = -1;
+	left = FALSE;
+	for(i = 0; i < run.count; ++i){
+		if(run.candidates[i].packed == FALSE)
+			continue;
+		lock = archived >= 0 ? _tc_lock_acquire(tcHomeDirectory,run.candidates[i].taskHash) : -1;
+		if(lock != -1 && _tc_archive_unchanged(&run,run.candidates + i)
+			&& run.store->ops->remove(run.store,run.candidates[i].taskHash) == TC_OK)
+			++archived;
+		else{
+			/* The hot files win, the line this run wrote has to go */
+			run.candidates[i].packed = FALSE;
+			left = TRUE;
+		}
+		_tc_lock_release(lock);
+	}
+	if(left && indexed && _tc_archive_update(tcHomeDirectory,NULL,0,_tc_archive_left,&run) != TC_OK)
+		archived = -1;
+
+	/* Nothing in the index points into the segment any more */
+	if(archived == 0 || indexed == FALSE)
+		remove(segmentPath);
+	_tc_store_close(run.store);
+	_tc_lock_release(runLock);
+	free(run.candidates);
+	free(entries);
+	return archived;
+}
@@ -0,0 +1,102 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tc-columnar.h"
+
+size_t _tc_columnar_align(size_t offset){
+	return (offset + TC_COLUMNAR_ALIGN - 1) & ~((size_t)TC_COLUMNAR_ALIGN - 1);
+}
+
+static const void * _tc_columnar_section(const struct tc_columnar * columns, const struct tc_columnar_section * sections, uint32_t sectionCount, const char * name, uint32_t elemSize, uint64_t * count){
+	/* Look a section up by name and make sure it really fits in the mapping */
+	uint32_t i;
+	for(i = 0; i < sectionCount; ++i){
+		if(strncmp(sections[i].name, name, sizeof(sections[i].name)) != 0)
+			continue;
+		if(sections[i].elemSize != elemSize)
+			return NULL;
+		if(sections[i].offset % TC_COLUMNAR_ALIGN != 0 || sections[i].offset > columns->size)
+			return NULL;
+		if(sections[i].count > (columns->size - sections[i].offset) / elemSize)
+			return NULL;
+		*count = sections[i].count;
+		return (const char *)columns->base + sections[i].offset;
+	}
+	return NULL;
+}
+
+int tc_columnar_open(const char * path, struct tc_columnar * columns){
+	/* Map the file read only and point the column arrays into it. 1 on success, 0 on failure */
+	int fd;
+	struct stat fileStat;
+	const struct tc_columnar_header * header;
+	const struct tc_columnar_section * sections;
+	uint64_t taskIdCount, startCount, endCount, stateCount;
+
+	memset(columns, 0, sizeof(*columns));
+
+	fd = open(path, O_RDONLY);
+	if(fd == -1)
+		return 0;
+	if(fstat(fd, &fileStat) == -1 || (size_t)fileStat.st_size < sizeof(*header)){
+		close(fd);
+		return 0;
+	}
+
+	columns->size = fileStat.st_size;
+	columns->base = mmap(NULL, columns->size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(columns->base == MAP_FAILED){
+		columns->base = NULL;
+		return 0;
+	}
+
+	header = columns->base;
+	if(memcmp(header->magic, TC_COLUMNAR_MAGIC, sizeof(header->magic)) != 0
+		|| header->version != TC_COLUMNAR_VERSION
+		|| header->byteOrder != TC_COLUMNAR_BYTE_ORDER
+		|| header->sectionCount > (columns->size - sizeof(*header)) / sizeof(*sections) ){
+		tc_columnar_close(columns);
+		return 0;
+	}
+	sections = (const struct tc_columnar_section *)(header + 1);
+	columns->exportTime = header->exportTime;
+
+	columns->taskIds = _tc_columnar_section(columns, sections, header->sectionCount, TC_COLUMNAR_SEC_TASKID, sizeof(uint32_t), &taskIdCount);
+	columns->starts = _tc_columnar_section(columns, sections, header->sectionCount, TC_COLUMNAR_SEC_START, sizeof(int64_t), &startCount);
+	columns->ends = _tc_columnar_section(columns, sections, header->sectionCount, TC_COLUMNAR_SEC_END, sizeof(int64_t), &endCount);
+	columns->states = _tc_columnar_section(columns, sections, header->sectionCount, TC_COLUMNAR_SEC_STATE, sizeof(uint32_t), &stateCount);
+	columns->nameOffsets = _tc_columnar_section(columns, sections, header->sectionCount, TC_COLUMNAR_SEC_NAMEOFF, sizeof(uint32_t), &columns->taskCount);
+	columns->names = _tc_columnar_section(columns, sections, header->sectionCount, TC_COLUMNAR_SEC_NAMES, sizeof(char), &columns->namesSize);
+
+	if(columns->taskIds == NULL || columns->starts == NULL || columns->ends == NULL
+		|| columns->states == NULL || columns->nameOffsets == NULL || columns->names == NULL
+		|| taskIdCount != startCount || startCount != endCount || endCount != stateCount){
+		tc_columnar_close(columns);
+		return 0;
+	}
+	columns->intervalCount = taskIdCount;
+
+	return 1;
+}
+
+const char * tc_columnar_taskName(const struct tc_columnar * columns, uint32_t taskId){
+	uint32_t offset;
+	if(taskId >= columns->taskCount)
+		return NULL;
+	offset = columns->nameOffsets[taskId];
+	if(offset >= columns->namesSize || memchr(columns->names + offset, '\0', columns->namesSize - offset) == NULL)
+		return NULL;
+	return columns->names + offset;
+}
+
+void tc_columnar_close(struct tc_columnar * columns){
+	if(columns->base != NULL)
+		munmap(columns->base, columns->size);
+	memset(columns, 0, sizeof(*columns));
+}
@@ -0,0 +1,337 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tc-counters.h"
+#include "tc-lock.h"
+#include "tc-task.h"
+
+void _tc_counters_init(struct tc_counters * counters){
+	memset(counters,0,sizeof(*counters));
+	counters->lock = -1;
+}
+
+int _tc_counters_load(char const * tcHomeDirectory, struct tc_counters * counters){
+	/* For readers, nothing is locked. A store without counters starts at 0 */
+	char countersPath[TC_MAX_BUFF*2];
+	char line[TC_MAX_BUFF*2];
+	char * cursor, * end;
+	int i, valueAt;
+	FILE * fp;
+
+	_tc_counters_init(counters);
+	if(strlen(tcHomeDirectory) >= TC_MAX_BUFF)
+		return TC_ERR_ARGS;
+	strcpy(counters->root,tcHomeDirectory);
+
+	sprintf(countersPath,"%s/%s",tcHomeDirectory,TC_COUNTERS_FILE);
+	fp = fopen(countersPath,"r");
+	if(!fp)
+		return errno == ENOENT ? TC_OK : TC_ERR_IO;
+	while(fgets(line,sizeof(line),fp) != NULL){
+		line[strcspn(line,"\n")] = '\0';
+		valueAt = 0;
+		if(sscanf(line,"started %ld",&counters->started) == 1
+			|| sscanf(line,"paused %ld",&counters->paused) == 1
+			|| sscanf(line,"finished %ld",&counters->finished) == 1
+			|| sscanf(line,"bytes %ld",&counters->bytes) == 1
+			|| sscanf(line,"commands %lu",&counters->commands) == 1)
+			continue;
+		if(strncmp(line,"latency ",8) == 0){
+			cursor = line + 8;
+			for(i = 0; i < TC_LATENCY_BUCKETS; ++i, cursor = end)
+				counters->latency[i] = strtoul(cursor,&end,10);
+		}else if(sscanf(line,"textfile %n",&valueAt) == 0 && valueAt > 0 && strlen(line + valueAt) < TC_MAX_BUFF){
+			strcpy(counters->textfile,line + valueAt);
+		}
+	}
+	fclose(fp);
+	return TC_OK;
+}
+
+static void _tc_counters_latency(struct tc_counters * counters, long micros){
+	/* One command into its power of two bucket, halving the old ones once
+	 * the window is full */
+	unsigned long held;
+	int bucket;
+
+	for(bucket = 0; bucket + 1 < TC_LATENCY_BUCKETS && (micros >> (bucket + 1)) > 0; ++bucket)
+		;
+	++counters->latency[bucket];
+	++counters->commands;
+
+	for(held = 0, bucket = 0; bucket < TC_LATENCY_BUCKETS; ++bucket)
+		held += counters->latency[bucket];
+	if(held >= TC_LATENCY_WINDOW)
+		for(bucket = 0; bucket < TC_LATENCY_BUCKETS; ++bucket)
+			counters->latency[bucket] /= 2;
+}
+
+static void _tc_counters_fold(struct tc_counters * counters){
+	/* Move the latency lines aside and add them to the buckets. A command
+	 * still appending to the file moved aside may lose its line, like one
+	 * that runs into a full disk */
+	char latencyPath[TC_MAX_BUFF*2];
+	char foldPath[TC_MAX_BUFF*2+8];
+	long micros;
+	FILE * fp;
+
+	sprintf(latencyPath,"%s/%s",counters->root,TC_LATENCY_FILE);
+	sprintf(foldPath,"%s.fold",latencyPath);
+	if(rename(latencyPath,foldPath) != 0)
+		return;
+	if((fp = fopen(foldPath,"r")) != NULL){
+		while(fscanf(fp,"%ld",&micros) == 1)
+			_tc_counters_latency(counters,micros < 0 ? 0 : micros);
+		fclose(fp);
+	}
+	remove(foldPath);
+}
+
+int _tc_counters_begin(char const * tcHomeDirectory, struct tc_counters * counters){
+	/* Take the counters lock and load them for writing, with the latencies
+	 * commands left since */
+	int lock, result;
+
+	lock = _tc_lock_acquire(tcHomeDirectory,TC_LOCK_COUNTERS);
+	if(lock == -1)
+		return TC_ERR_IO;
+	if((result = _tc_counters_load(tcHomeDirectory,counters)) != TC_OK){
+		_tc_lock_release(lock);
+		return result;
+	}
+	counters->lock = lock;
+	_tc_counters_fold(counters);
+	return TC_OK;
+}
+
+static int _tc_counters_save(struct tc_counters * counters){
+	/* Write beside the file and rename over it so readers never see half of it */
+	char countersPath[TC_MAX_BUFF*2];
+	char countersTempPath[TC_MAX_BUFF*2+8];
+	FILE * fp;
+	int i;
+
+	sprintf(countersPath,"%s/%s",counters->root,TC_COUNTERS_FILE);
+	sprintf(countersTempPath,"%s.tmp",countersPath);
+	fp = fopen(countersTempPath,"w");
+	if(!fp)
+		return TC_ERR_IO;
+	fprintf(fp, "started %ld\npaused %ld\nfinished %ld\nbytes %ld\ncommands %lu\nlatency",
+		counters->started, counters->paused, counters->finished, counters->bytes, counters->commands);
+	for(i = 0; i < TC_LATENCY_BUCKETS; ++i)
+		fprintf(fp, " %lu", counters->latency[i]);
+	fprintf(fp, "\n");
+	if(counters->textfile[0] != '\0')
+		fprintf(fp, "textfile %s\n", counters->textfile);
+	if(fclose(fp) != 0 || rename(countersTempPath,countersPath) != 0)
+		return TC_ERR_IO;
+	return TC_OK;
+}
+
+int _tc_counters_commit(struct tc_counters * counters){
+	/* Save the counters and the textfile made from them, then unlock */
+	char textfilePath[TC_MAX_BUFF*2];
+	int result;
+
+	result = _tc_counters_save(counters);
+	if(result == TC_OK)
+		result = _tc_counters_textfile(counters,textfilePath);
+	_tc_lock_release(counters->lock);
+	counters->lock = -1;
+	return result;
+}
+
+static long * _tc_counters_state(struct tc_counters * counters, int state){
+	if(state == TC_TASK_STARTED)
+		return &counters->started;
+	if(state == TC_TASK_PAUSED)
+		return &counters->paused;
+	if(state == TC_TASK_FINISHED)
+		return &counters->finished;
+	return NULL;
+}
+
+void _tc_counters_tally(struct tc_counters * counters, int priorState, int state, long bytes){
+	/* A task went from priorState to state (the same for no change) and its
+	 * files grew by bytes. TC_TASK_NOT_FOUND on either side is no task */
+	long * count;
+
+	if(priorState != state){
+		if((count = _tc_counters_state(counters,priorState)) != NULL)
+			--*count;
+		if((count = _tc_counters_state(counters,state)) != NULL)
+			++*count;
+	}
+	counters->bytes += bytes;
+}
+
+void _tc_counters_merge(struct tc_counters * counters, struct tc_counters * delta){
+	/* Add counts built in memory, latencies are only ever recorded */
+	counters->started += delta->started;
+	counters->paused += delta->paused;
+	counters->finished += delta->finished;
+	counters->bytes += delta->bytes;
+}
+
+int _tc_counters_record(char const * tcHomeDirectory, int priorState, int state, long bytes){
+	/* One update under one hold of the lock */
+	struct tc_counters counters;
+	int result;
+
+	if((result = _tc_counters_begin(tcHomeDirectory,&counters)) != TC_OK)
+		return result;
+	_tc_counters_tally(&counters,priorState,state,bytes);
+	return _tc_counters_commit(&counters);
+}
+
+int _tc_counters_sample(char const * tcHomeDirectory, long micros){
+	/* One command's latency, appended as a single write so nothing locks */
+	char latencyPath[TC_MAX_BUFF*2];
+	char line[32];
+	int fd, length, result;
+
+	if(strlen(tcHomeDirectory) >= TC_MAX_BUFF)
+		return TC_ERR_ARGS;
+	sprintf(latencyPath,"%s/%s",tcHomeDirectory,TC_LATENCY_FILE);
+	fd = open(latencyPath,O_WRONLY|O_APPEND|O_CREAT,0644);
+	if(fd == -1)
+		return TC_ERR_IO;
+	length = sprintf(line,"%ld\n",micros);
+	result = write(fd,line,length) == length ? TC_OK : TC_ERR_IO;
+	if(close(fd) != 0)
+		result = TC_ERR_IO;
+	return result;
+}
+
+static double _tc_counters_power(int bucket){
+	/* 2^bucket microseconds, where a bucket begins */
+	double power;
+
+	for(power = 1.0; bucket > 0; --bucket)
+		power *= 2.0;
+	return power;
+}
+
+double _tc_counters_quantile(struct tc_counters * counters, double quantile){
+	/* Seconds below which quantile of the recent commands finished,
+	 * interpolated inside the bucket it falls in. 0 with no commands */
+	double target, seen, low, high;
+	unsigned long held;
+	int bucket;
+
+	for(held = 0, bucket = 0; bucket < TC_LATENCY_BUCKETS; ++bucket)
+		held += counters->latency[bucket];
+	if(held == 0)
+		return 0.0;
+
+	target = quantile*held;
+	seen = 0.0;
+	for(bucket = 0; bucket < TC_LATENCY_BUCKETS; ++bucket){
+		if(counters->latency[bucket] == 0 || seen + counters->latency[bucket] < target){
+			seen += counters->latency[bucket];
+			continue;
+		}
+		low = bucket == 0 ? 0.0 : _tc_counters_power(bucket);
+		high = _tc_counters_power(bucket + 1);
+		return (low + (high - low)*(target - seen)/counters->latency[bucket])/1e6;
+	}
+	return _tc_counters_power(TC_LATENCY_BUCKETS)/1e6;
+}
+
+static void _tc_counters_label(FILE * fp, char const * value){
+	/* A label value with \, " and newlines escaped */
+	for(; *value != '\0'; ++value){
+		if(*value == '\\' || *value == '"')
+			fprintf(fp, "\\%c", *value);
+		else if(*value == '\n')
+			fprintf(fp, "%s", "\\n");
+		else
+			fputc(*value, fp);
+	}
+}
+
+void _tc_counters_textfile_path(struct tc_counters * counters, char * textfilePath){
+	/* Where the textfile goes, <tc home>/metrics.prom unless one was given */
+	if(counters->textfile[0] != '\0')
+		strcpy(textfilePath,counters->textfile);
+	else
+		sprintf(textfilePath,"%s/%s",counters->root,TC_METRICS_FILE);
+}
+
+int _tc_counters_textfile(struct tc_counters * counters, char * textfilePath){
+	/* The Prometheus text format, written beside the textfile and renamed
+	 * over it. textfilePath gets where it went */
+	char textfileTempPath[TC_MAX_BUFF*2+8];
+	char currentTaskPath[TC_MAX_BUFF*2];
+	char currentTaskName[TC_MAX_BUFF];
+	char line[TC_MAX_BUFF];
+	int seqNum, state;
+	long eventTime;
+	time_t now;
+	FILE * fp, * current;
+
+	_tc_counters_textfile_path(counters,textfilePath);
+
+	/* current is replaced with rename(), the one opened is whole */
+	currentTaskName[0] = '\0';
+	state = TC_TASK_NOT_FOUND;
+	eventTime = 0;
+	sprintf(currentTaskPath,"%s/%s",counters->root,TC_CURRENT_TASK);
+	if((current = fopen(currentTaskPath,"r")) != NULL){
+		if(fgets(currentTaskName,sizeof(currentTaskName),current) == NULL
+			|| fgets(line,sizeof(line),current) == NULL || fgets(line,sizeof(line),current) == NULL
+			|| sscanf(line,"%d %d %ld",&seqNum,&state,&eventTime) != 3)
+			state = TC_TASK_NOT_FOUND;
+		fclose(current);
+		currentTaskName[strcspn(currentTaskName,"\n")] = '\0';
+	}
+	now = time(0);
+
+	sprintf(textfileTempPath,"%s.tmp",textfilePath);
+	fp = fopen(textfileTempPath,"w");
+	if(!fp)
+		return TC_ERR_IO;
+	fprintf(fp, "%s\n%s\n", "# HELP tcatch_current_task Whether a task is being worked on",
+		"# TYPE tcatch_current_task gauge");
+	if(state == TC_TASK_STARTED){
+		fprintf(fp, "%s", "tcatch_current_task{task=\"");
+		_tc_counters_label(fp,currentTaskName);
+		fprintf(fp, "\"} 1\n%s\n%s\n%s", "# HELP tcatch_current_task_seconds Seconds since the current task was started or resumed",
+			"# TYPE tcatch_current_task_seconds gauge", "tcatch_current_task_seconds{task=\"");
+		_tc_counters_label(fp,currentTaskName);
+		fprintf(fp, "\"} %ld\n%s\n%s\n%s", (long)(now - eventTime),
+			"# HELP tcatch_current_task_started_seconds When the current task was started or resumed, in seconds since the epoch",
+			"# TYPE tcatch_current_task_started_seconds gauge", "tcatch_current_task_started_seconds{task=\"");
+		_tc_counters_label(fp,currentTaskName);
+		fprintf(fp, "\"} %ld\n", eventTime);
+	}else{
+		fprintf(fp, "%s\n", "tcatch_current_task{task=\"\"} 0");
+	}
+	fprintf(fp, "%s\n%s\n" "tcatch_tasks{state=\"started\"} %ld\n" "tcatch_tasks{state=\"paused\"} %ld\n" "tcatch_tasks{state=\"finished\"} %ld\n",
+		"# HELP tcatch_tasks Tasks in the tasks directory by their last state", "# TYPE tcatch_tasks gauge",
+		counters->started, counters->paused, counters->finished);
+	fprintf(fp, "%s\n%s\n" "tcatch_store_bytes %ld\n",
+		"# HELP tcatch_store_bytes Bytes of the task histories and information in the tasks directory", "# TYPE tcatch_store_bytes gauge",
+		counters->bytes);
+	fprintf(fp, "%s\n%s\n" "tcatch_command_latency_seconds{quantile=\"0.5\"} %.6f\n" "tcatch_command_latency_seconds{quantile=\"0.99\"} %.6f\n",
+		"# HELP tcatch_command_latency_seconds Latency of recent tcatch commands", "# TYPE tcatch_command_latency_seconds gauge",
+		_tc_counters_quantile(counters,0.5), _tc_counters_quantile(counters,0.99));
+	fprintf(fp, "%s\n%s\n" "tcatch_commands_total %lu\n",
+		"# HELP tcatch_commands_total Commands run against the store", "# TYPE tcatch_commands_total counter",
+		counters->commands);
+	fprintf(fp, "%s\n%s\n" "tcatch_metrics_updated_seconds %ld\n",
+		"# HELP tcatch_metrics_updated_seconds When this file was written, in seconds since the epoch", "# TYPE tcatch_metrics_updated_seconds gauge",
+		(long)now);
+	if(fclose(fp) != 0 || rename(textfileTempPath,textfilePath) != 0){
+		remove(textfileTempPath);
+		return TC_ERR_IO;
+	}
+	return TC_OK;
+}
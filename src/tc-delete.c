@@ -1,79 +1,611 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include "tc-delete.h"
+#include "tc-store.h"
+#include "tc-view.h"
+#include "tc-interval.h"
+#include "tc-manifest.h"
+#include "tc-journal.h"
+#include "tc-archive.h"
+#include "tc-lock.h"
 
-void tc_delete(int argc,const char * argv[]){
-	struct tc_task working_task;
-	struct tc_task currentTask; 
+#include <strings.h>
+#include <sys/stat.h>
+
+#define TC_DELETE_HELD 64
+
+/* A task picked for deletion, and whether it is gone */
+struct tc_delete_candidate {
+	char taskHash[48];
 	char taskName[TC_MAX_BUFF];
-	char tcHomeDirectory[TC_MAX_BUFF];
-	char currentTaskPath[TC_MAX_BUFF];
-	char taskSequencePath[TC_MAX_BUFF]; 
+	int archived;			/* Picked from the archive index */
+	int removed;
+	long journalMark;		/* Its records are all before this one */
+	long entries;			/* Index entries left to drop in a segment */
+};
+
+/* An index line to drop, with the task's lock held until it is gone.
+ * raw is the archived history to take out with it, NULL when the task
+ * was hot and its history is accounted for already */
+struct tc_delete_held {
+	size_t candidate;
+	int lock;
+	struct tc_archive_entry entry;
+	char * raw;
+};
+
+/* How many of a removed task's events went to one day's index entries */
+struct tc_delete_day {
+	long day;
+	size_t candidate;
+	size_t segment;
+	long entries;
+};
+
+struct tc_delete_run {
+	struct tc_store * store;
+	int state;				/* Only tasks last in this state, 0 for any */
+	int olderThan;			/* Only tasks with nothing since cutoff */
+	time_t cutoff;
+	struct tc_delete_candidate * candidates;	/* Sorted by hash */
+	size_t count;
+	size_t capacity;
+	size_t hotCount;		/* How many came from the tasks directory */
+	/* Archive index lines are dropped TC_DELETE_HELD tasks at a time */
+	struct tc_delete_held * held;
+	size_t heldCount;
+	/* What the removals leave for the end: where their index entries and
+	 * journal records are, and what comes off the projects, counters and
+	 * the sessions of each day */
+	struct tc_delete_day * days;
+	size_t dayCount;
+	size_t dayCapacity;
+	long journalPosition;
+	struct tc_projects projects;
+	struct tc_counters counters;
+	struct tc_sessions sessions;
+	int failed;
+};
+
+/* One task's history, into its summary, the days it was indexed on and
+ * the sessions it closed */
+struct tc_delete_replay {
+	struct tc_delete_run * run;
+	size_t candidate;
+	struct tc_task_summary summary;
+	struct tc_sessions sessions;
+	struct tc_sketch_replay sketch;
+};
+
+static int _tc_delete_picked(struct tc_delete_run * run, struct tc_task_summary * summary){
+	if(summary->state == TC_TASK_NOT_FOUND)
+		return FALSE;
+	if(run->state != 0 && summary->state != run->state)
+		return FALSE;
+	return run->olderThan == FALSE || summary->lastTime < run->cutoff;
+}
+
+static int _tc_delete_add(struct tc_delete_run * run, char const * taskHash, char const * taskName){
+	struct tc_delete_candidate * grown;
+
+	if(strlen(taskHash) >= sizeof(grown->taskHash))
+		return FALSE;
+	if(run->count == run->capacity){
+		grown = realloc(run->candidates,(run->capacity ? run->capacity*2 : 64)*sizeof(*grown));
+		if(grown == NULL){
+			run->failed = TRUE;
+			return FALSE;
+		}
+		run->candidates = grown;
+		run->capacity = run->capacity ? run->capacity*2 : 64;
+	}
+	strcpy(run->candidates[run->count].taskHash,taskHash);
+	strcpy(run->candidates[run->count].taskName,taskName);
+	run->candidates[run->count].archived = FALSE;
+	run->candidates[run->count].removed = FALSE;
+	run->candidates[run->count].journalMark = 0;
+	run->candidates[run->count].entries = 0;
+	++run->count;
+	return TRUE;
+}
+
+static void _tc_delete_consider(const char * taskHash, const char * taskName, void * data){
+	/* Picked from the summary alone, the task's files are not read twice */
+	struct tc_delete_run * run = data;
+	struct tc_task_summary summary;
+
+	if(run->failed)
+		return;
+	_tc_store_summarize(run->store,taskHash,&summary);
+	if(_tc_delete_picked(run,&summary))
+		_tc_delete_add(run,taskHash,taskName);
+}
+
+static int _tc_delete_hash_compare(const void * left, const void * right){
+	return strcmp(((const struct tc_delete_candidate *)left)->taskHash,((const struct tc_delete_candidate *)right)->taskHash);
+}
+
+static struct tc_delete_candidate * _tc_delete_find(struct tc_delete_run * run, char const * taskHash, size_t count){
+	/* Among the first count candidates, sorted by hash */
+	struct tc_delete_candidate key;
+
+	if(strlen(taskHash) >= sizeof(key.taskHash))
+		return NULL;
+	strcpy(key.taskHash,taskHash);
+	return bsearch(&key,run->candidates,count,sizeof(key),_tc_delete_hash_compare);
+}
+
+static void _tc_delete_archived(struct tc_archive_entry * entry, void * data){
+	/* An archived task is finished, at the time it was archived with. One
+	 * that is hot again was considered with the tasks directory */
+	struct tc_delete_run * run = data;
+	struct tc_task_summary summary;
+
+	if(run->failed || _tc_delete_find(run,entry->taskHash,run->hotCount) != NULL)
+		return;
+	_tc_task_summary_init(&summary);
+	summary.state = TC_TASK_FINISHED;
+	summary.lastTime = entry->finishTime;
+	if(_tc_delete_picked(run,&summary) && _tc_delete_add(run,entry->taskHash,entry->taskName))
+		run->candidates[run->count-1].archived = TRUE;
+}
+
+static void _tc_delete_record(int seqNum, int seqState, time_t seqTime, void * data){
+	/* Events come in runs on one day, each run is kept as a count */
+	struct tc_delete_replay * replay = data;
+	struct tc_delete_run * run = replay->run;
+	struct tc_delete_day * grown;
+	struct tm timeinfo;
+	long day;
+
+	_tc_task_summary_record(seqNum,seqState,seqTime,&replay->summary);
+	_tc_sketch_record(seqNum,seqState,seqTime,&replay->sketch);
+	if(run->failed || localtime_r(&seqTime,&timeinfo) == NULL)
+		return;
+	day = (timeinfo.tm_year + 1900)*10000L + (timeinfo.tm_mon + 1)*100L + timeinfo.tm_mday;
+	if(run->dayCount > 0 && run->days[run->dayCount-1].day == day && run->days[run->dayCount-1].candidate == replay->candidate){
+		++run->days[run->dayCount-1].entries;
+		return;
+	}
+	if(run->dayCount == run->dayCapacity){
+		grown = realloc(run->days,(run->dayCapacity ? run->dayCapacity*2 : 64)*sizeof(*grown));
+		if(grown == NULL){
+			run->failed = TRUE;
+			return;
+		}
+		run->days = grown;
+		run->dayCapacity = run->dayCapacity ? run->dayCapacity*2 : 64;
+	}
+	run->days[run->dayCount].day = day;
+	run->days[run->dayCount].candidate = replay->candidate;
+	run->days[run->dayCount].segment = 0;
+	run->days[run->dayCount].entries = 1;
+	++run->dayCount;
+}
+
+static void _tc_delete_replay_init(struct tc_delete_run * run, size_t index, struct tc_delete_replay * replay){
+	replay->run = run;
+	replay->candidate = index;
+	_tc_task_summary_init(&replay->summary);
+	_tc_sessions_init(&replay->sessions);
+	_tc_sketch_replay_init(&replay->sketch,NULL,&replay->sessions,1);
+}
+
+static void _tc_delete_account(struct tc_delete_run * run, struct tc_delete_replay * replay){
+	/* What a removed task takes out of the projects and the sessions */
+	struct tc_delete_candidate * candidate = run->candidates + replay->candidate;
+
+	/* Events of a task are journalled under its lock, so every record
+	 * of this one is before the end of the journal as it is now */
+	if((candidate->journalMark = _tc_journal_count(run->store->root)) < 0)
+		run->failed = TRUE;
+	/* Its closed time comes back out of its projects with it. The delta
+	 * counts what goes, a tree drops projects left without tasks */
+	if(_tc_projects_add(&run->projects,candidate->taskName,(long)replay->summary.accumulated,1) != TC_OK)
+		run->failed = TRUE;
+	/* ...and its sessions out of the days they closed on */
+	if(replay->sketch.failed || _tc_sessions_merge(&run->sessions,&replay->sessions,-1) != TC_OK)
+		run->failed = TRUE;
+	candidate->removed = TRUE;
+}
+
+static int _tc_delete_unheld(struct tc_archive_entry const * entry, void * data){
+	struct tc_delete_run * run = data;
+	size_t i;
+
+	for(i = 0; i < run->heldCount; ++i)
+		if(strcmp(run->held[i].entry.taskHash,entry->taskHash) == 0)
+			return FALSE;
+	return TRUE;
+}
+
+static int _tc_delete_flush(struct tc_delete_run * run){
+	/* Drop the held tasks' index lines in one rewrite of the index, then
+	 * take the archived ones' history out and let their locks go. An
+	 * archived task stays when its line can't be dropped */
+	struct tc_delete_held * held;
+	struct tc_delete_replay replay;
+	size_t dayCount, i;
+	int result;
+
+	if(run->heldCount == 0)
+		return TC_OK;
+	result = _tc_archive_update(run->store->root,NULL,0,_tc_delete_unheld,run);
+	for(i = 0; i < run->heldCount; ++i){
+		held = run->held + i;
+		if(result == TC_OK && held->raw != NULL){
+			_tc_delete_replay_init(run,held->candidate,&replay);
+			dayCount = run->dayCount;
+			if(_tc_seq_parse(held->raw,held->entry.seqSize,_tc_delete_record,&replay) < 0){
+				run->dayCount = dayCount;
+				run->failed = TRUE;
+			}
+			_tc_delete_account(run,&replay);
+			_tc_sessions_free(&replay.sessions);
+		}
+		if(result == TC_OK && run->candidates[held->candidate].removed)
+			_tc_lock_remove(run->store->root,held->entry.taskHash);
+		_tc_lock_release(held->lock);
+		free(held->raw);
+	}
+	run->heldCount = 0;
+	if(result != TC_OK)
+		fprintf(stderr, "%s\n", "Could not drop the tasks from the archive index. Please check permissions");
+	return result;
+}
+
+static int _tc_delete_hold(struct tc_delete_run * run, size_t index, int lock, struct tc_archive_entry * entry, int unpack){
+	/* Keep the task's lock until its index line is dropped, flushing
+	 * first when TC_DELETE_HELD are held. TC_ERR_IO if its history can't
+	 * be read back, the lock is let go then */
+	struct tc_delete_held * held;
+	char * raw;
+
+	raw = NULL;
+	if(unpack && (raw = _tc_archive_unpack(run->store->root,entry)) == NULL){
+		_tc_lock_release(lock);
+		return TC_ERR_IO;
+	}
+	if(run->held == NULL && (run->held = malloc(TC_DELETE_HELD*sizeof(*run->held))) == NULL){
+		free(raw);
+		_tc_lock_release(lock);
+		return TC_ERR_NOMEM;
+	}
+	if(run->heldCount == TC_DELETE_HELD)
+		_tc_delete_flush(run);
+	held = run->held + run->heldCount++;
+	held->candidate = index;
+	held->lock = lock;
+	held->entry = *entry;
+	held->raw = raw;
+	return TC_OK;
+}
+
+static int _tc_delete_task(struct tc_delete_run * run, size_t index){
+	/* Remove one task's files under its lock, after looking at it again:
+	 * it may have been started since it was picked. The index, journal,
+	 * projects and counters are left for _tc_delete_finish. An archived
+	 * task, or a hot one with an index line left, is held for
+	 * _tc_delete_flush to drop its line.
+	*/
+	struct tc_delete_candidate * candidate = run->candidates + index;
+	struct tc_delete_replay replay;
+	struct tc_archive_entry entry;
+	struct tc_lockset locks;
+	char currentName[TC_MAX_BUFF];
+	char taskSequencePath[TC_MAX_BUFF];
 	char taskInfoPath[TC_MAX_BUFF];
-	char * fileHash;
-	int yaynay;
-	
-	tc_init(tcHomeDirectory);
+	char taskSpanPath[TC_MAX_BUFF];
+	char taskSketchPath[TC_MAX_BUFF];
+	struct stat fileStat;
+	size_t dayCount;
+	long bytes;
+	int result, archived;
 
-	working_task.taskName = malloc(TC_MAX_BUFF*sizeof(char));
-	working_task.taskInfo = malloc(TC_MAX_BUFF*sizeof(char));
+	if((result = run->store->ops->lock(run->store,candidate->taskName,FALSE,currentName,&locks)) != TC_OK)
+		return result;
+	_tc_delete_replay_init(run,index,&replay);
+	dayCount = run->dayCount;
+	archived = _tc_archive_find(run->store->root,candidate->taskHash,&entry);
+	if(run->store->ops->history(run->store,candidate->taskHash,_tc_delete_record,&replay) <= 0){
+		run->dayCount = dayCount;
+		_tc_sessions_free(&replay.sessions);
+		/* Only in the archive, a finished task nobody else can be on */
+		replay.summary.state = TC_TASK_FINISHED;
+		replay.summary.lastTime = entry.finishTime;
+		if(archived == FALSE || _tc_delete_picked(run,&replay.summary) == FALSE){
+			run->store->ops->unlock(run->store,&locks);
+			return TC_ERR_NOT_FOUND;
+		}
+		_tc_unlock_current(&locks);
+		return _tc_delete_hold(run,index,locks.handles[0],&entry,TRUE);
+	}
+	if(_tc_delete_picked(run,&replay.summary) == FALSE){
+		run->dayCount = dayCount;
+		run->store->ops->unlock(run->store,&locks);
+		_tc_sessions_free(&replay.sessions);
+		return TC_ERR_NOT_FOUND;
+	}
+
+	/* If this task was the same as the current task, remove the current file */
+	if(strcmp(currentName,candidate->taskName) == 0 && run->store->ops->current_clear(run->store) != TC_OK)
+		fprintf(stderr, "%s\n", "Could not remove the current task file. ");
+
+	_tc_getTaskFilePath(taskSequencePath,run->store->root,candidate->taskHash,TC_SEQ_EXT);
+	_tc_getTaskFilePath(taskInfoPath,run->store->root,candidate->taskHash,TC_INFO_EXT);
+	_tc_getTaskFilePath(taskSpanPath,run->store->root,candidate->taskHash,TC_SPAN_EXT);
+	_tc_getTaskFilePath(taskSketchPath,run->store->root,candidate->taskHash,TC_SKETCH_EXT);
+	bytes = 0;
+	if(stat(taskSequencePath,&fileStat) == 0)
+		bytes += fileStat.st_size;
+	if(stat(taskInfoPath,&fileStat) == 0)
+		bytes += fileStat.st_size;
+	result = TC_OK;
+	if(remove(taskSequencePath) == -1 || remove(taskInfoPath) == -1){
+		result = TC_ERR_IO;
+	}else{
+		/* The interval index and sketch may never have been built */
+		remove(taskSpanPath);
+		remove(taskSketchPath);
+		run->store->ops->active_remove(run->store,candidate->taskHash);
+		_tc_counters_tally(&run->counters,replay.summary.state,TC_TASK_NOT_FOUND,-bytes);
+		_tc_delete_account(run,&replay);
+	}
+	_tc_sessions_free(&replay.sessions);
+	/* The hot files won over the line, which must not outlive them */
+	if(result == TC_OK && archived){
+		_tc_unlock_current(&locks);
+		return _tc_delete_hold(run,index,locks.handles[0],&entry,FALSE);
+	}
+	if(result == TC_OK)
+		_tc_lock_remove(run->store->root,candidate->taskHash);
+	run->store->ops->unlock(run->store,&locks);
+	return result;
+}
 
-	_resolve_taskName_from_args(argc,argv,taskName);
+static int _tc_delete_segment_compare(const void * left, const void * right){
+	const struct tc_delete_day * a = left;
+	const struct tc_delete_day * b = right;
 
-	/* Check if there's a task */
-	_tc_task_read(taskName, &working_task);
+	return (a->segment > b->segment) - (a->segment < b->segment);
+}
+
+static struct tc_delete_candidate * _tc_delete_gone(struct tc_delete_run * run, char const * taskHash){
+	struct tc_delete_candidate * found;
+
+	found = _tc_delete_find(run,taskHash,run->count);
+	return found != NULL && found->removed ? found : NULL;
+}
+
+static int _tc_delete_index_filter(char const * taskHash, void * data){
+	/* A removed task's entries are the first ones of its hash in a segment,
+	 * any after them are of a task started again under its name */
+	struct tc_delete_candidate * candidate;
+
+	if((candidate = _tc_delete_gone(data,taskHash)) == NULL || candidate->entries == 0)
+		return FALSE;
+	--candidate->entries;
+	return TRUE;
+}
 
-	if(working_task.state == TC_TASK_NOT_FOUND)
+static int _tc_delete_journal_filter(struct tc_journal_record * record, void * data){
+	struct tc_delete_run * run = data;
+	struct tc_delete_candidate * candidate;
+	long position;
+
+	position = run->journalPosition++;
+	return (candidate = _tc_delete_gone(run,record->taskHash)) != NULL && position < candidate->journalMark;
+}
+
+static int _tc_delete_index(struct tc_delete_run * run, long * entries){
+	/* Rewrite each segment the removed tasks' events went to, once */
+	struct tc_manifest manifest;
+	char date[16];
+	size_t i, first, last;
+	int found, result, dropped;
+
+	if(_tc_manifest_begin(run->store->root,&manifest) != TC_OK)
+		return TC_ERR_IO;
+	for(i = 0; i < run->dayCount; ++i){
+		sprintf(date,"%08ld",run->days[i].day);
+		run->days[i].segment = _tc_manifest_route(&manifest,date,&found);
+		if(found == FALSE)
+			run->days[i].segment = manifest.count;
+	}
+	qsort(run->days,run->dayCount,sizeof(*run->days),_tc_delete_segment_compare);
+
+	result = TC_OK;
+	for(first = 0; first < run->dayCount && run->days[first].segment < manifest.count && result == TC_OK; first = last){
+		for(last = first; last < run->dayCount && run->days[last].segment == run->days[first].segment; ++last)
+			run->candidates[run->days[last].candidate].entries += run->days[last].entries;
+		if((dropped = _tc_manifest_drop(&manifest,run->days[first].segment,_tc_delete_index_filter,run)) < 0)
+			result = dropped;
+		else
+			*entries += dropped;
+		for(i = first; i < last; ++i)
+			run->candidates[run->days[i].candidate].entries = 0;
+	}
+	_tc_manifest_prune(&manifest);
+	if(_tc_manifest_commit(&manifest) != TC_OK && result == TC_OK)
+		result = TC_ERR_IO;
+	return result;
+}
+
+static int _tc_delete_finish(struct tc_delete_run * run, long * entries, long * records){
+	/* Everything the removed tasks leave behind, each file written once */
+	struct tc_projects projects;
+	struct tc_counters counters;
+	struct tc_journal journal;
+	size_t i;
+	int result, written;
+
+	*entries = *records = 0;
+	_tc_delete_flush(run);
+	result = run->failed ? TC_ERR_NOMEM : _tc_delete_index(run,entries);
+	if(result == TC_OK && (result = _tc_journal_begin(run->store->root,&journal)) == TC_OK){
+		run->journalPosition = 0;
+		if((*records = _tc_journal_drop(&journal,_tc_delete_journal_filter,run)) < 0)
+			result = TC_ERR_IO;
+		if(_tc_journal_commit(&journal) != TC_OK && result == TC_OK)
+			result = TC_ERR_IO;
+	}
+
+	if(run->failed || (written = _tc_projects_begin(run->store->root,&projects)) != TC_OK)
+		written = TC_ERR_IO;
+	else{
+		for(i = 0; i < run->projects.count; ++i){
+			run->projects.nodes[i].accumulated = -run->projects.nodes[i].accumulated;
+			run->projects.nodes[i].tasks = -run->projects.nodes[i].tasks;
+		}
+		written = _tc_projects_merge(&projects,&run->projects);
+		if(_tc_projects_commit(&projects) != TC_OK && written == TC_OK)
+			written = TC_ERR_IO;
+	}
+	if(written != TC_OK)
+		fprintf(stderr, "%s\n", "Could not update the project totals. tcatch fsck --repair rebuilds them");
+	if(_tc_counters_begin(run->store->root,&counters) == TC_OK){
+		_tc_counters_merge(&counters,&run->counters);
+		_tc_counters_commit(&counters);
+	}
+	if(run->failed || _tc_sessions_commit(run->store->root,&run->sessions) != TC_OK)
+		fprintf(stderr, "%s\n", "Could not update the session sketches. tcatch fsck --repair rebuilds them");
+	return result;
+}
+
+static void _tc_delete_run_free(struct tc_delete_run * run){
+	_tc_store_close(run->store);
+	_tc_projects_free(&run->projects);
+	_tc_sessions_free(&run->sessions);
+	free(run->candidates);
+	free(run->held);
+	free(run->days);
+}
+
+static void _tc_delete_matching(struct tc_delete_run * run, int confirmed, int dryRun){
+	/* Every task the predicate picks, from one listing of the tasks
+	 * directory and one read of the archive index */
+	long entries, records;
+	size_t i;
+	int deleted;
+
+	run->store->ops->list(run->store,_tc_delete_consider,run);
+	qsort(run->candidates,run->count,sizeof(*run->candidates),_tc_delete_hash_compare);
+	run->hotCount = run->count;
+	_tc_archive_each(run->store->root,_tc_delete_archived,run);
+	if(run->failed){
+		fprintf(stderr, "%s\n", "Could not allocate memory for the tasks to delete.");
+		return;
+	}
+	if(run->count == 0){
+		fprintf(stdout, "%s\n", "No tasks to delete");
+		return;
+	}
+	qsort(run->candidates,run->count,sizeof(*run->candidates),_tc_delete_hash_compare);
+	if(dryRun){
+		for(i = 0; i < run->count; ++i)
+			fprintf(stdout, "%s\n", run->candidates[i].taskName);
+		fprintf(stdout, "Would delete %lu tasks\n", (unsigned long)run->count);
+		return;
+	}
+	if(confirmed == FALSE){
+		fprintf(stdout, "Deleting these %lu tasks is permanent!\n", (unsigned long)run->count);
+		if(_tc_askForConfirm() != TRUE)
+			return;
+	}
+
+	/* A task that changed since it was picked is passed over */
+	for(i = 0; i < run->count; ++i)
+		if(_tc_delete_task(run,i) == TC_ERR_IO)
+			fprintf(stderr, "Could not remove the files of %s\n", run->candidates[i].taskName);
+	if(_tc_delete_finish(run,&entries,&records) != TC_OK)
+		fprintf(stderr, "%s\n", "Could not drop the deleted tasks from the index and journal. tcatch fsck --repair rewrites them");
+	for(deleted = 0, i = 0; i < run->count; ++i)
+		if(run->candidates[i].removed)
+			++deleted;
+	fprintf(stdout, "Deleted %i tasks, %ld index entries and %ld journal records\n", deleted, entries, records);
+}
+
+void tc_delete(int argc,const char * argv[]){
+	/* One task by name, or with --state and --older-than every task they pick */
+	struct tc_delete_run run;
+	char tcHomeDirectory[TC_MAX_BUFF];
+	char taskName[TC_MAX_BUFF];
+	char fileHash[TC_MAX_BUFF];
+	struct tc_archive_entry entry;
+	char const * state, * olderThan;
+	long entries, records;
+	int confirmed, dryRun, result;
+
+	/* Usage has already been shown by the help check */
+	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
+		return;
+
+	tc_init(tcHomeDirectory);
+	memset(&run,0,sizeof(run));
+	state = _tc_args_flag_value(argc,argv,TC_STATE_LONG,TC_STATE_SHORT);
+	olderThan = _tc_args_flag_value(argc,argv,TC_OLDER_THAN_LONG,TC_OLDER_THAN_SHORT);
+	if(state != NULL){
+		if(strcasecmp(state,"started") == 0)
+			run.state = TC_TASK_STARTED;
+		else if(strcasecmp(state,"paused") == 0)
+			run.state = TC_TASK_PAUSED;
+		else if(strcasecmp(state,"finished") == 0)
+			run.state = TC_TASK_FINISHED;
+	}
+	if(olderThan != NULL)
+		run.olderThan = _tc_view_when(olderThan,FALSE,&run.cutoff);
+	if((state == NULL && _tc_args_flag_check(argc,argv,TC_STATE_LONG,TC_STATE_SHORT) == TRUE)
+		|| (state != NULL && run.state == 0)
+		|| (olderThan == NULL && _tc_args_flag_check(argc,argv,TC_OLDER_THAN_LONG,TC_OLDER_THAN_SHORT) == TRUE)
+		|| (olderThan != NULL && run.olderThan == FALSE)){
+		_tc_display_usage(TC_DELETE_COMMAND);
+		return;
+	}
+	confirmed = _tc_args_flag_check(argc,argv,TC_YES_LONG,TC_YES_SHORT);
+	dryRun = _tc_args_flag_check(argc,argv,TC_DRY_RUN_LONG,TC_DRY_RUN_SHORT);
+
+	if(_tc_store_open_directory(&run.store,tcHomeDirectory) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not open the .tc directory. Please check permissions");
+		return;
+	}
+	_tc_projects_init(&run.projects);
+	_tc_counters_init(&run.counters);
+	_tc_sessions_init(&run.sessions);
+
+	if(state != NULL || olderThan != NULL){
+		_tc_delete_matching(&run,confirmed,dryRun);
+		_tc_delete_run_free(&run);
+		return;
+	}
+
+	/* Check if there's a task, hot or archived, its name is all it takes */
+	_tc_cli_task_name(argc,argv,taskName);
+	_tc_taskName_to_Hash(taskName,fileHash);
+	if(taskName[0] == '\0' || (run.store->ops->task_open(run.store,fileHash,taskName,FALSE) != TC_OK
+		&& _tc_archive_find(tcHomeDirectory,fileHash,&entry) == FALSE) || _tc_delete_add(&run,fileHash,taskName) == FALSE)
 		fprintf(stderr, "%s\n", "Could not find the task to delete");
+	else if(dryRun)
+		fprintf(stdout, "Would delete %s\n", taskName);
 	else{
-		/* Check the current task to see if it should be removed.*/
-		currentTask.taskName = malloc(TC_MAX_BUFF*sizeof(char));
-		currentTask.taskInfo = malloc(TC_MAX_BUFF*sizeof(char));
-
-		_find_current_task(&currentTask);
-		_tc_getCurrentTaskPath(currentTaskPath);
-
-		/* If this task was the same as the current task, remove the current file */
-		if( currentTask.state != TC_TASK_NOT_FOUND )
-			if(strcmp(currentTask.taskName,working_task.taskName)==0)
-				if (remove(currentTaskPath) == -1){
-					/* Something went wrong */
-					fprintf(stderr, "%s\n", "Could not remove the current task file. ");
-				} 
-
-		free(currentTask.taskName);
-		free(currentTask.taskInfo);
-
-		fileHash = malloc(25*sizeof(char)); /* hash is 20 characters .seq is 4 more \0 is 1 more */
-		if( fileHash == NULL ){
-			fprintf(stderr, "%s\n", "Could not allocate memory for file hash string.");
-		}else{
-			fileHash[0] = '\0';	
-			/* Remove the task's sequence and info files*/
-			_tc_taskName_to_Hash(working_task.taskName,fileHash);
-	
-			sprintf(taskSequencePath,"%s/%s/%s.seq",tcHomeDirectory,TC_TASK_DIR,fileHash);
-			sprintf(taskInfoPath,"%s/%s/%s.info",tcHomeDirectory,TC_TASK_DIR,fileHash);
-
-			/* Ask for confirmation */
+		/* Ask for confirmation */
+		if(confirmed == FALSE)
 			fprintf(stdout, "%s\n", "Deleting this task is permanent!");
-			yaynay = _tc_askForConfirm();
-
-			if( yaynay == TRUE ){ /* Remove the files */
-				if(remove(taskSequencePath) == -1){
-					fprintf(stderr, "%s\n", "Could not remove the sequence file for the task to be deleted.");
-				}else{
-					if(remove(taskInfoPath) == -1){
-						fprintf(stderr, "%s\n", "Could not remove the info file for the task to be deleted.");
-					}else{
-						fprintf(stdout, "%s task has been removed.\n", working_task.taskName);
-					}
-				}
+		if(confirmed || _tc_askForConfirm() == TRUE){
+			/* Only lock once confirmed so the prompt doesn't hold anyone up */
+			result = _tc_delete_task(&run,0);
+			if(result == TC_ERR_NOT_FOUND)
+				fprintf(stderr, "%s\n", "Could not find the task to delete");
+			else if(result != TC_OK)
+				fprintf(stderr, "%s\n", "Could not remove the files for the task to be deleted.");
+			else{
+				if(_tc_delete_finish(&run,&entries,&records) != TC_OK)
+					fprintf(stderr, "%s\n", "Could not drop the task from the index and journal. tcatch fsck --repair rewrites them");
+				if(run.candidates[0].removed)
+					fprintf(stdout, "%s task has been removed.\n", taskName);
 			}
 		}
-		free(fileHash);
 	}
-
-	free(working_task.taskInfo);
-	free(working_task.taskName);
+	_tc_delete_run_free(&run);
 }
 
 int _tc_askForConfirm(){
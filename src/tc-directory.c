@@ -6,6 +6,7 @@
 
 #include "tc-directory.h"
 #include "tc-task.h"
+#include "tc-lock.h"
 
 const char * _tc_getHomePath(){
 	const char * homePath;
@@ -28,6 +29,11 @@ void _tc_getTasksDir(char * tasksDir){
 	sprintf(tasksDir,"%s/.tc/%s",home,TC_TASK_DIR);
 }
 
+void _tc_getTaskFilePath(char * taskFilePath, char const * tcHomeDirectory, char const * taskHash, char const * extension){
+	/* <tc home>/tasks/<hash>.<seq|info> */
+	sprintf(taskFilePath,"%s/%s/%s.%s",tcHomeDirectory,TC_TASK_DIR,taskHash,extension);
+}
+
 void _tc_getCurrentTaskPath(char * currentTaskPath){
 	const char * home;
 	home = _tc_getHomePath();
@@ -61,3 +67,26 @@ int _tc_file_exists(const char * filename){
 	return(stat (filename, &buffer) == 0);
 }
 
+
+int _tc_store_create(char const * tcHomeDirectory){
+	/* Make the store and its directories if they are missing, FALSE on failure */
+	char const * directories[4];
+	char directoryPath[TC_MAX_BUFF*2];
+	int i, success;
+
+	directories[0] = "";
+	directories[1] = TC_INDEX_DIR;
+	directories[2] = TC_TASK_DIR;
+	directories[3] = TC_LOCK_DIR;
+	if(strlen(tcHomeDirectory) >= TC_MAX_BUFF)
+		return FALSE;
+
+	for(i = 0; i < 4; ++i){
+		sprintf(directoryPath,"%s/%s",tcHomeDirectory,directories[i]);
+		if((success = _tc_directoryExists(directoryPath)) == 0)
+			success = mkdir(directoryPath,TC_DIR_PERM);
+		if(success == -1)
+			return FALSE;
+	}
+	return TRUE;
+}
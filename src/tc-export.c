@@ -0,0 +1,264 @@
+#include "tc-export.h"
+#include "tc-columnar.h"
+#include "tc-store.h"
+#include "tc-task.h"
+#include "tc-directory.h"
+#include "tc-init.h"
+
+#include <stdio.h>
+
+void tc_export(int argc, char const *argv[]){
+	char tcHomeDirectory[TC_MAX_BUFF];
+	char exportPath[TC_MAX_BUFF];
+
+	/* Usage has already been shown by the help check */
+	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
+		return;
+
+	tc_init(tcHomeDirectory);
+	_tc_cli_task_name(argc,argv,exportPath);
+
+	if(strcmp(exportPath,"") == 0){
+		_tc_display_usage(TC_EXPORT_COMMAND);
+		return;
+	}
+
+	if(_tc_args_flag_check(argc,argv,TC_DUMP_LONG,TC_DUMP_SHORT) == TRUE)
+		_tc_export_dump(exportPath);
+	else if(_tc_args_flag_check(argc,argv,TC_COLUMNAR_LONG,TC_COLUMNAR_SHORT) == TRUE)
+		_tc_export_columnar(tcHomeDirectory,exportPath);
+	else
+		_tc_display_usage(TC_EXPORT_COMMAND);
+}
+
+static int _tc_export_resize(void ** array, size_t capacity, size_t elemSize){
+	void * grown = realloc(*array, capacity*elemSize);
+	if(grown == NULL)
+		return FALSE;
+	*array = grown;
+	return TRUE;
+}
+
+static int _tc_export_grow(void ** array, size_t * capacity, size_t needed, size_t elemSize){
+	/* Double the array until it can hold needed elements */
+	size_t newCapacity;
+
+	if(needed <= *capacity)
+		return TRUE;
+	newCapacity = *capacity == 0 ? 1024 : *capacity;
+	while(newCapacity < needed)
+		newCapacity *= 2;
+	if(!_tc_export_resize(array,newCapacity,elemSize))
+		return FALSE;
+	*capacity = newCapacity;
+	return TRUE;
+}
+
+static int _tc_export_push_interval(struct tc_export_columns * columns, time_t start, time_t end, int state){
+	size_t newCapacity;
+
+	if(columns->intervalCount == columns->intervalCapacity){
+		/* The four interval columns always share one capacity */
+		newCapacity = columns->intervalCapacity == 0 ? 1024 : columns->intervalCapacity*2;
+		if(!_tc_export_resize((void **)&columns->taskIds,newCapacity,sizeof(uint32_t))
+			|| !_tc_export_resize((void **)&columns->starts,newCapacity,sizeof(int64_t))
+			|| !_tc_export_resize((void **)&columns->ends,newCapacity,sizeof(int64_t))
+			|| !_tc_export_resize((void **)&columns->states,newCapacity,sizeof(uint32_t))){
+			columns->failed = TRUE;
+			return FALSE;
+		}
+		columns->intervalCapacity = newCapacity;
+	}
+	columns->taskIds[columns->intervalCount] = columns->taskId;
+	columns->starts[columns->intervalCount] = start;
+	columns->ends[columns->intervalCount] = end;
+	columns->states[columns->intervalCount] = state;
+	++columns->intervalCount;
+	return TRUE;
+}
+
+static void _tc_export_seq_record(int seqNum, int seqState, time_t seqTime, void * data){
+	/* Same pairing rule as _tc_task_read: a STARTED record is closed by the next PAUSED or FINISHED */
+	struct tc_export_columns * columns = data;
+	(void)seqNum;
+
+	if(columns->priorState == TC_TASK_STARTED && (seqState == TC_TASK_PAUSED || seqState == TC_TASK_FINISHED))
+		_tc_export_push_interval(columns,columns->priorTime,seqTime,seqState);
+
+	if(seqState == TC_TASK_STARTED && columns->priorState == TC_TASK_STARTED)
+		return; /* A repeated start keeps the original start time */
+	columns->priorState = seqState;
+	columns->priorTime = seqTime;
+}
+
+static int _tc_export_add_task(struct tc_export_columns * columns, char const * taskName){
+	size_t nameLength = strlen(taskName) + 1;
+
+	if(!_tc_export_grow((void **)&columns->nameOffsets,&columns->taskCapacity,columns->taskCount+1,sizeof(uint32_t))
+		|| !_tc_export_grow((void **)&columns->names,&columns->namesCapacity,columns->namesSize+nameLength,sizeof(char))){
+		columns->failed = TRUE;
+		return FALSE;
+	}
+	columns->nameOffsets[columns->taskCount] = columns->namesSize;
+	memcpy(columns->names + columns->namesSize, taskName, nameLength);
+	columns->namesSize += nameLength;
+	columns->taskId = columns->taskCount++;
+	return TRUE;
+}
+
+static void _tc_export_task(const char * taskHash, const char * taskName, void * data){
+	/* Replay one task, appending its intervals to the columns */
+	struct tc_export_columns * columns = data;
+
+	if(columns->failed || !_tc_export_add_task(columns,taskName))
+		return;
+
+	columns->priorState = 0;
+	columns->priorTime = 0;
+	if(columns->store->ops->history(columns->store,taskHash,_tc_export_seq_record,columns) < 0)
+		fprintf(stderr, "Could not open the sequence file for task %s\n", taskName);
+	else if(columns->priorState == TC_TASK_STARTED)
+		_tc_export_push_interval(columns,columns->priorTime,columns->exportTime,TC_TASK_STARTED);
+}
+
+int _tc_export_collect(struct tc_store * store, struct tc_export_columns * columns){
+	/* Replay every task once, appending its intervals to the columns */
+	columns->store = store;
+	if(store->ops->list(store,_tc_export_task,columns) < 0){
+		fprintf(stderr, "%s\n", "Could not open task directory for file listing");
+		return FALSE;
+	}
+
+	if(columns->failed)
+		fprintf(stderr, "%s\n", "Could not allocate memory for the export.");
+	return !columns->failed;
+}
+
+static int _tc_export_write_section(FILE * fp, const void * array, size_t count, size_t elemSize, size_t * offset){
+	/* Pad up to the section's alignment then write the array */
+	static const char padding[TC_COLUMNAR_ALIGN] = {0};
+	size_t aligned = _tc_columnar_align(*offset);
+
+	if(aligned != *offset && fwrite(padding,1,aligned - *offset,fp) != aligned - *offset)
+		return FALSE;
+	if(count > 0 && fwrite(array,elemSize,count,fp) != count)
+		return FALSE;
+	*offset = aligned + count*elemSize;
+	return TRUE;
+}
+
+int _tc_export_write(char const * exportPath, struct tc_export_columns * columns){
+	struct tc_columnar_header header;
+	struct tc_columnar_section sections[TC_COLUMNAR_SECTIONS];
+	const char * names[TC_COLUMNAR_SECTIONS];
+	const void * arrays[TC_COLUMNAR_SECTIONS];
+	size_t counts[TC_COLUMNAR_SECTIONS];
+	size_t sizes[TC_COLUMNAR_SECTIONS];
+	char * tempPath;
+	size_t offset;
+	FILE * fp;
+	int i, success;
+
+	names[0] = TC_COLUMNAR_SEC_TASKID;	arrays[0] = columns->taskIds;		counts[0] = columns->intervalCount;	sizes[0] = sizeof(uint32_t);
+	names[1] = TC_COLUMNAR_SEC_START;	arrays[1] = columns->starts;		counts[1] = columns->intervalCount;	sizes[1] = sizeof(int64_t);
+	names[2] = TC_COLUMNAR_SEC_END;		arrays[2] = columns->ends;		counts[2] = columns->intervalCount;	sizes[2] = sizeof(int64_t);
+	names[3] = TC_COLUMNAR_SEC_STATE;	arrays[3] = columns->states;		counts[3] = columns->intervalCount;	sizes[3] = sizeof(uint32_t);
+	names[4] = TC_COLUMNAR_SEC_NAMEOFF;	arrays[4] = columns->nameOffsets;	counts[4] = columns->taskCount;		sizes[4] = sizeof(uint32_t);
+	names[5] = TC_COLUMNAR_SEC_NAMES;	arrays[5] = columns->names;		counts[5] = columns->namesSize;		sizes[5] = sizeof(char);
+
+	memset(&header,0,sizeof(header));
+	memcpy(header.magic,TC_COLUMNAR_MAGIC,sizeof(header.magic));
+	header.version = TC_COLUMNAR_VERSION;
+	header.byteOrder = TC_COLUMNAR_BYTE_ORDER;
+	header.sectionCount = TC_COLUMNAR_SECTIONS;
+	header.exportTime = columns->exportTime;
+
+	/* Lay the sections out back to back after the directory */
+	memset(sections,0,sizeof(sections));
+	offset = sizeof(header) + sizeof(sections);
+	for(i = 0; i < TC_COLUMNAR_SECTIONS; ++i){
+		offset = _tc_columnar_align(offset);
+		strncpy(sections[i].name,names[i],sizeof(sections[i].name));
+		sections[i].offset = offset;
+		sections[i].count = counts[i];
+		sections[i].elemSize = sizes[i];
+		offset += counts[i]*sizes[i];
+	}
+
+	/* Write next to the target and rename so a reader never maps half a
+	 * file. The path is the user's, so its length is whatever they gave */
+	if((tempPath = malloc(strlen(exportPath) + 5)) == NULL){
+		fprintf(stderr, "%s\n", "Could not allocate memory for the export.");
+		return FALSE;
+	}
+	sprintf(tempPath,"%s.tmp",exportPath);
+	fp = fopen(tempPath,"wb");
+	if(!fp){
+		fprintf(stderr, "%s\n", "Could not create the export file. Please check permissions");
+		free(tempPath);
+		return FALSE;
+	}
+
+	success = fwrite(&header,sizeof(header),1,fp) == 1 && fwrite(sections,sizeof(sections),1,fp) == 1;
+	offset = sizeof(header) + sizeof(sections);
+	for(i = 0; success && i < TC_COLUMNAR_SECTIONS; ++i)
+		success = _tc_export_write_section(fp,arrays[i],counts[i],sizes[i],&offset);
+
+	if(fclose(fp) != 0)
+		success = FALSE;
+	if(!success || rename(tempPath,exportPath) == -1){
+		fprintf(stderr, "%s\n", "Could not write the export file.");
+		remove(tempPath);
+		free(tempPath);
+		return FALSE;
+	}
+	free(tempPath);
+	return TRUE;
+}
+
+void _tc_export_columnar(char * tcHomeDirectory, char const * exportPath){
+	struct tc_export_columns columns;
+	struct tc_store * store;
+
+	if(_tc_store_open_directory(&store,tcHomeDirectory) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not open the .tc directory. Please check permissions");
+		return;
+	}
+
+	memset(&columns,0,sizeof(columns));
+	columns.exportTime = time(0);
+
+	if(_tc_export_collect(store,&columns) && _tc_export_write(exportPath,&columns))
+		fprintf(stdout, "Exported %lu intervals from %lu tasks to %s\n", (unsigned long)columns.intervalCount, (unsigned long)columns.taskCount, exportPath);
+
+	free(columns.taskIds);
+	free(columns.starts);
+	free(columns.ends);
+	free(columns.states);
+	free(columns.nameOffsets);
+	free(columns.names);
+	_tc_store_close(store);
+}
+
+void _tc_export_dump(char const * exportPath){
+	/* Print a columnar file back out through the reader, one interval per line */
+	struct tc_columnar columns;
+	uint64_t i;
+	const char * taskName;
+
+	if(!tc_columnar_open(exportPath,&columns)){
+		fprintf(stderr, "%s\n", "Could not read the columnar export file. Is it corrupt?");
+		return;
+	}
+
+	for(i = 0; i < columns.intervalCount; ++i){
+		taskName = tc_columnar_taskName(&columns,columns.taskIds[i]);
+		fprintf(stdout, "%s\t%ld\t%ld\t%s\n",
+			taskName == NULL ? "?" : taskName,
+			(long)columns.starts[i], (long)columns.ends[i],
+			_tc_stateToString(columns.states[i]));
+	}
+	fprintf(stdout, "%lu intervals from %lu tasks\n", (unsigned long)columns.intervalCount, (unsigned long)columns.taskCount);
+
+	tc_columnar_close(&columns);
+}
@@ -6,65 +6,29 @@
 #include <stdio.h>
 
 void tc_finish(int argc, char const * argv[]){
+	struct tc_context * context;
+	struct tc_status finished;
 	struct tc_task working_task;
-	struct tc_task currentTask; 
 	char taskName[TC_MAX_BUFF];
-	char tcHomeDirectory[TC_MAX_BUFF];
-	char currentTaskPath[TC_MAX_BUFF];
-	time_t rawtime;
-	time_t oldEndTime;
-
-	tc_init(tcHomeDirectory);
-
-	working_task.taskName = malloc(TC_MAX_BUFF*sizeof(char));
-	working_task.taskInfo = malloc(TC_MAX_BUFF*sizeof(char));
-
-	_resolve_taskName_from_args(argc,argv,taskName);
-
-	/* Check if there's a task */
-	_tc_task_read(taskName, &working_task);
-
-	if(working_task.state == TC_TASK_NOT_FOUND)
-		fprintf(stderr, "%s\n", "Could not find the task to finish");
-	else if(working_task.state == TC_TASK_FINISHED)
-		fprintf(stderr, "%s\n", "Task is already finished. To resume use the start -s command");
-	else{
-		/* Finish the task */
-		working_task.state = TC_TASK_FINISHED;
-		rawtime = time(0); 
-		if(rawtime == -1){
-			fprintf(stderr, "%s\n", "Could not determine time. Exiting");
-			free(working_task.taskInfo);
-			free(working_task.taskName);
-			exit(1);
-		}
-		oldEndTime = working_task.endTime;
-		working_task.endTime = rawtime;
-
-		/* Check the current task before the write.*/
-		currentTask.taskName = malloc(TC_MAX_BUFF*sizeof(char));
-		currentTask.taskInfo = malloc(TC_MAX_BUFF*sizeof(char));
-		
-		_find_current_task(&currentTask);
-		_tc_getCurrentTaskPath(currentTaskPath);
-
-		/* Save the task */
-		_tc_task_write(working_task, tcHomeDirectory);
-
-		/* Set the state and times so the finished task will display correctly*/
-		working_task.state = TC_TASK_STARTED;
-		working_task.endTime = oldEndTime;
+	char taskInfoPath[TC_MAX_BUFF];
+	int result;
+
+	context = _tc_cli_context();
+	_tc_cli_task_name(argc,argv,taskName);
+
+	result = tc_lib_finish(context,taskName,&finished);
+	if(result == TC_OK){
+		/* Show the finished task with the time worked up to now */
+		_tc_getTaskFilePath(taskInfoPath,tc_lib_root(context),finished.taskHash,TC_INFO_EXT);
+		working_task.taskName = finished.taskName;
+		working_task.taskInfo = taskInfoPath;
+		working_task.startTime = finished.startTime;
+		working_task.endTime = finished.lastUpdate;
+		working_task.pauseTime = finished.worked;
+		working_task.seqNum = finished.seqNum;
+		working_task.state = finished.state;
 		_tc_displayView(working_task,FALSE,TRUE);
-
-		/* If this task was the same as the current task, remove the current file */
-		if(strcmp(currentTask.taskName,working_task.taskName)==0)
-			remove(currentTaskPath); 
-
-		free(currentTask.taskName);
-		free(currentTask.taskInfo);
 	}
 
-
-	free(working_task.taskInfo);
-	free(working_task.taskName);
+	_tc_cli_done(context, result);
 }
@@ -0,0 +1,1097 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "tc-fsck.h"
+#include "tc-manifest.h"
+#include "tc-store.h"
+#include "tc-active.h"
+#include "tc-lock.h"
+#include "tc-init.h"
+#include "tc-project.h"
+#include "tc-counters.h"
+#include "tc-journal.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const struct tc_fsck_message {
+	int problem;
+	const char * text;
+} _tc_fsck_messages[] = {
+	{TC_FSCK_SEQ_MISSING, "has no sequence file"},
+	{TC_FSCK_SEQ_MALFORMED, "has malformed records in its sequence"},
+	{TC_FSCK_SEQ_NUMBERS, "has sequence numbers out of order"},
+	{TC_FSCK_SEQ_TIMES, "has events going back in time"},
+	{TC_FSCK_SEQ_STATES, "has state changes tcatch never makes"},
+	{TC_FSCK_INFO_MISSING, "has no name in an info file"},
+	{TC_FSCK_INFO_NAME, "has an info file whose name does not hash to it"},
+	{TC_FSCK_ARCHIVE, "can't be read back from its archive segment"},
+	{0, NULL}
+};
+
+void tc_fsck(int argc, char const *argv[]){
+	char tcHomeDirectory[TC_MAX_BUFF];
+
+	/* Usage has already been shown by the help check */
+	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
+		return;
+
+	tc_init(tcHomeDirectory);
+	if(_tc_fsck_run(tcHomeDirectory,_tc_args_flag_check(argc,argv,TC_REPAIR_LONG,TC_REPAIR_SHORT)) < 0)
+		fprintf(stderr, "%s\n", "Could not check the store. Please check permissions");
+}
+
+static int _tc_fsck_task_compare(const void * left, const void * right){
+	return strcmp(((const struct tc_fsck_task *)left)->taskHash,((const struct tc_fsck_task *)right)->taskHash);
+}
+
+static struct tc_fsck_task * _tc_fsck_lookup(struct tc_fsck * fsck, size_t count, char const * taskHash){
+	/* Binary search of the first count tasks, which are sorted */
+	struct tc_fsck_task key;
+
+	if(strlen(taskHash) >= sizeof(key.taskHash))
+		return NULL;
+	strcpy(key.taskHash,taskHash);
+	return bsearch(&key,fsck->tasks,count,sizeof(key),_tc_fsck_task_compare);
+}
+
+static struct tc_fsck_task * _tc_fsck_add(struct tc_fsck * fsck, char const * taskHash){
+	struct tc_fsck_task * grown;
+	size_t capacity;
+
+	if(fsck->taskCount == fsck->taskCapacity){
+		capacity = fsck->taskCapacity ? fsck->taskCapacity*2 : 256;
+		grown = realloc(fsck->tasks,capacity*sizeof(*grown));
+		if(grown == NULL)
+			return NULL;
+		fsck->tasks = grown;
+		fsck->taskCapacity = capacity;
+	}
+	grown = fsck->tasks + fsck->taskCount++;
+	memset(grown,0,sizeof(*grown));
+	strcpy(grown->taskHash,taskHash);
+	return grown;
+}
+
+static int _tc_fsck_scan_tasks(struct tc_fsck * fsck){
+	/* One readdir for every .seq and .info, paired up by hash */
+	char tasksDirectory[TC_MAX_BUFF*2];
+	struct dirent * dirEntry;
+	struct tc_fsck_task * task;
+	DIR * dirPointer;
+	char * extension;
+	size_t i, kept;
+
+	sprintf(tasksDirectory,"%s/%s",fsck->root,TC_TASK_DIR);
+	dirPointer = opendir(tasksDirectory);
+	if(dirPointer == NULL)
+		return FALSE;
+	while((dirEntry = readdir(dirPointer)) != NULL){
+		extension = strrchr(dirEntry->d_name,'.');
+		if(extension == NULL || extension == dirEntry->d_name || (size_t)(extension - dirEntry->d_name) >= sizeof(task->taskHash))
+			continue;
+		if(strcmp(extension + 1,TC_SEQ_EXT) != 0 && strcmp(extension + 1,TC_INFO_EXT) != 0)
+			continue;
+		*extension = '\0';
+		if((task = _tc_fsck_add(fsck,dirEntry->d_name)) == NULL){
+			closedir(dirPointer);
+			return FALSE;
+		}
+		if(strcmp(extension + 1,TC_SEQ_EXT) == 0)
+			task->hasSeq = TRUE;
+		else
+			task->hasInfo = TRUE;
+	}
+	closedir(dirPointer);
+
+	qsort(fsck->tasks,fsck->taskCount,sizeof(*fsck->tasks),_tc_fsck_task_compare);
+	for(kept = i = 0; i < fsck->taskCount; ++i){
+		if(kept > 0 && strcmp(fsck->tasks[kept-1].taskHash,fsck->tasks[i].taskHash) == 0){
+			fsck->tasks[kept-1].hasSeq |= fsck->tasks[i].hasSeq;
+			fsck->tasks[kept-1].hasInfo |= fsck->tasks[i].hasInfo;
+			continue;
+		}
+		fsck->tasks[kept++] = fsck->tasks[i];
+	}
+	fsck->taskCount = kept;
+	return TRUE;
+}
+
+static void _tc_fsck_keep_archived(struct tc_archive_entry * entry, void * data){
+	struct tc_fsck * fsck = data;
+	struct tc_archive_entry * grown;
+	size_t capacity;
+
+	if(fsck->archivedCapacity == (size_t)-1)
+		return;
+	if(fsck->archivedCount == fsck->archivedCapacity){
+		capacity = fsck->archivedCapacity ? fsck->archivedCapacity*2 : 64;
+		grown = realloc(fsck->archived,capacity*sizeof(*grown));
+		if(grown == NULL){
+			fsck->archivedCapacity = (size_t)-1;
+			return;
+		}
+		fsck->archived = grown;
+		fsck->archivedCapacity = capacity;
+	}
+	fsck->archived[fsck->archivedCount++] = *entry;
+}
+
+static int _tc_fsck_entry_compare(const void * left, const void * right){
+	/* By hash, and in index order for the same hash */
+	struct tc_archive_entry * const * a = left;
+	struct tc_archive_entry * const * b = right;
+	int order;
+
+	if((order = strcmp((*a)->taskHash,(*b)->taskHash)) != 0)
+		return order;
+	return *a < *b ? -1 : *a > *b;
+}
+
+static int _tc_fsck_scan_archive(struct tc_fsck * fsck){
+	/* The latest index line of every archived task that is not hot again */
+	struct tc_archive_entry ** entries;
+	struct tc_fsck_task * task;
+	size_t hotCount, i;
+
+	_tc_archive_each(fsck->root,_tc_fsck_keep_archived,fsck);
+	if(fsck->archivedCapacity == (size_t)-1)
+		return FALSE;
+	if(fsck->archivedCount == 0)
+		return TRUE;
+	if((entries = malloc(fsck->archivedCount*sizeof(*entries))) == NULL)
+		return FALSE;
+	for(i = 0; i < fsck->archivedCount; ++i)
+		entries[i] = fsck->archived + i;
+	qsort(entries,fsck->archivedCount,sizeof(*entries),_tc_fsck_entry_compare);
+
+	hotCount = fsck->taskCount;
+	for(i = 0; i < fsck->archivedCount; ++i){
+		if(i + 1 < fsck->archivedCount && strcmp(entries[i]->taskHash,entries[i+1]->taskHash) == 0)
+			continue;
+		if(_tc_fsck_lookup(fsck,hotCount,entries[i]->taskHash) != NULL)
+			continue;
+		if((task = _tc_fsck_add(fsck,entries[i]->taskHash)) == NULL){
+			free(entries);
+			return FALSE;
+		}
+		task->archived = entries[i];
+	}
+	free(entries);
+	qsort(fsck->tasks,fsck->taskCount,sizeof(*fsck->tasks),_tc_fsck_task_compare);
+	return TRUE;
+}
+
+static size_t _tc_fsck_days_slot(struct tc_fsck_days * days, int32_t day){
+	size_t slot;
+
+	slot = ((uint32_t)day * 2654435761u) & (days->capacity - 1);
+	while(days->days[slot] != 0 && days->days[slot] != day)
+		slot = (slot + 1) & (days->capacity - 1);
+	return slot;
+}
+
+static int _tc_fsck_days_add(struct tc_fsck_days * days, int32_t day, long count){
+	struct tc_fsck_days grown;
+	size_t slot, i;
+
+	if((days->count + 1)*2 > days->capacity){
+		grown.capacity = days->capacity ? days->capacity*2 : 256;
+		grown.count = days->count;
+		grown.days = calloc(grown.capacity,sizeof(*grown.days));
+		grown.counts = calloc(grown.capacity,sizeof(*grown.counts));
+		if(grown.days == NULL || grown.counts == NULL){
+			free(grown.days);
+			free(grown.counts);
+			return FALSE;
+		}
+		for(i = 0; i < days->capacity; ++i)
+			if(days->days[i] != 0){
+				slot = _tc_fsck_days_slot(&grown,days->days[i]);
+				grown.days[slot] = days->days[i];
+				grown.counts[slot] = days->counts[i];
+			}
+		free(days->days);
+		free(days->counts);
+		*days = grown;
+	}
+	slot = _tc_fsck_days_slot(days,day);
+	if(days->days[slot] == 0){
+		days->days[slot] = day;
+		++days->count;
+	}
+	days->counts[slot] += count;
+	return TRUE;
+}
+
+static int32_t _tc_fsck_day(struct tc_fsck_worker * worker, time_t eventTime){
+	/* The local YYYYMMDD an event's index entry went to, 0 if there is none.
+	 * Events come in runs on the same day, so the day is kept along with
+	 * a span that lies inside it whatever daylight saving does to the clock.
+	*/
+	struct tm timeinfo;
+	long sinceMidnight;
+
+	if(worker->dayFrom <= eventTime && eventTime <= worker->dayTo)
+		return worker->day;
+	if(localtime_r(&eventTime,&timeinfo) == NULL)
+		return 0;
+	sinceMidnight = timeinfo.tm_hour*3600L + timeinfo.tm_min*60L + timeinfo.tm_sec;
+	worker->day = (timeinfo.tm_year + 1900)*10000 + (timeinfo.tm_mon + 1)*100 + timeinfo.tm_mday;
+	worker->dayFrom = eventTime - sinceMidnight + 3600;
+	worker->dayTo = eventTime - sinceMidnight + 86400 - 3600 - 1;
+	return worker->day;
+}
+
+int _tc_fsck_transition(int from, int to){
+	/* The moves tcatch makes: a task is started, paused or finished, and started again */
+	switch(from){
+		case TC_TASK_NOT_FOUND:
+			return to == TC_TASK_STARTED;
+		case TC_TASK_STARTED:
+			return to == TC_TASK_PAUSED || to == TC_TASK_FINISHED;
+		case TC_TASK_PAUSED:
+			return to == TC_TASK_STARTED || to == TC_TASK_FINISHED;
+		case TC_TASK_FINISHED:
+			return to == TC_TASK_STARTED;
+	}
+	return FALSE;
+}
+
+/* One task being replayed by a worker */
+struct tc_fsck_replay {
+	struct tc_fsck_worker * worker;
+	struct tc_fsck_task * task;
+	uint32_t taskIndex;
+	int lastState;
+	time_t lastTime;
+};
+
+static int _tc_fsck_event_add(struct tc_fsck_worker * worker, struct tc_fsck_event * event){
+	struct tc_fsck_event * grown;
+	size_t capacity;
+
+	if(worker->eventCount == worker->eventCapacity){
+		capacity = worker->eventCapacity ? worker->eventCapacity*2 : 1024;
+		grown = realloc(worker->events,capacity*sizeof(*grown));
+		if(grown == NULL)
+			return FALSE;
+		worker->events = grown;
+		worker->eventCapacity = capacity;
+	}
+	worker->events[worker->eventCount++] = *event;
+	return TRUE;
+}
+
+static void _tc_fsck_record(int seqNum, int seqState, time_t seqTime, void * data){
+	struct tc_fsck_replay * replay = data;
+	struct tc_fsck_task * task = replay->task;
+	struct tc_fsck_worker * worker = replay->worker;
+	struct tc_fsck_event event;
+	int32_t day;
+
+	if(seqNum != task->records)
+		task->problems |= TC_FSCK_SEQ_NUMBERS;
+	if(task->records > 0 && seqTime < replay->lastTime)
+		task->problems |= TC_FSCK_SEQ_TIMES;
+	if(_tc_fsck_transition(replay->lastState,seqState) == FALSE)
+		task->problems |= TC_FSCK_SEQ_STATES;
+	/* A closed interval is a session of the day it closed on */
+	if(task->summary.state == TC_TASK_STARTED && (seqState == TC_TASK_PAUSED || seqState == TC_TASK_FINISHED)
+		&& worker->failed == FALSE && (day = _tc_fsck_day(worker,seqTime)) != 0
+		&& _tc_sessions_add(&worker->sessions,day,(long)(seqTime - task->summary.lastStart),1) != TC_OK)
+		worker->failed = TRUE;
+	_tc_task_summary_record(seqNum,seqState,seqTime,&task->summary);
+	replay->lastState = seqState;
+	replay->lastTime = seqTime;
+	++task->records;
+
+	/* Every event wrote one index entry, on its local day */
+	if(worker->failed || (day = _tc_fsck_day(worker,seqTime)) == 0)
+		return;
+	if(worker->fsck->repair == FALSE){
+		if(_tc_fsck_days_add(&worker->days,day,1) == FALSE)
+			worker->failed = TRUE;
+		return;
+	}
+	event.task = replay->taskIndex;
+	event.state = seqState;
+	event.day = day;
+	event.seqNum = seqNum;
+	event.eventTime = seqTime;
+	if(_tc_fsck_event_add(worker,&event) == FALSE)
+		worker->failed = TRUE;
+}
+
+static long _tc_fsck_lines(const char * text, size_t length){
+	/* Lines with anything but blanks on them */
+	long lines;
+	int blank;
+	size_t i;
+
+	lines = 0;
+	blank = TRUE;
+	for(i = 0; i < length; ++i){
+		if(text[i] == '\n'){
+			lines += !blank;
+			blank = TRUE;
+		}else if(!isspace((unsigned char)text[i])){
+			blank = FALSE;
+		}
+	}
+	return lines + !blank;
+}
+
+static void _tc_fsck_name_check(struct tc_fsck_task * task){
+	char taskHash[TC_MAX_BUFF];
+
+	if(task->taskName[0] == '\0'){
+		task->problems |= TC_FSCK_INFO_MISSING;
+		return;
+	}
+	_tc_taskName_to_Hash(task->taskName,taskHash);
+	if(strcmp(taskHash,task->taskHash) != 0)
+		task->problems |= TC_FSCK_INFO_NAME;
+}
+
+static char * _tc_fsck_read(struct tc_fsck_worker * worker, char const * path, size_t * size){
+	/* The whole file in the worker's buffer, NULL if it can't be read */
+	struct stat status;
+	size_t capacity;
+	ssize_t got;
+	char * grown;
+	int fd;
+
+	if((fd = open(path,O_RDONLY)) == -1)
+		return NULL;
+	if(fstat(fd,&status) != 0){
+		close(fd);
+		return NULL;
+	}
+	if((size_t)status.st_size >= worker->bufferCapacity){
+		capacity = (size_t)status.st_size + 1 > 65536 ? (size_t)status.st_size + 1 : 65536;
+		if((grown = realloc(worker->buffer,capacity)) == NULL){
+			close(fd);
+			worker->failed = TRUE;
+			return NULL;
+		}
+		worker->buffer = grown;
+		worker->bufferCapacity = capacity;
+	}
+	for(*size = 0; *size < (size_t)status.st_size; *size += got)
+		if((got = read(fd,worker->buffer + *size,(size_t)status.st_size - *size)) <= 0)
+			break;
+	close(fd);
+	return worker->buffer;
+}
+
+static void _tc_fsck_check(struct tc_fsck_worker * worker, size_t index){
+	/* Replay one task, from the tasks directory or its archive segment */
+	struct tc_fsck * fsck = worker->fsck;
+	struct tc_fsck_task * task = fsck->tasks + index;
+	struct tc_fsck_replay replay;
+	char path[TC_MAX_BUFF*2];
+	char * text, * raw, * info;
+	size_t size, nameLength;
+
+	replay.worker = worker;
+	replay.task = task;
+	replay.taskIndex = (uint32_t)index;
+	replay.lastState = TC_TASK_NOT_FOUND;
+	replay.lastTime = 0;
+	_tc_task_summary_init(&task->summary);
+
+	raw = NULL;
+	if(task->archived != NULL){
+		if((raw = _tc_archive_unpack(fsck->root,task->archived)) == NULL){
+			task->problems |= TC_FSCK_ARCHIVE;
+			return;
+		}
+		text = raw;
+		size = task->archived->seqSize;
+		info = raw + size;
+		nameLength = strcspn(info,"\n");
+		if(nameLength >= TC_MAX_BUFF)
+			nameLength = TC_MAX_BUFF - 1;
+		memcpy(task->taskName,info,nameLength);
+		task->taskName[nameLength] = '\0';
+		_tc_fsck_name_check(task);
+	}else{
+		_tc_getTaskFilePath(path,fsck->root,task->taskHash,TC_INFO_EXT);
+		if(task->hasInfo == FALSE || _tc_task_name_from_info(path,task->taskName) == FALSE)
+			task->taskName[0] = '\0';
+		_tc_fsck_name_check(task);
+
+		_tc_getTaskFilePath(path,fsck->root,task->taskHash,TC_SEQ_EXT);
+		if(task->hasSeq == FALSE || (text = _tc_fsck_read(worker,path,&size)) == NULL){
+			task->problems |= TC_FSCK_SEQ_MISSING;
+			return;
+		}
+	}
+
+	if(_tc_seq_parse(text,size,_tc_fsck_record,&replay) != _tc_fsck_lines(text,size))
+		task->problems |= TC_FSCK_SEQ_MALFORMED;
+	free(raw);
+}
+
+static void * _tc_fsck_work(void * data){
+	/* Take chunks of tasks off the shared list until there are none left */
+	struct tc_fsck_worker * worker = data;
+	struct tc_fsck * fsck = worker->fsck;
+	size_t first, last;
+
+	while(worker->failed == FALSE){
+		pthread_mutex_lock(&fsck->lock);
+		first = fsck->next;
+		last = fsck->taskCount - first > TC_FSCK_CHUNK ? first + TC_FSCK_CHUNK : fsck->taskCount;
+		fsck->next = last;
+		pthread_mutex_unlock(&fsck->lock);
+		if(first == last)
+			break;
+		for(; first < last; ++first)
+			_tc_fsck_check(worker,first);
+	}
+	return NULL;
+}
+
+static int _tc_fsck_threads(struct tc_fsck * fsck){
+	/* A worker per core, but never more than there are chunks of tasks */
+	long threads;
+	size_t chunks;
+
+	threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if(threads < 1)
+		threads = 1;
+	if(threads > TC_FSCK_THREADS_MAX)
+		threads = TC_FSCK_THREADS_MAX;
+	chunks = (fsck->taskCount + TC_FSCK_CHUNK - 1)/TC_FSCK_CHUNK;
+	if((size_t)threads > chunks)
+		threads = chunks > 0 ? (long)chunks : 1;
+	return (int)threads;
+}
+
+static void _tc_fsck_found(struct tc_fsck * fsck, int repaired, char const * format, ...){
+	/* Print one problem with the store, saying whether it was repaired */
+	va_list args;
+
+	va_start(args,format);
+	vfprintf(stdout, format, args);
+	va_end(args);
+	fprintf(stdout, "%s\n", repaired ? ", repaired" : "");
+	++fsck->problems;
+	if(repaired)
+		++fsck->repaired;
+}
+
+static void _tc_fsck_offer(struct tc_fsck * fsck, char const * claimedHash, char const * taskName){
+	/* A name seen somewhere in the store, kept for a task whose info lost its name */
+	struct tc_fsck_task * task;
+	char taskHash[TC_MAX_BUFF];
+
+	if(taskName[0] == '\0' || strlen(taskName) >= TC_MAX_BUFF)
+		return;
+	if(claimedHash != NULL && ((task = _tc_fsck_lookup(fsck,fsck->taskCount,claimedHash)) == NULL
+		|| task->archived != NULL || (task->problems & (TC_FSCK_INFO_MISSING|TC_FSCK_INFO_NAME)) == 0 || task->repaired))
+		return;
+	_tc_taskName_to_Hash((char *)taskName,taskHash);
+	task = _tc_fsck_lookup(fsck,fsck->taskCount,taskHash);
+	if(task == NULL || task->archived != NULL || (task->problems & (TC_FSCK_INFO_MISSING|TC_FSCK_INFO_NAME)) == 0 || task->repaired)
+		return;
+	strcpy(task->taskName,taskName);
+	task->repaired = task->problems & (TC_FSCK_INFO_MISSING|TC_FSCK_INFO_NAME);
+}
+
+static void _tc_fsck_offer_index(struct tc_fsck * fsck){
+	/* Index entries carry "<hash> <name> <state>", a name may have spaces */
+	struct tc_manifest manifest;
+	char segmentPath[TC_MAX_BUFF*2];
+	char line[TC_MAX_BUFF*2];
+	char * nameAt, * stateAt;
+	size_t i;
+	FILE * fp;
+
+	if(_tc_manifest_load(fsck->root,&manifest) != TC_OK)
+		return;
+	for(i = 0; i < manifest.count; ++i){
+		_tc_manifest_segment_path(&manifest,manifest.segments + i,segmentPath);
+		if((fp = fopen(segmentPath,"r")) == NULL)
+			continue;
+		while(fgets(line,sizeof(line),fp) != NULL){
+			line[strcspn(line,"\n")] = '\0';
+			if((nameAt = strchr(line,' ')) == NULL || (stateAt = strrchr(line,' ')) == nameAt)
+				continue;
+			*nameAt++ = '\0';
+			*stateAt = '\0';
+			_tc_fsck_offer(fsck,line,nameAt);
+		}
+		fclose(fp);
+	}
+	_tc_manifest_free(&manifest);
+}
+
+static int _tc_fsck_rewrite_info(struct tc_fsck * fsck, struct tc_fsck_task * task){
+	/* Put the name back on the first line, keeping the text added after it */
+	char taskInfoPath[TC_MAX_BUFF*2];
+	char taskInfoTempPath[TC_MAX_BUFF*2+8];
+	char buffer[8192];
+	size_t read;
+	FILE * in, * out;
+	int lock, c, result;
+
+	_tc_getTaskFilePath(taskInfoPath,fsck->root,task->taskHash,TC_INFO_EXT);
+	sprintf(taskInfoTempPath,"%s.tmp",taskInfoPath);
+	lock = _tc_lock_acquire(fsck->root,task->taskHash);
+	if(lock == -1 || (out = fopen(taskInfoTempPath,"w")) == NULL){
+		_tc_lock_release(lock);
+		return FALSE;
+	}
+	fprintf(out, "%s\n", task->taskName);
+	if((in = fopen(taskInfoPath,"r")) != NULL){
+		while((c = getc(in)) != EOF && c != '\n')
+			;
+		while((read = fread(buffer,1,sizeof(buffer),in)) > 0)
+			fwrite(buffer,1,read,out);
+		fclose(in);
+	}
+	result = ferror(out) == 0;
+	if(fclose(out) != 0 || result == FALSE || rename(taskInfoTempPath,taskInfoPath) != 0){
+		remove(taskInfoTempPath);
+		result = FALSE;
+	}
+	_tc_lock_release(lock);
+	return result;
+}
+
+static void _tc_fsck_repair_names(struct tc_fsck * fsck, struct tc_active_slot slots[], int slotCount){
+	/* A lost name is looked for wherever else the store wrote it down, and
+	 * only a name that hashes to the task's own file name is taken. */
+	char currentTaskName[TC_MAX_BUFF];
+	size_t i;
+	int j;
+
+	for(j = 0; j < slotCount; ++j)
+		_tc_fsck_offer(fsck,slots[j].taskHash,slots[j].taskName);
+	_tc_current_task_name(fsck->root,currentTaskName);
+	_tc_fsck_offer(fsck,NULL,currentTaskName);
+	for(i = 0; i < fsck->archivedCount; ++i)
+		_tc_fsck_offer(fsck,fsck->archived[i].taskHash,fsck->archived[i].taskName);
+	_tc_fsck_offer_index(fsck);
+
+	for(i = 0; i < fsck->taskCount; ++i)
+		if(fsck->tasks[i].repaired && _tc_fsck_rewrite_info(fsck,fsck->tasks + i) == FALSE)
+			fsck->tasks[i].repaired = 0;
+}
+
+static void _tc_fsck_report_tasks(struct tc_fsck * fsck){
+	struct tc_fsck_task * task;
+	const struct tc_fsck_message * message;
+	size_t i;
+
+	for(i = 0; i < fsck->taskCount; ++i){
+		task = fsck->tasks + i;
+		for(message = _tc_fsck_messages; message->problem != 0; ++message){
+			if((task->problems & message->problem) == 0)
+				continue;
+			fprintf(stdout, "Task %s%s %s%s\n", task->taskHash, task->archived ? " (archived)" : "",
+				message->text, task->repaired & message->problem ? ", repaired" : "");
+			++fsck->problems;
+			if(task->repaired & message->problem)
+				++fsck->repaired;
+		}
+	}
+}
+
+static struct tc_fsck_task * _tc_fsck_running(struct tc_fsck * fsck, char const * taskHash){
+	/* The hot task with that hash if its history leaves it started */
+	struct tc_fsck_task * task;
+
+	task = _tc_fsck_lookup(fsck,fsck->taskCount,taskHash);
+	if(task == NULL || task->archived != NULL || task->summary.state != TC_TASK_STARTED)
+		return NULL;
+	return task;
+}
+
+static void _tc_fsck_current(struct tc_fsck * fsck, struct tc_store * store){
+	/* current names the running task and repeats its last event */
+	char currentTaskPath[TC_MAX_BUFF*2];
+	char currentTaskName[TC_MAX_BUFF];
+	char line[TC_MAX_BUFF];
+	char storedHash[TC_MAX_BUFF];
+	char taskHash[TC_MAX_BUFF];
+	struct tc_fsck_task * task;
+	struct tc_current current;
+	int seqNum, state, fields, taskLock, currentLock, repaired;
+	long eventTime;
+	FILE * fp;
+
+	sprintf(currentTaskPath,"%s/%s",fsck->root,TC_CURRENT_TASK);
+	if((fp = fopen(currentTaskPath,"r")) == NULL)
+		return;
+	currentTaskName[0] = storedHash[0] = '\0';
+	fields = 0;
+	if(fgets(currentTaskName,sizeof(currentTaskName),fp) != NULL && fgets(storedHash,sizeof(storedHash),fp) != NULL
+		&& fgets(line,sizeof(line),fp) != NULL)
+		fields = sscanf(line,"%d %d %ld",&seqNum,&state,&eventTime);
+	fclose(fp);
+	currentTaskName[strcspn(currentTaskName,"\n")] = '\0';
+	storedHash[strcspn(storedHash,"\n")] = '\0';
+
+	_tc_taskName_to_Hash(currentTaskName,taskHash);
+	task = currentTaskName[0] ? _tc_fsck_running(fsck,taskHash) : NULL;
+	/* A record still in step with the .seq file is read instead of it, so
+	 * it has to agree with the history too. A stale one is only replayed */
+	if(task != NULL && fields == 3 && strcmp(storedHash,taskHash) == 0 && seqNum == task->summary.seqNum - 1
+		&& state == TC_TASK_STARTED && (time_t)eventTime == task->summary.lastTime
+		&& (_tc_current_read(fsck->root,&current) == FALSE || (current.summary.startTime == task->summary.startTime
+			&& current.summary.lastStart == task->summary.lastStart && current.summary.accumulated == task->summary.accumulated)))
+		return;
+
+	repaired = FALSE;
+	if(fsck->repair){
+		taskLock = _tc_lock_acquire(fsck->root,taskHash);
+		currentLock = _tc_lock_current(fsck->root);
+		if(taskLock == -1 || currentLock == -1)
+			repaired = FALSE;
+		else if(task == NULL)
+			repaired = store->ops->current_clear(store) == TC_OK;
+		else
+			repaired = store->ops->current_set(store,currentTaskName,taskHash,&task->summary) == TC_OK;
+		_tc_lock_release(currentLock);
+		_tc_lock_release(taskLock);
+	}
+	if(task == NULL)
+		_tc_fsck_found(fsck,repaired,"Current names \"%s\", which is not running",currentTaskName);
+	else
+		_tc_fsck_found(fsck,repaired,"Current is out of step with the history of \"%s\"",currentTaskName);
+}
+
+static void _tc_fsck_active(struct tc_fsck * fsck, struct tc_store * store, struct tc_active_slot slots[], int slotCount){
+	/* Every timer in the table is a running task and agrees with its history */
+	struct tc_active_slot rebuilt;
+	struct tc_fsck_task * task;
+	int i, lock, repaired;
+
+	for(i = 0; i < slotCount; ++i){
+		task = _tc_fsck_running(fsck,slots[i].taskHash);
+		if(task != NULL && slots[i].seqNum == task->summary.seqNum && slots[i].startTime == task->summary.startTime
+			&& slots[i].lastStart == task->summary.lastStart && slots[i].accumulated == task->summary.accumulated
+			&& strcmp(slots[i].taskName,task->taskName) == 0)
+			continue;
+
+		repaired = FALSE;
+		if(fsck->repair){
+			lock = _tc_lock_acquire(fsck->root,slots[i].taskHash);
+			repaired = lock != -1 && store->ops->active_remove(store,slots[i].taskHash) == TRUE;
+			if(repaired && task != NULL){
+				memset(&rebuilt,0,sizeof(rebuilt));
+				strcpy(rebuilt.taskHash,task->taskHash);
+				strcpy(rebuilt.taskName,task->taskName);
+				rebuilt.seqNum = task->summary.seqNum;
+				rebuilt.startTime = task->summary.startTime;
+				rebuilt.lastStart = task->summary.lastStart;
+				rebuilt.accumulated = task->summary.accumulated;
+				repaired = store->ops->active_insert(store,&rebuilt) == TC_OK;
+			}
+			_tc_lock_release(lock);
+		}
+		if(task == NULL)
+			_tc_fsck_found(fsck,repaired,"The timer table holds \"%s\", which is not running",slots[i].taskName);
+		else
+			_tc_fsck_found(fsck,repaired,"The timer of \"%s\" is out of step with its history",slots[i].taskName);
+	}
+}
+
+static int _tc_fsck_event_compare(const void * left, const void * right){
+	/* In the order the events were written: by time, then task and number */
+	const struct tc_fsck_event * a = left;
+	const struct tc_fsck_event * b = right;
+
+	if(a->eventTime != b->eventTime)
+		return a->eventTime < b->eventTime ? -1 : 1;
+	if(a->task != b->task)
+		return a->task < b->task ? -1 : 1;
+	return (a->seqNum > b->seqNum) - (a->seqNum < b->seqNum);
+}
+
+static int _tc_fsck_reindex(struct tc_fsck * fsck, struct tc_manifest * manifest, struct tc_fsck_event * events, size_t count){
+	/* Write every index entry again from the histories, in time order */
+	struct tc_fsck_task * task;
+	char date[16];
+	size_t i;
+	int result;
+
+	if((result = _tc_manifest_reset(manifest)) != TC_OK)
+		return result;
+	for(i = 0; i < count && result == TC_OK; ++i){
+		task = fsck->tasks + events[i].task;
+		sprintf(date,"%08ld",(long)events[i].day);
+		result = _tc_manifest_write(manifest,date,task->taskHash,task->taskName[0] ? task->taskName : task->taskHash,events[i].state);
+	}
+	_tc_manifest_prune(manifest);
+	return result;
+}
+
+static int _tc_fsck_journal(struct tc_fsck * fsck, struct tc_fsck_event * events, size_t count, int fixable){
+	/* A record for every event of the histories, rewritten in time order */
+	struct tc_journal journal;
+	char journalPath[TC_MAX_BUFF*2];
+	long expected, stored;
+	size_t i;
+	int result;
+
+	for(expected = 0, i = 0; i < fsck->taskCount; ++i)
+		expected += fsck->tasks[i].records;
+	stored = _tc_journal_count(fsck->root);
+	if(stored == -1)
+		_tc_fsck_found(fsck,fixable,"%s","The journal can't be read");
+	else if(stored != expected)
+		_tc_fsck_found(fsck,fixable,"The journal has %ld events, the histories have %ld",stored,expected);
+	if(fixable == FALSE || stored == expected)
+		return TRUE;
+
+	if(_tc_journal_begin(fsck->root,&journal) != TC_OK){
+		/* A journal from another machine is started over */
+		sprintf(journalPath,"%s/%s",fsck->root,TC_JOURNAL_FILE);
+		remove(journalPath);
+		if(_tc_journal_begin(fsck->root,&journal) != TC_OK)
+			return FALSE;
+	}
+	result = _tc_journal_reset(&journal);
+	for(i = 0; i < count && result == TC_OK; ++i)
+		result = _tc_journal_write(&journal,events[i].eventTime,fsck->tasks[events[i].task].taskHash,events[i].state,events[i].seqNum);
+	if(_tc_journal_commit(&journal) != TC_OK && result == TC_OK)
+		result = TC_ERR_IO;
+	if(result == TC_OK)
+		fprintf(stdout, "Rewrote %lu journal records\n", (unsigned long)count);
+	return result == TC_OK;
+}
+
+static int _tc_fsck_indexes(struct tc_fsck * fsck, struct tc_fsck_worker * workers, int threads){
+	/* The entries the histories imply, per segment, against the manifest and the files */
+	struct tc_fsck_days days;
+	struct tc_fsck_event * events;
+	struct tc_manifest manifest;
+	struct stat status;
+	char segmentPath[TC_MAX_BUFF*2];
+	char date[16];
+	size_t count, position, i;
+	long * expected;
+	unsigned long problems;
+	int t, found, result, fixable;
+
+	memset(&days,0,sizeof(days));
+	events = NULL;
+	count = 0;
+	result = TRUE;
+	for(t = 0; t < threads && result; ++t){
+		for(i = 0; i < workers[t].days.capacity && result; ++i)
+			if(workers[t].days.days[i] != 0)
+				result = _tc_fsck_days_add(&days,workers[t].days.days[i],workers[t].days.counts[i]);
+		count += workers[t].eventCount;
+	}
+	if(result && fsck->repair && count > 0){
+		if((events = malloc(count*sizeof(*events))) == NULL)
+			result = FALSE;
+		for(count = 0, t = 0; t < threads && events; ++t){
+			memcpy(events + count,workers[t].events,workers[t].eventCount*sizeof(*events));
+			count += workers[t].eventCount;
+		}
+		if(events)
+			qsort(events,count,sizeof(*events),_tc_fsck_event_compare);
+		for(i = 0; i < count && result; ++i)
+			result = _tc_fsck_days_add(&days,events[i].day,1);
+	}
+	if(result == FALSE || (fsck->repair ? _tc_manifest_begin(fsck->root,&manifest) : _tc_manifest_load(fsck->root,&manifest)) != TC_OK){
+		free(days.days);
+		free(days.counts);
+		free(events);
+		return FALSE;
+	}
+
+	/* Entries of an archived task that can't be read would be lost by a rewrite */
+	fixable = fsck->repair;
+	for(i = 0; i < fsck->taskCount; ++i)
+		if(fsck->tasks[i].problems & TC_FSCK_ARCHIVE)
+			fixable = FALSE;
+
+	problems = fsck->problems;
+	expected = calloc(manifest.count + 1,sizeof(*expected));
+	for(i = 0; i < days.capacity && expected; ++i){
+		if(days.days[i] == 0)
+			continue;
+		sprintf(date,"%08ld",(long)days.days[i]);
+		position = _tc_manifest_route(&manifest,date,&found);
+		if(found)
+			expected[position] += days.counts[i];
+		else
+			_tc_fsck_found(fsck,fixable,"Index segment %s is missing, %ld entries belong in it",date,days.counts[i]);
+	}
+	for(i = 0; i < manifest.count && expected; ++i){
+		if(manifest.segments[i].entries != expected[i])
+			_tc_fsck_found(fsck,fixable,"Index segment %s lists %ld entries, the histories have %ld",manifest.segments[i].name,manifest.segments[i].entries,expected[i]);
+		_tc_manifest_segment_path(&manifest,manifest.segments + i,segmentPath);
+		if(stat(segmentPath,&status) != 0)
+			_tc_fsck_found(fsck,fixable,"Index segment %s is in the manifest but has no file",manifest.segments[i].name);
+		else if((long)status.st_size != manifest.segments[i].bytes)
+			_tc_fsck_found(fsck,fixable,"Index segment %s is %ld bytes, the manifest says %ld",manifest.segments[i].name,(long)status.st_size,manifest.segments[i].bytes);
+	}
+	result = expected != NULL;
+	if(fixable && result && fsck->problems != problems){
+		if((result = _tc_fsck_reindex(fsck,&manifest,events,count) == TC_OK))
+			fprintf(stdout, "Rewrote %lu index entries\n", (unsigned long)count);
+	}else if(fsck->repair && fixable == FALSE && fsck->problems != problems){
+		fprintf(stdout, "%s\n", "Index segments left as they are while an archived task can't be read");
+	}
+	if(fsck->repair && _tc_manifest_commit(&manifest) != TC_OK)
+		result = FALSE;
+	if(result)
+		result = _tc_fsck_journal(fsck,events,count,fixable);
+	if(fsck->repair == FALSE)
+		_tc_manifest_free(&manifest);
+	free(expected);
+	free(days.days);
+	free(days.counts);
+	free(events);
+	return result;
+}
+
+static int _tc_fsck_projects(struct tc_fsck * fsck){
+	/* The project rollups against the totals of the histories under them */
+	struct tc_projects expected, stored;
+	struct tc_project * want, * have;
+	struct tc_fsck_task * task;
+	unsigned long problems;
+	size_t i, j;
+	int order, fixable, result;
+
+	_tc_projects_init(&expected);
+	fixable = fsck->repair;
+	result = TC_OK;
+	for(i = 0; i < fsck->taskCount && result == TC_OK; ++i){
+		task = fsck->tasks + i;
+		/* The time of an archived task that can't be read is unknown */
+		if(task->problems & TC_FSCK_ARCHIVE)
+			fixable = FALSE;
+		if(task->records > 0)
+			result = _tc_projects_add(&expected,task->taskName,task->summary.accumulated,1);
+	}
+	if(result != TC_OK || (fsck->repair ? _tc_projects_begin(fsck->root,&stored) : _tc_projects_load(fsck->root,&stored)) != TC_OK){
+		_tc_projects_free(&expected);
+		return FALSE;
+	}
+
+	/* Both trees are in the same order, walk them side by side */
+	problems = fsck->problems;
+	for(i = j = 0; i < expected.count || j < stored.count;){
+		want = i < expected.count ? expected.nodes + i : NULL;
+		have = j < stored.count ? stored.nodes + j : NULL;
+		order = want == NULL ? 1 : have == NULL ? -1 : _tc_projects_order(want->path,have->path);
+		if(order < 0)
+			_tc_fsck_found(fsck,fixable,"Project %s is missing, %ld tasks belong in it",want->path,want->tasks);
+		else if(order > 0)
+			_tc_fsck_found(fsck,fixable,"Project %s has no tasks but is in the project totals",have->path);
+		else if(want->tasks != have->tasks || want->accumulated != have->accumulated)
+			_tc_fsck_found(fsck,fixable,"Project %s has %ld tasks and %ld seconds, the histories have %ld and %ld",
+				want->path,have->tasks,have->accumulated,want->tasks,want->accumulated);
+		i += order <= 0;
+		j += order >= 0;
+	}
+
+	if(fixable && fsck->problems != problems){
+		/* Take the rebuilt tree in place of the stored one */
+		free(stored.nodes);
+		stored.nodes = expected.nodes;
+		stored.count = expected.count;
+		stored.capacity = expected.capacity;
+		stored.changed = TRUE;
+		_tc_projects_init(&expected);
+	}else if(fsck->repair && fixable == FALSE && fsck->problems != problems){
+		fprintf(stdout, "%s\n", "Project totals left as they are while an archived task can't be read");
+	}
+	result = fsck->repair ? _tc_projects_commit(&stored) == TC_OK : TRUE;
+	_tc_projects_free(&stored);
+	_tc_projects_free(&expected);
+	return result;
+}
+
+static int _tc_fsck_counters(struct tc_fsck * fsck){
+	/* The store counters against the tasks directory as it is now */
+	struct tc_counters expected, stored;
+	struct tc_fsck_task * task;
+	struct stat fileStat;
+	char path[TC_MAX_BUFF*2];
+	int repaired;
+	size_t i;
+
+	_tc_counters_init(&expected);
+	for(i = 0; i < fsck->taskCount; ++i){
+		task = fsck->tasks + i;
+		if(task->archived != NULL)
+			continue;
+		if(task->records > 0)
+			_tc_counters_tally(&expected,TC_TASK_NOT_FOUND,task->summary.state,0);
+		_tc_getTaskFilePath(path,fsck->root,task->taskHash,TC_SEQ_EXT);
+		if(stat(path,&fileStat) == 0)
+			expected.bytes += fileStat.st_size;
+		_tc_getTaskFilePath(path,fsck->root,task->taskHash,TC_INFO_EXT);
+		if(stat(path,&fileStat) == 0)
+			expected.bytes += fileStat.st_size;
+	}
+	if((fsck->repair ? _tc_counters_begin(fsck->root,&stored) : _tc_counters_load(fsck->root,&stored)) != TC_OK)
+		return FALSE;
+
+	repaired = fsck->repair;
+	if(stored.started != expected.started || stored.paused != expected.paused || stored.finished != expected.finished)
+		_tc_fsck_found(fsck,repaired,"Counters have %ld started, %ld paused and %ld finished tasks, the tasks directory has %ld, %ld and %ld",
+			stored.started,stored.paused,stored.finished,expected.started,expected.paused,expected.finished);
+	if(stored.bytes != expected.bytes)
+		_tc_fsck_found(fsck,repaired,"Counters have %ld bytes of tasks, the tasks directory has %ld",stored.bytes,expected.bytes);
+
+	if(fsck->repair == FALSE)
+		return TRUE;
+	/* The latencies are kept, only the counts come from the histories */
+	stored.started = expected.started;
+	stored.paused = expected.paused;
+	stored.finished = expected.finished;
+	stored.bytes = expected.bytes;
+	return _tc_counters_commit(&stored) == TC_OK;
+}
+
+static int _tc_fsck_sessions(struct tc_fsck * fsck, struct tc_fsck_worker * workers, int threads){
+	/* The session sketches of each day against the sessions the histories close */
+	struct tc_sessions expected, stored;
+	struct tc_sessions_day * want, * have;
+	unsigned long problems;
+	size_t i, j;
+	int fixable, result, t;
+
+	_tc_sessions_init(&expected);
+	for(t = 0; t < threads; ++t)
+		if(_tc_sessions_merge(&expected,&workers[t].sessions,1) != TC_OK){
+			_tc_sessions_free(&expected);
+			return FALSE;
+		}
+	if(_tc_sessions_load(fsck->root,0,0,&stored) != TC_OK){
+		_tc_sessions_free(&expected);
+		return FALSE;
+	}
+
+	/* Sessions of an archived task that can't be read would be lost by a rewrite */
+	fixable = fsck->repair;
+	for(i = 0; i < fsck->taskCount; ++i)
+		if(fsck->tasks[i].problems & TC_FSCK_ARCHIVE)
+			fixable = FALSE;
+
+	problems = fsck->problems;
+	for(i = j = 0; i < expected.count || j < stored.count;){
+		want = i < expected.count ? expected.days + i : NULL;
+		have = j < stored.count ? stored.days + j : NULL;
+		if(have == NULL || (want != NULL && want->day < have->day)){
+			_tc_fsck_found(fsck,fixable,"Sessions of %08ld are missing, the histories close %ld",(long)want->day,want->sketch.sessions);
+			++i;
+		}else if(want == NULL || have->day < want->day){
+			_tc_fsck_found(fsck,fixable,"Sessions of %08ld list %ld, the histories close none",(long)have->day,have->sketch.sessions);
+			++j;
+		}else{
+			if(_tc_sketch_equal(&want->sketch,&have->sketch) == FALSE)
+				_tc_fsck_found(fsck,fixable,"Sessions of %08ld list %ld for %ld seconds, the histories have %ld for %ld",
+					(long)want->day,have->sketch.sessions,have->sketch.seconds,want->sketch.sessions,want->sketch.seconds);
+			++i;
+			++j;
+		}
+	}
+
+	result = TRUE;
+	if(fixable && fsck->problems != problems)
+		result = _tc_sessions_replace(fsck->root,&expected) == TC_OK;
+	else if(fsck->repair && fixable == FALSE && fsck->problems != problems)
+		fprintf(stdout, "%s\n", "Session sketches left as they are while an archived task can't be read");
+	_tc_sessions_free(&stored);
+	_tc_sessions_free(&expected);
+	return result;
+}
+
+int _tc_fsck_run(char const * tcHomeDirectory, int repair){
+	/* Check the store, and repair what can be rebuilt from the histories
+	 * when asked. Returns how many problems are left, -1 on failure.
+	*/
+	struct tc_fsck fsck;
+	struct tc_fsck_worker * workers;
+	struct tc_active_slot slots[TC_ACTIVE_SLOTS];
+	struct tc_store * store;
+	struct timespec began, ended;
+	size_t archived, i;
+	int threads, started, slotCount, result, t;
+
+	memset(&fsck,0,sizeof(fsck));
+	if(strlen(tcHomeDirectory) >= TC_MAX_BUFF || _tc_store_open_directory(&store,tcHomeDirectory) != TC_OK)
+		return -1;
+	strcpy(fsck.root,tcHomeDirectory);
+	fsck.repair = repair;
+	clock_gettime(CLOCK_MONOTONIC,&began);
+
+	result = _tc_fsck_scan_tasks(&fsck) && _tc_fsck_scan_archive(&fsck);
+	threads = _tc_fsck_threads(&fsck);
+	workers = result ? calloc(threads,sizeof(*workers)) : NULL;
+	if(workers == NULL){
+		_tc_store_close(store);
+		free(fsck.tasks);
+		free(fsck.archived);
+		return -1;
+	}
+
+	/* Workers pull chunks of tasks, whatever could not be started runs here */
+	pthread_mutex_init(&fsck.lock,NULL);
+	for(started = 0; started < threads; ++started){
+		workers[started].fsck = &fsck;
+		workers[started].dayFrom = 1;
+		if(pthread_create(&workers[started].thread,NULL,_tc_fsck_work,workers + started) != 0)
+			break;
+	}
+	if(started < threads)
+		_tc_fsck_work(workers + started);
+	for(t = 0; t < started; ++t)
+		pthread_join(workers[t].thread,NULL);
+	pthread_mutex_destroy(&fsck.lock);
+
+	for(t = 0; t < threads; ++t)
+		result = result && workers[t].failed == FALSE;
+	if(result){
+		slotCount = _tc_active_list(tcHomeDirectory,slots,TC_ACTIVE_SLOTS);
+		if(repair)
+			_tc_fsck_repair_names(&fsck,slots,slotCount);
+		_tc_fsck_report_tasks(&fsck);
+		_tc_fsck_current(&fsck,store);
+		_tc_fsck_active(&fsck,store,slots,slotCount);
+		result = _tc_fsck_indexes(&fsck,workers,threads) && _tc_fsck_projects(&fsck) && _tc_fsck_counters(&fsck)
+			&& _tc_fsck_sessions(&fsck,workers,threads);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC,&ended);
+	for(archived = i = 0; i < fsck.taskCount; ++i)
+		archived += fsck.tasks[i].archived != NULL;
+	if(result)
+		fprintf(stdout, "Checked %lu tasks (%lu archived) in %.3f seconds on %i threads: %lu problems, %lu repaired\n",
+			(unsigned long)fsck.taskCount, (unsigned long)archived,
+			(ended.tv_sec - began.tv_sec) + (ended.tv_nsec - began.tv_nsec)/1e9, threads, fsck.problems, fsck.repaired);
+
+	for(t = 0; t < threads; ++t){
+		free(workers[t].days.days);
+		free(workers[t].days.counts);
+		_tc_sessions_free(&workers[t].sessions);
+		free(workers[t].events);
+		free(workers[t].buffer);
+	}
+	free(workers);
+	free(fsck.tasks);
+	free(fsck.archived);
+	_tc_store_close(store);
+	return result ? (int)(fsck.problems - fsck.repaired) : -1;
+}
@@ -0,0 +1,481 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "tc-import.h"
+#include "tc-task.h"
+#include "tc-directory.h"
+#include "tc-init.h"
+#include "tc-lock.h"
+#include "tc-store.h"
+#include "tc-manifest.h"
+#include "tc-journal.h"
+#include "tc-fsck.h"
+
+#include <stdio.h>
+#include <strings.h>
+
+void tc_import(int argc, char const *argv[]){
+	char tcHomeDirectory[TC_MAX_BUFF];
+	char importPath[TC_MAX_BUFF];
+
+	/* Usage has already been shown by the help check */
+	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
+		return;
+
+	tc_init(tcHomeDirectory);
+	_tc_cli_task_name(argc,argv,importPath);
+
+	if(strcmp(importPath,"") == 0 || _tc_args_flag_check(argc,argv,TC_CSV_LONG,TC_CSV_SHORT) == FALSE){
+		_tc_display_usage(TC_IMPORT_COMMAND);
+		return;
+	}
+
+	_tc_import_csv(tcHomeDirectory,importPath);
+}
+
+static char * _tc_import_field(char ** cursor){
+	/* Cut the next comma separated field out of a line in place.
+	 * Quoted fields may contain commas and "" for a literal quote.
+	*/
+	char * field, * read, * write;
+
+	field = *cursor;
+	if(field == NULL)
+		return NULL;
+
+	if(*field == '"'){
+		read = write = ++field;
+		while(*read != '\0'){
+			if(*read == '"'){
+				if(read[1] != '"')
+					break;
+				++read;
+			}
+			*write++ = *read++;
+		}
+		if(*read != '"')
+			return NULL; /* Unterminated quote */
+		++read;
+		*write = '\0';
+		if(*read == ',')
+			*cursor = read + 1;
+		else if(*read == '\0')
+			*cursor = NULL;
+		else
+			return NULL; /* Junk after the closing quote */
+		return field;
+	}
+
+	read = strchr(field,',');
+	if(read == NULL){
+		*cursor = NULL;
+	}else{
+		*read = '\0';
+		*cursor = read + 1;
+	}
+	return field;
+}
+
+int _tc_import_state(char const * state){
+	if(strcasecmp(state,"started") == 0 || strcasecmp(state,"start") == 0 || strcmp(state,"8") == 0)
+		return TC_TASK_STARTED;
+	if(strcasecmp(state,"paused") == 0 || strcasecmp(state,"pause") == 0 || strcmp(state,"32") == 0)
+		return TC_TASK_PAUSED;
+	if(strcasecmp(state,"finished") == 0 || strcasecmp(state,"finish") == 0 || strcmp(state,"16") == 0)
+		return TC_TASK_FINISHED;
+	return TC_TASK_NOT_FOUND;
+}
+
+static char const * _tc_import_state_name(int state){
+	switch(state){
+		case TC_TASK_STARTED:
+			return "started";
+		case TC_TASK_PAUSED:
+			return "paused";
+		case TC_TASK_FINISHED:
+			return "finished";
+	}
+	return "new";
+}
+
+static int _tc_import_parse_line(char * line, unsigned long lineNumber, struct tc_import_row * row){
+	/* task,state,timestamp[,note] */
+	char * cursor, * taskName, * state, * timestamp, * note, * end;
+	long seqTime;
+
+	cursor = line;
+	taskName = _tc_import_field(&cursor);
+	state = _tc_import_field(&cursor);
+	timestamp = _tc_import_field(&cursor);
+	if(cursor != NULL && *cursor == '"')
+		note = _tc_import_field(&cursor);
+	else
+		note = cursor; /* An unquoted note is the rest of the line, commas and all */
+
+	if(taskName == NULL || state == NULL || timestamp == NULL)
+		return FALSE;
+
+	trim(taskName);
+	trim(state);
+	trim(timestamp);
+	if(taskName[0] == '\0' || strlen(taskName) >= TC_MAX_BUFF)
+		return FALSE;
+
+	seqTime = strtol(timestamp,&end,10);
+	if(end == timestamp || *end != '\0' || seqTime < 0)
+		return FALSE;
+
+	row->taskName = taskName;
+	row->state = _tc_import_state(state);
+	row->seqTime = seqTime;
+	row->note = note == NULL ? NULL : trim(note);
+	row->line = lineNumber;
+	row->imported = FALSE;
+	return row->state != TC_TASK_NOT_FOUND;
+}
+
+static int _tc_import_compare(const void * left, const void * right){
+	/* Group rows by task, then order each task's rows by time and file position */
+	const struct tc_import_row * a = left;
+	const struct tc_import_row * b = right;
+	int byName;
+
+	if((byName = strcmp(a->taskName,b->taskName)) != 0)
+		return byName;
+	if(a->seqTime != b->seqTime)
+		return a->seqTime < b->seqTime ? -1 : 1;
+	if(a->line != b->line)
+		return a->line < b->line ? -1 : 1;
+	return 0;
+}
+
+static char * _tc_import_slurp(char const * importPath, size_t * size){
+	/* Read the whole file into one NUL terminated buffer the rows can point into */
+	FILE * fp;
+	char * buffer;
+	long length;
+
+	fp = fopen(importPath,"rb");
+	if(!fp)
+		return NULL;
+	if(fseek(fp,0,SEEK_END) != 0 || (length = ftell(fp)) < 0 || fseek(fp,0,SEEK_SET) != 0){
+		fclose(fp);
+		return NULL;
+	}
+	buffer = malloc(length + 1);
+	if(buffer == NULL || fread(buffer,1,length,fp) != (size_t)length){
+		free(buffer);
+		fclose(fp);
+		return NULL;
+	}
+	fclose(fp);
+	buffer[length] = '\0';
+	*size = length;
+	return buffer;
+}
+
+static size_t _tc_import_rows(char * buffer, size_t size, struct tc_import_row ** rowsOut, unsigned long * rejected){
+	/* Split the buffer into lines and parse each into a row */
+	struct tc_import_row * rows, * grown;
+	size_t count, capacity;
+	unsigned long lineNumber;
+	char * line, * next, * end;
+
+	rows = NULL;
+	count = capacity = 0;
+	lineNumber = 0;
+	end = buffer + size;
+
+	for(line = buffer; line < end; line = next){
+		next = memchr(line,'\n',end - line);
+		if(next == NULL)
+			next = end;
+		else
+			*next++ = '\0';
+		++lineNumber;
+		if(next - line > 1 && line[strlen(line)-1] == '\r')
+			line[strlen(line)-1] = '\0';
+		if(*line == '\0')
+			continue;
+
+		if(count == capacity){
+			capacity = capacity == 0 ? 1024 : capacity*2;
+			grown = realloc(rows,capacity*sizeof(*rows));
+			if(grown == NULL){
+				fprintf(stderr, "%s\n", "Could not allocate memory for the imported rows.");
+				free(rows);
+				return 0;
+			}
+			rows = grown;
+		}
+
+		if(_tc_import_parse_line(line,lineNumber,&rows[count]) == FALSE){
+			/* A header row is expected, anything else is worth mentioning */
+			if(lineNumber != 1 || strncasecmp(line,"task",4) != 0){
+				fprintf(stderr, "Line %lu: expected task,state,timestamp[,note]. Skipping\n", lineNumber);
+				++(*rejected);
+			}
+			continue;
+		}
+		++count;
+	}
+
+	*rowsOut = rows;
+	return count;
+}
+
+static void _tc_import_indexes(char * tcHomeDirectory, struct tc_import_row * rows, size_t count){
+	/* Index every imported row under one hold of the index lock. This runs
+	 * after the task locks are released, the index lock is always taken last.
+	*/
+	struct tc_manifest manifest;
+	char currentDate[TC_MAX_BUFF/2];
+	char taskHash[TC_MAX_BUFF];
+	size_t i;
+	int result;
+
+	if(_tc_manifest_begin(tcHomeDirectory,&manifest) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not open the index manifest. Please check permissions");
+		return;
+	}
+	result = TC_OK;
+	for(i = 0; i < count && result == TC_OK; ++i){
+		if(rows[i].imported == FALSE)
+			continue;
+		if(i == 0 || strcmp(rows[i].taskName,rows[i-1].taskName) != 0)
+			_tc_taskName_to_Hash(rows[i].taskName,taskHash);
+		strftime(currentDate,TC_MAX_BUFF/2,"%Y%m%d",localtime(&rows[i].seqTime));
+		result = _tc_manifest_write(&manifest,currentDate,taskHash,rows[i].taskName,rows[i].state);
+	}
+	if(_tc_manifest_commit(&manifest) != TC_OK || result != TC_OK)
+		fprintf(stderr, "%s\n", "Could not write the index segments. Please check permissions");
+}
+
+static void _tc_import_journal(char * tcHomeDirectory, struct tc_import_row * rows, size_t count){
+	/* Journal them the same way, under one hold of the journal lock */
+	struct tc_journal journal;
+	char taskHash[TC_MAX_BUFF];
+	size_t i;
+	int result;
+
+	if(_tc_journal_begin(tcHomeDirectory,&journal) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not open the journal. tcatch fsck --repair rewrites it");
+		return;
+	}
+	result = TC_OK;
+	for(i = 0; i < count && result == TC_OK; ++i){
+		if(rows[i].imported == FALSE)
+			continue;
+		if(i == 0 || strcmp(rows[i].taskName,rows[i-1].taskName) != 0)
+			_tc_taskName_to_Hash(rows[i].taskName,taskHash);
+		result = _tc_journal_write(&journal,rows[i].seqTime,taskHash,rows[i].state,rows[i].seqNum);
+	}
+	if(_tc_journal_commit(&journal) != TC_OK || result != TC_OK)
+		fprintf(stderr, "%s\n", "Could not write the journal. tcatch fsck --repair rewrites it");
+}
+
+static void _tc_import_projects(char * tcHomeDirectory, struct tc_projects * delta){
+	/* Fold the imported tasks and intervals into the project rollups, like
+	 * the indexes after the task locks are released */
+	struct tc_projects projects;
+	int result;
+
+	if(delta->count == 0)
+		return;
+	if(_tc_projects_begin(tcHomeDirectory,&projects) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not open the project totals. tcatch fsck --repair rebuilds them");
+		return;
+	}
+	result = _tc_projects_merge(&projects,delta);
+	if(_tc_projects_commit(&projects) != TC_OK || result != TC_OK)
+		fprintf(stderr, "%s\n", "Could not write the project totals. tcatch fsck --repair rebuilds them");
+}
+
+static void _tc_import_counters(char * tcHomeDirectory, struct tc_counters * delta){
+	/* The same for the store counters */
+	struct tc_counters counters;
+
+	if(delta->started == 0 && delta->paused == 0 && delta->finished == 0 && delta->bytes == 0)
+		return;
+	if(_tc_counters_begin(tcHomeDirectory,&counters) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not open the store counters. tcatch fsck --repair recounts them");
+		return;
+	}
+	_tc_counters_merge(&counters,delta);
+	if(_tc_counters_commit(&counters) != TC_OK)
+		fprintf(stderr, "%s\n", "Could not write the store counters. tcatch fsck --repair recounts them");
+}
+
+static void _tc_import_sessions(char * tcHomeDirectory, struct tc_sessions * delta){
+	/* The same for the session sketches of each day. A task's own sketch
+	 * catches up with its appended events when it is next opened */
+	if(_tc_sessions_commit(tcHomeDirectory,delta) != TC_OK)
+		fprintf(stderr, "%s\n", "Could not write the session sketches. tcatch fsck --repair rebuilds them");
+}
+
+int _tc_import_task(struct tc_store * store, struct tc_import_row * rows, size_t count, struct tc_import_stats * stats){
+	/* Append one task's sorted rows to its history in a single batch. Rows
+	 * that made it in are marked for _tc_import_indexes. FALSE when the
+	 * task could not be written, with none of its rows marked and its
+	 * history as it was.
+	*/
+	struct tc_task_summary task, before;
+	struct tc_store_event * events;
+	struct tc_lockset locks;
+	char taskHash[TC_MAX_BUFF];
+	char currentTaskName[TC_MAX_BUFF];
+	size_t i, kept;
+	int priorState, state, result;
+	time_t accumulated, lastTime;
+	long bytes;
+
+	_tc_taskName_to_Hash(rows[0].taskName,taskHash);
+
+	/* Imported history continues any history the task already has, an
+	 * archived task is brought back for it first */
+	if(store->ops->lock(store,rows[0].taskName,FALSE,currentTaskName,&locks) != TC_OK){
+		fprintf(stderr, "Could not lock %s. Please check permissions\n", rows[0].taskName);
+		return FALSE;
+	}
+	if(store->ops->task_open(store,taskHash,rows[0].taskName,FALSE) == TC_ERR_NOT_FOUND
+		&& (result = store->ops->restore(store,taskHash)) != TC_OK && result != TC_ERR_NOT_FOUND){
+		fprintf(stderr, "Could not bring %s back from the archive. Please check permissions\n", rows[0].taskName);
+		store->ops->unlock(store,&locks);
+		return FALSE;
+	}
+	_tc_task_summary_init(&task);
+	if(store->ops->history(store,taskHash,_tc_task_summary_record,&task) <= 0)
+		_tc_task_summary_init(&task);
+	before = task;
+	accumulated = task.accumulated;
+	priorState = task.state;
+
+	/* Each row has to follow the history before it, by time and by the
+	 * moves tcatch itself makes. Rows that do not are left out */
+	state = task.state;
+	lastTime = task.lastTime;
+	for(i = kept = 0; i < count; ++i){
+		if(state != TC_TASK_NOT_FOUND && rows[i].seqTime <= lastTime){
+			fprintf(stderr, "Line %lu: %s already has later history. Skipping\n", rows[i].line, rows[i].taskName);
+			++stats->skipped;
+		}else if(_tc_fsck_transition(state,rows[i].state) == FALSE){
+			fprintf(stderr, "Line %lu: %s can not go from %s to %s. Skipping\n", rows[i].line, rows[i].taskName, _tc_import_state_name(state), _tc_import_state_name(rows[i].state));
+			++stats->skipped;
+		}else{
+			rows[i].imported = TRUE;
+			state = rows[i].state;
+			lastTime = rows[i].seqTime;
+			++kept;
+		}
+	}
+	if(kept == 0){
+		store->ops->unlock(store,&locks);
+		return TRUE;
+	}
+
+	/* One batch, so a failed write leaves none of the task's rows in */
+	if((events = malloc(kept*sizeof(*events))) == NULL){
+		fprintf(stderr, "%s\n", "Could not allocate memory for the imported events.");
+		result = TC_ERR_NOMEM;
+	}else{
+		for(i = kept = 0; i < count; ++i){
+			if(rows[i].imported == FALSE)
+				continue;
+			rows[i].seqNum = task.seqNum;
+			events[kept].seqNum = task.seqNum;
+			events[kept].state = rows[i].state;
+			events[kept].eventTime = rows[i].seqTime;
+			events[kept].note = rows[i].note;
+			++kept;
+			_tc_task_summary_record(task.seqNum,rows[i].state,rows[i].seqTime,&task);
+		}
+		if((result = store->ops->append_events(store,taskHash,rows[0].taskName,events,kept,&bytes)) != TC_OK)
+			fprintf(stderr, "Could not write the task files for %s. Please check permissions\n", rows[0].taskName);
+		free(events);
+	}
+	store->ops->unlock(store,&locks);
+	if(result != TC_OK){
+		for(i = 0; i < count; ++i)
+			rows[i].imported = FALSE;
+		return FALSE;
+	}
+
+	/* Only a task that was written goes into the rollups, replayed again
+	 * from where it stood for the sessions its rows close */
+	for(i = 0; i < count; ++i){
+		if(rows[i].imported == FALSE)
+			continue;
+		if(before.seqNum == 0 && _tc_projects_add(&stats->projects,rows[i].taskName,0,1) != TC_OK)
+			fprintf(stderr, "%s\n", "Could not allocate memory for the project totals.");
+		if(before.state == TC_TASK_STARTED && (rows[i].state == TC_TASK_PAUSED || rows[i].state == TC_TASK_FINISHED)
+			&& _tc_sessions_add(&stats->sessions,_tc_sessions_day(rows[i].seqTime),(long)(rows[i].seqTime - before.lastStart),1) != TC_OK)
+			fprintf(stderr, "%s\n", "Could not allocate memory for the session sketches.");
+		_tc_task_summary_record(before.seqNum,rows[i].state,rows[i].seqTime,&before);
+		++stats->events;
+	}
+	if(task.accumulated != accumulated && _tc_projects_add(&stats->projects,rows[0].taskName,task.accumulated - accumulated,0) != TC_OK)
+		fprintf(stderr, "%s\n", "Could not allocate memory for the project totals.");
+	_tc_counters_tally(&stats->counters,priorState,task.state,bytes);
+	++stats->tasks;
+	return TRUE;
+}
+
+void _tc_import_csv(char * tcHomeDirectory, char const * importPath){
+	struct tc_import_stats stats;
+	struct tc_import_row * rows;
+	struct tc_store * store;
+	struct timespec began, ended;
+	char * buffer;
+	size_t size, count, first, last;
+	double seconds;
+
+	memset(&stats,0,sizeof(stats));
+	_tc_projects_init(&stats.projects);
+	_tc_counters_init(&stats.counters);
+	_tc_sessions_init(&stats.sessions);
+	clock_gettime(CLOCK_MONOTONIC,&began);
+
+	buffer = _tc_import_slurp(importPath,&size);
+	if(buffer == NULL){
+		fprintf(stderr, "%s\n", "Could not read the file to import.");
+		return;
+	}
+	if(_tc_store_open_directory(&store,tcHomeDirectory) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not open the .tc directory. Please check permissions");
+		free(buffer);
+		return;
+	}
+
+	rows = NULL;
+	count = _tc_import_rows(buffer,size,&rows,&stats.skipped);
+	qsort(rows,count,sizeof(*rows),_tc_import_compare);
+
+	/* Rows are grouped by task now, hand each run to _tc_import_task */
+	for(first = 0; first < count; first = last){
+		for(last = first + 1; last < count && strcmp(rows[last].taskName,rows[first].taskName) == 0; ++last)
+			;
+		if(_tc_import_task(store,rows + first,last - first,&stats) == FALSE)
+			++stats.failed;
+	}
+	_tc_store_close(store);
+	if(stats.events > 0){
+		_tc_import_indexes(tcHomeDirectory,rows,count);
+		_tc_import_journal(tcHomeDirectory,rows,count);
+	}
+	_tc_import_projects(tcHomeDirectory,&stats.projects);
+	_tc_projects_free(&stats.projects);
+	_tc_import_counters(tcHomeDirectory,&stats.counters);
+	_tc_import_sessions(tcHomeDirectory,&stats.sessions);
+	_tc_sessions_free(&stats.sessions);
+
+	free(rows);
+	free(buffer);
+
+	clock_gettime(CLOCK_MONOTONIC,&ended);
+	seconds = (ended.tv_sec - began.tv_sec) + (ended.tv_nsec - began.tv_nsec)/1e9;
+	fprintf(stdout, "Imported %lu events for %lu tasks in %.3f seconds (%.0f events/s)\n",
+		stats.events, stats.tasks, seconds, seconds > 0 ? stats.events/seconds : 0.0);
+	if(stats.skipped > 0)
+		fprintf(stdout, "Skipped %lu rows\n", stats.skipped);
+	if(stats.failed > 0)
+		fprintf(stderr, "Could not import %lu tasks, none of their rows went in\n", stats.failed);
+}
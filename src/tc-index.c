@@ -0,0 +1,107 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "tc-index.h"
+#include "tc-task.h"
+#include "tc-directory.h"
+#include "tc-init.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+static int _tc_index_date_check(char const * date){
+	size_t i;
+
+	for(i = 0; isdigit((unsigned char)date[i]); ++i)
+		;
+	return i == 8 && date[i] == '\0';
+}
+
+void tc_index(int argc, char const *argv[]){
+	char tcHomeDirectory[TC_MAX_BUFF];
+	char currentMonth[16];
+	char const * dates[2];
+	struct tc_manifest manifest;
+	time_t now;
+	int i, count, result;
+
+	/* Usage has already been shown by the help check */
+	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
+		return;
+
+	tc_init(tcHomeDirectory);
+
+	/* Up to two dates bound the listing */
+	dates[0] = dates[1] = NULL;
+	for(count = 0, i = 2; i < argc; ++i){
+		if(argv[i][0] == '-')
+			continue;
+		if(count == 2 || _tc_index_date_check(argv[i]) == FALSE){
+			_tc_display_usage(TC_INDEX_COMMAND);
+			return;
+		}
+		dates[count++] = argv[i];
+	}
+
+	if(_tc_args_flag_check(argc,argv,TC_REBUILD_LONG,TC_REBUILD_SHORT) == TRUE){
+		if(_tc_manifest_begin(tcHomeDirectory,&manifest) != TC_OK){
+			fprintf(stderr, "%s\n", "Could not open the index manifest. Please check permissions");
+			return;
+		}
+		result = _tc_manifest_rebuild(&manifest);
+		count = (int)manifest.count;
+		if(_tc_manifest_commit(&manifest) != TC_OK || result != TC_OK)
+			fprintf(stderr, "%s\n", "Could not rebuild the index manifest.");
+		else
+			fprintf(stdout, "Rebuilt the index manifest, %i segments\n", count);
+		return;
+	}
+
+	if(_tc_args_flag_check(argc,argv,TC_MERGE_LONG,TC_MERGE_SHORT) == TRUE){
+		/* Only months that are over are merged, today keeps its own segment */
+		now = time(0);
+		strftime(currentMonth,sizeof(currentMonth),"%Y%m",localtime(&now));
+		if(_tc_manifest_begin(tcHomeDirectory,&manifest) != TC_OK){
+			fprintf(stderr, "%s\n", "Could not open the index manifest. Please check permissions");
+			return;
+		}
+		result = _tc_manifest_merge(&manifest,currentMonth);
+		if(_tc_manifest_commit(&manifest) != TC_OK || result < 0)
+			fprintf(stderr, "%s\n", "Could not merge the index segments.");
+		else
+			fprintf(stdout, "Merged the day segments of %i months\n", result);
+		return;
+	}
+
+	if(_tc_manifest_load(tcHomeDirectory,&manifest) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not read the index manifest.");
+		return;
+	}
+	_tc_index_list(&manifest,dates[0],count == 2 ? dates[1] : dates[0]);
+	_tc_manifest_free(&manifest);
+}
+
+struct tc_index_totals {
+	long entries;
+	long bytes;
+};
+
+static void _tc_index_print(struct tc_manifest * manifest, struct tc_segment * segment, void * data){
+	struct tc_index_totals * totals = data;
+	(void)manifest;
+
+	fprintf(stdout, "%-8s  %s - %s  %8ld entries  %10ld bytes\n", segment->name, segment->firstDate, segment->lastDate, segment->entries, segment->bytes);
+	totals->entries += segment->entries;
+	totals->bytes += segment->bytes;
+}
+
+void _tc_index_list(struct tc_manifest * manifest, char const * fromDate, char const * toDate){
+	/* Print the segments overlapping the dates, a single date lists just that day */
+	struct tc_index_totals totals;
+	int count;
+
+	totals.entries = totals.bytes = 0;
+	count = _tc_manifest_select(manifest,fromDate,toDate,_tc_index_print,&totals);
+	fprintf(stdout, "%i segments, %ld entries, %ld bytes\n", count, totals.entries, totals.bytes);
+}
@@ -1,42 +1,33 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include "tc-info.h"
 #include "tc-task.h"
 #include "tc-init.h"
 #include "tc-directory.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 void tc_addInfo(int argc, char const *argv[]){
-	char tcHomeDirectory[TC_MAX_BUFF];
-	struct tc_task working_task;
-	char taskInfo[TC_MAX_BUFF];
-	taskInfo[0] = '\0';
-
-	tc_init(tcHomeDirectory);
-	
-	working_task.taskName = malloc(TC_MAX_BUFF*sizeof(char));
-	working_task.taskInfo = malloc(TC_MAX_BUFF*sizeof(char));
-	
-	_find_current_task(&working_task);
-	if(working_task.state == TC_TASK_NOT_FOUND){
-			fprintf(stderr, "%s\n", "No current task to add information to.");
-	}else{
-		/* Open up the info file for writing */
-		if(_tc_file_exists(working_task.taskInfo) == FALSE)
-			fprintf(stderr, "%s\n", "Could not find information file for current task.");
-		else {/* Add information to the task */
+	struct tc_context * context;
+	char * taskInfo;
 
-			/* The cli is the task information, so grab it like a name */
-			_resolve_taskName_from_args(argc,argv,taskInfo);
+	context = _tc_cli_context();
 
-			strcpy(working_task.taskInfo,taskInfo); 
-			_tc_task_write(working_task,tcHomeDirectory);
-
-			fprintf(stdout, "%s\n", "Wrote information to current task.");
-		}
-		
+	/* add-info - streams stdin, however much there is */
+	if(argc == 3 && strcmp(argv[2],TC_STDIN_ARG) == 0){
+		_tc_cli_done(context, tc_lib_add_info_fd(context,fileno(stdin)));
+		return;
 	}
-	
-	free(working_task.taskName);
-	free(working_task.taskInfo);
 
-}
\ No newline at end of file
+	/* The cli is the task information, so grab it like a name, only longer */
+	taskInfo = _tc_args_join(argc,argv);
+	if(taskInfo == NULL){
+		tc_lib_close(context);
+		fprintf(stderr, "%s\n", "Could not allocate memory for the information.");
+		exit(1);
+	}
+	_tc_cli_done(context, tc_lib_add_info(context,taskInfo));
+	free(taskInfo);
+}
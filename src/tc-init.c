@@ -10,6 +10,8 @@
 
 #include "tc-directory.h"
 #include "tc-init.h"
+#include "tc-lock.h"
+#include "tc-task.h"
 
 
 int _tc_args_flag_check(int argc, char const *argv[], char const * longFlag, char const * shortFlag){
@@ -26,6 +28,24 @@ int _tc_args_flag_check(int argc, char const *argv[], char const * longFlag, cha
 	return FALSE;
 }
 
+int _tc_args_flag_index(int argc, char const *argv[], char const * longFlag, char const * shortFlag){
+	/* Where a flag is in argv, -1 if it isn't */
+	int counter;
+	for(counter = 0; counter < argc; ++counter)
+		if( strcasecmp( argv[counter], shortFlag ) == 0 || strcasecmp( argv[counter], longFlag ) == 0 )
+			return counter;
+	return -1;
+}
+
+char const * _tc_args_flag_value(int argc, char const *argv[], char const * longFlag, char const * shortFlag){
+	/* The argument after a flag, NULL if the flag is missing or has none */
+	int counter;
+	counter = _tc_args_flag_index(argc,argv,longFlag,shortFlag);
+	if(counter == -1 || counter + 1 >= argc || argv[counter+1][0] == '-')
+		return NULL;
+	return argv[counter+1];
+}
+
 void _tc_help_check(int argc, char const *argv[]){
 	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
 		_tc_display_usage(argv[1]);
@@ -33,47 +53,103 @@ void _tc_help_check(int argc, char const *argv[]){
 
 void _tc_display_usage(const char * command){
 	const char * general_usage;
+	const char * general_footer;
+	const char * command_summary[4];
+	int i;
 	const char * view_usage;
+	const char * view_archive_usage;
+	const char * view_project_usage;
+	const char * view_between_usage;
 	const char * start_usage;
 	const char * add_info_usage;
 	const char * finish_usage;
 	const char * pause_usage;
 	const char * delete_usage;
+	const char * export_usage;
+	const char * import_usage;
+	const char * index_usage;
+	const char * archive_usage;
+	const char * fsck_usage;
+	const char * metrics_usage;
+	const char * merge_usage;
+	const char * log_usage;
+	const char * timeline_usage;
+	const char * stats_usage;
+	const char * prompt_usage;
+	const char * report_usage;
 
 	general_usage = ""
 	"tcatch <command> [<args>]\n"
 	"\n"
-	"The tcatch commands are the following:\n"
+	"The tcatch commands are the following:\n";
+	general_footer = ""
+	"\n"
+	"See tcatch <command> --help for information on a specific command\n"
+	"\n";
+
+	/* One line per command, kept apart so the usage stays within C89 string limits */
+	command_summary[0] = ""
 	"\tstart		Start a new task\n"
 	"\tadd-info 	Append information about the current task\n"
 	"\tfinish		Finish a task that has been started\n"
 	"\tview		View the current task or a list of all tasks\n"
 	"\tpause 		Pause the current task.\n"
-	"\tdelete 		Delete a task by name. Permanently.\n"
-	"\n"
-	"See tcatch <command> --help for information on a specific command\n"
-	"\n";
+	"\tdelete 		Delete a task by name. Permanently.\n";
+	command_summary[1] = ""
+	"\texport 		Export every task's intervals to a columnar file\n"
+	"\timport 		Import task history from a csv file\n"
+	"\tindex 		List, merge or rebuild the index segments\n"
+	"\tarchive 	Move finished tasks into compressed archive segments\n"
+	"\tfsck 		Check the store, and repair what the histories can rebuild\n"
+	"\tmetrics 	Write the Prometheus textfile of the store counters\n";
+	command_summary[2] = ""
+	"\tmerge 		Merge the tasks of other stores into this one\n"
+	"\tlog 		List the events of every task in time order\n"
+	"\ttimeline 	Chart the tasks worked on over a day or a week\n"
+	"\tstats 		Show how long work sessions last, as percentiles\n"
+	"\tprompt 		Print the current task and its time for a shell prompt\n"
+	"\treport 		Total the time worked per task, day or hour of the week\n";
+	command_summary[3] = NULL;
 
 	view_usage = ""
-	"tcatch view [--help | -h][ --all | -a][ <task name> ][--verbose | -v]\n"
+	"tcatch view [--help | -h][ --all | -a [--include-archived | -i]][ --multi | -m][ --project | -p [<project>][--depth | -d <levels>]][ --between | -b <from> <to>][ --top | -t <k> [--by | -y time|updated|sessions]][ <task name> ][--verbose | -v]\n"
 	"\n"
 	"Running view with no arguments will display the current tasks information\n"
 	"If there is no current task, tcatch will let you know.\n"
 	"To see this help dialog you can run view with the --help flag\n"
+	;
+	view_project_usage = ""
 	"To view information on all tasks, use the --all flag and if you want to see\n"
 	"information on a single specific task, use view <task name>\n"
+	"To list every running timer in multi-timer mode use the --multi flag\n"
+	"To see the total time of a project, the tasks named <project>/<task>,\n"
+	"use --project [<project>] [--depth | -d <levels>]. Without a project every\n"
+	"project is shown. Running intervals are counted once they are paused\n"
+	;
+	view_between_usage = ""
+	"To see the time worked on a task (or with --all on every task) inside a\n"
+	"window use --between <from> <to>. Each is a day as YYYYMMDD, the whole of\n"
+	"<to> included, or seconds since the epoch\n"
+	;
+	view_archive_usage = ""
+	"To list only the <k> tasks with the most time worked, the latest updates\n"
+	"or the most sessions use --top <k> [--by time|updated|sessions]\n"
+	"Archived tasks are found by name, --all lists them with --include-archived\n"
 	;
 	start_usage = ""
-	"tcatch start [--help | -h][--switch | -s ] <task name>\n"
+	"tcatch start [--help | -h][--switch | -s | --multi | -m ] <task name>\n"
 	"\n"
 	"To see this help text use --help or -h. \n"
 	"To switch from the current task to the new one pass --switch or -s. \n"
+	"To keep every other timer running and start this one too pass --multi or -m\n"
 	"To create a new task to be worked on simple use tcatch start and then the \n"
 	"task name\n";
 	add_info_usage = ""
-	"tcatch add-info [--help | -h] <information>\n"
+	"tcatch add-info [--help | -h] <information> | -\n"
 	"\n"
 	"The add-info command appends a given information string to the current task.\n"
+	"With - in its place, everything on standard input is appended instead, so a\n"
+	"build log can be piped in: make 2>&1 | tcatch add-info -\n"
 	"If there is no current task, this will fail. You can see this help text with\n"
 	"--help or -h.\n"
 	;
@@ -88,25 +164,175 @@ void _tc_display_usage(const char * command){
 	;
 
 	pause_usage = ""
-	"tcatch pause[-h|--help]\n"
+	"tcatch pause[-h|--help][--multi | -m <task name>]\n"
 	"\n"
 	"Pause the current task. If there is no current task then this command does\n"
-	"nothing\n"
+	"nothing. With --multi, pause the named running timer instead.\n"
 	"To See this help dialog pass the --help or -h flag\n"
 	;
 
 	delete_usage = ""
-	"tcatch delete [-h|--help]\n"
-	"Delete a task. This is permanent and there is no recovering the deleted task\n"
-	"Before deleting you will be asked to enter y or n to confirm.\n"
+	"tcatch delete [-h|--help] [--yes | -y] [--dry-run | -n] <task>\n"
+	"tcatch delete [--state | -s <state>] [--older-than | -o <day>] [-y] [-n]\n"
+	"Delete a task, or every task last started, paused or finished (--state)\n"
+	"with no event since the day (--older-than), archived tasks included. This is\n"
+	"permanent and there is no recovering the deleted task. Before deleting you\n"
+	"will be asked to enter y or n to confirm, unless --yes is given. --dry-run\n"
+	"lists what would go.\n"
+	"\n"
+	"To see this help dialog pass the --help or -h flag\n"
+	;
+
+	export_usage = ""
+	"tcatch export [-h|--help] [--columnar | -c | --dump | -d] <file>\n"
+	"\n"
+	"Export the intervals of every task into a binary columnar file with\n"
+	"--columnar. The file holds contiguous arrays of task ids, interval starts,\n"
+	"interval ends and states plus a table of task names so analysis tools can\n"
+	"mmap it instead of parsing view --all. See headers/tc-columnar.h.\n"
+	"Pass --dump to print a columnar file back out one interval per line.\n"
+	"\n"
+	"To see this help dialog pass the --help or -h flag\n"
+	;
+
+	import_usage = ""
+	"tcatch import [-h|--help] --csv | -c <file>\n"
+	"\n"
+	"Import history from another time tracker. Each csv line is\n"
+	"task,state,timestamp[,note] with state started, paused or finished and the\n"
+	"timestamp in epoch seconds. Fields may be double quoted. Each task's files\n"
+	"are written in one pass and the index segments under one lock. Rows not\n"
+	"newer than a task's existing history are skipped and the current task is\n"
+	"left alone.\n"
+	"\n"
+	"To see this help dialog pass the --help or -h flag\n"
+	;
+
+	index_usage = ""
+	"tcatch index [-h|--help] [--merge | -m | --rebuild | -r] [<date> [<date>]]\n"
+	"\n"
+	"List the index segments from the manifest with their date span, entries\n"
+	"and size. One date (YYYYMMDD) lists the segment holding that day, two list\n"
+	"every segment overlapping the range.\n"
+	"Pass --merge to fold the day segments of past months into one segment per\n"
+	"month, or --rebuild to scan the index directory and write a new manifest.\n"
+	"\n"
+	"To see this help dialog pass the --help or -h flag\n"
+	;
+
+	archive_usage = ""
+	"tcatch archive [-h|--help] --finished-before | -f <YYYYMMDD>\n"
+	"\n"
+	"Move every task finished before the given day out of the tasks directory\n"
+	"into a compressed archive segment. Archived tasks can still be viewed by\n"
+	"name and are listed by view --all --include-archived. Starting the name\n"
+	"of an archived task again begins a new task.\n"
+	"\n"
+	"To see this help dialog pass the --help or -h flag\n"
+	;
+
+	fsck_usage = ""
+	"tcatch fsck [-h|--help] [--repair | -r]\n"
+	"\n"
+	"Check every task, archived ones included, on all cores: sequence numbers,\n"
+	"times and state changes, and that each info file names the task it belongs\n"
+	"to. Then check current, the timer table and the index segments against the\n"
+	"task histories. Pass --repair to restore lost names, rebuild current and\n"
+	"the timer table and rewrite the index segments. Sequences are never\n"
+	"changed. Repair while no other tcatch is running.\n"
+	"\n"
+	"To see this help dialog pass the --help or -h flag\n"
+	;
+
+	metrics_usage = ""
+	"tcatch metrics [-h|--help] [--textfile | -t <path>]\n"
+	"\n"
+	"Write the store counters as a Prometheus textfile: the current task and\n"
+	"how long it has run, tasks by state, the size of the tasks directory and\n"
+	"the median and 99th percentile latency of recent commands. Every command\n"
+	"that changes the store writes it too. It goes to ~/.tc/metrics.prom, or\n"
+	"to the path given with --textfile, which is remembered.\n"
+	"\n"
+	"To see this help dialog pass the --help or -h flag\n"
+	;
+
+	merge_usage = ""
+	"tcatch merge [-h|--help] <store> [<store> ...]\n"
+	"\n"
+	"Merge the tasks of other stores, each a .tc directory or a home directory\n"
+	"holding one, into this one. The events of a task are merged by time, an\n"
+	"event in several stores is kept once and the sequence is numbered again.\n"
+	"Information lines missing here are appended, and the index segments,\n"
+	"project totals and counters follow. Tasks are merged one at a time.\n"
 	"\n"
 	"To see this help dialog pass the --help or -h flag\n"
 	;
 
-	if( command == NULL || strcasecmp(command, TC_HELP_COMMAND) == 0 )
+	log_usage = ""
+	"tcatch log [-h|--help] [--tail | -n <count>] [--since | -s <when>]\n"
+	"\n"
+	"List the events of every task in time order: when each was started,\n"
+	"paused or finished. Without options that is today, --since lists\n"
+	"everything from a day given as YYYYMMDD or seconds since the epoch, and\n"
+	"--tail the last count events written.\n"
+	"\n"
+	"To see this help dialog pass the --help or -h flag\n"
+	;
+
+	timeline_usage = ""
+	"tcatch timeline [-h|--help] [--day | -d [<day>]] [--week | -w [<day>]]\n"
+	"\n"
+	"Chart when every task was worked on during a day, today unless one is\n"
+	"given as YYYYMMDD, or with --week during the week from the Monday before.\n"
+	"A # is a column mostly worked, a + one partly worked. The last row has\n"
+	"the most tasks running at once in each column, a . where none was, and\n"
+	"the busy, idle and overlapping time follow. COLUMNS sets the width.\n"
+	"\n"
+	"To see this help dialog pass the --help or -h flag\n"
+	;
+
+	stats_usage = ""
+	"tcatch stats [-h|--help] [<task name> | --project | -p <project> [--include-archived | -i] | --between | -b <from> <to>]\n"
+	"\n"
+	"Count the work sessions, each a start to the pause or finish after it,\n"
+	"with their total and mean and the p50, p90 and p99 of their lengths to\n"
+	"within 2%. Every session without arguments, else those of a task, of\n"
+	"the tasks under a project, or closed on the days <from> to <to>.\n"
+	"\n"
+	"To see this help dialog pass the --help or -h flag\n"
+	;
+
+	prompt_usage = ""
+	"tcatch prompt [-h|--help]\n"
+	"\n"
+	"Print the current task and the hours and minutes worked on it, or\n"
+	"nothing when there is none, from a status record kept beside current.\n"
+	"Cheap enough to run for every prompt: PS1='$(tcatch prompt) \\$ '.\n"
+	"Prompt tools can read the record themselves, see headers/tc-prompt.h.\n"
+	"\n"
+	"To see this help dialog pass the --help or -h flag\n"
+	;
+
+	report_usage = ""
+	"tcatch report [-h|--help] [--between | -b <from> <to>] [--by | -y task|day|hour]\n"
+	"\n"
+	"Total the time worked between <from> and <to>, everything recorded when\n"
+	"no window is given, per task (the default), per day or per hour of the\n"
+	"week, with every week of the window folded onto one. A running task\n"
+	"counts up to now, archived tasks are left out. <from> and <to> are days\n"
+	"as YYYYMMDD, <to> included, or epoch seconds.\n"
+	"\n"
+	"To see this help dialog pass the --help or -h flag\n"
+	;
+
+	if( command == NULL || strcasecmp(command, TC_HELP_COMMAND) == 0 ){
 		printf("%s", general_usage);
+		for(i = 0; command_summary[i] != NULL; ++i)
+			printf("%s", command_summary[i]);
+		printf("%s", general_footer);
+	}
 	else if( strcasecmp(command, TC_VIEW_COMMAND ) == 0) 
-		printf("%s\n", view_usage);
+		printf("%s%s%s%s\n", view_usage, view_project_usage, view_between_usage, view_archive_usage);
 	else if( strcasecmp(command, TC_START_COMMAND ) ==0 ) 
 		printf("%s\n", start_usage);
 	else if ( strcasecmp(command, TC_ADD_INFO_COMMAND ) == 0 ) 
@@ -117,6 +343,30 @@ void _tc_display_usage(const char * command){
 		printf("%s\n", pause_usage);
 	else if (strcasecmp(command, TC_DELETE_COMMAND) == 0 )
 		printf("%s\n", delete_usage);
+	else if (strcasecmp(command, TC_EXPORT_COMMAND) == 0 )
+		printf("%s\n", export_usage);
+	else if (strcasecmp(command, TC_IMPORT_COMMAND) == 0 )
+		printf("%s\n", import_usage);
+	else if (strcasecmp(command, TC_INDEX_COMMAND) == 0 )
+		printf("%s\n", index_usage);
+	else if (strcasecmp(command, TC_ARCHIVE_COMMAND) == 0 )
+		printf("%s\n", archive_usage);
+	else if (strcasecmp(command, TC_FSCK_COMMAND) == 0 )
+		printf("%s\n", fsck_usage);
+	else if (strcasecmp(command, TC_METRICS_COMMAND) == 0 )
+		printf("%s\n", metrics_usage);
+	else if (strcasecmp(command, TC_MERGE_COMMAND) == 0 )
+		printf("%s\n", merge_usage);
+	else if (strcasecmp(command, TC_LOG_COMMAND) == 0 )
+		printf("%s\n", log_usage);
+	else if (strcasecmp(command, TC_TIMELINE_COMMAND) == 0 )
+		printf("%s\n", timeline_usage);
+	else if (strcasecmp(command, TC_STATS_COMMAND) == 0 )
+		printf("%s\n", stats_usage);
+	else if (strcasecmp(command, TC_PROMPT_COMMAND) == 0 )
+		printf("%s\n", prompt_usage);
+	else if (strcasecmp(command, TC_REPORT_COMMAND) == 0 )
+		printf("%s\n", report_usage);
 	else{
 		fprintf(stderr,"%s\n\n", "Command not recognized, usage:");
 		_tc_display_usage(NULL);
@@ -130,12 +380,8 @@ const char * tc_init(char tcdirectory[]){
 	const char * homePath;
 	char indexDirectory[TC_MAX_BUFF];
 	int success;
-	/* Time Variables */
-	time_t rawtime;
-	struct tm * timeinfo;
-	char currentDate[TC_MAX_BUFF/2];
-	char indexFilePath[TC_MAX_BUFF];
 	char taskDirectory[TC_MAX_BUFF];
+	char lockDirectory[TC_MAX_BUFF];
 	
 
 
@@ -151,7 +397,7 @@ const char * tc_init(char tcdirectory[]){
 		exit(1);
 	}
 
-	/* Create the index directory to store index files */
+	/* Create the index directory. Segments in it are made by their first write */
 	sprintf(indexDirectory,"%s/.tc/%s",homePath,TC_INDEX_DIR);
 
 	if ((success = _tc_directoryExists(indexDirectory)) == 0)
@@ -162,28 +408,6 @@ const char * tc_init(char tcdirectory[]){
 		exit(1);
 	}
 
-	/* 	Now that the directory is setup correctly check for the index file */
-	rawtime = time(0);
-	timeinfo = localtime (&rawtime);
-	strftime(currentDate,80,"%Y%m%d",timeinfo);
-	sprintf(indexFilePath,"%s/.tc/%s/%s.index",homePath,TC_INDEX_DIR,currentDate);
-	if ( _tc_file_exists(indexFilePath) ){
-		/* It exists so we'll have it later on to use */
-		success = 1;
-	}else{
-		/* Create the index file */
-		FILE *fp = fopen(indexFilePath, "wb");
-		if (!fp) {
-    		success = -1;
-			fprintf(stderr,"%s\n", "Could not create index file. Please check permissions");
-			exit(1);    		
-    	} else {
-    		fclose(fp);
-    		success = 1;
-    	}
-
-	}
-
 	/* Create the tasks directory */
 	sprintf(taskDirectory,"%s/.tc/%s",homePath,TC_TASK_DIR);
 	if (( success = _tc_directoryExists(taskDirectory)) == 0)
@@ -194,6 +418,62 @@ const char * tc_init(char tcdirectory[]){
 		exit(1);
 	}
 
+	/* Create the lock directory writers coordinate through */
+	sprintf(lockDirectory,"%s/.tc/%s",homePath,TC_LOCK_DIR);
+	if (( success = _tc_directoryExists(lockDirectory)) == 0)
+		success = mkdir(lockDirectory,TC_DIR_PERM);
+
+	if (success == -1) {
+		fprintf(stderr,"%s\n", "Could not create lock directory. Please check permissions");
+		exit(1);
+	}
+
 	return tcdirectory;
 
 }
+
+static void _tc_cli_output(int level, const char * message, void * outputData){
+	/* Library messages go where the command line always put them */
+	(void)outputData;
+	fprintf(level == TC_OUTPUT_ERROR ? stderr : stdout, "%s\n", message);
+}
+
+struct tc_context * _tc_cli_context(){
+	/* A library context on ~/.tc for the command being run */
+	struct tc_context * context;
+	struct tc_options options;
+	char tcHomeDirectory[TC_MAX_BUFF];
+
+	tc_init(tcHomeDirectory);
+	options.storeRoot = tcHomeDirectory;
+	options.backend = TC_BACKEND_DIRECTORY;
+	options.clock = NULL;
+	options.clockData = NULL;
+	options.output = _tc_cli_output;
+	options.outputData = NULL;
+	if(tc_lib_open(&context,&options) != TC_OK){
+		fprintf(stderr,"%s\n", "Could not open the .tc directory. Please check permissions");
+		exit(1);
+	}
+	return context;
+}
+
+void _tc_cli_done(struct tc_context * context, int result){
+	/* The library has already explained user errors, only failures are left */
+	tc_lib_close(context);
+	if(result == TC_ERR_IO || result == TC_ERR_NOMEM || result == TC_ERR_TIME){
+		fprintf(stderr, "%s. Exiting\n", tc_lib_strerror(result));
+		exit(1);
+	}
+}
+
+void _tc_cli_task_name(int argc, char const *argv[], char * taskName){
+	/* The words after the command into a TC_MAX_BUFF buffer, or exit */
+	int result;
+
+	result = _resolve_taskName_from_args(argc,argv,taskName);
+	if(result != TC_OK){
+		fprintf(stderr, "%s\n", result == TC_ERR_NOMEM ? "Could not allocate memory for the arguments." : "The name given is too long. Please use a shorter one");
+		exit(1);
+	}
+}
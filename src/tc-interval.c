@@ -0,0 +1,249 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tc-interval.h"
+#include "tc-task.h"
+#include "tc-directory.h"
+
+void _tc_spans_reset(struct tc_spans * spans){
+	memset(spans,0,sizeof(*spans));
+	spans->state = TC_TASK_NOT_FOUND;
+}
+
+void _tc_spans_record(int seqNum, int seqState, time_t seqTime, void * data){
+	/* The transitions _tc_task_summary_record counts, kept one by one */
+	struct tc_spans * spans = data;
+	struct tc_span * grown, * span;
+	size_t capacity;
+	(void)seqNum;
+
+	if(spans->state == TC_TASK_STARTED && (seqState == TC_TASK_PAUSED || seqState == TC_TASK_FINISHED) && spans->failed == FALSE){
+		if(spans->count == spans->capacity){
+			capacity = spans->capacity ? spans->capacity*2 : 64;
+			grown = realloc(spans->spans,capacity*sizeof(*grown));
+			if(grown == NULL){
+				spans->failed = TRUE;
+				return;
+			}
+			spans->spans = grown;
+			spans->capacity = capacity;
+		}
+		span = spans->spans + spans->count;
+		span->start = spans->openStart;
+		span->end = seqTime;
+		span->before = spans->count ? span[-1].before + (span[-1].end - span[-1].start) : 0;
+		++spans->count;
+	}
+	if(seqState == TC_TASK_STARTED && spans->state != TC_TASK_STARTED)
+		spans->openStart = seqTime;
+	spans->state = seqState;
+}
+
+void _tc_spans_from_text(char const * text, size_t length, struct tc_spans * spans){
+	/* For sequences with no span file, archived ones */
+	_tc_spans_reset(spans);
+	_tc_seq_parse(text,length,_tc_spans_record,spans);
+}
+
+static int64_t _tc_spans_map(char const * spanPath, struct tc_spans * spans){
+	/* Map a span file, returns the sequence bytes it covers or -1 */
+	struct tc_span_header * header;
+	struct stat fileStat;
+	void * mapped;
+	int fd;
+
+	fd = open(spanPath,O_RDONLY);
+	if(fd == -1)
+		return -1;
+	if(fstat(fd,&fileStat) == -1 || (size_t)fileStat.st_size < sizeof(*header)){
+		close(fd);
+		return -1;
+	}
+	mapped = mmap(NULL,fileStat.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd);
+	if(mapped == MAP_FAILED)
+		return -1;
+
+	header = mapped;
+	if(memcmp(header->magic,TC_SPAN_MAGIC,sizeof(TC_SPAN_MAGIC)) != 0 || header->version != TC_SPAN_VERSION
+		|| header->byteOrder != TC_SPAN_BYTE_ORDER || header->count < 0 || header->seqBytes < 0
+		|| (size_t)fileStat.st_size != sizeof(*header) + (size_t)header->count*sizeof(struct tc_span)){
+		munmap(mapped,fileStat.st_size);
+		return -1;
+	}
+	spans->base = mapped;
+	spans->size = fileStat.st_size;
+	spans->spans = (struct tc_span *)(header + 1);
+	spans->count = header->count;
+	spans->state = header->state;
+	spans->openStart = header->openStart;
+	return header->seqBytes;
+}
+
+static void _tc_spans_save(char const * spanPath, struct tc_spans * spans, int64_t seqBytes){
+	/* Best effort, a reader that can't write the cache still has its answer */
+	char spanTempPath[TC_MAX_BUFF*2];
+	struct tc_span_header header;
+	FILE * fp;
+	int written;
+
+	/* Readers may race to save, each writes its own file */
+	sprintf(spanTempPath,"%s.%ld.tmp",spanPath,(long)getpid());
+	fp = fopen(spanTempPath,"wb");
+	if(!fp)
+		return;
+	memset(&header,0,sizeof(header));
+	memcpy(header.magic,TC_SPAN_MAGIC,sizeof(TC_SPAN_MAGIC));
+	header.version = TC_SPAN_VERSION;
+	header.byteOrder = TC_SPAN_BYTE_ORDER;
+	header.seqBytes = seqBytes;
+	header.count = spans->count;
+	header.state = spans->state;
+	header.openStart = spans->openStart;
+	written = fwrite(&header,sizeof(header),1,fp) == 1
+		&& (spans->count == 0 || fwrite(spans->spans,sizeof(*spans->spans),spans->count,fp) == spans->count);
+	if(fclose(fp) != 0 || written == FALSE || rename(spanTempPath,spanPath) != 0)
+		remove(spanTempPath);
+}
+
+int _tc_spans_open(char const * tcHomeDirectory, char const * taskHash, struct tc_spans * spans){
+	/* A task's intervals, catching its span file up with the sequence first */
+	char taskSequencePath[TC_MAX_BUFF*2];
+	char spanPath[TC_MAX_BUFF*2];
+	struct tc_span * owned;
+	struct stat fileStat;
+	int64_t covered;
+	size_t consumed;
+	char * text;
+	int fd;
+
+	_tc_spans_reset(spans);
+	_tc_getTaskFilePath(taskSequencePath,tcHomeDirectory,taskHash,TC_SEQ_EXT);
+	_tc_getTaskFilePath(spanPath,tcHomeDirectory,taskHash,TC_SPAN_EXT);
+	fd = open(taskSequencePath,O_RDONLY);
+	if(fd == -1)
+		return errno == ENOENT ? TC_ERR_NOT_FOUND : TC_ERR_IO;
+	if(fstat(fd,&fileStat) == -1){
+		close(fd);
+		return TC_ERR_IO;
+	}
+
+	/* Nearly always nothing was appended since, the mapping is the answer */
+	covered = _tc_spans_map(spanPath,spans);
+	if(covered == (int64_t)fileStat.st_size){
+		close(fd);
+		return TC_OK;
+	}
+
+	text = NULL;
+	if(fileStat.st_size > 0){
+		text = mmap(NULL,fileStat.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+		if(text == MAP_FAILED){
+			close(fd);
+			_tc_spans_free(spans);
+			return TC_ERR_IO;
+		}
+	}
+	close(fd);
+
+	/* Only whole lines, a writer may be halfway through the last one */
+	for(consumed = fileStat.st_size; consumed > 0 && text[consumed-1] != '\n'; --consumed)
+		;
+
+	/* Carry on from the cached intervals unless the sequence was replaced */
+	if(covered >= 0 && (size_t)covered <= consumed && (covered == 0 || text[covered-1] == '\n')){
+		owned = spans->count ? malloc((spans->count + 64)*sizeof(*owned)) : NULL;
+		if(spans->count && owned == NULL){
+			munmap(text,fileStat.st_size);
+			_tc_spans_free(spans);
+			return TC_ERR_NOMEM;
+		}
+		if(owned != NULL)
+			memcpy(owned,spans->spans,spans->count*sizeof(*owned));
+		munmap(spans->base,spans->size);
+		spans->base = NULL;
+		spans->size = 0;
+		spans->spans = owned;
+		spans->capacity = owned ? spans->count + 64 : 0;
+	}else{
+		_tc_spans_free(spans);
+		covered = 0;
+	}
+	if(consumed > (size_t)covered)
+		_tc_seq_parse(text + covered,consumed - covered,_tc_spans_record,spans);
+	if(text != NULL)
+		munmap(text,fileStat.st_size);
+
+	if(spans->failed){
+		_tc_spans_free(spans);
+		return TC_ERR_NOMEM;
+	}
+	_tc_spans_save(spanPath,spans,consumed);
+	return TC_OK;
+}
+
+time_t _tc_spans_between(struct tc_spans * spans, time_t from, time_t to, time_t now){
+	/* Seconds worked in [from, to), the running interval counting up to now */
+	struct tc_span * first, * last;
+	size_t low, high, middle, lastAfter;
+	time_t worked, start, end;
+
+	worked = 0;
+	if(to <= from)
+		return 0;
+
+	/* The first interval ending after from... */
+	low = 0;
+	high = spans->count;
+	while(low < high){
+		middle = low + (high - low)/2;
+		if(spans->spans[middle].end > from)
+			high = middle;
+		else
+			low = middle + 1;
+	}
+	/* ...and the first one starting at or after to */
+	lastAfter = low;
+	high = spans->count;
+	while(lastAfter < high){
+		middle = lastAfter + (high - lastAfter)/2;
+		if(spans->spans[middle].start < to)
+			lastAfter = middle + 1;
+		else
+			high = middle;
+	}
+
+	if(low < lastAfter){
+		first = spans->spans + low;
+		last = spans->spans + lastAfter - 1;
+		worked = last->before + (last->end - last->start) - first->before;
+		if(first->start < from)
+			worked -= from - first->start;
+		if(last->end > to)
+			worked -= last->end - to;
+	}
+
+	if(spans->state == TC_TASK_STARTED){
+		start = spans->openStart > from ? spans->openStart : from;
+		end = now < to ? now : to;
+		if(end > start)
+			worked += end - start;
+	}
+	return worked;
+}
+
+void _tc_spans_free(struct tc_spans * spans){
+	if(spans->base != NULL)
+		munmap(spans->base,spans->size);
+	else
+		free(spans->spans);
+	_tc_spans_reset(spans);
+}
@@ -0,0 +1,354 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "tc-journal.h"
+#include "tc-lock.h"
+#include "tc-task.h"
+
+#define TC_JOURNAL_RECORD (long)sizeof(struct tc_journal_record)
+#define TC_JOURNAL_HEADER (long)sizeof(struct tc_journal_header)
+
+static void _tc_journal_paths(char const * tcHomeDirectory, char * recordsPath, char * marksPath){
+	sprintf(recordsPath,"%s/%s",tcHomeDirectory,TC_JOURNAL_FILE);
+	sprintf(marksPath,"%s/%s",tcHomeDirectory,TC_JOURNAL_MARKS);
+}
+
+static int _tc_journal_header_check(FILE * fp, int64_t * count){
+	/* TC_OK for a journal this machine wrote, count gets its whole records */
+	struct tc_journal_header header;
+	long size;
+
+	if(fseek(fp,0,SEEK_END) != 0 || (size = ftell(fp)) < 0)
+		return TC_ERR_IO;
+	rewind(fp);
+	if(fread(&header,sizeof(header),1,fp) != 1 || strcmp(header.magic,TC_JOURNAL_MAGIC) != 0
+		|| header.version != TC_JOURNAL_VERSION || header.byteOrder != TC_JOURNAL_BYTE_ORDER)
+		return TC_ERR_IO;
+	*count = (size - TC_JOURNAL_HEADER)/TC_JOURNAL_RECORD;
+	return TC_OK;
+}
+
+static int _tc_journal_open(char const * tcHomeDirectory, FILE ** fp, int64_t * count){
+	/* For reading. A store without a journal has an empty one */
+	char recordsPath[TC_MAX_BUFF*2];
+	char marksPath[TC_MAX_BUFF*2];
+
+	_tc_journal_paths(tcHomeDirectory,recordsPath,marksPath);
+	*count = 0;
+	if((*fp = fopen(recordsPath,"rb")) == NULL)
+		return errno == ENOENT ? TC_OK : TC_ERR_IO;
+	if(_tc_journal_header_check(*fp,count) != TC_OK){
+		fclose(*fp);
+		*fp = NULL;
+		return TC_ERR_IO;
+	}
+	return TC_OK;
+}
+
+static int _tc_journal_mark(struct tc_journal * journal, int64_t block){
+	if(fseek(journal->marks,(long)(block*sizeof(journal->latest)),SEEK_SET) != 0
+		|| fwrite(&journal->latest,sizeof(journal->latest),1,journal->marks) != 1)
+		return TC_ERR_IO;
+	return TC_OK;
+}
+
+static int _tc_journal_remark(struct tc_journal * journal, int64_t block){
+	/* Mark again from block on, reading the records it covers */
+	struct tc_journal_record record;
+	int64_t i;
+
+	journal->latest = 0;
+	if(block > 0 && (fseek(journal->marks,(long)((block - 1)*sizeof(journal->latest)),SEEK_SET) != 0
+		|| fread(&journal->latest,sizeof(journal->latest),1,journal->marks) != 1))
+		return TC_ERR_IO;
+	if(fseek(journal->records,TC_JOURNAL_HEADER + (long)(block*TC_JOURNAL_STRIDE)*TC_JOURNAL_RECORD,SEEK_SET) != 0)
+		return TC_ERR_IO;
+	for(i = block*TC_JOURNAL_STRIDE; i < journal->count; ++i){
+		if(fread(&record,sizeof(record),1,journal->records) != 1)
+			return TC_ERR_IO;
+		if(record.eventTime > journal->latest)
+			journal->latest = record.eventTime;
+		if((i + 1) % TC_JOURNAL_STRIDE == 0 || i + 1 == journal->count){
+			if(_tc_journal_mark(journal,i/TC_JOURNAL_STRIDE) != TC_OK)
+				return TC_ERR_IO;
+			/* Reads and writes of one stream need a seek between them */
+			if(fseek(journal->records,TC_JOURNAL_HEADER + (long)(i + 1)*TC_JOURNAL_RECORD,SEEK_SET) != 0)
+				return TC_ERR_IO;
+		}
+	}
+	return TC_OK;
+}
+
+int _tc_journal_begin(char const * tcHomeDirectory, struct tc_journal * journal){
+	/* Take the journal lock and open it for appending, creating it on the
+	 * first event and dropping a record cut short by a crash */
+	struct tc_journal_header header;
+	char recordsPath[TC_MAX_BUFF*2];
+	char marksPath[TC_MAX_BUFF*2];
+	int64_t marked;
+	long size;
+	int result;
+
+	memset(journal,0,sizeof(*journal));
+	journal->lock = _tc_lock_acquire(tcHomeDirectory,TC_LOCK_JOURNAL);
+	if(journal->lock == -1)
+		return TC_ERR_IO;
+	strcpy(journal->root,tcHomeDirectory);
+	_tc_journal_paths(tcHomeDirectory,recordsPath,marksPath);
+
+	result = TC_OK;
+	if((journal->records = fopen(recordsPath,"r+b")) != NULL){
+		result = _tc_journal_header_check(journal->records,&journal->count);
+	}else if(errno == ENOENT && (journal->records = fopen(recordsPath,"w+b")) != NULL){
+		memset(&header,0,sizeof(header));
+		strcpy(header.magic,TC_JOURNAL_MAGIC);
+		header.version = TC_JOURNAL_VERSION;
+		header.byteOrder = TC_JOURNAL_BYTE_ORDER;
+		if(fwrite(&header,sizeof(header),1,journal->records) != 1 || fflush(journal->records) != 0)
+			result = TC_ERR_IO;
+	}else{
+		result = TC_ERR_IO;
+	}
+	if(result == TC_OK && (journal->marks = fopen(marksPath,"r+b")) == NULL && (errno != ENOENT || (journal->marks = fopen(marksPath,"w+b")) == NULL))
+		result = TC_ERR_IO;
+	if(result == TC_OK && ftruncate(fileno(journal->records),TC_JOURNAL_HEADER + (long)journal->count*TC_JOURNAL_RECORD) != 0)
+		result = TC_ERR_IO;
+
+	/* The mark of the last stretch may be behind its records, and every mark
+	 * is missing for a journal older than its marks file */
+	if(result == TC_OK && fseek(journal->marks,0,SEEK_END) == 0 && (size = ftell(journal->marks)) >= 0){
+		marked = size/(long)sizeof(journal->latest);
+		if(journal->count > 0 && marked > (journal->count - 1)/TC_JOURNAL_STRIDE)
+			marked = (journal->count - 1)/TC_JOURNAL_STRIDE;
+		result = _tc_journal_remark(journal,journal->count > 0 ? marked : 0);
+	}
+	if(result == TC_OK && fseek(journal->records,TC_JOURNAL_HEADER + (long)journal->count*TC_JOURNAL_RECORD,SEEK_SET) != 0)
+		result = TC_ERR_IO;
+	if(result != TC_OK){
+		if(journal->records)
+			fclose(journal->records);
+		if(journal->marks)
+			fclose(journal->marks);
+		_tc_lock_release(journal->lock);
+		journal->lock = -1;
+	}
+	return result;
+}
+
+int _tc_journal_write(struct tc_journal * journal, time_t eventTime, char const * taskHash, int state, int seqNum){
+	/* One record at the end. Marks are written as each stretch fills up,
+	 * and for the last one on commit */
+	struct tc_journal_record record;
+
+	if(strlen(taskHash) >= sizeof(record.taskHash))
+		return TC_ERR_ARGS;
+	memset(&record,0,sizeof(record));
+	record.eventTime = eventTime;
+	record.state = state;
+	record.seqNum = seqNum;
+	strcpy(record.taskHash,taskHash);
+	if(fwrite(&record,sizeof(record),1,journal->records) != 1)
+		return TC_ERR_IO;
+	if(record.eventTime > journal->latest)
+		journal->latest = record.eventTime;
+	if(++journal->count % TC_JOURNAL_STRIDE == 0)
+		return _tc_journal_mark(journal,(journal->count - 1)/TC_JOURNAL_STRIDE);
+	return TC_OK;
+}
+
+int _tc_journal_reset(struct tc_journal * journal){
+	/* Empty the journal, for a rewrite from the histories */
+	if(fflush(journal->records) != 0 || fflush(journal->marks) != 0
+		|| ftruncate(fileno(journal->records),TC_JOURNAL_HEADER) != 0 || ftruncate(fileno(journal->marks),0) != 0
+		|| fseek(journal->records,TC_JOURNAL_HEADER,SEEK_SET) != 0)
+		return TC_ERR_IO;
+	journal->count = 0;
+	journal->latest = 0;
+	return TC_OK;
+}
+
+int _tc_journal_commit(struct tc_journal * journal){
+	/* Mark the last stretch, close and unlock */
+	int result;
+
+	result = TC_OK;
+	if(journal->count % TC_JOURNAL_STRIDE != 0)
+		result = _tc_journal_mark(journal,(journal->count - 1)/TC_JOURNAL_STRIDE);
+	if(fclose(journal->records) != 0)
+		result = TC_ERR_IO;
+	if(fclose(journal->marks) != 0)
+		result = TC_ERR_IO;
+	_tc_lock_release(journal->lock);
+	journal->lock = -1;
+	return result;
+}
+
+long _tc_journal_drop(struct tc_journal * journal, tc_journal_filter drop, void * data){
+	/* Take the records drop picks out of the journal, sliding the rest down
+	 * over them a stretch at a time, and mark it all again. Call between
+	 * begin and commit. Returns how many were dropped, -1 on failure.
+	*/
+	struct tc_journal_record * records;
+	int64_t read, kept;
+	size_t got, out, i;
+	long dropped;
+	int result;
+
+	records = malloc(TC_JOURNAL_STRIDE*sizeof(*records));
+	if(records == NULL)
+		return -1;
+	result = TC_OK;
+	read = kept = 0;
+	dropped = 0;
+	while(read < journal->count && result == TC_OK){
+		if(fseek(journal->records,TC_JOURNAL_HEADER + (long)read*TC_JOURNAL_RECORD,SEEK_SET) != 0
+			|| (got = fread(records,sizeof(*records),journal->count - read < TC_JOURNAL_STRIDE ? (size_t)(journal->count - read) : TC_JOURNAL_STRIDE,journal->records)) == 0){
+			result = TC_ERR_IO;
+			break;
+		}
+		read += got;
+		for(out = i = 0; i < got; ++i){
+			records[i].taskHash[sizeof(records[i].taskHash) - 1] = '\0';
+			if(drop(records + i,data))
+				++dropped;
+			else
+				records[out++] = records[i];
+		}
+		/* Kept records only ever move down, onto ones already read */
+		if(dropped > 0 && out > 0 && (fseek(journal->records,TC_JOURNAL_HEADER + (long)kept*TC_JOURNAL_RECORD,SEEK_SET) != 0
+			|| fwrite(records,sizeof(*records),out,journal->records) != out))
+			result = TC_ERR_IO;
+		kept += out;
+	}
+	free(records);
+	if(result != TC_OK)
+		return -1;
+	if(dropped == 0)
+		return 0;
+
+	journal->count = kept;
+	if(fflush(journal->records) != 0 || fflush(journal->marks) != 0
+		|| ftruncate(fileno(journal->records),TC_JOURNAL_HEADER + (long)kept*TC_JOURNAL_RECORD) != 0
+		|| ftruncate(fileno(journal->marks),0) != 0
+		|| _tc_journal_remark(journal,0) != TC_OK
+		|| fseek(journal->records,TC_JOURNAL_HEADER + (long)kept*TC_JOURNAL_RECORD,SEEK_SET) != 0)
+		return -1;
+	return dropped;
+}
+
+int _tc_journal_append(char const * tcHomeDirectory, time_t eventTime, char const * taskHash, int state, int seqNum){
+	struct tc_journal journal;
+	int result;
+
+	if((result = _tc_journal_begin(tcHomeDirectory,&journal)) != TC_OK)
+		return result;
+	result = _tc_journal_write(&journal,eventTime,taskHash,state,seqNum);
+	if(_tc_journal_commit(&journal) != TC_OK && result == TC_OK)
+		result = TC_ERR_IO;
+	return result;
+}
+
+long _tc_journal_count(char const * tcHomeDirectory){
+	/* Records in the journal, -1 when it can't be read */
+	int64_t count;
+	FILE * fp;
+
+	if(_tc_journal_open(tcHomeDirectory,&fp,&count) != TC_OK)
+		return -1;
+	if(fp != NULL)
+		fclose(fp);
+	return (long)count;
+}
+
+static long _tc_journal_scan(FILE * fp, int64_t first, int64_t count, time_t since, tc_journal_callback callback, void * data){
+	/* Records first up to count at or after since, a stretch at a time */
+	struct tc_journal_record * records;
+	long found;
+	size_t got, i;
+
+	records = malloc(TC_JOURNAL_STRIDE*sizeof(*records));
+	if(records == NULL)
+		return -1;
+	found = 0;
+	if(fseek(fp,TC_JOURNAL_HEADER + (long)first*TC_JOURNAL_RECORD,SEEK_SET) != 0)
+		first = count;
+	while(first < count){
+		got = fread(records,sizeof(*records),count - first < TC_JOURNAL_STRIDE ? (size_t)(count - first) : TC_JOURNAL_STRIDE,fp);
+		if(got == 0)
+			break;
+		for(i = 0; i < got; ++i){
+			if(records[i].eventTime < since)
+				continue;
+			records[i].taskHash[sizeof(records[i].taskHash) - 1] = '\0';
+			callback(records + i,data);
+			++found;
+		}
+		first += got;
+	}
+	free(records);
+	return found;
+}
+
+long _tc_journal_tail(char const * tcHomeDirectory, long count, tc_journal_callback callback, void * data){
+	/* The last count records, oldest first. Returns how many, -1 on failure */
+	int64_t records;
+	FILE * fp;
+	long found;
+
+	if(_tc_journal_open(tcHomeDirectory,&fp,&records) != TC_OK)
+		return -1;
+	if(fp == NULL)
+		return 0;
+	found = _tc_journal_scan(fp,records > count ? records - count : 0,records,0,callback,data);
+	fclose(fp);
+	return found;
+}
+
+long _tc_journal_since(char const * tcHomeDirectory, time_t since, tc_journal_callback callback, void * data){
+	/* Every record at or after since. The marks point at the first stretch
+	 * that can have one, the last of them is checked whatever it says */
+	char recordsPath[TC_MAX_BUFF*2];
+	char marksPath[TC_MAX_BUFF*2];
+	int64_t records, marked, low, high, middle, latest;
+	FILE * fp, * marks;
+	long size, found;
+
+	if(_tc_journal_open(tcHomeDirectory,&fp,&records) != TC_OK)
+		return -1;
+	if(fp == NULL)
+		return 0;
+	_tc_journal_paths(tcHomeDirectory,recordsPath,marksPath);
+
+	marked = 0;
+	low = 0;
+	if((marks = fopen(marksPath,"rb")) != NULL){
+		if(fseek(marks,0,SEEK_END) == 0 && (size = ftell(marks)) > 0)
+			marked = size/(long)sizeof(latest);
+		if(marked > (records + TC_JOURNAL_STRIDE - 1)/TC_JOURNAL_STRIDE)
+			marked = (records + TC_JOURNAL_STRIDE - 1)/TC_JOURNAL_STRIDE;
+		high = marked;
+		while(low < high){
+			middle = low + (high - low)/2;
+			if(fseek(marks,(long)(middle*sizeof(latest)),SEEK_SET) != 0 || fread(&latest,sizeof(latest),1,marks) != 1){
+				low = 0;
+				break;
+			}
+			if(latest < since)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		fclose(marks);
+	}
+	if(marked > 0 && low > marked - 1)
+		low = marked - 1;
+
+	found = _tc_journal_scan(fp,low*TC_JOURNAL_STRIDE,records,since,callback,data);
+	fclose(fp);
+	return found;
+}
@@ -0,0 +1,632 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "timecatcher.h"
+#include "tc-task.h"
+#include "tc-directory.h"
+#include "tc-store.h"
+
+struct tc_context {
+	struct tc_store * store;
+	tc_clock_fn clock;
+	void * clockData;
+	tc_output_fn output;
+	void * outputData;
+};
+
+static void _tc_lib_say(struct tc_context * context, int level, const char * format, ...){
+	/* Hand one formatted message to the caller's output, if it wants them */
+	char message[TC_MAX_BUFF*2];
+	va_list args;
+
+	if(context->output == NULL)
+		return;
+	va_start(args,format);
+	vsnprintf(message,sizeof(message),format,args);
+	va_end(args);
+	context->output(level,message,context->outputData);
+}
+
+static int _tc_lib_name_ok(const char * taskName){
+	return taskName != NULL && taskName[0] != '\0' && strlen(taskName) < TC_MAX_BUFF;
+}
+
+int tc_lib_open(struct tc_context ** context, const struct tc_options * options){
+	struct tc_context * opened;
+	char tcHomeDirectory[TC_MAX_BUFF];
+	const char * home;
+	int result;
+
+	*context = NULL;
+	opened = malloc(sizeof(*opened));
+	if(opened == NULL)
+		return TC_ERR_NOMEM;
+	memset(opened,0,sizeof(*opened));
+
+	if(options != NULL && options->backend == TC_BACKEND_MEMORY){
+		result = _tc_store_open_memory(&opened->store);
+	}else if(options != NULL && options->storeRoot != NULL){
+		result = _tc_store_open_directory(&opened->store,options->storeRoot);
+	}else{
+		home = _tc_getHomePath();
+		if(home == NULL || strlen(home) >= TC_MAX_BUFF/2)
+			result = TC_ERR_ARGS;
+		else{
+			sprintf(tcHomeDirectory,"%s/.tc",home);
+			result = _tc_store_open_directory(&opened->store,tcHomeDirectory);
+		}
+	}
+	if(result != TC_OK){
+		free(opened);
+		return result;
+	}
+
+	if(options != NULL){
+		opened->clock = options->clock;
+		opened->clockData = options->clockData;
+		opened->output = options->output;
+		opened->outputData = options->outputData;
+	}
+
+	*context = opened;
+	return TC_OK;
+}
+
+void tc_lib_close(struct tc_context * context){
+	if(context == NULL)
+		return;
+	_tc_store_close(context->store);
+	free(context);
+}
+
+const char * tc_lib_root(const struct tc_context * context){
+	return context->store->root;
+}
+
+time_t tc_lib_now(struct tc_context * context){
+	if(context->clock != NULL)
+		return context->clock(context->clockData);
+	return time(0);
+}
+
+static int _tc_lib_summary(struct tc_context * context, const char * taskName, char * taskHash, struct tc_task_summary * summary){
+	/* Replay taskName, leaving its hash behind for the write */
+	_tc_taskName_to_Hash((char *)taskName,taskHash);
+	return _tc_store_summarize(context->store,taskHash,summary);
+}
+
+static int _tc_lib_append(struct tc_context * context, const char * taskName, const char * taskHash, struct tc_task_summary * summary, int state, time_t eventTime){
+	/* Append one event and keep the timer table, the project rollups, the
+	 * session sketches and the store counters in step, everything but
+	 * current. summary is where the task stood before the event and is
+	 * moved on past it. Nothing is locked here, the caller holds the task
+	 * and current locks. */
+	struct tc_store * store = context->store;
+	char seqLine[TC_MAX_BUFF];
+	long bytes, closed;
+	int priorState, seqNum, result;
+
+	priorState = summary->state;
+	seqNum = summary->seqNum;
+	closed = 0;
+	if(priorState == TC_TASK_STARTED && (state == TC_TASK_PAUSED || state == TC_TASK_FINISHED))
+		closed = eventTime - summary->lastStart;
+
+	if((result = store->ops->task_open(store,taskHash,taskName,TRUE)) != TC_OK
+		|| (result = store->ops->append(store,taskHash,taskName,seqNum,state,eventTime)) != TC_OK)
+		return result;
+
+	/* A first event brings a new task into its projects */
+	if(store->ops->rollup(store,taskName,closed,seqNum == 0 ? 1 : 0) != TC_OK)
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Could not update the project totals. tcatch fsck --repair rebuilds them");
+
+	/* A closed interval is one more session for the sketches */
+	if(priorState == TC_TASK_STARTED && (state == TC_TASK_PAUSED || state == TC_TASK_FINISHED)
+		&& store->ops->session(store,taskHash,closed,eventTime) != TC_OK)
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Could not update the session sketches. tcatch fsck --repair rebuilds them");
+
+	/* The sequence line, and the name line of a new task's info file */
+	bytes = sprintf(seqLine, "%i %i %ld\n", seqNum, state, (long)eventTime);
+	if(seqNum == 0)
+		bytes += strlen(taskName) + 1;
+	if(store->ops->tally(store,priorState,state,bytes) != TC_OK)
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Could not update the store counters. tcatch fsck --repair recounts them");
+
+	/* A paused or finished task is no longer a running timer */
+	if(state == TC_TASK_PAUSED || state == TC_TASK_FINISHED)
+		store->ops->active_remove(store,taskHash);
+
+	_tc_task_summary_record(seqNum,state,eventTime,summary);
+	return TC_OK;
+}
+
+static int _tc_lib_write(struct tc_context * context, const char * taskName, const char * taskHash, struct tc_task_summary * summary, int state, time_t eventTime){
+	/* Append one event, then bring current along with it */
+	struct tc_store * store = context->store;
+	char currentTaskName[TC_MAX_BUFF+1];
+	int result;
+
+	result = _tc_lib_append(context,taskName,taskHash,summary,state,eventTime);
+	if(result != TC_OK)
+		return result;
+
+	/* A started task is the current task. Other tasks finishing must not
+	 * take over the current task, but the current one's event is kept there */
+	store->ops->current_get(store,currentTaskName);
+	if(state == TC_TASK_STARTED || strcmp(currentTaskName,taskName) == 0)
+		return store->ops->current_set(store,taskName,taskHash,summary);
+	return TC_OK;
+}
+
+static int _tc_lib_clear_current(struct tc_context * context){
+	return context->store->ops->current_clear(context->store);
+}
+
+static void _tc_lib_fill_status(const char * taskName, const char * taskHash, struct tc_task_summary * summary, time_t now, struct tc_status * status){
+	memset(status,0,sizeof(*status));
+	strcpy(status->taskName,taskName);
+	strcpy(status->taskHash,taskHash);
+	status->state = summary->state;
+	status->seqNum = summary->seqNum;
+	status->startTime = summary->startTime;
+	status->lastUpdate = summary->lastTime;
+	status->worked = summary->accumulated;
+	if(summary->state == TC_TASK_STARTED)
+		status->worked += now - summary->lastStart;
+}
+
+static void _tc_lib_from_slot(const struct tc_active_slot * slot, struct tc_task_summary * summary){
+	summary->state = TC_TASK_STARTED;
+	summary->seqNum = slot->seqNum;
+	summary->startTime = slot->startTime;
+	summary->lastStart = slot->lastStart;
+	summary->lastTime = slot->lastStart;
+	summary->accumulated = slot->accumulated;
+}
+
+static void _tc_lib_to_slot(const struct tc_task_summary * summary, struct tc_active_slot * slot){
+	slot->seqNum = summary->seqNum;
+	slot->startTime = summary->startTime;
+	slot->lastStart = summary->lastStart;
+	slot->accumulated = summary->accumulated;
+}
+
+static int _tc_lib_slot_summary(struct tc_context * context, const char * taskName, char * taskHash, struct tc_task_summary * summary){
+	/* Running timers come straight from the active table, others are replayed */
+	struct tc_active_slot slot;
+
+	_tc_taskName_to_Hash((char *)taskName,taskHash);
+	if(context->store->ops->active_find(context->store,taskHash,&slot) == FALSE)
+		return _tc_lib_summary(context,taskName,taskHash,summary);
+	_tc_lib_from_slot(&slot,summary);
+	return summary->state;
+}
+
+static void _tc_lib_say_started(struct tc_context * context, const char * taskName, int priorState){
+	if(priorState == TC_TASK_NOT_FOUND)
+		_tc_lib_say(context, TC_OUTPUT_INFO, "Task: %s has been started.", taskName);
+	else
+		_tc_lib_say(context, TC_OUTPUT_INFO, "Resuming task: %s", taskName);
+}
+
+static int _tc_lib_begin(struct tc_context * context, const char * taskName, time_t now){
+	/* Start or resume taskName, the caller holds its lock and current's */
+	struct tc_task_summary summary;
+	char taskHash[TC_MAX_BUFF];
+	int priorState, result;
+
+	_tc_lib_summary(context,taskName,taskHash,&summary);
+	if(summary.state == TC_TASK_STARTED){
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "That task is already running.");
+		return TC_ERR_ALREADY;
+	}
+
+	priorState = summary.state;
+	result = _tc_lib_write(context,taskName,taskHash,&summary,TC_TASK_STARTED,now);
+	if(result != TC_OK)
+		return result;
+	_tc_lib_say_started(context,taskName,priorState);
+	return TC_OK;
+}
+
+static int _tc_lib_switch(struct tc_context * context, const char * taskName, const char * currentTaskName, time_t now){
+	/* Pause the current task and start taskName at the same second, the
+	 * caller holds both their locks and current's. Both events go in before
+	 * current is touched, and then current is renamed straight from the old
+	 * task's record to the new one's, so it never goes missing in between */
+	struct tc_task_summary paused, started;
+	char pausedName[TC_MAX_BUFF];
+	char pausedHash[TC_MAX_BUFF];
+	char startedHash[TC_MAX_BUFF];
+	int priorState, result;
+
+	/* Refuse before writing anything rather than leave the old task paused */
+	_tc_lib_summary(context,taskName,startedHash,&started);
+	if(started.state == TC_TASK_STARTED){
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "That task is already running.");
+		return TC_ERR_ALREADY;
+	}
+
+	/* The old task's standing comes from current's record, not a replay */
+	result = TC_OK;
+	if(context->store->ops->current_summary(context->store,pausedName,pausedHash,&paused) == TC_OK
+		&& strcmp(pausedName,currentTaskName) == 0 && paused.state == TC_TASK_STARTED)
+		result = _tc_lib_append(context,currentTaskName,pausedHash,&paused,TC_TASK_PAUSED,now);
+	priorState = started.state;
+	if(result == TC_OK)
+		result = _tc_lib_append(context,taskName,startedHash,&started,TC_TASK_STARTED,now);
+	if(result == TC_OK)
+		result = context->store->ops->current_set(context->store,taskName,startedHash,&started);
+	if(result != TC_OK)
+		return result;
+	_tc_lib_say_started(context,taskName,priorState);
+	return TC_OK;
+}
+
+static int _tc_lib_replay_slot(struct tc_context * context, const char * taskName, struct tc_active_slot * slot, struct tc_task_summary * summary){
+	/* Build a timer slot for taskName from its history. Returns its last state */
+	char taskHash[TC_MAX_BUFF];
+
+	memset(slot,0,sizeof(*slot));
+	_tc_lib_summary(context,taskName,taskHash,summary);
+	strcpy(slot->taskHash,taskHash);
+	strcpy(slot->taskName,taskName);
+	_tc_lib_to_slot(summary,slot);
+	return summary->state;
+}
+
+static int _tc_lib_adopt(struct tc_context * context, const char * taskName){
+	/* Put an already running task into the active table as it is */
+	struct tc_task_summary summary;
+	struct tc_active_slot slot;
+	char taskHash[TC_MAX_BUFF];
+
+	_tc_taskName_to_Hash((char *)taskName,taskHash);
+	if(context->store->ops->active_find(context->store,taskHash,&slot) == TRUE)
+		return TC_OK;
+	if(_tc_lib_replay_slot(context,taskName,&slot,&summary) != TC_TASK_STARTED)
+		return TC_OK;
+	return context->store->ops->active_insert(context->store,&slot);
+}
+
+static int _tc_lib_start_multi(struct tc_context * context, const char * taskName, const char * currentTaskName, time_t now){
+	/* Start taskName as one more running timer, nothing else is paused */
+	struct tc_task_summary summary;
+	struct tc_active_slot slot;
+	char taskHash[TC_MAX_BUFF];
+	int lastState, result;
+
+	/* The single-mode current task keeps its timer running in the table */
+	if(currentTaskName[0] != '\0' && strcmp(currentTaskName,taskName) != 0)
+		_tc_lib_adopt(context,currentTaskName);
+
+	_tc_taskName_to_Hash((char *)taskName,taskHash);
+	if(context->store->ops->active_find(context->store,taskHash,&slot) == TRUE){
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "That task is already running.");
+		return TC_ERR_ALREADY;
+	}
+
+	lastState = _tc_lib_replay_slot(context,taskName,&slot,&summary);
+	if(lastState != TC_TASK_STARTED){
+		result = _tc_lib_write(context,taskName,taskHash,&summary,TC_TASK_STARTED,now);
+		if(result != TC_OK)
+			return result;
+		_tc_lib_to_slot(&summary,&slot);
+	}
+
+	result = context->store->ops->active_insert(context->store,&slot);
+	if(result == TC_ERR_FULL)
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "Only %i timers can run at once. Pause or finish one first.", TC_ACTIVE_SLOTS);
+	else if(result != TC_OK)
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Could not open the active task table. Please check permissions");
+	else if(lastState == TC_TASK_STARTED)
+		/* Running outside the table (started in single mode), just track it */
+		_tc_lib_say(context, TC_OUTPUT_INFO, "Task: %s is now tracked as a running timer.", taskName);
+	else
+		_tc_lib_say(context, TC_OUTPUT_INFO, "Task: %s is running alongside the other timers.", taskName);
+	return result;
+}
+
+static int _tc_lib_locked(struct tc_context * context, int result){
+	/* Say why the store's locks could not be taken */
+	if(result == TC_ERR_BUSY)
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "The current task keeps changing, try again.");
+	else if(result != TC_OK)
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Could not take the store's locks. Please check permissions");
+	return result;
+}
+
+static int _tc_lib_lock(struct tc_context * context, const char * taskName, int withCurrentTask, char * currentTaskName, struct tc_lockset * locks, time_t * now){
+	/* Lock for a write and only then read the clock, so events stay in order */
+	int result;
+
+	result = context->store->ops->lock(context->store,taskName,withCurrentTask,currentTaskName,locks);
+	if(result != TC_OK)
+		return _tc_lib_locked(context,result);
+	*now = tc_lib_now(context);
+	if(*now == -1){
+		context->store->ops->unlock(context->store,locks);
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Could not determine time.");
+		return TC_ERR_TIME;
+	}
+	return TC_OK;
+}
+
+static int _tc_lib_unarchive(struct tc_context * context, const char * taskName){
+	/* An archived task comes back before anything is appended to it, so it
+	 * picks up where it left off. The caller holds the task's lock */
+	char taskHash[TC_MAX_BUFF];
+	int result;
+
+	_tc_taskName_to_Hash((char *)taskName,taskHash);
+	if(context->store->ops->task_open(context->store,taskHash,taskName,FALSE) != TC_ERR_NOT_FOUND)
+		return TC_OK;
+	result = context->store->ops->restore(context->store,taskHash);
+	if(result == TC_ERR_NOT_FOUND)
+		return TC_OK;
+	if(result != TC_OK)
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Could not bring the task back from the archive. Please check permissions");
+	return result;
+}
+
+int tc_lib_start(struct tc_context * context, const char * taskName, int flags){
+	struct tc_lockset locks;
+	char currentTaskName[TC_MAX_BUFF];
+	time_t now;
+	int result;
+
+	if(!_tc_lib_name_ok(taskName))
+		return TC_ERR_ARGS;
+
+	/* Switching writes the current task too, and multi-timer mode may adopt
+	 * it into the active table, so both need that task's lock */
+	result = _tc_lib_lock(context,taskName,(flags & (TC_START_SWITCH|TC_START_MULTI)) != 0,currentTaskName,&locks,&now);
+	if(result != TC_OK)
+		return result;
+
+	if((result = _tc_lib_unarchive(context,taskName)) != TC_OK){
+		context->store->ops->unlock(context->store,&locks);
+		return result;
+	}
+
+	if(flags & TC_START_MULTI){
+		result = _tc_lib_start_multi(context,taskName,currentTaskName,now);
+	}else if(currentTaskName[0] == '\0'){
+		/* No current task anyway so just start the task */
+		result = _tc_lib_begin(context,taskName,now);
+	}else if((flags & TC_START_SWITCH) == 0){
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "There is already a task being worked on. Finish the current task first or switch tasks.");
+		result = TC_ERR_BUSY;
+	}else if(strcmp(currentTaskName,taskName) == 0){
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Already working on that task. No need to switch");
+		result = TC_ERR_ALREADY;
+	}else{
+		result = _tc_lib_switch(context,taskName,currentTaskName,now);
+	}
+
+	context->store->ops->unlock(context->store,&locks);
+	return result;
+}
+
+int tc_lib_pause(struct tc_context * context, const char * taskName){
+	struct tc_task_summary summary;
+	struct tc_active_slot slot;
+	struct tc_lockset locks;
+	char currentTaskName[TC_MAX_BUFF];
+	char recordName[TC_MAX_BUFF];
+	char taskHash[TC_MAX_BUFF];
+	time_t now;
+	int result;
+
+	if(taskName != NULL && !_tc_lib_name_ok(taskName))
+		return TC_ERR_ARGS;
+
+	if(taskName == NULL){
+		/* Pause whatever is current */
+		result = _tc_lib_lock(context,NULL,TRUE,currentTaskName,&locks,&now);
+		if(result != TC_OK)
+			return result;
+		if(currentTaskName[0] == '\0'){
+			_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "No current task to pause.");
+			result = TC_ERR_NO_CURRENT;
+		}else{
+			/* current's record has where the task stands, and is cleared
+			 * rather than rewritten after the event */
+			result = TC_OK;
+			if(context->store->ops->current_summary(context->store,recordName,taskHash,&summary) == TC_OK
+				&& strcmp(recordName,currentTaskName) == 0 && summary.state == TC_TASK_STARTED)
+				result = _tc_lib_append(context,currentTaskName,taskHash,&summary,TC_TASK_PAUSED,now);
+			if(result == TC_OK)
+				result = _tc_lib_clear_current(context);
+			if(result == TC_OK)
+				_tc_lib_say(context, TC_OUTPUT_INFO, "%s", "The current task has been paused.");
+		}
+		context->store->ops->unlock(context->store,&locks);
+		return result;
+	}
+
+	/* In multi-timer mode any running task can be paused by name, the table
+	 * has everything the pause needs so there is no replay */
+	result = _tc_lib_lock(context,taskName,FALSE,currentTaskName,&locks,&now);
+	if(result != TC_OK)
+		return result;
+	_tc_taskName_to_Hash((char *)taskName,taskHash);
+	if(context->store->ops->active_find(context->store,taskHash,&slot) == FALSE){
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "That task is not a running timer.");
+		result = TC_ERR_NOT_FOUND;
+	}else{
+		_tc_lib_from_slot(&slot,&summary);
+		result = _tc_lib_append(context,taskName,taskHash,&summary,TC_TASK_PAUSED,now);
+		/* Pausing the current task clears current like a plain pause */
+		if(result == TC_OK && strcmp(currentTaskName,taskName) == 0)
+			result = _tc_lib_clear_current(context);
+		if(result == TC_OK)
+			_tc_lib_say(context, TC_OUTPUT_INFO, "Task: %s has been paused.", taskName);
+	}
+	context->store->ops->unlock(context->store,&locks);
+	return result;
+}
+
+int tc_lib_finish(struct tc_context * context, const char * taskName, struct tc_status * finished){
+	struct tc_task_summary summary;
+	struct tc_lockset locks;
+	char currentTaskName[TC_MAX_BUFF];
+	char taskHash[TC_MAX_BUFF];
+	time_t now;
+	int result;
+
+	if(!_tc_lib_name_ok(taskName))
+		return TC_ERR_ARGS;
+
+	result = _tc_lib_lock(context,taskName,FALSE,currentTaskName,&locks,&now);
+	if(result != TC_OK)
+		return result;
+	_tc_lib_slot_summary(context,taskName,taskHash,&summary);
+	if(summary.state == TC_TASK_NOT_FOUND){
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Could not find the task to finish");
+		result = TC_ERR_NOT_FOUND;
+	}else if(summary.state == TC_TASK_FINISHED){
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Task is already finished. To resume use the start -s command");
+		result = TC_ERR_FINISHED;
+	}else{
+		result = _tc_lib_append(context,taskName,taskHash,&summary,TC_TASK_FINISHED,now);
+		/* If this task was the current task, there is no current task anymore */
+		if(result == TC_OK && strcmp(currentTaskName,taskName) == 0)
+			result = _tc_lib_clear_current(context);
+		if(result == TC_OK && finished != NULL)
+			_tc_lib_fill_status(taskName,taskHash,&summary,now,finished);
+	}
+	context->store->ops->unlock(context->store,&locks);
+	return result;
+}
+
+int tc_lib_add_info(struct tc_context * context, const char * text){
+	struct tc_store * store = context->store;
+	struct tc_lockset locks;
+	char currentTaskName[TC_MAX_BUFF];
+	char taskHash[TC_MAX_BUFF];
+	int result;
+
+	if(text == NULL)
+		return TC_ERR_ARGS;
+
+	if((result = store->ops->lock(store,NULL,TRUE,currentTaskName,&locks)) != TC_OK)
+		return _tc_lib_locked(context,result);
+	if(currentTaskName[0] == '\0'){
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "No current task to add information to.");
+		store->ops->unlock(store,&locks);
+		return TC_ERR_NO_CURRENT;
+	}
+
+	/* Information goes to the info file alone, it is not an event */
+	_tc_taskName_to_Hash(currentTaskName,taskHash);
+	if(store->ops->task_open(store,taskHash,currentTaskName,FALSE) != TC_OK){
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Could not find information file for current task.");
+		result = TC_ERR_NOT_FOUND;
+	}else{
+		result = store->ops->add_info(store,taskHash,text);
+		if(result == TC_OK && store->ops->tally(store,0,0,strlen(text) + 1) != TC_OK)
+			_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Could not update the store counters. tcatch fsck --repair recounts them");
+		if(result == TC_OK)
+			_tc_lib_say(context, TC_OUTPUT_INFO, "%s", "Wrote information to current task.");
+	}
+	store->ops->unlock(store,&locks);
+	return result;
+}
+
+int tc_lib_add_info_fd(struct tc_context * context, int fd){
+	/* Information streamed from fd to its end. Only the task's lock is held
+	 * while it streams, so a slow pipe holds up no other task or current */
+	struct tc_store * store = context->store;
+	struct tc_lockset locks;
+	char currentTaskName[TC_MAX_BUFF];
+	char lockedCurrent[TC_MAX_BUFF];
+	char taskHash[TC_MAX_BUFF];
+	long bytes;
+	int result;
+
+	/* Readers never lock current, it is replaced with rename() */
+	store->ops->current_get(store,currentTaskName);
+	if(currentTaskName[0] == '\0'){
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "No current task to add information to.");
+		return TC_ERR_NO_CURRENT;
+	}
+	if((result = store->ops->lock(store,currentTaskName,FALSE,lockedCurrent,&locks)) != TC_OK)
+		return _tc_lib_locked(context,result);
+	/* Streaming never touches current */
+	_tc_unlock_current(&locks);
+
+	_tc_taskName_to_Hash(currentTaskName,taskHash);
+	if(store->ops->task_open(store,taskHash,currentTaskName,FALSE) != TC_OK){
+		_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Could not find information file for current task.");
+		result = TC_ERR_NOT_FOUND;
+	}else{
+		result = store->ops->add_info_stream(store,taskHash,fd,&bytes);
+		if(bytes > 0 && store->ops->tally(store,0,0,bytes) != TC_OK)
+			_tc_lib_say(context, TC_OUTPUT_ERROR, "%s", "Could not update the store counters. tcatch fsck --repair recounts them");
+		if(result == TC_OK)
+			_tc_lib_say(context, TC_OUTPUT_INFO, "Wrote %ld bytes of information to current task.", bytes);
+	}
+	store->ops->unlock(store,&locks);
+	return result;
+}
+
+int tc_lib_status(struct tc_context * context, const char * taskName, struct tc_status * status){
+	/* Readers never lock, see tc-lock.h */
+	struct tc_task_summary summary;
+	char currentTaskName[TC_MAX_BUFF];
+	char taskHash[TC_MAX_BUFF];
+	time_t now;
+
+	if(taskName != NULL && !_tc_lib_name_ok(taskName))
+		return TC_ERR_ARGS;
+
+	now = tc_lib_now(context);
+	if(now == -1)
+		return TC_ERR_TIME;
+	if(taskName == NULL){
+		/* The current task is one small read of current while it is in step */
+		if(context->store->ops->current_summary(context->store,currentTaskName,taskHash,&summary) != TC_OK)
+			return TC_ERR_NO_CURRENT;
+		taskName = currentTaskName;
+	}else{
+		_tc_lib_slot_summary(context,taskName,taskHash,&summary);
+	}
+	if(summary.state == TC_TASK_NOT_FOUND)
+		return TC_ERR_NOT_FOUND;
+	_tc_lib_fill_status(taskName,taskHash,&summary,now,status);
+	return TC_OK;
+}
+
+const char * tc_lib_strerror(int code){
+	switch(code){
+		case TC_OK:
+			return "Success";
+		case TC_ERR_IO:
+			return "Could not read or write the store";
+		case TC_ERR_NOMEM:
+			return "Out of memory";
+		case TC_ERR_ARGS:
+			return "Missing or too long argument";
+		case TC_ERR_TIME:
+			return "Could not determine time";
+		case TC_ERR_NOT_FOUND:
+			return "Task not found";
+		case TC_ERR_NO_CURRENT:
+			return "No current task";
+		case TC_ERR_BUSY:
+			return "Another task is being worked on";
+		case TC_ERR_ALREADY:
+			return "Task is already running";
+		case TC_ERR_FINISHED:
+			return "Task is already finished";
+		case TC_ERR_FULL:
+			return "Every timer slot is taken";
+		default:
+			return "Unknown error";
+	}
+}
@@ -0,0 +1,152 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "tc-lock.h"
+#include "tc-task.h"
+#include "tc-directory.h"
+
+int _tc_lock_acquire(char const * tcHomeDirectory, char const * lockName){
+	/* Blocks until <tc home>/locks/<lockName>.lock is ours. Returns its fd or -1 */
+	char lockPath[TC_MAX_BUFF*2];
+	struct stat held, named;
+	int fd, attempt;
+
+	if(strlen(tcHomeDirectory) + strlen(lockName) + 16 >= sizeof(lockPath))
+		return -1;
+
+	sprintf(lockPath,"%s/%s/%s.lock",tcHomeDirectory,TC_LOCK_DIR,lockName);
+	for(attempt = 0; attempt < TC_LOCK_RETRIES; ++attempt){
+		fd = open(lockPath, O_RDWR | O_CREAT, 0644);
+		if(fd == -1)
+			return -1;
+		while(flock(fd, LOCK_EX) == -1){
+			if(errno != EINTR){
+				close(fd);
+				return -1;
+			}
+		}
+		/* The file may have been removed (see _tc_lock_remove) while this
+		 * waited on it, then the lock is on the file now at the path */
+		if(fstat(fd,&held) == 0 && stat(lockPath,&named) == 0 && held.st_dev == named.st_dev && held.st_ino == named.st_ino)
+			return fd;
+		close(fd);
+	}
+	return -1;
+}
+
+void _tc_lock_remove(char const * tcHomeDirectory, char const * lockName){
+	/* Unlink a lock file the caller holds, for a task that is gone */
+	char lockPath[TC_MAX_BUFF*2];
+
+	if(strlen(tcHomeDirectory) + strlen(lockName) + 16 >= sizeof(lockPath))
+		return;
+	sprintf(lockPath,"%s/%s/%s.lock",tcHomeDirectory,TC_LOCK_DIR,lockName);
+	unlink(lockPath);
+}
+
+void _tc_lock_release(int lock){
+	if(lock < 0)
+		return;
+	flock(lock, LOCK_UN);
+	close(lock);
+}
+
+int _tc_lock_task(char const * tcHomeDirectory, char const * taskName){
+	char taskHash[TC_MAX_BUFF];
+	_tc_taskName_to_Hash((char *)taskName,taskHash);
+	return _tc_lock_acquire(tcHomeDirectory,taskHash);
+}
+
+int _tc_lock_current(char const * tcHomeDirectory){
+	return _tc_lock_acquire(tcHomeDirectory,TC_LOCK_CURRENT);
+}
+
+static int _tc_lock_add(struct tc_lockset * locks, int lock){
+	/* Keep lock with the others, or let all of them go if it failed */
+	if(lock == -1){
+		_tc_unlock_command(locks);
+		return FALSE;
+	}
+	locks->handles[locks->count++] = lock;
+	return TRUE;
+}
+
+static int _tc_lock_tasks(char const * tcHomeDirectory, char const * taskName, char const * otherTaskName, struct tc_lockset * locks){
+	/* Take up to two task locks in hash order. FALSE with nothing held when
+	 * one of them can not be taken */
+	char taskHash[TC_MAX_BUFF];
+	char otherHash[TC_MAX_BUFF];
+	int order;
+
+	locks->count = 0;
+	if(taskName == NULL || taskName[0] == '\0'){
+		taskName = otherTaskName;
+		otherTaskName = NULL;
+	}
+	if(taskName == NULL || taskName[0] == '\0')
+		return TRUE;
+
+	_tc_taskName_to_Hash((char *)taskName,taskHash);
+	if(otherTaskName == NULL || otherTaskName[0] == '\0')
+		return _tc_lock_add(locks,_tc_lock_acquire(tcHomeDirectory,taskHash));
+
+	_tc_taskName_to_Hash((char *)otherTaskName,otherHash);
+	order = strcmp(taskHash,otherHash);
+	if(_tc_lock_add(locks,_tc_lock_acquire(tcHomeDirectory,order <= 0 ? taskHash : otherHash)) == FALSE)
+		return FALSE;
+	if(order != 0)
+		return _tc_lock_add(locks,_tc_lock_acquire(tcHomeDirectory,order < 0 ? otherHash : taskHash));
+	return TRUE;
+}
+
+static int _tc_lock_all(char const * tcHomeDirectory, char const * taskName, char const * otherTaskName, char * currentTaskName, struct tc_lockset * locks){
+	/* The task locks and then current, FALSE with nothing held on a failure */
+	if(_tc_lock_tasks(tcHomeDirectory,taskName,otherTaskName,locks) == FALSE
+		|| _tc_lock_add(locks,_tc_lock_current(tcHomeDirectory)) == FALSE)
+		return FALSE;
+	_tc_current_task_name(tcHomeDirectory,currentTaskName);
+	return TRUE;
+}
+
+int _tc_lock_command(char const * tcHomeDirectory, char const * taskName, int withCurrentTask, char * currentTaskName, struct tc_lockset * locks){
+	/* Lock taskName (and the current task when asked) and then current itself.
+	 * currentTaskName is filled with the current task seen while holding the locks.
+	 * Returns TC_OK, TC_ERR_IO when a lock file can not be taken or
+	 * TC_ERR_BUSY when the current task kept changing. Nothing is held
+	 * unless it is TC_OK.
+	*/
+	char peekedName[TC_MAX_BUFF];
+	int attempt;
+
+	currentTaskName[0] = '\0';
+	if(withCurrentTask == FALSE)
+		return _tc_lock_all(tcHomeDirectory,taskName,NULL,currentTaskName,locks) ? TC_OK : TC_ERR_IO;
+
+	/* The current task's lock comes before the current lock, so peek, lock and
+	 * make sure nobody switched tasks in between. */
+	for(attempt = 0; attempt < TC_LOCK_RETRIES; ++attempt){
+		_tc_current_task_name(tcHomeDirectory,peekedName);
+		if(_tc_lock_all(tcHomeDirectory,taskName,peekedName,currentTaskName,locks) == FALSE)
+			return TC_ERR_IO;
+		if(strcmp(peekedName,currentTaskName) == 0)
+			return TC_OK;
+		_tc_unlock_command(locks);
+	}
+
+	locks->count = 0;
+	return TC_ERR_BUSY;
+}
+
+void _tc_unlock_command(struct tc_lockset * locks){
+	while(locks->count > 0)
+		_tc_lock_release(locks->handles[--locks->count]);
+}
+
+void _tc_unlock_current(struct tc_lockset * locks){
+	/* Let go of current early, it is always the last lock taken */
+	if(locks->count > 0)
+		_tc_lock_release(locks->handles[--locks->count]);
+}
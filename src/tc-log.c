@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tc-log.h"
+#include "tc-init.h"
+#include "tc-task.h"
+#include "tc-view.h"
+#include "tc-archive.h"
+
+static void _tc_log_keep(struct tc_journal_record * record, void * data){
+	struct tc_log_lines * lines = data;
+	struct tc_log_line * grown;
+	size_t capacity;
+
+	if(lines->failed)
+		return;
+	if(lines->count == lines->capacity){
+		capacity = lines->capacity ? lines->capacity*2 : 64;
+		grown = realloc(lines->lines,capacity*sizeof(*grown));
+		if(grown == NULL){
+			lines->failed = TRUE;
+			return;
+		}
+		lines->lines = grown;
+		lines->capacity = capacity;
+	}
+	lines->lines[lines->count].record = *record;
+	lines->lines[lines->count].position = lines->count;
+	++lines->count;
+}
+
+static int _tc_log_compare(const void * left, const void * right){
+	/* By time, imported and merged events are written out of order */
+	const struct tc_log_line * a = left;
+	const struct tc_log_line * b = right;
+
+	if(a->record.eventTime != b->record.eventTime)
+		return a->record.eventTime < b->record.eventTime ? -1 : 1;
+	return (a->position > b->position) - (a->position < b->position);
+}
+
+int _tc_log_name(char const * tcHomeDirectory, char const * taskHash, char * taskName){
+	/* From the info file, or the archive index. FALSE for a deleted task */
+	struct tc_archive_entry entry;
+	char taskInfoPath[TC_MAX_BUFF];
+
+	_tc_getTaskFilePath(taskInfoPath,tcHomeDirectory,taskHash,TC_INFO_EXT);
+	if(_tc_task_name_from_info(taskInfoPath,taskName) == TRUE)
+		return TRUE;
+	if(_tc_archive_find(tcHomeDirectory,taskHash,&entry) != TRUE)
+		return FALSE;
+	strcpy(taskName,entry.taskName);
+	return TRUE;
+}
+
+static void _tc_log_print(char const * tcHomeDirectory, struct tc_log_lines * lines){
+	struct tc_journal_record * record;
+	char lastHash[sizeof(record->taskHash)];
+	char taskName[TC_MAX_BUFF];
+	char when[TC_MAX_BUFF/2];
+	time_t eventTime;
+	size_t i;
+	int named;
+
+	lastHash[0] = '\0';
+	named = FALSE;
+	for(i = 0; i < lines->count; ++i){
+		record = &lines->lines[i].record;
+		/* Work comes in runs of one task, look each run's name up once */
+		if(strcmp(record->taskHash,lastHash) != 0){
+			strcpy(lastHash,record->taskHash);
+			named = _tc_log_name(tcHomeDirectory,record->taskHash,taskName);
+		}
+		if(named == FALSE)
+			continue;
+		eventTime = (time_t)record->eventTime;
+		strftime(when,sizeof(when),"%Y-%m-%d %H:%M:%S",localtime(&eventTime));
+		fprintf(stdout, "%s  %-8s  %s\n", when,
+			record->state == TC_TASK_STARTED ? "started" : record->state == TC_TASK_PAUSED ? "paused" : record->state == TC_TASK_FINISHED ? "finished" : "?",
+			taskName);
+	}
+}
+
+void tc_log(int argc, char const *argv[]){
+	/* Events of every task in time order: the last N, or since a time, today by default */
+	char tcHomeDirectory[TC_MAX_BUFF];
+	char today[16];
+	struct tc_log_lines lines;
+	char const * tail, * since;
+	char * end;
+	time_t from, now;
+	long count, found;
+
+	/* Usage has already been shown by the help check */
+	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
+		return;
+
+	tc_init(tcHomeDirectory);
+	tail = _tc_args_flag_value(argc,argv,TC_TAIL_LONG,TC_TAIL_SHORT);
+	since = _tc_args_flag_value(argc,argv,TC_SINCE_LONG,TC_SINCE_SHORT);
+	if((tail == NULL && _tc_args_flag_check(argc,argv,TC_TAIL_LONG,TC_TAIL_SHORT) == TRUE)
+		|| (since == NULL && _tc_args_flag_check(argc,argv,TC_SINCE_LONG,TC_SINCE_SHORT) == TRUE)
+		|| (tail != NULL && since != NULL)){
+		_tc_display_usage(TC_LOG_COMMAND);
+		return;
+	}
+
+	memset(&lines,0,sizeof(lines));
+	if(tail != NULL){
+		count = strtol(tail,&end,10);
+		if(end == tail || *end != '\0' || count < 0){
+			_tc_display_usage(TC_LOG_COMMAND);
+			return;
+		}
+		found = _tc_journal_tail(tcHomeDirectory,count,_tc_log_keep,&lines);
+	}else{
+		if(since == NULL){
+			if((now = time(0)) == -1){
+				fprintf(stderr, "%s\n", "Could not determine time.");
+				return;
+			}
+			strftime(today,sizeof(today),"%Y%m%d",localtime(&now));
+			since = today;
+		}
+		if(_tc_view_when(since,FALSE,&from) == FALSE){
+			_tc_display_usage(TC_LOG_COMMAND);
+			return;
+		}
+		found = _tc_journal_since(tcHomeDirectory,from,_tc_log_keep,&lines);
+	}
+
+	if(found < 0 || lines.failed)
+		fprintf(stderr, "%s\n", found < 0 ? "Could not read the journal. tcatch fsck --repair rewrites it" : "Could not allocate memory for the journal records.");
+	else{
+		if(lines.count > 0)
+			qsort(lines.lines,lines.count,sizeof(*lines.lines),_tc_log_compare);
+		_tc_log_print(tcHomeDirectory,&lines);
+	}
+	free(lines.lines);
+}
@@ -0,0 +1,598 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "tc-manifest.h"
+#include "tc-lock.h"
+#include "tc-task.h"
+
+static int _tc_manifest_name_check(char const * name, size_t * digits){
+	/* TRUE for YYYYMMDD.index and YYYYMM.index */
+	size_t i;
+
+	for(i = 0; isdigit((unsigned char)name[i]); ++i)
+		;
+	*digits = i;
+	return (i == 8 || i == 6) && name[i] == '.' && strcmp(name + i + 1,TC_INDEX_EXT) == 0;
+}
+
+static int _tc_manifest_compare(const void * left, const void * right){
+	return strcmp(((const struct tc_segment *)left)->name,((const struct tc_segment *)right)->name);
+}
+
+static size_t _tc_manifest_find(struct tc_manifest * manifest, char const * name, int * found){
+	/* Binary search by name. Returns where name is, or where it would go */
+	size_t low, high, middle;
+	int order;
+
+	low = 0;
+	high = manifest->count;
+	*found = FALSE;
+	while(low < high){
+		middle = low + (high - low)/2;
+		order = strcmp(manifest->segments[middle].name,name);
+		if(order == 0){
+			*found = TRUE;
+			return middle;
+		}
+		if(order < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+static struct tc_segment * _tc_manifest_insert(struct tc_manifest * manifest, size_t position, char const * name){
+	struct tc_segment * grown;
+	size_t capacity;
+
+	if(manifest->count == manifest->capacity){
+		capacity = manifest->capacity ? manifest->capacity*2 : 64;
+		grown = realloc(manifest->segments,capacity*sizeof(*grown));
+		if(grown == NULL)
+			return NULL;
+		manifest->segments = grown;
+		manifest->capacity = capacity;
+	}
+	memmove(manifest->segments + position + 1,manifest->segments + position,(manifest->count - position)*sizeof(*grown));
+	++manifest->count;
+
+	memset(manifest->segments + position,0,sizeof(*grown));
+	strcpy(manifest->segments[position].name,name);
+	return manifest->segments + position;
+}
+
+static void _tc_manifest_span(struct tc_segment * segment){
+	/* The widest span a segment's name allows: a day, or a whole month */
+	strcpy(segment->firstDate,segment->name);
+	strcpy(segment->lastDate,segment->name);
+	if(strlen(segment->name) == 6){
+		strcat(segment->firstDate,"01");
+		strcat(segment->lastDate,"31");
+	}
+}
+
+void _tc_manifest_segment_path(struct tc_manifest * manifest, struct tc_segment * segment, char * segmentPath){
+	/* segmentPath needs TC_MAX_BUFF*2 */
+	sprintf(segmentPath,"%s/%s/%s.%s",manifest->root,TC_INDEX_DIR,segment->name,TC_INDEX_EXT);
+}
+
+static long _tc_manifest_count_lines(char const * path){
+	char buffer[8192];
+	char * cursor, * end;
+	size_t read;
+	long lines;
+	FILE * fp;
+
+	fp = fopen(path,"r");
+	if(!fp)
+		return -1;
+	lines = 0;
+	while((read = fread(buffer,1,sizeof(buffer),fp)) > 0)
+		for(cursor = buffer, end = buffer + read; (cursor = memchr(cursor,'\n',end - cursor)) != NULL; ++cursor)
+			++lines;
+	fclose(fp);
+	return lines;
+}
+
+int _tc_manifest_rebuild(struct tc_manifest * manifest){
+	/* Scan the index directory once. Empty day files left behind by older
+	 * versions of tcatch, which made one every day it ran, are skipped, and
+	 * removed when the index lock is held so no writer is about to fill one.
+	*/
+	char indexDirectory[TC_MAX_BUFF*2];
+	char segmentPath[TC_MAX_BUFF*2];
+	struct tc_segment * segment;
+	struct dirent * dirEntry;
+	struct stat status;
+	DIR * dirPointer;
+	size_t digits;
+
+	sprintf(indexDirectory,"%s/%s",manifest->root,TC_INDEX_DIR);
+	dirPointer = opendir(indexDirectory);
+	if(dirPointer == NULL)
+		return TC_ERR_IO;
+
+	manifest->count = 0;
+	while((dirEntry = readdir(dirPointer)) != NULL){
+		if(_tc_manifest_name_check(dirEntry->d_name,&digits) == FALSE)
+			continue;
+		sprintf(segmentPath,"%s/%s/%.15s",manifest->root,TC_INDEX_DIR,dirEntry->d_name);
+		if(stat(segmentPath,&status) != 0)
+			continue;
+		if(status.st_size == 0){
+			if(manifest->lock != -1)
+				remove(segmentPath);
+			continue;
+		}
+
+		dirEntry->d_name[digits] = '\0';
+		if((segment = _tc_manifest_insert(manifest,manifest->count,dirEntry->d_name)) == NULL){
+			closedir(dirPointer);
+			return TC_ERR_NOMEM;
+		}
+		_tc_manifest_span(segment);
+		segment->entries = _tc_manifest_count_lines(segmentPath);
+		segment->bytes = (long)status.st_size;
+	}
+	closedir(dirPointer);
+
+	/* segments is still NULL when the directory had none */
+	if(manifest->count > 1)
+		qsort(manifest->segments,manifest->count,sizeof(*manifest->segments),_tc_manifest_compare);
+	manifest->changed = TRUE;
+	return TC_OK;
+}
+
+static int _tc_manifest_open(char const * tcHomeDirectory, struct tc_manifest * manifest, int lock){
+	/* Read the manifest, or build one from the directory if there is none yet */
+	char manifestPath[TC_MAX_BUFF*2];
+	char line[TC_MAX_BUFF];
+	struct tc_segment segment;
+	FILE * fp;
+	int result;
+
+	memset(manifest,0,sizeof(*manifest));
+	manifest->lock = lock;
+	if(strlen(tcHomeDirectory) >= TC_MAX_BUFF)
+		return TC_ERR_ARGS;
+	strcpy(manifest->root,tcHomeDirectory);
+
+	sprintf(manifestPath,"%s/%s/%s",tcHomeDirectory,TC_INDEX_DIR,TC_INDEX_MANIFEST);
+	fp = fopen(manifestPath,"r");
+	if(!fp){
+		if(errno != ENOENT)
+			return TC_ERR_IO;
+		if((result = _tc_manifest_rebuild(manifest)) != TC_OK)
+			_tc_manifest_free(manifest);
+		return result;
+	}
+
+	while(fgets(line,sizeof(line),fp) != NULL){
+		if(sscanf(line,"%15s %15s %15s %ld %ld",segment.name,segment.firstDate,segment.lastDate,&segment.entries,&segment.bytes) != 5)
+			continue;
+		if(_tc_manifest_insert(manifest,manifest->count,segment.name) == NULL){
+			fclose(fp);
+			_tc_manifest_free(manifest);
+			return TC_ERR_NOMEM;
+		}
+		manifest->segments[manifest->count - 1] = segment;
+	}
+	fclose(fp);
+	return TC_OK;
+}
+
+int _tc_manifest_load(char const * tcHomeDirectory, struct tc_manifest * manifest){
+	/* For readers, nothing is locked */
+	return _tc_manifest_open(tcHomeDirectory,manifest,-1);
+}
+
+void _tc_manifest_free(struct tc_manifest * manifest){
+	if(manifest->segmentFile != NULL)
+		fclose(manifest->segmentFile);
+	free(manifest->segments);
+	manifest->segmentFile = NULL;
+	manifest->segments = NULL;
+	manifest->count = manifest->capacity = 0;
+}
+
+static int _tc_manifest_save(struct tc_manifest * manifest){
+	/* Write beside the manifest and rename over it so readers never see half a file */
+	char manifestPath[TC_MAX_BUFF*2];
+	char manifestTempPath[TC_MAX_BUFF*2+8];
+	struct tc_segment * segment;
+	FILE * fp;
+	size_t i;
+
+	sprintf(manifestPath,"%s/%s/%s",manifest->root,TC_INDEX_DIR,TC_INDEX_MANIFEST);
+	sprintf(manifestTempPath,"%s.tmp",manifestPath);
+	fp = fopen(manifestTempPath,"w");
+	if(!fp)
+		return TC_ERR_IO;
+	for(i = 0; i < manifest->count; ++i){
+		segment = manifest->segments + i;
+		fprintf(fp, "%s %s %s %ld %ld\n", segment->name, segment->firstDate, segment->lastDate, segment->entries, segment->bytes);
+	}
+	if(fclose(fp) != 0 || rename(manifestTempPath,manifestPath) != 0)
+		return TC_ERR_IO;
+	manifest->changed = FALSE;
+	return TC_OK;
+}
+
+int _tc_manifest_begin(char const * tcHomeDirectory, struct tc_manifest * manifest){
+	/* Take the index lock and load the manifest for writing */
+	int lock, result;
+
+	lock = _tc_lock_acquire(tcHomeDirectory,TC_LOCK_INDEX);
+	if(lock == -1)
+		return TC_ERR_IO;
+	if((result = _tc_manifest_open(tcHomeDirectory,manifest,lock)) != TC_OK)
+		_tc_lock_release(lock);
+	return result;
+}
+
+size_t _tc_manifest_route(struct tc_manifest * manifest, char const * date, int * found){
+	/* The segment entries for date (YYYYMMDD) go to: its month's if that was
+	 * merged, its own otherwise. Without either, found is FALSE and this is
+	 * where the day's segment would be inserted.
+	*/
+	char month[16];
+	size_t position;
+
+	strncpy(month,date,6);
+	month[6] = '\0';
+	position = _tc_manifest_find(manifest,month,found);
+	if(*found == FALSE)
+		position = _tc_manifest_find(manifest,date,found);
+	return position;
+}
+
+int _tc_manifest_write(struct tc_manifest * manifest, char const * date, char const * taskHash, char const * taskName, int state){
+	/* Append one entry for an event on date (YYYYMMDD). It goes to the
+	 * month's segment if that month was merged, the day's otherwise.
+	*/
+	char segmentPath[TC_MAX_BUFF*2];
+	struct tc_segment * segment;
+	size_t position;
+	int found, written;
+
+	if(strlen(date) != 8)
+		return TC_ERR_ARGS;
+	position = _tc_manifest_route(manifest,date,&found);
+	if(found == FALSE){
+		if((segment = _tc_manifest_insert(manifest,position,date)) == NULL)
+			return TC_ERR_NOMEM;
+		_tc_manifest_span(segment);
+	}
+	segment = manifest->segments + position;
+
+	if(manifest->segmentFile == NULL || strcmp(manifest->segmentOpen,segment->name) != 0){
+		if(manifest->segmentFile != NULL && fclose(manifest->segmentFile) != 0){
+			manifest->segmentFile = NULL;
+			return TC_ERR_IO;
+		}
+		_tc_manifest_segment_path(manifest,segment,segmentPath);
+		manifest->segmentFile = fopen(segmentPath,"a");
+		if(manifest->segmentFile == NULL)
+			return TC_ERR_IO;
+		strcpy(manifest->segmentOpen,segment->name);
+	}
+
+	written = fprintf(manifest->segmentFile, "%s %s %i\n", taskHash, taskName, state);
+	if(written < 0)
+		return TC_ERR_IO;
+	segment->entries += 1;
+	segment->bytes += written;
+	if(strcmp(date,segment->firstDate) < 0)
+		strcpy(segment->firstDate,date);
+	if(strcmp(date,segment->lastDate) > 0)
+		strcpy(segment->lastDate,date);
+	manifest->changed = TRUE;
+	return TC_OK;
+}
+
+int _tc_manifest_commit(struct tc_manifest * manifest){
+	/* Flush the open segment, save the manifest if it changed and unlock */
+	int result;
+
+	result = TC_OK;
+	if(manifest->segmentFile != NULL && fclose(manifest->segmentFile) != 0)
+		result = TC_ERR_IO;
+	manifest->segmentFile = NULL;
+	if(manifest->changed && result == TC_OK)
+		result = _tc_manifest_save(manifest);
+	_tc_manifest_free(manifest);
+	_tc_lock_release(manifest->lock);
+	manifest->lock = -1;
+	return result;
+}
+
+int _tc_manifest_append(char const * tcHomeDirectory, char const * date, char const * taskHash, char const * taskName, int state){
+	struct tc_manifest manifest;
+	int result;
+
+	if((result = _tc_manifest_begin(tcHomeDirectory,&manifest)) != TC_OK)
+		return result;
+	result = _tc_manifest_write(&manifest,date,taskHash,taskName,state);
+	if(_tc_manifest_commit(&manifest) != TC_OK && result == TC_OK)
+		result = TC_ERR_IO;
+	return result;
+}
+
+int _tc_manifest_select(struct tc_manifest * manifest, char const * fromDate, char const * toDate, tc_manifest_callback callback, void * data){
+	/* Hand every segment whose span overlaps [fromDate, toDate] to callback.
+	 * Either date may be NULL for no bound. Returns how many there were.
+	*/
+	struct tc_segment * segment;
+	size_t i;
+	int count;
+
+	count = 0;
+	for(i = 0; i < manifest->count; ++i){
+		segment = manifest->segments + i;
+		if(fromDate != NULL && strcmp(segment->lastDate,fromDate) < 0)
+			continue;
+		if(toDate != NULL && strcmp(segment->firstDate,toDate) > 0)
+			continue;
+		callback(manifest,segment,data);
+		++count;
+	}
+	return count;
+}
+
+static int _tc_manifest_copy(FILE * to, char const * fromPath){
+	char buffer[8192];
+	size_t read;
+	FILE * from;
+	int result;
+
+	from = fopen(fromPath,"r");
+	if(!from)
+		return TC_ERR_IO;
+	result = TC_OK;
+	while((read = fread(buffer,1,sizeof(buffer),from)) > 0)
+		if(fwrite(buffer,1,read,to) != read){
+			result = TC_ERR_IO;
+			break;
+		}
+	if(ferror(from))
+		result = TC_ERR_IO;
+	fclose(from);
+	return result;
+}
+
+static int _tc_manifest_merge_month(struct tc_manifest * manifest, size_t first, size_t last){
+	/* Fold the day segments [first, last) of one month into its month segment.
+	 * The month file is written beside itself and renamed into place, the
+	 * manifest is saved and only then are the day files removed.
+	*/
+	char segmentPath[TC_MAX_BUFF*2];
+	char mergedPath[TC_MAX_BUFF*2];
+	char mergedTempPath[TC_MAX_BUFF*2+8];
+	struct tc_segment merged, * days;
+	size_t count, i, position;
+	int found, result;
+	FILE * fp;
+
+	memset(&merged,0,sizeof(merged));
+	/* YYYYMM, the memset left the terminator */
+	memcpy(merged.name,manifest->segments[first].name,6);
+	position = _tc_manifest_find(manifest,merged.name,&found);
+	if(found)
+		merged = manifest->segments[position];
+	else
+		strcpy(merged.firstDate,manifest->segments[first].firstDate);
+
+	count = last - first;
+	days = malloc(count*sizeof(*days));
+	if(days == NULL)
+		return TC_ERR_NOMEM;
+	memcpy(days,manifest->segments + first,count*sizeof(*days));
+
+	_tc_manifest_segment_path(manifest,&merged,mergedPath);
+	sprintf(mergedTempPath,"%s.tmp",mergedPath);
+	fp = fopen(mergedTempPath,"w");
+	if(!fp){
+		free(days);
+		return TC_ERR_IO;
+	}
+	result = found ? _tc_manifest_copy(fp,mergedPath) : TC_OK;
+	for(i = 0; i < count && result == TC_OK; ++i){
+		_tc_manifest_segment_path(manifest,days + i,segmentPath);
+		result = _tc_manifest_copy(fp,segmentPath);
+		merged.entries += days[i].entries;
+		merged.bytes += days[i].bytes;
+		if(strcmp(days[i].firstDate,merged.firstDate) < 0)
+			strcpy(merged.firstDate,days[i].firstDate);
+		if(strcmp(days[i].lastDate,merged.lastDate) > 0)
+			strcpy(merged.lastDate,days[i].lastDate);
+	}
+	if(fclose(fp) != 0)
+		result = TC_ERR_IO;
+	if(result != TC_OK || rename(mergedTempPath,mergedPath) != 0){
+		remove(mergedTempPath);
+		free(days);
+		return TC_ERR_IO;
+	}
+
+	/* The month sorts right before its days, so it takes the first day's place */
+	if(found){
+		manifest->segments[position] = merged;
+	}else{
+		manifest->segments[first] = merged;
+		++first;
+	}
+	memmove(manifest->segments + first,manifest->segments + last,(manifest->count - last)*sizeof(*days));
+	manifest->count -= last - first;
+	if((result = _tc_manifest_save(manifest)) == TC_OK)
+		for(i = 0; i < count; ++i){
+			_tc_manifest_segment_path(manifest,days + i,segmentPath);
+			remove(segmentPath);
+		}
+	free(days);
+	return result;
+}
+
+int _tc_manifest_merge(struct tc_manifest * manifest, char const * beforeMonth){
+	/* Merge the day segments of every month before beforeMonth (YYYYMM).
+	 * Call between begin and commit. Returns how many months were merged.
+	*/
+	char month[16];
+	size_t first, last;
+	int merged, result, found;
+
+	merged = 0;
+	first = 0;
+	while(first < manifest->count){
+		if(strlen(manifest->segments[first].name) != 8 || strncmp(manifest->segments[first].name,beforeMonth,6) >= 0){
+			++first;
+			continue;
+		}
+		for(last = first + 1; last < manifest->count && strlen(manifest->segments[last].name) == 8
+			&& strncmp(manifest->segments[last].name,manifest->segments[first].name,6) == 0; ++last)
+			;
+		strncpy(month,manifest->segments[first].name,6);
+		month[6] = '\0';
+		if((result = _tc_manifest_merge_month(manifest,first,last)) != TC_OK)
+			return result;
+		++merged;
+		first = _tc_manifest_find(manifest,month,&found) + 1;
+	}
+	return merged;
+}
+
+int _tc_manifest_reset(struct tc_manifest * manifest){
+	/* Empty the index ahead of writing every entry again. All segment files
+	 * go, listed or not. Merged months stay listed, empty, so their days are
+	 * written back to them, and day segments are dropped. Call between begin
+	 * and commit, and _tc_manifest_prune after the writes.
+	*/
+	char segmentPath[TC_MAX_BUFF*2];
+	struct tc_segment * segment;
+	size_t i, kept;
+	int result;
+
+	if(manifest->segmentFile != NULL)
+		fclose(manifest->segmentFile);
+	manifest->segmentFile = NULL;
+	if((result = _tc_manifest_rebuild(manifest)) != TC_OK)
+		return result;
+
+	for(kept = i = 0; i < manifest->count; ++i){
+		segment = manifest->segments + i;
+		_tc_manifest_segment_path(manifest,segment,segmentPath);
+		if(remove(segmentPath) != 0 && errno != ENOENT)
+			return TC_ERR_IO;
+		if(strlen(segment->name) != 6)
+			continue;
+		/* An inverted span, the first write sets both ends */
+		segment->entries = segment->bytes = 0;
+		sprintf(segment->firstDate,"%.6s31",segment->name);
+		sprintf(segment->lastDate,"%.6s01",segment->name);
+		manifest->segments[kept++] = *segment;
+	}
+	manifest->count = kept;
+	manifest->changed = TRUE;
+	return TC_OK;
+}
+
+void _tc_manifest_prune(struct tc_manifest * manifest){
+	/* Drop the segments left without entries by _tc_manifest_reset or _tc_manifest_drop */
+	size_t i, kept;
+
+	for(kept = i = 0; i < manifest->count; ++i)
+		if(manifest->segments[i].entries > 0)
+			manifest->segments[kept++] = manifest->segments[i];
+	if(kept != manifest->count)
+		manifest->changed = TRUE;
+	manifest->count = kept;
+}
+
+int _tc_manifest_drop(struct tc_manifest * manifest, size_t position, tc_manifest_filter drop, void * data){
+	/* Rewrite one segment beside itself without the entries drop picks out.
+	 * A segment left empty loses its file, _tc_manifest_prune then takes it
+	 * out of the manifest. Call between begin and commit. Returns how many
+	 * entries were dropped, or a TC_ERR code.
+	*/
+	char segmentPath[TC_MAX_BUFF*2];
+	char segmentTempPath[TC_MAX_BUFF*2+8];
+	char line[TC_MAX_BUFF*2];
+	char taskHash[TC_MAX_BUFF];
+	struct tc_segment * segment;
+	FILE * from, * to;
+	long entries, bytes, dropped;
+	size_t length;
+	int lineStart, dropping, result;
+
+	segment = manifest->segments + position;
+	if(manifest->segmentFile != NULL && strcmp(manifest->segmentOpen,segment->name) == 0){
+		if(fclose(manifest->segmentFile) != 0){
+			manifest->segmentFile = NULL;
+			return TC_ERR_IO;
+		}
+		manifest->segmentFile = NULL;
+	}
+	_tc_manifest_segment_path(manifest,segment,segmentPath);
+	sprintf(segmentTempPath,"%s.tmp",segmentPath);
+	if((from = fopen(segmentPath,"r")) == NULL)
+		return TC_ERR_IO;
+	if((to = fopen(segmentTempPath,"w")) == NULL){
+		fclose(from);
+		return TC_ERR_IO;
+	}
+
+	/* A line longer than the buffer comes in pieces, all of them go with the first */
+	result = TC_OK;
+	entries = bytes = dropped = 0;
+	lineStart = TRUE;
+	dropping = FALSE;
+	while(fgets(line,sizeof(line),from) != NULL){
+		length = strlen(line);
+		if(lineStart){
+			sscanf(line,"%254s",taskHash);
+			dropping = drop(taskHash,data);
+			if(dropping)
+				++dropped;
+			else
+				++entries;
+		}
+		lineStart = length > 0 && line[length-1] == '\n';
+		if(dropping)
+			continue;
+		if(fwrite(line,1,length,to) != length){
+			result = TC_ERR_IO;
+			break;
+		}
+		bytes += (long)length;
+	}
+	if(ferror(from))
+		result = TC_ERR_IO;
+	fclose(from);
+	if(fclose(to) != 0)
+		result = TC_ERR_IO;
+
+	if(result != TC_OK || dropped == 0){
+		remove(segmentTempPath);
+		return result != TC_OK ? result : 0;
+	}
+	if(entries == 0){
+		remove(segmentTempPath);
+		if(remove(segmentPath) != 0)
+			return TC_ERR_IO;
+	}else if(rename(segmentTempPath,segmentPath) != 0){
+		remove(segmentTempPath);
+		return TC_ERR_IO;
+	}
+	segment->entries = entries;
+	segment->bytes = bytes;
+	manifest->changed = TRUE;
+	return (int)dropped;
+}
@@ -0,0 +1,586 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "tc-merge.h"
+#include "tc-init.h"
+#include "tc-store.h"
+#include "tc-manifest.h"
+#include "tc-journal.h"
+#include "tc-interval.h"
+#include "tc-fsck.h"
+
+void tc_merge(int argc, char const *argv[]){
+	char tcHomeDirectory[TC_MAX_BUFF];
+	char resolved[TC_MERGE_STORES][TC_MAX_BUFF];
+	char tasksPath[TC_MAX_BUFF*2];
+	char const * others[TC_MERGE_STORES];
+	struct stat localTasks, otherTasks;
+	int count, i;
+
+	/* Usage has already been shown by the help check */
+	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
+		return;
+
+	tc_init(tcHomeDirectory);
+	sprintf(tasksPath,"%s/%s",tcHomeDirectory,TC_TASK_DIR);
+	if(stat(tasksPath,&localTasks) != 0){
+		fprintf(stderr, "%s\n", "Could not read the tasks directory. Please check permissions");
+		return;
+	}
+
+	/* Each store is its .tc directory, or a home directory holding one */
+	for(count = 0, i = 2; i < argc; ++i){
+		if(argv[i][0] == '-')
+			continue;
+		if(count == TC_MERGE_STORES || strlen(argv[i]) + 4 >= TC_MAX_BUFF/2){
+			fprintf(stderr, "At most %i stores, each under %i characters, can be merged at once\n", TC_MERGE_STORES, TC_MAX_BUFF/2 - 4);
+			return;
+		}
+		sprintf(resolved[count],"%s/.tc",argv[i]);
+		sprintf(tasksPath,"%s/%s",resolved[count],TC_TASK_DIR);
+		if(stat(tasksPath,&otherTasks) != 0){
+			strcpy(resolved[count],argv[i]);
+			sprintf(tasksPath,"%s/%s",resolved[count],TC_TASK_DIR);
+		}
+		if(stat(tasksPath,&otherTasks) != 0){
+			fprintf(stderr, "%s has no tasks directory to merge from\n", argv[i]);
+			return;
+		}
+		if(otherTasks.st_dev == localTasks.st_dev && otherTasks.st_ino == localTasks.st_ino){
+			fprintf(stderr, "%s is this store, there is nothing to merge\n", argv[i]);
+			return;
+		}
+		others[count] = resolved[count];
+		++count;
+	}
+	if(count == 0){
+		_tc_display_usage(TC_MERGE_COMMAND);
+		return;
+	}
+
+	if(_tc_merge_stores(tcHomeDirectory,others,count) != TC_OK)
+		fprintf(stderr, "%s\n", "Could not merge the stores. Please check permissions");
+}
+
+static int _tc_merge_next(struct tc_merge_stream * stream){
+	/* The next whole, well formed event of a sequence */
+	char line[TC_MAX_BUFF];
+	long eventTime;
+	size_t length;
+
+	stream->valid = FALSE;
+	while(stream->fp != NULL && fgets(line,sizeof(line),stream->fp) != NULL){
+		length = strlen(line);
+		/* A writer may be halfway through the last line */
+		if(length == 0 || line[length-1] != '\n')
+			break;
+		if(sscanf(line,"%d %d %ld",&stream->seqNum,&stream->state,&eventTime) == 3){
+			stream->eventTime = eventTime;
+			stream->valid = TRUE;
+			break;
+		}
+	}
+	return stream->valid;
+}
+
+static long _tc_merge_line(FILE * fp, char ** line, size_t * capacity){
+	/* One info line of any length without its newline, -1 at the end */
+	char * grown;
+	size_t length;
+	int c;
+
+	length = 0;
+	while((c = getc(fp)) != EOF && c != '\n'){
+		if(length + 1 >= *capacity){
+			grown = realloc(*line,*capacity ? *capacity*2 : TC_MAX_BUFF);
+			if(grown == NULL)
+				return -2;
+			*line = grown;
+			*capacity = *capacity ? *capacity*2 : TC_MAX_BUFF;
+		}
+		(*line)[length++] = (char)c;
+	}
+	if(c == EOF && length == 0)
+		return -1;
+	if(*line != NULL)
+		(*line)[length] = '\0';
+	return (long)length;
+}
+
+static uint64_t _tc_merge_hash(char const * line, size_t length){
+	/* FNV-1a, 64 bits */
+	uint64_t hash;
+	size_t i;
+
+	hash = (uint64_t)14695981039346656037UL;
+	for(i = 0; i < length; ++i){
+		hash ^= (unsigned char)line[i];
+		hash *= (uint64_t)1099511628211UL;
+	}
+	return hash;
+}
+
+static size_t _tc_merge_slot(struct tc_merge_lines * lines, uint64_t key){
+	size_t slot;
+
+	for(slot = key & (lines->capacity - 1); lines->counts[slot] != 0 && lines->keys[slot] != key; slot = (slot + 1) & (lines->capacity - 1))
+		;
+	return slot;
+}
+
+static int _tc_merge_remember(struct tc_merge_lines * lines, uint64_t key){
+	/* Count one more line with key, growing the table at half full */
+	struct tc_merge_lines grown;
+	size_t slot, i;
+
+	if((lines->count + 1)*2 > lines->capacity){
+		grown.capacity = lines->capacity ? lines->capacity*2 : 256;
+		grown.count = lines->count;
+		grown.keys = malloc(grown.capacity*sizeof(*grown.keys));
+		grown.counts = calloc(grown.capacity,sizeof(*grown.counts));
+		grown.used = calloc(grown.capacity,sizeof(*grown.used));
+		if(grown.keys == NULL || grown.counts == NULL || grown.used == NULL){
+			free(grown.keys);
+			free(grown.counts);
+			free(grown.used);
+			return FALSE;
+		}
+		for(i = 0; i < lines->capacity; ++i){
+			if(lines->counts[i] == 0)
+				continue;
+			slot = _tc_merge_slot(&grown,lines->keys[i]);
+			grown.keys[slot] = lines->keys[i];
+			grown.counts[slot] = lines->counts[i];
+			grown.used[slot] = lines->used[i];
+		}
+		free(lines->keys);
+		free(lines->counts);
+		free(lines->used);
+		*lines = grown;
+	}
+	slot = _tc_merge_slot(lines,key);
+	if(lines->counts[slot] == 0){
+		lines->keys[slot] = key;
+		++lines->count;
+	}
+	++lines->counts[slot];
+	return TRUE;
+}
+
+static void _tc_merge_lines_free(struct tc_merge_lines * lines){
+	free(lines->keys);
+	free(lines->counts);
+	free(lines->used);
+	memset(lines,0,sizeof(*lines));
+}
+
+static int _tc_merge_info(char const * localInfoPath, char const * otherInfoPaths[], int count, char const * taskName){
+	/* Append the info lines of the other stores that this one lacks. The
+	 * first line is the name, the same everywhere */
+	struct tc_merge_lines lines;
+	FILE * local, * other;
+	char * line;
+	size_t capacity, slot;
+	long length;
+	int i, result;
+
+	memset(&lines,0,sizeof(lines));
+	line = NULL;
+	capacity = 0;
+	result = TC_OK;
+
+	local = fopen(localInfoPath,"r");
+	if(local != NULL){
+		_tc_merge_line(local,&line,&capacity);
+		while(result == TC_OK && (length = _tc_merge_line(local,&line,&capacity)) >= 0)
+			if(_tc_merge_remember(&lines,_tc_merge_hash(line,length)) == FALSE)
+				result = TC_ERR_NOMEM;
+		if(length == -2)
+			result = TC_ERR_NOMEM;
+		fclose(local);
+	}else if(errno != ENOENT){
+		return TC_ERR_IO;
+	}
+	if(result != TC_OK || (local = fopen(localInfoPath,"a")) == NULL){
+		_tc_merge_lines_free(&lines);
+		free(line);
+		return result != TC_OK ? result : TC_ERR_IO;
+	}
+	if(ftell(local) == 0)
+		fprintf(local, "%s\n", taskName);
+
+	for(i = 0; i < count && result == TC_OK; ++i){
+		if((other = fopen(otherInfoPaths[i],"r")) == NULL)
+			continue;
+		/* Each store matches the local lines afresh */
+		for(slot = 0; slot < lines.capacity; ++slot)
+			lines.used[slot] = 0;
+		_tc_merge_line(other,&line,&capacity);
+		while(result == TC_OK && (length = _tc_merge_line(other,&line,&capacity)) >= 0){
+			slot = lines.capacity ? _tc_merge_slot(&lines,_tc_merge_hash(line,length)) : 0;
+			if(lines.capacity && lines.counts[slot] > lines.used[slot]){
+				++lines.used[slot];
+				continue;
+			}
+			/* A line new here, and one the next store may have too */
+			if(fprintf(local, "%s\n", line ? line : "") < 0)
+				result = TC_ERR_IO;
+			else if(_tc_merge_remember(&lines,_tc_merge_hash(line,length)) == FALSE)
+				result = TC_ERR_NOMEM;
+			else
+				++lines.used[_tc_merge_slot(&lines,_tc_merge_hash(line,length))];
+		}
+		if(length == -2)
+			result = TC_ERR_NOMEM;
+		fclose(other);
+	}
+
+	if(fclose(local) != 0 && result == TC_OK)
+		result = TC_ERR_IO;
+	_tc_merge_lines_free(&lines);
+	free(line);
+	return result;
+}
+
+static long _tc_merge_bytes(char const * tcHomeDirectory, char const * taskHash){
+	/* What the task's files hold, for the store counters */
+	char path[TC_MAX_BUFF];
+	struct stat fileStat;
+	long bytes;
+
+	bytes = 0;
+	_tc_getTaskFilePath(path,tcHomeDirectory,taskHash,TC_SEQ_EXT);
+	if(stat(path,&fileStat) == 0)
+		bytes += fileStat.st_size;
+	_tc_getTaskFilePath(path,tcHomeDirectory,taskHash,TC_INFO_EXT);
+	if(stat(path,&fileStat) == 0)
+		bytes += fileStat.st_size;
+	return bytes;
+}
+
+static int _tc_merge_sequences(struct tc_merge_stream * streams, int count, FILE * merged, struct tc_task_summary * local, struct tc_task_summary * summary, char const * taskHash, char const * taskName, struct tc_merge_stats * stats){
+	/* The k-way merge on time. streams[0] is the local sequence. Every
+	 * stream whose next event is the one taken moves past it, so an event
+	 * several stores share is written once */
+	char date[16];
+	struct tm timeinfo;
+	int best, state, fresh, i;
+	time_t eventTime;
+
+	for(;;){
+		best = -1;
+		for(i = 0; i < count; ++i)
+			if(streams[i].valid && (best == -1 || streams[i].eventTime < streams[best].eventTime))
+				best = i;
+		if(best == -1)
+			return TC_OK;
+
+		state = streams[best].state;
+		eventTime = streams[best].eventTime;
+		fresh = TRUE;
+		for(i = 0; i < count; ++i){
+			if(streams[i].valid == FALSE || streams[i].eventTime != eventTime || streams[i].state != state)
+				continue;
+			if(i == 0){
+				fresh = FALSE;
+				_tc_task_summary_record(local->seqNum,state,eventTime,local);
+			}
+			_tc_merge_next(streams + i);
+		}
+
+		/* An event from elsewhere has to fit between what is written and
+		 * the next local event */
+		if(fresh && (_tc_fsck_transition(summary->state,state) == FALSE || (streams[0].valid && _tc_fsck_transition(state,streams[0].state) == FALSE))){
+			++stats->conflicts;
+			continue;
+		}
+		if(fprintf(merged, "%i %i %ld\n", summary->seqNum, state, (long)eventTime) < 0)
+			return TC_ERR_IO;
+		_tc_task_summary_record(summary->seqNum,state,eventTime,summary);
+
+		/* Only events new here need index entries */
+		if(fresh){
+			++stats->events;
+			if(localtime_r(&eventTime,&timeinfo) == NULL)
+				return TC_ERR_TIME;
+			strftime(date,sizeof(date),"%Y%m%d",&timeinfo);
+			fprintf(stats->indexes, "%s %ld %s %i %i %s\n", date, (long)eventTime, taskHash, state, summary->seqNum - 1, taskName);
+		}
+	}
+}
+
+static void _tc_merge_derived(struct tc_store * store, char const * taskHash, char const * taskName, char const * currentTaskName, struct tc_task_summary * summary){
+	/* The timer table and current hold sequence numbers, bring them in line */
+	struct tc_active_slot slot;
+
+	if(store->ops->active_find(store,taskHash,&slot) == TRUE){
+		if(summary->state == TC_TASK_STARTED){
+			slot.seqNum = summary->seqNum;
+			slot.startTime = summary->startTime;
+			slot.lastStart = summary->lastStart;
+			slot.accumulated = summary->accumulated;
+			store->ops->active_insert(store,&slot);
+		}else{
+			store->ops->active_remove(store,taskHash);
+		}
+	}
+	if(strcmp(currentTaskName,taskName) != 0)
+		return;
+	if(summary->state == TC_TASK_STARTED)
+		store->ops->current_set(store,taskName,taskHash,summary);
+	else
+		store->ops->current_clear(store);
+}
+
+static int _tc_merge_sessions(char const * localPath, char const * mergedPath, struct tc_sessions * delta){
+	/* The local sequence's sessions come out of their days, the merged one's go in */
+	struct tc_sketch_replay replay;
+	int failed;
+
+	_tc_sketch_replay_init(&replay,NULL,delta,-1);
+	_tc_seq_foreach(localPath,_tc_sketch_record,&replay);
+	failed = replay.failed;
+	_tc_sketch_replay_init(&replay,NULL,delta,1);
+	_tc_seq_foreach(mergedPath,_tc_sketch_record,&replay);
+	return failed || replay.failed ? TC_ERR_NOMEM : TC_OK;
+}
+
+static int _tc_merge_task(struct tc_store * store, char const * others[], int count, int first, char const * taskHash, struct tc_merge_stats * stats){
+	/* Merge one task from others[first] and every store after it that has it */
+	struct tc_merge_stream streams[TC_MERGE_STORES + 1];
+	struct tc_task_summary local, summary;
+	struct tc_lockset locks;
+	char const * otherInfoPaths[TC_MERGE_STORES];
+	char infoPaths[TC_MERGE_STORES][TC_MAX_BUFF];
+	char taskName[TC_MAX_BUFF];
+	char otherName[TC_MAX_BUFF];
+	char currentTaskName[TC_MAX_BUFF];
+	char path[TC_MAX_BUFF];
+	char mergedPath[TC_MAX_BUFF*2];
+	FILE * merged;
+	long bytes;
+	int streamCount, infoCount, result, i;
+
+	/* A name that doesn't hash to its file is for fsck, not merge */
+	_tc_getTaskFilePath(infoPaths[0],others[first],taskHash,TC_INFO_EXT);
+	if(_tc_task_name_from_info(infoPaths[0],taskName) == FALSE || strlen(taskName) >= TC_MAX_BUFF){
+		fprintf(stderr, "Task %s in %s has no name in its info file. Skipping\n", taskHash, others[first]);
+		++stats->skipped;
+		return TC_OK;
+	}
+	_tc_taskName_to_Hash(taskName,path);
+	if(strcmp(path,taskHash) != 0){
+		fprintf(stderr, "Task %s in %s is named \"%s\", which does not hash to it. Skipping\n", taskHash, others[first], taskName);
+		++stats->skipped;
+		return TC_OK;
+	}
+	_tc_getTaskFilePath(path,store->root,taskHash,TC_INFO_EXT);
+	if(_tc_task_name_from_info(path,otherName) == TRUE && strcmp(otherName,taskName) != 0){
+		fprintf(stderr, "Task %s is \"%s\" here and \"%s\" in %s. Skipping\n", taskHash, otherName, taskName, others[first]);
+		++stats->skipped;
+		return TC_OK;
+	}
+
+	if((result = store->ops->lock(store,taskName,FALSE,currentTaskName,&locks)) != TC_OK)
+		return result;
+	/* An archived task is merged into the history it had, not a new one */
+	if(store->ops->task_open(store,taskHash,taskName,FALSE) == TC_ERR_NOT_FOUND
+		&& (result = store->ops->restore(store,taskHash)) != TC_OK && result != TC_ERR_NOT_FOUND){
+		store->ops->unlock(store,&locks);
+		return result;
+	}
+	bytes = _tc_merge_bytes(store->root,taskHash);
+
+	/* The local sequence first, then each store with the task */
+	memset(streams,0,sizeof(streams));
+	_tc_getTaskFilePath(path,store->root,taskHash,TC_SEQ_EXT);
+	streams[0].fp = fopen(path,"r");
+	_tc_merge_next(streams);
+	streamCount = 1;
+	for(infoCount = 0, i = first; i < count; ++i){
+		_tc_getTaskFilePath(path,others[i],taskHash,TC_SEQ_EXT);
+		if((streams[streamCount].fp = fopen(path,"r")) == NULL)
+			continue;
+		_tc_merge_next(streams + streamCount++);
+		_tc_getTaskFilePath(infoPaths[infoCount],others[i],taskHash,TC_INFO_EXT);
+		otherInfoPaths[infoCount] = infoPaths[infoCount];
+		++infoCount;
+	}
+
+	_tc_getTaskFilePath(path,store->root,taskHash,TC_SEQ_EXT);
+	sprintf(mergedPath,"%s.%s",path,TC_MERGE_EXT);
+	_tc_task_summary_init(&local);
+	_tc_task_summary_init(&summary);
+	merged = fopen(mergedPath,"w");
+	result = merged != NULL ? _tc_merge_sequences(streams,streamCount,merged,&local,&summary,taskHash,taskName,stats) : TC_ERR_IO;
+	for(i = 0; i < streamCount; ++i)
+		if(streams[i].fp != NULL)
+			fclose(streams[i].fp);
+	if(merged != NULL && fclose(merged) != 0 && result == TC_OK)
+		result = TC_ERR_IO;
+
+	/* Nothing new leaves the local sequence as it was */
+	if(result == TC_OK && summary.seqNum != local.seqNum){
+		if(_tc_merge_sessions(path,mergedPath,&stats->sessions) != TC_OK)
+			stats->sessionsLost = TRUE;
+		if(rename(mergedPath,path) != 0){
+			result = TC_ERR_IO;
+		}else{
+			/* The interval index and sketch covered the old numbering */
+			_tc_getTaskFilePath(path,store->root,taskHash,TC_SPAN_EXT);
+			remove(path);
+			_tc_getTaskFilePath(path,store->root,taskHash,TC_SKETCH_EXT);
+			remove(path);
+			_tc_merge_derived(store,taskHash,taskName,currentTaskName,&summary);
+		}
+	}
+	remove(mergedPath);
+
+	_tc_getTaskFilePath(path,store->root,taskHash,TC_INFO_EXT);
+	if(result == TC_OK)
+		result = _tc_merge_info(path,otherInfoPaths,infoCount,taskName);
+	store->ops->unlock(store,&locks);
+	if(result != TC_OK)
+		return result;
+
+	/* What the task brought to the projects and counters */
+	if(local.seqNum == 0 && summary.seqNum > 0){
+		++stats->created;
+		_tc_projects_add(&stats->projects,taskName,0,1);
+	}
+	if(summary.accumulated != local.accumulated)
+		_tc_projects_add(&stats->projects,taskName,summary.accumulated - local.accumulated,0);
+	_tc_counters_tally(&stats->counters,local.state,summary.state,_tc_merge_bytes(store->root,taskHash) - bytes);
+	++stats->tasks;
+	return TC_OK;
+}
+
+static int _tc_merge_indexes(char const * tcHomeDirectory, FILE * indexes){
+	/* The spilled entries under one hold of the index lock, then of the
+	 * journal lock, after every task lock is released */
+	struct tc_manifest manifest;
+	struct tc_journal journal;
+	char line[TC_MAX_BUFF*2];
+	char date[16];
+	char taskHash[48];
+	long eventTime;
+	int state, seqNum, nameAt, result;
+
+	rewind(indexes);
+	if(_tc_manifest_begin(tcHomeDirectory,&manifest) != TC_OK)
+		return TC_ERR_IO;
+	result = TC_OK;
+	while(result == TC_OK && fgets(line,sizeof(line),indexes) != NULL){
+		line[strcspn(line,"\n")] = '\0';
+		nameAt = 0;
+		if(sscanf(line,"%15s %ld %47s %d %d %n",date,&eventTime,taskHash,&state,&seqNum,&nameAt) == 5 && nameAt > 0)
+			result = _tc_manifest_write(&manifest,date,taskHash,line + nameAt,state);
+	}
+	if(_tc_manifest_commit(&manifest) != TC_OK && result == TC_OK)
+		result = TC_ERR_IO;
+
+	rewind(indexes);
+	if(result != TC_OK || _tc_journal_begin(tcHomeDirectory,&journal) != TC_OK)
+		return TC_ERR_IO;
+	while(result == TC_OK && fgets(line,sizeof(line),indexes) != NULL)
+		if(sscanf(line,"%15s %ld %47s %d %d",date,&eventTime,taskHash,&state,&seqNum) == 5)
+			result = _tc_journal_write(&journal,eventTime,taskHash,state,seqNum);
+	if(_tc_journal_commit(&journal) != TC_OK && result == TC_OK)
+		result = TC_ERR_IO;
+	return result;
+}
+
+static int _tc_merge_totals(char const * tcHomeDirectory, struct tc_merge_stats * stats){
+	/* Fold the deltas into the project totals, the counters and the sessions */
+	struct tc_projects projects;
+	struct tc_counters counters;
+	int result;
+
+	result = TC_OK;
+	if(stats->projects.count > 0){
+		if((result = _tc_projects_begin(tcHomeDirectory,&projects)) != TC_OK)
+			return result;
+		result = _tc_projects_merge(&projects,&stats->projects);
+		if(_tc_projects_commit(&projects) != TC_OK && result == TC_OK)
+			result = TC_ERR_IO;
+	}
+	if(result == TC_OK && stats->tasks > 0){
+		if((result = _tc_counters_begin(tcHomeDirectory,&counters)) != TC_OK)
+			return result;
+		_tc_counters_merge(&counters,&stats->counters);
+		result = _tc_counters_commit(&counters);
+	}
+	if(result == TC_OK && stats->sessionsLost == FALSE)
+		result = _tc_sessions_commit(tcHomeDirectory,&stats->sessions);
+	return result == TC_OK && stats->sessionsLost ? TC_ERR_NOMEM : result;
+}
+
+int _tc_merge_stores(char const * tcHomeDirectory, char const * others[], int count){
+	/* Merge every task of the other stores into this one, a task at a time */
+	struct tc_merge_stats stats;
+	struct tc_store * store;
+	struct dirent * dirEntry;
+	char tasksPath[TC_MAX_BUFF*2];
+	char taskHash[TC_MAX_BUFF];
+	char path[TC_MAX_BUFF];
+	char * extension;
+	DIR * dirPointer;
+	int result, seen, i, j;
+
+	if(_tc_store_open_directory(&store,tcHomeDirectory) != TC_OK)
+		return TC_ERR_IO;
+	memset(&stats,0,sizeof(stats));
+	_tc_projects_init(&stats.projects);
+	_tc_counters_init(&stats.counters);
+	_tc_sessions_init(&stats.sessions);
+	if((stats.indexes = tmpfile()) == NULL){
+		_tc_store_close(store);
+		return TC_ERR_IO;
+	}
+
+	result = TC_OK;
+	for(i = 0; i < count && result == TC_OK; ++i){
+		sprintf(tasksPath,"%s/%s",others[i],TC_TASK_DIR);
+		if((dirPointer = opendir(tasksPath)) == NULL){
+			result = TC_ERR_IO;
+			break;
+		}
+		while(result == TC_OK && (dirEntry = readdir(dirPointer)) != NULL){
+			extension = strrchr(dirEntry->d_name,'.');
+			if(extension == NULL || strcmp(extension + 1,TC_SEQ_EXT) != 0 || (size_t)(extension - dirEntry->d_name) >= sizeof(taskHash))
+				continue;
+			memcpy(taskHash,dirEntry->d_name,extension - dirEntry->d_name);
+			taskHash[extension - dirEntry->d_name] = '\0';
+
+			/* A store earlier in the list already brought this task in */
+			for(seen = FALSE, j = 0; j < i && seen == FALSE; ++j){
+				_tc_getTaskFilePath(path,others[j],taskHash,TC_SEQ_EXT);
+				seen = _tc_file_exists(path);
+			}
+			if(seen == FALSE)
+				result = _tc_merge_task(store,others,count,i,taskHash,&stats);
+		}
+		closedir(dirPointer);
+	}
+
+	if(stats.events > 0 && _tc_merge_indexes(tcHomeDirectory,stats.indexes) != TC_OK)
+		fprintf(stderr, "%s\n", "Could not write the index segments and journal. tcatch fsck --repair rewrites them");
+	if(_tc_merge_totals(tcHomeDirectory,&stats) != TC_OK)
+		fprintf(stderr, "%s\n", "Could not update the project totals, counters and sessions. tcatch fsck --repair rebuilds them");
+	fprintf(stdout, "Merged %lu tasks from %i store%s: %lu events added, %lu new tasks, %lu skipped\n",
+		stats.tasks, count, count == 1 ? "" : "s", stats.events, stats.created, stats.skipped);
+	if(stats.conflicts > 0)
+		fprintf(stdout, "Left out %lu events that conflict with the history here\n", stats.conflicts);
+
+	fclose(stats.indexes);
+	_tc_projects_free(&stats.projects);
+	_tc_sessions_free(&stats.sessions);
+	_tc_store_close(store);
+	return result;
+}
@@ -0,0 +1,56 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tc-metrics.h"
+#include "tc-counters.h"
+#include "tc-init.h"
+
+void tc_metrics(int argc, char const *argv[]){
+	/* Write the textfile now, remembering where it goes when asked */
+	char tcHomeDirectory[TC_MAX_BUFF];
+	char textfilePath[TC_MAX_BUFF*2];
+	char workingDirectory[TC_MAX_BUFF];
+	char const * textfile;
+	struct tc_counters counters;
+
+	/* Usage has already been shown by the help check */
+	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
+		return;
+
+	tc_init(tcHomeDirectory);
+	textfile = _tc_args_flag_value(argc,argv,TC_TEXTFILE_LONG,TC_TEXTFILE_SHORT);
+	if(textfile == NULL && _tc_args_flag_check(argc,argv,TC_TEXTFILE_LONG,TC_TEXTFILE_SHORT) == TRUE){
+		_tc_display_usage(TC_METRICS_COMMAND);
+		return;
+	}
+
+	/* Later updates come from wherever tcatch runs, keep the path absolute */
+	textfilePath[0] = '\0';
+	if(textfile != NULL && textfile[0] != '/'){
+		if(getcwd(workingDirectory,sizeof(workingDirectory)) == NULL){
+			fprintf(stderr, "%s\n", "Could not determine the working directory.");
+			return;
+		}
+		sprintf(textfilePath,"%s/",workingDirectory);
+	}
+	if(textfile != NULL && strlen(textfilePath) + strlen(textfile) >= TC_MAX_BUFF){
+		fprintf(stderr, "%s\n", "The textfile path is too long.");
+		return;
+	}
+
+	if(_tc_counters_begin(tcHomeDirectory,&counters) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not open the store counters. Please check permissions");
+		return;
+	}
+	if(textfile != NULL)
+		snprintf(counters.textfile,sizeof(counters.textfile),"%s%s",textfilePath,textfile);
+	if(_tc_counters_commit(&counters) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not write the metrics textfile. Please check permissions");
+		return;
+	}
+	_tc_counters_textfile_path(&counters,textfilePath);
+	fprintf(stdout, "Wrote metrics to %s\n", textfilePath);
+}
@@ -0,0 +1,259 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "tc-project.h"
+#include "tc-lock.h"
+#include "tc-task.h"
+
+int _tc_projects_order(char const * left, char const * right){
+	/* strcmp with the separator below every other character, so client/x
+	 * sorts before client-b and a project's subtree stays in one run */
+	int a, b;
+
+	for(;; ++left, ++right){
+		a = *left == TC_PROJECT_SEPARATOR ? 1 : (unsigned char)*left;
+		b = *right == TC_PROJECT_SEPARATOR ? 1 : (unsigned char)*right;
+		if(a != b || a == 0)
+			return a - b;
+	}
+}
+
+static size_t _tc_projects_find(struct tc_projects * projects, char const * path, int * found){
+	/* Binary search by path. Returns where path is, or where it would go */
+	size_t low, high, middle;
+	int order;
+
+	low = 0;
+	high = projects->count;
+	*found = FALSE;
+	while(low < high){
+		middle = low + (high - low)/2;
+		order = _tc_projects_order(projects->nodes[middle].path,path);
+		if(order == 0){
+			*found = TRUE;
+			return middle;
+		}
+		if(order < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+static int _tc_projects_depth(char const * path){
+	int depth;
+
+	for(depth = 1; (path = strchr(path,TC_PROJECT_SEPARATOR)) != NULL; ++path)
+		++depth;
+	return depth;
+}
+
+static int _tc_projects_apply(struct tc_projects * projects, char const * path, long seconds, long tasks){
+	/* Add to one project, creating it. A project goes when its last task is deleted */
+	struct tc_project * grown;
+	size_t position, capacity;
+	int found;
+
+	position = _tc_projects_find(projects,path,&found);
+	if(found == FALSE){
+		if(projects->count == projects->capacity){
+			capacity = projects->capacity ? projects->capacity*2 : 64;
+			grown = realloc(projects->nodes,capacity*sizeof(*grown));
+			if(grown == NULL)
+				return TC_ERR_NOMEM;
+			projects->nodes = grown;
+			projects->capacity = capacity;
+		}
+		memmove(projects->nodes + position + 1,projects->nodes + position,(projects->count - position)*sizeof(*grown));
+		++projects->count;
+		memset(projects->nodes + position,0,sizeof(*grown));
+		strcpy(projects->nodes[position].path,path);
+		projects->nodes[position].depth = _tc_projects_depth(path);
+	}
+
+	projects->nodes[position].tasks += tasks;
+	projects->nodes[position].accumulated += seconds;
+	if(tasks < 0 && projects->nodes[position].tasks <= 0){
+		memmove(projects->nodes + position,projects->nodes + position + 1,(projects->count - position - 1)*sizeof(*grown));
+		--projects->count;
+	}
+	projects->changed = TRUE;
+	return TC_OK;
+}
+
+void _tc_projects_init(struct tc_projects * projects){
+	memset(projects,0,sizeof(*projects));
+	projects->lock = -1;
+}
+
+int _tc_projects_load(char const * tcHomeDirectory, struct tc_projects * projects){
+	/* For readers, nothing is locked. A store without projects has an empty tree */
+	char projectsPath[TC_MAX_BUFF*2];
+	char line[TC_MAX_BUFF*2];
+	long seconds, tasks;
+	int pathAt;
+	FILE * fp;
+
+	_tc_projects_init(projects);
+	if(strlen(tcHomeDirectory) >= TC_MAX_BUFF)
+		return TC_ERR_ARGS;
+	strcpy(projects->root,tcHomeDirectory);
+
+	sprintf(projectsPath,"%s/%s",tcHomeDirectory,TC_PROJECTS_FILE);
+	fp = fopen(projectsPath,"r");
+	if(!fp)
+		return errno == ENOENT ? TC_OK : TC_ERR_IO;
+	while(fgets(line,sizeof(line),fp) != NULL){
+		pathAt = 0;
+		line[strcspn(line,"\n")] = '\0';
+		if(sscanf(line,"%ld %ld %n",&seconds,&tasks,&pathAt) != 2 || pathAt == 0
+			|| line[pathAt] == '\0' || strlen(line + pathAt) >= TC_MAX_BUFF)
+			continue;
+		if(_tc_projects_apply(projects,line + pathAt,seconds,tasks) != TC_OK){
+			fclose(fp);
+			_tc_projects_free(projects);
+			return TC_ERR_NOMEM;
+		}
+	}
+	fclose(fp);
+	projects->changed = FALSE;
+	return TC_OK;
+}
+
+int _tc_projects_begin(char const * tcHomeDirectory, struct tc_projects * projects){
+	/* Take the projects lock and load the tree for writing */
+	int lock, result;
+
+	lock = _tc_lock_acquire(tcHomeDirectory,TC_LOCK_PROJECTS);
+	if(lock == -1)
+		return TC_ERR_IO;
+	if((result = _tc_projects_load(tcHomeDirectory,projects)) != TC_OK){
+		_tc_lock_release(lock);
+		return result;
+	}
+	projects->lock = lock;
+	return TC_OK;
+}
+
+static int _tc_projects_save(struct tc_projects * projects){
+	/* Write beside the file and rename over it so readers never see half a tree */
+	char projectsPath[TC_MAX_BUFF*2];
+	char projectsTempPath[TC_MAX_BUFF*2+8];
+	struct tc_project * node;
+	FILE * fp;
+	size_t i;
+
+	sprintf(projectsPath,"%s/%s",projects->root,TC_PROJECTS_FILE);
+	sprintf(projectsTempPath,"%s.tmp",projectsPath);
+	fp = fopen(projectsTempPath,"w");
+	if(!fp)
+		return TC_ERR_IO;
+	for(i = 0; i < projects->count; ++i){
+		node = projects->nodes + i;
+		fprintf(fp, "%ld %ld %s\n", node->accumulated, node->tasks, node->path);
+	}
+	if(fclose(fp) != 0 || rename(projectsTempPath,projectsPath) != 0)
+		return TC_ERR_IO;
+	projects->changed = FALSE;
+	return TC_OK;
+}
+
+int _tc_projects_commit(struct tc_projects * projects){
+	/* Save the tree if it changed, unlock and free it */
+	int result;
+
+	result = projects->changed ? _tc_projects_save(projects) : TC_OK;
+	_tc_lock_release(projects->lock);
+	_tc_projects_free(projects);
+	return result;
+}
+
+void _tc_projects_free(struct tc_projects * projects){
+	free(projects->nodes);
+	projects->nodes = NULL;
+	projects->count = projects->capacity = 0;
+	projects->lock = -1;
+}
+
+int _tc_projects_add(struct tc_projects * projects, char const * taskName, long seconds, long tasks){
+	/* Add to every project above taskName: a, a/b for a task named a/b/c */
+	char path[TC_MAX_BUFF];
+	char const * separator;
+	size_t length;
+	int result;
+
+	for(separator = strchr(taskName,TC_PROJECT_SEPARATOR); separator != NULL; separator = strchr(separator + 1,TC_PROJECT_SEPARATOR)){
+		length = separator - taskName;
+		/* Empty components don't make a project */
+		if(length == 0 || length >= TC_MAX_BUFF || taskName[length-1] == TC_PROJECT_SEPARATOR)
+			continue;
+		memcpy(path,taskName,length);
+		path[length] = '\0';
+		if((result = _tc_projects_apply(projects,path,seconds,tasks)) != TC_OK)
+			return result;
+	}
+	return TC_OK;
+}
+
+int _tc_projects_merge(struct tc_projects * projects, struct tc_projects * delta){
+	/* Add a tree built in memory, project by project */
+	size_t i;
+	int result;
+
+	for(i = 0; i < delta->count; ++i)
+		if((result = _tc_projects_apply(projects,delta->nodes[i].path,delta->nodes[i].accumulated,delta->nodes[i].tasks)) != TC_OK)
+			return result;
+	return TC_OK;
+}
+
+int _tc_projects_record(char const * tcHomeDirectory, char const * taskName, long seconds, long tasks){
+	/* One task's change under one hold of the lock. Flat names cost nothing */
+	struct tc_projects projects;
+	int result;
+
+	if(strchr(taskName,TC_PROJECT_SEPARATOR) == NULL || (seconds == 0 && tasks == 0))
+		return TC_OK;
+	if((result = _tc_projects_begin(tcHomeDirectory,&projects)) != TC_OK)
+		return result;
+	result = _tc_projects_add(&projects,taskName,seconds,tasks);
+	if(_tc_projects_commit(&projects) != TC_OK && result == TC_OK)
+		result = TC_ERR_IO;
+	return result;
+}
+
+int _tc_projects_select(struct tc_projects * projects, char const * path, int maxDepth, tc_project_callback callback, void * data){
+	/* Hand path and its subtree, down to maxDepth levels below it (no limit
+	 * when negative), to callback. Without a path every project is handed
+	 * over and top level ones are at depth 1. Returns how many there were.
+	*/
+	struct tc_project * node;
+	size_t first, length, i;
+	int base, found, count;
+
+	first = 0;
+	base = 0;
+	length = 0;
+	if(path != NULL && path[0] != '\0'){
+		first = _tc_projects_find(projects,path,&found);
+		base = _tc_projects_depth(path);
+		length = strlen(path);
+	}
+
+	count = 0;
+	for(i = first; i < projects->count; ++i){
+		node = projects->nodes + i;
+		if(length > 0 && (strncmp(node->path,path,length) != 0
+			|| (node->path[length] != '\0' && node->path[length] != TC_PROJECT_SEPARATOR)))
+			break;
+		if(maxDepth >= 0 && node->depth - base > maxDepth)
+			continue;
+		callback(node,node->depth - base,data);
+		++count;
+	}
+	return count;
+}
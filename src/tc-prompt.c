@@ -0,0 +1,78 @@
+#define _XOPEN_SOURCE 500
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tc-prompt.h"
+#include "timecatcher.h"
+
+/* Keep the compiler, and the processor, from moving stores across a bump */
+#ifdef __GNUC__
+	#define TC_PROMPT_BARRIER() __sync_synchronize()
+#else
+	#define TC_PROMPT_BARRIER()
+#endif
+
+int tc_prompt_read(const char * path, struct tc_prompt * prompt){
+	int fd, tries, whole;
+
+	fd = open(path, O_RDONLY);
+	if(fd == -1)
+		return 0;
+	whole = 0;
+	for(tries = 0; tries < TC_PROMPT_RETRIES && !whole; ++tries)
+		whole = pread(fd, prompt, sizeof(*prompt), 0) == sizeof(*prompt) && prompt->sequence == prompt->check;
+	close(fd);
+	return whole && memcmp(prompt->magic, TC_PROMPT_MAGIC, sizeof(prompt->magic)) == 0
+		&& prompt->version == TC_PROMPT_VERSION;
+}
+
+int64_t tc_prompt_worked(const struct tc_prompt * prompt, time_t now){
+	if(prompt->state == TC_TASK_STARTED)
+		return prompt->accumulated + (now - prompt->lastStart);
+	return prompt->accumulated;
+}
+
+int _tc_prompt_write(const char * path, const char * taskName, int state, time_t startTime, time_t lastStart, time_t accumulated){
+	/* In place through a shared mapping, so readers only ever see the
+	 * record or a torn copy they can tell apart. 1 on success */
+	volatile struct tc_prompt * record;
+	struct stat fileStat;
+	uint32_t sequence;
+	void * mapped;
+	int fd;
+
+	fd = open(path, O_RDWR | O_CREAT, 0644);
+	if(fd == -1)
+		return 0;
+	if(fstat(fd, &fileStat) == -1 || ((size_t)fileStat.st_size < sizeof(*record) && ftruncate(fd, sizeof(*record)) == -1)){
+		close(fd);
+		return 0;
+	}
+	mapped = mmap(NULL, sizeof(*record), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(mapped == MAP_FAILED)
+		return 0;
+	record = mapped;
+
+	sequence = record->sequence + 1;
+	record->check = sequence;
+	TC_PROMPT_BARRIER();
+	memcpy((char *)record->magic, TC_PROMPT_MAGIC, sizeof(record->magic));
+	record->version = TC_PROMPT_VERSION;
+	record->state = taskName == NULL ? TC_TASK_NOT_FOUND : state;
+	record->startTime = taskName == NULL ? 0 : startTime;
+	record->lastStart = taskName == NULL ? 0 : lastStart;
+	record->accumulated = taskName == NULL ? 0 : accumulated;
+	memset((char *)record->taskName, 0, sizeof(record->taskName));
+	if(taskName != NULL)
+		strncpy((char *)record->taskName, taskName, sizeof(record->taskName) - 1);
+	TC_PROMPT_BARRIER();
+	record->sequence = sequence;
+
+	munmap(mapped, sizeof(*record));
+	return 1;
+}
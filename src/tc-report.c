@@ -0,0 +1,245 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tc-report.h"
+#include "tc-analytics.h"
+#include "tc-store.h"
+#include "tc-init.h"
+#include "tc-view.h"
+
+/* One task's total, for sorting */
+struct tc_report_row {
+	int64_t seconds;
+	uint32_t task;
+};
+
+static void _tc_report_length(int64_t seconds, char * text){
+	sprintf(text, "%ldh%02ldm%02lds", (long)(seconds/3600), (long)((seconds%3600)/60), (long)(seconds%60));
+}
+
+static int _tc_report_edge(struct tc_report * report, int64_t edge, size_t * capacity){
+	/* Append a bucket boundary, doubling the edges as needed */
+	int64_t * grown;
+
+	if(report->edgeCount == *capacity){
+		*capacity = *capacity == 0 ? 64 : *capacity*2;
+		grown = realloc(report->edges, *capacity*sizeof(*grown));
+		if(grown == NULL)
+			return FALSE;
+		report->edges = grown;
+	}
+	report->edges[report->edgeCount++] = edge;
+	return TRUE;
+}
+
+static int _tc_report_buckets(struct tc_report * report, int hours){
+	/* Local midnights, or hours, from the one before from up to the first at
+	 * or after to. The outer two are then moved in onto the window */
+	size_t capacity;
+	struct tm local;
+	time_t when;
+
+	capacity = 0;
+	when = report->from;
+	localtime_r(&when,&local);
+	if(hours)
+		when -= local.tm_min*60 + local.tm_sec;
+	else{
+		local.tm_hour = local.tm_min = local.tm_sec = 0;
+		local.tm_isdst = -1;
+		when = mktime(&local);
+	}
+	if(!_tc_report_edge(report,when,&capacity))
+		return FALSE;
+	while(when < report->to){
+		if(hours)
+			when += 3600;
+		else{
+			++local.tm_mday;
+			local.tm_isdst = -1;
+			when = mktime(&local);
+		}
+		if(!_tc_report_edge(report,when,&capacity))
+			return FALSE;
+	}
+	report->edges[0] = report->from;
+	report->edges[report->edgeCount-1] = report->to;
+	return TRUE;
+}
+
+static int _tc_report_row_compare(const void * left, const void * right){
+	/* Most time first */
+	int64_t a = ((const struct tc_report_row *)left)->seconds, b = ((const struct tc_report_row *)right)->seconds;
+	return a > b ? -1 : a < b;
+}
+
+static int _tc_report_by_task(struct tc_report * report){
+	struct tc_export_columns * columns = &report->columns;
+	struct tc_report_row * rows;
+	char length[64];
+	size_t i;
+
+	report->sums = calloc(columns->taskCount, sizeof(*report->sums));
+	rows = malloc(columns->taskCount*sizeof(*rows));
+	if(report->sums == NULL || rows == NULL){
+		free(rows);
+		return FALSE;
+	}
+	tc_analytics_sum_by(columns->taskIds,columns->starts,columns->ends,columns->intervalCount,report->from,report->to,report->sums);
+	for(i = 0; i < columns->taskCount; ++i){
+		rows[i].seconds = report->sums[i];
+		rows[i].task = i;
+	}
+	qsort(rows,columns->taskCount,sizeof(*rows),_tc_report_row_compare);
+	for(i = 0; i < columns->taskCount && rows[i].seconds > 0; ++i){
+		_tc_report_length(rows[i].seconds,length);
+		fprintf(stdout, "%s\t%s\n", length, columns->names + columns->nameOffsets[rows[i].task]);
+	}
+	free(rows);
+	return TRUE;
+}
+
+static int _tc_report_by_day(struct tc_report * report){
+	struct tm local;
+	char day[32], length[64];
+	time_t when;
+	size_t b;
+
+	if(!_tc_report_buckets(report,FALSE) || (report->sums = calloc(report->edgeCount, sizeof(*report->sums))) == NULL)
+		return FALSE;
+	tc_analytics_spread(report->columns.starts,report->columns.ends,report->columns.intervalCount,report->edges,report->edgeCount,report->sums);
+	for(b = 0; b + 1 < report->edgeCount; ++b){
+		if(report->sums[b] == 0)
+			continue;
+		when = report->edges[b];
+		localtime_r(&when,&local);
+		strftime(day,sizeof(day),"%Y-%m-%d %a",&local);
+		_tc_report_length(report->sums[b],length);
+		fprintf(stdout, "%s\t%s\n", day, length);
+	}
+	return TRUE;
+}
+
+static int _tc_report_by_hour(struct tc_report * report){
+	/* Hours of the week, Monday first, every week in the window folded in */
+	static const char * dayNames[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+	int64_t week[7][24];
+	struct tm local;
+	char length[64];
+	time_t when;
+	size_t b;
+	int d, h;
+
+	if(!_tc_report_buckets(report,TRUE) || (report->sums = calloc(report->edgeCount, sizeof(*report->sums))) == NULL)
+		return FALSE;
+	tc_analytics_spread(report->columns.starts,report->columns.ends,report->columns.intervalCount,report->edges,report->edgeCount,report->sums);
+	memset(week,0,sizeof(week));
+	for(b = 0; b + 1 < report->edgeCount; ++b){
+		if(report->sums[b] == 0)
+			continue;
+		when = report->edges[b];
+		localtime_r(&when,&local);
+		week[local.tm_wday][local.tm_hour] += report->sums[b];
+	}
+	for(d = 1; d <= 7; ++d)
+		for(h = 0; h < 24; ++h){
+			if(week[d%7][h] == 0)
+				continue;
+			_tc_report_length(week[d%7][h],length);
+			fprintf(stdout, "%s %02d:00\t%s\n", dayNames[d%7], h, length);
+		}
+	return TRUE;
+}
+
+static int _tc_report_load(char const * tcHomeDirectory, struct tc_report * report, time_t now){
+	struct tc_store * store;
+	int loaded;
+
+	if(_tc_store_open_directory(&store,tcHomeDirectory) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not open the .tc directory. Please check permissions");
+		return FALSE;
+	}
+	report->columns.exportTime = now;
+	loaded = _tc_export_collect(store,&report->columns);
+	_tc_store_close(store);
+	return loaded;
+}
+
+static void _tc_report_free(struct tc_report * report){
+	free(report->columns.taskIds);
+	free(report->columns.starts);
+	free(report->columns.ends);
+	free(report->columns.states);
+	free(report->columns.nameOffsets);
+	free(report->columns.names);
+	free(report->edges);
+	free(report->sums);
+}
+
+void tc_report(int argc, char const *argv[]){
+	char tcHomeDirectory[TC_MAX_BUFF];
+	char fromText[TC_MAX_BUFF/2], toText[TC_MAX_BUFF/2], length[64];
+	struct tc_report report;
+	char const * by;
+	int64_t first, last;
+	time_t now;
+	int at, reported;
+
+	/* Usage has already been shown by the help check */
+	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
+		return;
+
+	tc_init(tcHomeDirectory);
+	memset(&report,0,sizeof(report));
+	by = _tc_args_flag_value(argc,argv,TC_BY_LONG,TC_BY_SHORT);
+	if(by == NULL && _tc_args_flag_check(argc,argv,TC_BY_LONG,TC_BY_SHORT) == FALSE)
+		by = TC_REPORT_BY_TASK;
+	at = _tc_args_flag_index(argc,argv,TC_BETWEEN_LONG,TC_BETWEEN_SHORT);
+	if(by == NULL || (strcmp(by,TC_REPORT_BY_TASK) != 0 && strcmp(by,TC_REPORT_BY_DAY) != 0 && strcmp(by,TC_REPORT_BY_HOUR) != 0)
+		|| (at != -1 && (at + 2 >= argc || _tc_view_when(argv[at+1],FALSE,&report.from) == FALSE || _tc_view_when(argv[at+2],TRUE,&report.to) == FALSE || report.to <= report.from))){
+		_tc_display_usage(TC_REPORT_COMMAND);
+		return;
+	}
+	if((now = time(0)) == -1){
+		fprintf(stderr, "%s\n", "Could not determine time.");
+		return;
+	}
+
+	if(!_tc_report_load(tcHomeDirectory,&report,now)){
+		_tc_report_free(&report);
+		return;
+	}
+	if(report.columns.intervalCount == 0){
+		fprintf(stdout, "%s\n", "No time recorded yet.");
+		_tc_report_free(&report);
+		return;
+	}
+	/* Without a window, all of it */
+	if(at == -1){
+		tc_analytics_range(report.columns.starts,report.columns.ends,report.columns.intervalCount,&first,&last);
+		report.from = first;
+		report.to = last > first ? last : first + 1;
+	}
+
+	strftime(fromText,sizeof(fromText),"%c",localtime(&report.from));
+	strftime(toText,sizeof(toText),"%c",localtime(&report.to));
+	fprintf(stdout, "Time worked from %s up to %s\n", fromText, toText);
+	if(strcmp(by,TC_REPORT_BY_DAY) == 0)
+		reported = _tc_report_by_day(&report);
+	else if(strcmp(by,TC_REPORT_BY_HOUR) == 0)
+		reported = _tc_report_by_hour(&report);
+	else
+		reported = _tc_report_by_task(&report);
+
+	if(!reported)
+		fprintf(stderr, "%s\n", "Could not allocate memory for the report.");
+	else{
+		_tc_report_length(tc_analytics_clipped(report.columns.starts,report.columns.ends,report.columns.intervalCount,report.from,report.to),length);
+		fprintf(stdout, "Total\t%s\n", length);
+	}
+	_tc_report_free(&report);
+}
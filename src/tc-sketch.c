@@ -0,0 +1,605 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "tc-sketch.h"
+#include "tc-task.h"
+#include "tc-lock.h"
+
+void _tc_sketch_init(struct tc_sketch * sketch){
+	memset(sketch,0,sizeof(*sketch));
+}
+
+void _tc_sketch_free(struct tc_sketch * sketch){
+	free(sketch->buckets);
+	_tc_sketch_init(sketch);
+}
+
+static int _tc_sketch_bucket(long seconds){
+	/* A bucket per second below TC_SKETCH_LINEAR, then TC_SKETCH_SUBBUCKETS
+	 * per power of two, picked by the bits below the top one */
+	unsigned long value;
+	int exponent;
+
+	value = seconds < 0 ? 0 : seconds > TC_SKETCH_MAX ? TC_SKETCH_MAX : (unsigned long)seconds;
+	if(value < TC_SKETCH_LINEAR)
+		return (int)value;
+	for(exponent = 6; (value >> (exponent + 1)) != 0; ++exponent)
+		;
+	return TC_SKETCH_LINEAR + (exponent - 6)*TC_SKETCH_SUBBUCKETS + (int)((value >> (exponent - 5)) - TC_SKETCH_SUBBUCKETS);
+}
+
+static long _tc_sketch_value(int bucket){
+	/* The middle of the lengths that land in bucket */
+	long width;
+	int exponent;
+
+	if(bucket < TC_SKETCH_LINEAR)
+		return bucket;
+	exponent = 6 + (bucket - TC_SKETCH_LINEAR)/TC_SKETCH_SUBBUCKETS;
+	width = 1L << (exponent - 5);
+	return (TC_SKETCH_SUBBUCKETS + (bucket - TC_SKETCH_LINEAR) % TC_SKETCH_SUBBUCKETS)*width + width/2;
+}
+
+static size_t _tc_sketch_find(struct tc_sketch const * sketch, int bucket){
+	/* Where bucket is, or where it would go */
+	size_t low, high, middle;
+
+	low = 0;
+	high = sketch->count;
+	while(low < high){
+		middle = low + (high - low)/2;
+		if(sketch->buckets[middle].bucket < bucket)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+static int _tc_sketch_count(struct tc_sketch * sketch, int bucket, long count){
+	/* Add count to one bucket. Deltas may leave a bucket below zero, only
+	 * buckets that come to nothing are dropped */
+	struct tc_sketch_bucket * grown;
+	size_t position, capacity;
+
+	position = _tc_sketch_find(sketch,bucket);
+	if(position < sketch->count && sketch->buckets[position].bucket == bucket){
+		if((sketch->buckets[position].count += count) == 0){
+			memmove(sketch->buckets + position,sketch->buckets + position + 1,(sketch->count - position - 1)*sizeof(*grown));
+			--sketch->count;
+		}
+		return TC_OK;
+	}
+	if(count == 0)
+		return TC_OK;
+	if(sketch->count == sketch->capacity){
+		capacity = sketch->capacity ? sketch->capacity*2 : 16;
+		if((grown = realloc(sketch->buckets,capacity*sizeof(*grown))) == NULL){
+			sketch->failed = TRUE;
+			return TC_ERR_NOMEM;
+		}
+		sketch->buckets = grown;
+		sketch->capacity = capacity;
+	}
+	memmove(sketch->buckets + position + 1,sketch->buckets + position,(sketch->count - position)*sizeof(*grown));
+	sketch->buckets[position].bucket = bucket;
+	sketch->buckets[position].count = count;
+	++sketch->count;
+	return TC_OK;
+}
+
+int _tc_sketch_add(struct tc_sketch * sketch, long seconds, long weight){
+	/* One session of seconds, or with a weight of -1 one less */
+	sketch->sessions += weight;
+	sketch->seconds += seconds*weight;
+	return _tc_sketch_count(sketch,_tc_sketch_bucket(seconds),weight);
+}
+
+int _tc_sketch_merge(struct tc_sketch * into, struct tc_sketch const * from, long weight){
+	size_t i;
+
+	into->sessions += from->sessions*weight;
+	into->seconds += from->seconds*weight;
+	for(i = 0; i < from->count; ++i)
+		if(_tc_sketch_count(into,from->buckets[i].bucket,from->buckets[i].count*weight) != TC_OK)
+			return TC_ERR_NOMEM;
+	return TC_OK;
+}
+
+int _tc_sketch_equal(struct tc_sketch const * left, struct tc_sketch const * right){
+	size_t i;
+
+	if(left->sessions != right->sessions || left->seconds != right->seconds || left->count != right->count)
+		return FALSE;
+	for(i = 0; i < left->count; ++i)
+		if(left->buckets[i].bucket != right->buckets[i].bucket || left->buckets[i].count != right->buckets[i].count)
+			return FALSE;
+	return TRUE;
+}
+
+long _tc_sketch_quantile(struct tc_sketch const * sketch, double quantile){
+	/* The length of the session ranked quantile of the way up, 0 without any */
+	long rank, seen;
+	size_t i;
+
+	if(sketch->sessions <= 0 || sketch->count == 0)
+		return 0;
+	rank = (long)(quantile*sketch->sessions);
+	if((double)rank < quantile*sketch->sessions)
+		++rank;
+	if(rank < 1)
+		rank = 1;
+	for(seen = 0, i = 0; i < sketch->count; ++i)
+		if((seen += sketch->buckets[i].count) >= rank)
+			return _tc_sketch_value(sketch->buckets[i].bucket);
+	return _tc_sketch_value(sketch->buckets[sketch->count - 1].bucket);
+}
+
+static int _tc_sketch_parse(char const * text, struct tc_sketch * sketch){
+	/* "<sessions> <seconds> <bucket>:<count> ..." added to sketch */
+	char const * cursor;
+	char * end;
+	long sessions, seconds, bucket, count;
+
+	sessions = strtol(text,&end,10);
+	if(end == text)
+		return FALSE;
+	cursor = end;
+	seconds = strtol(cursor,&end,10);
+	if(end == cursor)
+		return FALSE;
+	sketch->sessions += sessions;
+	sketch->seconds += seconds;
+	for(cursor = end; ; cursor = end){
+		while(isspace((unsigned char)*cursor))
+			++cursor;
+		if(*cursor == '\0')
+			return TRUE;
+		bucket = strtol(cursor,&end,10);
+		if(end == cursor || *end != ':')
+			return FALSE;
+		cursor = end + 1;
+		count = strtol(cursor,&end,10);
+		if(end == cursor || bucket < 0 || _tc_sketch_count(sketch,(int)bucket,count) != TC_OK)
+			return FALSE;
+	}
+}
+
+static void _tc_sketch_print(FILE * fp, struct tc_sketch const * sketch){
+	size_t i;
+
+	fprintf(fp, "%ld %ld", sketch->sessions, sketch->seconds);
+	for(i = 0; i < sketch->count; ++i)
+		fprintf(fp, " %i:%ld", sketch->buckets[i].bucket, sketch->buckets[i].count);
+	fprintf(fp, "\n");
+}
+
+void _tc_sketch_replay_init(struct tc_sketch_replay * replay, struct tc_sketch * sketch, struct tc_sessions * days, long weight){
+	memset(replay,0,sizeof(*replay));
+	replay->sketch = sketch;
+	replay->days = days;
+	replay->weight = weight;
+	replay->state = TC_TASK_NOT_FOUND;
+}
+
+void _tc_sketch_record(int seqNum, int seqState, time_t seqTime, void * data){
+	/* The transitions _tc_task_summary_record counts, a session each */
+	struct tc_sketch_replay * replay = data;
+	long closed;
+	(void)seqNum;
+
+	if(replay->state == TC_TASK_STARTED && (seqState == TC_TASK_PAUSED || seqState == TC_TASK_FINISHED)){
+		closed = (long)(seqTime - replay->openStart);
+		if(replay->sketch != NULL && _tc_sketch_add(replay->sketch,closed,replay->weight) != TC_OK)
+			replay->failed = TRUE;
+		if(replay->days != NULL && _tc_sessions_add(replay->days,_tc_sessions_day(seqTime),closed,replay->weight) != TC_OK)
+			replay->failed = TRUE;
+	}
+	if(seqState == TC_TASK_STARTED && replay->state != TC_TASK_STARTED)
+		replay->openStart = seqTime;
+	replay->state = seqState;
+}
+
+int _tc_sketch_from_text(char const * text, size_t length, struct tc_sketch * sketch){
+	/* For sequences with no sketch file, archived ones */
+	struct tc_sketch_replay replay;
+
+	_tc_sketch_init(sketch);
+	_tc_sketch_replay_init(&replay,sketch,NULL,1);
+	_tc_seq_parse(text,length,_tc_sketch_record,&replay);
+	if(replay.failed){
+		_tc_sketch_free(sketch);
+		return TC_ERR_NOMEM;
+	}
+	return TC_OK;
+}
+
+static int _tc_sketch_line(FILE * fp, char ** line, size_t * capacity){
+	/* A whole line however long, a busy task's has a bucket per length it
+	 * was ever worked for. FALSE at the end of the file or without memory */
+	size_t length;
+	char * grown;
+
+	if(*line == NULL){
+		*capacity = 4096;
+		if((*line = malloc(*capacity)) == NULL)
+			return FALSE;
+	}
+	if(fgets(*line,(int)*capacity,fp) == NULL)
+		return FALSE;
+	for(length = strlen(*line); length > 0 && (*line)[length-1] != '\n'; length += strlen(*line + length)){
+		if(length + 1 < *capacity)
+			break;
+		if((grown = realloc(*line,*capacity*2)) == NULL)
+			return FALSE;
+		*line = grown;
+		*capacity *= 2;
+		if(fgets(*line + length,(int)(*capacity - length),fp) == NULL)
+			break;
+	}
+	return TRUE;
+}
+
+static long _tc_sketch_cached(char const * sketchPath, struct tc_sketch * sketch, struct tc_sketch_replay * replay){
+	/* Read a sketch file, returns the sequence bytes it covers or -1 */
+	char * line;
+	size_t capacity;
+	long covered, openStart;
+	int state, ok;
+	FILE * fp;
+
+	if((fp = fopen(sketchPath,"r")) == NULL)
+		return -1;
+	line = NULL;
+	ok = _tc_sketch_line(fp,&line,&capacity) && sscanf(line,"%ld %i %ld",&covered,&state,&openStart) == 3 && covered >= 0
+		&& _tc_sketch_line(fp,&line,&capacity) && _tc_sketch_parse(line,sketch);
+	free(line);
+	fclose(fp);
+	if(ok == FALSE){
+		_tc_sketch_free(sketch);
+		return -1;
+	}
+	replay->state = state;
+	replay->openStart = (time_t)openStart;
+	return covered;
+}
+
+static void _tc_sketch_save(char const * sketchPath, struct tc_sketch * sketch, struct tc_sketch_replay * replay, long covered){
+	/* Best effort, a reader that can't write the cache still has its answer */
+	char sketchTempPath[TC_MAX_BUFF*2+32];
+	FILE * fp;
+
+	/* Readers may race to save, each writes its own file */
+	sprintf(sketchTempPath,"%s.%ld.tmp",sketchPath,(long)getpid());
+	if((fp = fopen(sketchTempPath,"w")) == NULL)
+		return;
+	fprintf(fp, "%ld %i %ld\n", covered, replay->state, (long)replay->openStart);
+	_tc_sketch_print(fp,sketch);
+	if(ferror(fp) != 0 || fclose(fp) != 0 || rename(sketchTempPath,sketchPath) != 0)
+		remove(sketchTempPath);
+}
+
+int _tc_sketch_open(char const * tcHomeDirectory, char const * taskHash, struct tc_sketch * sketch){
+	/* A task's sketch, catching its sketch file up with the sequence first */
+	struct tc_sketch_replay replay;
+	char taskSequencePath[TC_MAX_BUFF*2];
+	char sketchPath[TC_MAX_BUFF*2];
+	struct stat fileStat;
+	size_t consumed, got;
+	long covered;
+	char * text;
+	FILE * fp;
+
+	_tc_sketch_init(sketch);
+	_tc_sketch_replay_init(&replay,sketch,NULL,1);
+	_tc_getTaskFilePath(taskSequencePath,tcHomeDirectory,taskHash,TC_SEQ_EXT);
+	_tc_getTaskFilePath(sketchPath,tcHomeDirectory,taskHash,TC_SKETCH_EXT);
+	if((fp = fopen(taskSequencePath,"r")) == NULL)
+		return errno == ENOENT ? TC_ERR_NOT_FOUND : TC_ERR_IO;
+	if(fstat(fileno(fp),&fileStat) == -1){
+		fclose(fp);
+		return TC_ERR_IO;
+	}
+
+	/* Nearly always nothing was appended since */
+	covered = _tc_sketch_cached(sketchPath,sketch,&replay);
+	if(covered == (long)fileStat.st_size){
+		fclose(fp);
+		return TC_OK;
+	}
+
+	/* Carry on from the cache unless the sequence was replaced under it */
+	if(covered < 0 || covered > (long)fileStat.st_size || (covered > 0 && (fseek(fp,covered - 1,SEEK_SET) != 0 || getc(fp) != '\n'))){
+		_tc_sketch_free(sketch);
+		_tc_sketch_replay_init(&replay,sketch,NULL,1);
+		covered = 0;
+	}
+	if(fseek(fp,covered,SEEK_SET) != 0 || (text = malloc((size_t)fileStat.st_size - covered + 1)) == NULL){
+		fclose(fp);
+		_tc_sketch_free(sketch);
+		return TC_ERR_IO;
+	}
+	got = fread(text,1,(size_t)fileStat.st_size - covered,fp);
+	fclose(fp);
+
+	/* Only whole lines, a writer may be halfway through the last one */
+	for(consumed = got; consumed > 0 && text[consumed-1] != '\n'; --consumed)
+		;
+	_tc_seq_parse(text,consumed,_tc_sketch_record,&replay);
+	free(text);
+	if(replay.failed){
+		_tc_sketch_free(sketch);
+		return TC_ERR_NOMEM;
+	}
+	_tc_sketch_save(sketchPath,sketch,&replay,covered + (long)consumed);
+	return TC_OK;
+}
+
+void _tc_sessions_init(struct tc_sessions * sessions){
+	memset(sessions,0,sizeof(*sessions));
+}
+
+void _tc_sessions_free(struct tc_sessions * sessions){
+	size_t i;
+
+	for(i = 0; i < sessions->count; ++i)
+		_tc_sketch_free(&sessions->days[i].sketch);
+	free(sessions->days);
+	_tc_sessions_init(sessions);
+}
+
+int32_t _tc_sessions_day(time_t closedAt){
+	/* The local YYYYMMDD a session closed on, 0 if there is none */
+	struct tm timeinfo;
+
+	if(localtime_r(&closedAt,&timeinfo) == NULL)
+		return 0;
+	return (timeinfo.tm_year + 1900)*10000 + (timeinfo.tm_mon + 1)*100 + timeinfo.tm_mday;
+}
+
+static struct tc_sessions_day * _tc_sessions_slot(struct tc_sessions * sessions, int32_t day){
+	/* The day's sketch, made empty if the day is new */
+	struct tc_sessions_day * grown;
+	size_t low, high, middle, capacity;
+
+	low = 0;
+	high = sessions->count;
+	while(low < high){
+		middle = low + (high - low)/2;
+		if(sessions->days[middle].day < day)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	if(low < sessions->count && sessions->days[low].day == day)
+		return sessions->days + low;
+	if(sessions->count == sessions->capacity){
+		capacity = sessions->capacity ? sessions->capacity*2 : 32;
+		if((grown = realloc(sessions->days,capacity*sizeof(*grown))) == NULL)
+			return NULL;
+		sessions->days = grown;
+		sessions->capacity = capacity;
+	}
+	memmove(sessions->days + low + 1,sessions->days + low,(sessions->count - low)*sizeof(*grown));
+	sessions->days[low].day = day;
+	_tc_sketch_init(&sessions->days[low].sketch);
+	++sessions->count;
+	return sessions->days + low;
+}
+
+int _tc_sessions_add(struct tc_sessions * sessions, int32_t day, long seconds, long weight){
+	struct tc_sessions_day * slot;
+
+	if(day == 0)
+		return TC_ERR_TIME;
+	if((slot = _tc_sessions_slot(sessions,day)) == NULL)
+		return TC_ERR_NOMEM;
+	return _tc_sketch_add(&slot->sketch,seconds,weight);
+}
+
+int _tc_sessions_merge(struct tc_sessions * into, struct tc_sessions const * from, long weight){
+	struct tc_sessions_day * slot;
+	size_t i;
+
+	for(i = 0; i < from->count; ++i)
+		if((slot = _tc_sessions_slot(into,from->days[i].day)) == NULL
+			|| _tc_sketch_merge(&slot->sketch,&from->days[i].sketch,weight) != TC_OK)
+			return TC_ERR_NOMEM;
+	return TC_OK;
+}
+
+static void _tc_sessions_month_path(char const * tcHomeDirectory, long month, char * monthPath){
+	sprintf(monthPath,"%s/%s/%06ld",tcHomeDirectory,TC_SESSIONS_DIR,month);
+}
+
+static int _tc_sessions_read_month(char const * monthPath, int32_t fromDay, int32_t toDay, struct tc_sessions * sessions){
+	/* Days of one month file inside [fromDay, toDay] added to sessions */
+	struct tc_sessions_day * slot;
+	char * line;
+	size_t capacity;
+	long day;
+	int dayAt, result;
+	FILE * fp;
+
+	if((fp = fopen(monthPath,"r")) == NULL)
+		return errno == ENOENT ? TC_OK : TC_ERR_IO;
+	line = NULL;
+	result = TC_OK;
+	while(result == TC_OK && _tc_sketch_line(fp,&line,&capacity)){
+		dayAt = 0;
+		if(sscanf(line,"%ld %n",&day,&dayAt) != 1 || dayAt == 0 || day < fromDay || day > toDay)
+			continue;
+		if((slot = _tc_sessions_slot(sessions,(int32_t)day)) == NULL)
+			result = TC_ERR_NOMEM;
+		else if(_tc_sketch_parse(line + dayAt,&slot->sketch) == FALSE)
+			result = slot->sketch.failed ? TC_ERR_NOMEM : TC_ERR_IO;
+	}
+	if(result == TC_OK && ferror(fp) != 0)
+		result = TC_ERR_IO;
+	free(line);
+	fclose(fp);
+	return result;
+}
+
+int _tc_sessions_load(char const * tcHomeDirectory, int32_t fromDay, int32_t toDay, struct tc_sessions * sessions){
+	/* For readers, nothing is locked. The month files that can hold days of
+	 * [fromDay, toDay], 0 for either end leaves it open */
+	char sessionsPath[TC_MAX_BUFF*2];
+	char monthPath[TC_MAX_BUFF*2];
+	struct dirent * entry;
+	char * end;
+	long month;
+	int result;
+	DIR * dir;
+
+	_tc_sessions_init(sessions);
+	if(toDay == 0)
+		toDay = 99999999;
+	sprintf(sessionsPath,"%s/%s",tcHomeDirectory,TC_SESSIONS_DIR);
+	if((dir = opendir(sessionsPath)) == NULL)
+		return errno == ENOENT ? TC_OK : TC_ERR_IO;
+	result = TC_OK;
+	while(result == TC_OK && (entry = readdir(dir)) != NULL){
+		month = strtol(entry->d_name,&end,10);
+		if(strlen(entry->d_name) != 6 || *end != '\0' || month*100 + 31 < fromDay || month*100 + 1 > toDay)
+			continue;
+		_tc_sessions_month_path(tcHomeDirectory,month,monthPath);
+		result = _tc_sessions_read_month(monthPath,fromDay,toDay,sessions);
+	}
+	closedir(dir);
+	if(result != TC_OK)
+		_tc_sessions_free(sessions);
+	return result;
+}
+
+int _tc_sessions_total(struct tc_sessions const * sessions, int32_t fromDay, int32_t toDay, struct tc_sketch * total){
+	/* Every day in [fromDay, toDay] merged into total, 0 leaves an end open */
+	size_t i;
+
+	for(i = 0; i < sessions->count; ++i)
+		if((fromDay == 0 || sessions->days[i].day >= fromDay) && (toDay == 0 || sessions->days[i].day <= toDay)
+			&& _tc_sketch_merge(total,&sessions->days[i].sketch,1) != TC_OK)
+			return TC_ERR_NOMEM;
+	return TC_OK;
+}
+
+static int _tc_sessions_write_month(char const * tcHomeDirectory, long month, struct tc_sessions_day * days, size_t count){
+	/* Replace one month file beside itself, days with nothing left are dropped */
+	char monthPath[TC_MAX_BUFF*2];
+	char monthTempPath[TC_MAX_BUFF*2+8];
+	size_t i, written;
+	FILE * fp;
+
+	_tc_sessions_month_path(tcHomeDirectory,month,monthPath);
+	sprintf(monthTempPath,"%s.tmp",monthPath);
+	if((fp = fopen(monthTempPath,"w")) == NULL)
+		return TC_ERR_IO;
+	for(written = i = 0; i < count; ++i){
+		if(days[i].sketch.sessions == 0 && days[i].sketch.count == 0 && days[i].sketch.seconds == 0)
+			continue;
+		fprintf(fp, "%08ld ", (long)days[i].day);
+		_tc_sketch_print(fp,&days[i].sketch);
+		++written;
+	}
+	if(ferror(fp) != 0 || fclose(fp) != 0){
+		remove(monthTempPath);
+		return TC_ERR_IO;
+	}
+	if(written == 0){
+		remove(monthTempPath);
+		return remove(monthPath) == 0 || errno == ENOENT ? TC_OK : TC_ERR_IO;
+	}
+	return rename(monthTempPath,monthPath) == 0 ? TC_OK : TC_ERR_IO;
+}
+
+static int _tc_sessions_begin(char const * tcHomeDirectory){
+	/* Take the sessions lock, making the directory the first time */
+	char sessionsPath[TC_MAX_BUFF*2];
+
+	sprintf(sessionsPath,"%s/%s",tcHomeDirectory,TC_SESSIONS_DIR);
+	if(_tc_directoryExists(sessionsPath) == 0 && mkdir(sessionsPath,TC_DIR_PERM) == -1 && errno != EEXIST)
+		return -1;
+	return _tc_lock_acquire(tcHomeDirectory,TC_LOCK_SESSIONS);
+}
+
+int _tc_sessions_commit(char const * tcHomeDirectory, struct tc_sessions * delta){
+	/* Add delta to the month files it touches, under one hold of the lock */
+	struct tc_sessions_day * slot;
+	struct tc_sessions month;
+	char monthPath[TC_MAX_BUFF*2];
+	size_t first, last;
+	long monthOf;
+	int lock, result;
+
+	if(delta->count == 0)
+		return TC_OK;
+	if((lock = _tc_sessions_begin(tcHomeDirectory)) == -1)
+		return TC_ERR_IO;
+	result = TC_OK;
+	for(first = 0; first < delta->count && result == TC_OK; first = last){
+		monthOf = delta->days[first].day/100;
+		for(last = first + 1; last < delta->count && delta->days[last].day/100 == monthOf; ++last)
+			;
+		_tc_sessions_init(&month);
+		_tc_sessions_month_path(tcHomeDirectory,monthOf,monthPath);
+		result = _tc_sessions_read_month(monthPath,0,99999999,&month);
+		for(; first < last && result == TC_OK; ++first)
+			if((slot = _tc_sessions_slot(&month,delta->days[first].day)) == NULL
+				|| _tc_sketch_merge(&slot->sketch,&delta->days[first].sketch,1) != TC_OK)
+				result = TC_ERR_NOMEM;
+		if(result == TC_OK)
+			result = _tc_sessions_write_month(tcHomeDirectory,monthOf,month.days,month.count);
+		_tc_sessions_free(&month);
+	}
+	_tc_lock_release(lock);
+	return result;
+}
+
+int _tc_sessions_replace(char const * tcHomeDirectory, struct tc_sessions * sessions){
+	/* Write every month of sessions and drop the month files it doesn't have */
+	struct tc_sessions stored;
+	size_t first, last, i;
+	long monthOf;
+	int lock, result;
+
+	if((lock = _tc_sessions_begin(tcHomeDirectory)) == -1)
+		return TC_ERR_IO;
+	if((result = _tc_sessions_load(tcHomeDirectory,0,0,&stored)) == TC_OK){
+		for(first = 0; first < sessions->count && result == TC_OK; first = last){
+			monthOf = sessions->days[first].day/100;
+			for(last = first + 1; last < sessions->count && sessions->days[last].day/100 == monthOf; ++last)
+				;
+			result = _tc_sessions_write_month(tcHomeDirectory,monthOf,sessions->days + first,last - first);
+		}
+		for(i = 0; i < stored.count && result == TC_OK; ++i){
+			monthOf = stored.days[i].day/100;
+			for(first = 0; first < sessions->count && sessions->days[first].day/100 != monthOf; ++first)
+				;
+			if(first == sessions->count)
+				result = _tc_sessions_write_month(tcHomeDirectory,monthOf,NULL,0);
+		}
+	}
+	_tc_sessions_free(&stored);
+	_tc_lock_release(lock);
+	return result;
+}
+
+int _tc_sessions_record(char const * tcHomeDirectory, time_t closedAt, long seconds){
+	/* One session closing, under one hold of the lock */
+	struct tc_sessions delta;
+	int result;
+
+	_tc_sessions_init(&delta);
+	if((result = _tc_sessions_add(&delta,_tc_sessions_day(closedAt),seconds,1)) == TC_OK)
+		result = _tc_sessions_commit(tcHomeDirectory,&delta);
+	_tc_sessions_free(&delta);
+	return result;
+}
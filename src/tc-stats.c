@@ -0,0 +1,205 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "tc-stats.h"
+#include "tc-init.h"
+#include "tc-task.h"
+#include "tc-view.h"
+#include "tc-archive.h"
+#include "tc-project.h"
+
+static void _tc_stats_length(long seconds, char * text){
+	/* 1h02m03s, 2m03s or 3s */
+	if(seconds >= 3600)
+		sprintf(text, "%ldh%02ldm%02lds", seconds/3600, (seconds%3600)/60, seconds%60);
+	else if(seconds >= 60)
+		sprintf(text, "%ldm%02lds", seconds/60, seconds%60);
+	else
+		sprintf(text, "%lds", seconds);
+}
+
+void _tc_stats_print(struct tc_sketch const * sketch){
+	static const struct tc_stats_quantile {
+		const char * label;
+		double quantile;
+	} quantiles[] = {{"p50", 0.50}, {"p90", 0.90}, {"p99", 0.99}, {NULL, 0}};
+	const struct tc_stats_quantile * quantile;
+	char length[64];
+
+	if(sketch->sessions <= 0){
+		fprintf(stdout, "%s\n", "No sessions");
+		return;
+	}
+	fprintf(stdout, "Sessions\t%ld\n", sketch->sessions);
+	_tc_stats_length(sketch->seconds,length);
+	fprintf(stdout, "Total\t\t%s\n", length);
+	_tc_stats_length(sketch->seconds/sketch->sessions,length);
+	fprintf(stdout, "Mean\t\t%s\n", length);
+	for(quantile = quantiles; quantile->label != NULL; ++quantile){
+		_tc_stats_length(_tc_sketch_quantile(sketch,quantile->quantile),length);
+		fprintf(stdout, "%s\t\t%s\n", quantile->label, length);
+	}
+}
+
+static int _tc_stats_archived(char const * tcHomeDirectory, struct tc_archive_entry * entry, struct tc_sketch * sketch){
+	/* An archived task's sketch from its unpacked sequence */
+	char * raw;
+	int result;
+
+	if((raw = _tc_archive_unpack(tcHomeDirectory,entry)) == NULL)
+		return TC_ERR_IO;
+	result = _tc_sketch_from_text(raw,entry->seqSize,sketch);
+	free(raw);
+	return result;
+}
+
+static int _tc_stats_under(struct tc_stats_project * project, char const * taskName){
+	return strncmp(taskName,project->path,project->length) == 0 && taskName[project->length] == TC_PROJECT_SEPARATOR;
+}
+
+static void _tc_stats_add(struct tc_stats_project * project, struct tc_sketch * task, int result){
+	if(result != TC_OK || _tc_sketch_merge(project->sketch,task,1) != TC_OK)
+		project->failed = TRUE;
+	else
+		++project->tasks;
+	_tc_sketch_free(task);
+}
+
+static void _tc_stats_task(const char * taskHash, const char * taskName, void * data){
+	struct tc_stats_project * project = data;
+	struct tc_sketch task;
+
+	if(project->failed == FALSE && _tc_stats_under(project,taskName))
+		_tc_stats_add(project,&task,_tc_sketch_open(project->root,taskHash,&task));
+}
+
+static void _tc_stats_archived_task(struct tc_archive_entry * entry, void * data){
+	struct tc_stats_project * project = data;
+	struct tc_sketch task;
+
+	if(project->failed == FALSE && _tc_stats_under(project,entry->taskName))
+		_tc_stats_add(project,&task,_tc_stats_archived(project->root,entry,&task));
+}
+
+static void _tc_stats_project(char const * tcHomeDirectory, char const * path, int includeArchived){
+	struct tc_stats_project project;
+	struct tc_sketch sketch;
+	struct tc_store * store;
+
+	if(_tc_store_open_directory(&store,tcHomeDirectory) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not open the .tc directory. Please check permissions");
+		return;
+	}
+	_tc_sketch_init(&sketch);
+	memset(&project,0,sizeof(project));
+	strcpy(project.root,tcHomeDirectory);
+	project.path = path;
+	project.length = strlen(path);
+	project.sketch = &sketch;
+	store->ops->list(store,_tc_stats_task,&project);
+	_tc_store_close(store);
+	if(includeArchived && project.failed == FALSE)
+		_tc_archive_each(tcHomeDirectory,_tc_stats_archived_task,&project);
+
+	if(project.failed)
+		fprintf(stderr, "%s\n", "Could not read the sketches of the project's tasks.");
+	else if(project.tasks == 0)
+		fprintf(stderr, "Could not find any tasks under %s.\n", path);
+	else{
+		fprintf(stdout, "Project %s, %ld task%s\n", path, project.tasks, project.tasks == 1 ? "" : "s");
+		_tc_stats_print(&sketch);
+	}
+	_tc_sketch_free(&sketch);
+}
+
+static void _tc_stats_one(char const * tcHomeDirectory, char const * taskName){
+	struct tc_archive_entry entry;
+	struct tc_sketch sketch;
+	char taskHash[TC_MAX_BUFF];
+	int result;
+
+	_tc_taskName_to_Hash((char *)taskName,taskHash);
+	result = _tc_sketch_open(tcHomeDirectory,taskHash,&sketch);
+	if(result == TC_ERR_NOT_FOUND && _tc_archive_find(tcHomeDirectory,taskHash,&entry) == TRUE)
+		result = _tc_stats_archived(tcHomeDirectory,&entry,&sketch);
+	if(result == TC_ERR_NOT_FOUND){
+		fprintf(stderr, "Could not find task %s.\n", taskName);
+		return;
+	}
+	if(result != TC_OK){
+		fprintf(stderr, "%s\n", "Could not read the task's history. Please check permissions");
+		return;
+	}
+	fprintf(stdout, "Task %s\n", taskName);
+	_tc_stats_print(&sketch);
+	_tc_sketch_free(&sketch);
+}
+
+static void _tc_stats_days(char const * tcHomeDirectory, int32_t fromDay, int32_t toDay){
+	/* Every session, or those closed on the days from fromDay to toDay */
+	struct tc_sessions sessions;
+	struct tc_sketch sketch;
+	char sessionsPath[TC_MAX_BUFF*2];
+
+	sprintf(sessionsPath,"%s/%s",tcHomeDirectory,TC_SESSIONS_DIR);
+	if(_tc_directoryExists(sessionsPath) == 0){
+		fprintf(stdout, "%s\n", "No sessions recorded yet. tcatch fsck --repair counts the ones already in the histories");
+		return;
+	}
+	_tc_sketch_init(&sketch);
+	if(_tc_sessions_load(tcHomeDirectory,fromDay,toDay,&sessions) != TC_OK || _tc_sessions_total(&sessions,fromDay,toDay,&sketch) != TC_OK)
+		fprintf(stderr, "%s\n", "Could not read the session sketches. tcatch fsck --repair rebuilds them");
+	else{
+		if(fromDay != 0)
+			fprintf(stdout, "Sessions closed from %08ld to %08ld\n", (long)fromDay, (long)toDay);
+		_tc_stats_print(&sketch);
+	}
+	_tc_sessions_free(&sessions);
+	_tc_sketch_free(&sketch);
+}
+
+void tc_stats(int argc, char const *argv[]){
+	/* Session lengths of a task, a project, a window of days or everything */
+	char tcHomeDirectory[TC_MAX_BUFF];
+	char taskName[TC_MAX_BUFF];
+	char const * project;
+	time_t from, to;
+	int at, includeArchived;
+
+	/* Usage has already been shown by the help check */
+	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
+		return;
+
+	tc_init(tcHomeDirectory);
+	project = _tc_args_flag_value(argc,argv,TC_PROJECT_LONG,TC_PROJECT_SHORT);
+	includeArchived = _tc_args_flag_check(argc,argv,TC_INCLUDE_ARCHIVED_LONG,TC_INCLUDE_ARCHIVED_SHORT);
+	at = _tc_args_flag_index(argc,argv,TC_BETWEEN_LONG,TC_BETWEEN_SHORT);
+	if(project == NULL && _tc_args_flag_check(argc,argv,TC_PROJECT_LONG,TC_PROJECT_SHORT) == TRUE){
+		_tc_display_usage(TC_STATS_COMMAND);
+		return;
+	}
+
+	/* The window is read off the days, it can't be told apart from a name */
+	if(at != -1){
+		if(project != NULL || at + 2 >= argc || _tc_view_when(argv[at+1],FALSE,&from) == FALSE || _tc_view_when(argv[at+2],TRUE,&to) == FALSE){
+			_tc_display_usage(TC_STATS_COMMAND);
+			return;
+		}
+		_tc_stats_days(tcHomeDirectory,_tc_sessions_day(from),_tc_sessions_day(to - 1));
+		return;
+	}
+	if(project != NULL){
+		_tc_stats_project(tcHomeDirectory,project,includeArchived);
+		return;
+	}
+	_tc_cli_task_name(argc,argv,taskName);
+	if(taskName[0] == '\0')
+		_tc_stats_days(tcHomeDirectory,0,0);
+	else
+		_tc_stats_one(tcHomeDirectory,taskName);
+}
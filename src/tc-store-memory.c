@@ -0,0 +1,547 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "tc-store.h"
+
+/* The memory backend keeps every task in a table hashed like the active
+ * table (first 8 hex digits of the task hash), with each task's events in
+ * a growable array. Nothing outlives the store and nothing is locked, one
+ * store belongs to one thread.
+*/
+
+struct tc_memory_event {
+	int seqNum;
+	int state;
+	time_t eventTime;
+};
+
+struct tc_memory_task {
+	char taskHash[24];
+	char taskName[TC_MAX_BUFF+1];
+	struct tc_memory_event * events;
+	size_t eventCount;
+	size_t eventCapacity;
+	char * info;
+	size_t infoSize;
+};
+
+struct tc_memory_store {
+	struct tc_memory_task ** tasks;		/* Open addressed, NULL is empty */
+	size_t taskCount;
+	size_t taskCapacity;				/* Always a power of two */
+	char currentName[TC_MAX_BUFF+1];
+	struct tc_active_slot active[TC_ACTIVE_SLOTS];
+	struct tc_projects projects;
+	struct tc_counters counters;
+	struct tc_sessions sessions;
+};
+
+static size_t _tc_store_mem_home(const char * taskHash, size_t capacity){
+	unsigned long home;
+	int i;
+
+	home = 0;
+	for(i = 0; i < 8 && taskHash[i] != '\0'; ++i)
+		home = home*16 + (taskHash[i] <= '9' ? taskHash[i] - '0' : (taskHash[i] | 0x20) - 'a' + 10);
+	return home & (capacity - 1);
+}
+
+static size_t _tc_store_mem_probe(struct tc_memory_store * memory, const char * taskHash){
+	/* Index of the task or of the empty slot it would go in */
+	size_t index;
+
+	index = _tc_store_mem_home(taskHash,memory->taskCapacity);
+	while(memory->tasks[index] != NULL && strcmp(memory->tasks[index]->taskHash,taskHash) != 0)
+		index = (index + 1) & (memory->taskCapacity - 1);
+	return index;
+}
+
+static int _tc_store_mem_grow(struct tc_memory_store * memory){
+	/* Keep the table at most half full */
+	struct tc_memory_task ** old;
+	size_t oldCapacity, i;
+
+	if((memory->taskCount + 1)*2 <= memory->taskCapacity)
+		return TRUE;
+
+	old = memory->tasks;
+	oldCapacity = memory->taskCapacity;
+	memory->taskCapacity = oldCapacity == 0 ? 64 : oldCapacity*2;
+	memory->tasks = calloc(memory->taskCapacity,sizeof(*memory->tasks));
+	if(memory->tasks == NULL){
+		memory->tasks = old;
+		memory->taskCapacity = oldCapacity;
+		return FALSE;
+	}
+	for(i = 0; i < oldCapacity; ++i)
+		if(old[i] != NULL)
+			memory->tasks[_tc_store_mem_probe(memory,old[i]->taskHash)] = old[i];
+	free(old);
+	return TRUE;
+}
+
+static struct tc_memory_task * _tc_store_mem_find(struct tc_store * store, const char * taskHash){
+	struct tc_memory_store * memory = store->data;
+
+	if(memory->taskCapacity == 0)
+		return NULL;
+	return memory->tasks[_tc_store_mem_probe(memory,taskHash)];
+}
+
+static int _tc_store_mem_task_open(struct tc_store * store, const char * taskHash, const char * taskName, int create){
+	struct tc_memory_store * memory = store->data;
+	struct tc_memory_task * task;
+
+	if(_tc_store_mem_find(store,taskHash) != NULL)
+		return TC_OK;
+	if(create == FALSE)
+		return TC_ERR_NOT_FOUND;
+	if(strlen(taskHash) >= sizeof(task->taskHash) || strlen(taskName) > TC_MAX_BUFF)
+		return TC_ERR_ARGS;
+	if(!_tc_store_mem_grow(memory))
+		return TC_ERR_NOMEM;
+
+	task = calloc(1,sizeof(*task));
+	if(task == NULL)
+		return TC_ERR_NOMEM;
+	strcpy(task->taskHash,taskHash);
+	strcpy(task->taskName,taskName);
+	memory->tasks[_tc_store_mem_probe(memory,taskHash)] = task;
+	++memory->taskCount;
+	return TC_OK;
+}
+
+static int _tc_store_mem_task_name(struct tc_store * store, const char * taskHash, char * taskName){
+	struct tc_memory_task * task = _tc_store_mem_find(store,taskHash);
+
+	if(task == NULL)
+		return TC_ERR_NOT_FOUND;
+	strcpy(taskName,task->taskName);
+	return TC_OK;
+}
+
+static int _tc_store_mem_append(struct tc_store * store, const char * taskHash, const char * taskName, int seqNum, int state, time_t eventTime){
+	struct tc_memory_task * task;
+	struct tc_memory_event * grown;
+	size_t newCapacity;
+	int result;
+
+	if((result = _tc_store_mem_task_open(store,taskHash,taskName,TRUE)) != TC_OK)
+		return result;
+	task = _tc_store_mem_find(store,taskHash);
+
+	if(task->eventCount == task->eventCapacity){
+		newCapacity = task->eventCapacity == 0 ? 16 : task->eventCapacity*2;
+		grown = realloc(task->events,newCapacity*sizeof(*grown));
+		if(grown == NULL)
+			return TC_ERR_NOMEM;
+		task->events = grown;
+		task->eventCapacity = newCapacity;
+	}
+	task->events[task->eventCount].seqNum = seqNum;
+	task->events[task->eventCount].state = state;
+	task->events[task->eventCount].eventTime = eventTime;
+	++task->eventCount;
+	return TC_OK;
+}
+
+static int _tc_store_mem_history(struct tc_store * store, const char * taskHash, tc_seq_callback callback, void * data){
+	struct tc_memory_task * task = _tc_store_mem_find(store,taskHash);
+	size_t i;
+
+	if(task == NULL)
+		return TC_ERR_NOT_FOUND;
+	for(i = 0; i < task->eventCount; ++i)
+		callback(task->events[i].seqNum,task->events[i].state,task->events[i].eventTime,data);
+	return (int)task->eventCount;
+}
+
+static int _tc_store_mem_last(struct tc_store * store, const char * taskHash, tc_seq_callback callback, void * data){
+	struct tc_memory_task * task = _tc_store_mem_find(store,taskHash);
+
+	if(task == NULL)
+		return TC_ERR_NOT_FOUND;
+	if(task->eventCount == 0)
+		return 0;
+	callback(task->events[task->eventCount-1].seqNum,task->events[task->eventCount-1].state,task->events[task->eventCount-1].eventTime,data);
+	return 1;
+}
+
+static int _tc_store_mem_spans(struct tc_store * store, const char * taskHash, struct tc_spans * spans){
+	/* Nothing is cached in memory, the intervals come from a replay */
+	_tc_spans_reset(spans);
+	if(_tc_store_mem_history(store,taskHash,_tc_spans_record,spans) < 0)
+		return TC_ERR_NOT_FOUND;
+	if(spans->failed){
+		_tc_spans_free(spans);
+		return TC_ERR_NOMEM;
+	}
+	return TC_OK;
+}
+
+static int _tc_store_mem_append_events(struct tc_store * store, const char * taskHash, const char * taskName, const struct tc_store_event * events, size_t count, long * bytes){
+	/* Room for all of them is made first, so nothing is added unless everything is */
+	struct tc_memory_task * task;
+	struct tc_memory_event * grown;
+	char seqLine[TC_MAX_BUFF];
+	size_t newCapacity, noteSize, length, i;
+	char * info;
+	int result;
+
+	*bytes = 0;
+	if((result = _tc_store_mem_task_open(store,taskHash,taskName,TRUE)) != TC_OK)
+		return result;
+	task = _tc_store_mem_find(store,taskHash);
+	if(task->eventCount == 0)
+		*bytes += strlen(task->taskName) + 1;
+
+	if(task->eventCount + count > task->eventCapacity){
+		for(newCapacity = task->eventCapacity == 0 ? 16 : task->eventCapacity; newCapacity < task->eventCount + count; newCapacity *= 2)
+			;
+		grown = realloc(task->events,newCapacity*sizeof(*grown));
+		if(grown == NULL){
+			*bytes = 0;
+			return TC_ERR_NOMEM;
+		}
+		task->events = grown;
+		task->eventCapacity = newCapacity;
+	}
+	for(noteSize = i = 0; i < count; ++i)
+		if(events[i].note != NULL && events[i].note[0] != '\0')
+			noteSize += strlen(events[i].note) + 1;
+	if(noteSize > 0){
+		info = realloc(task->info,task->infoSize + noteSize + 1);
+		if(info == NULL){
+			*bytes = 0;
+			return TC_ERR_NOMEM;
+		}
+		task->info = info;
+	}
+
+	for(i = 0; i < count; ++i){
+		task->events[task->eventCount].seqNum = events[i].seqNum;
+		task->events[task->eventCount].state = events[i].state;
+		task->events[task->eventCount].eventTime = events[i].eventTime;
+		++task->eventCount;
+		*bytes += sprintf(seqLine, "%i %i %ld\n", events[i].seqNum, events[i].state, (long)events[i].eventTime);
+		if(events[i].note != NULL && events[i].note[0] != '\0'){
+			length = strlen(events[i].note);
+			memcpy(task->info + task->infoSize,events[i].note,length);
+			task->infoSize += length;
+			task->info[task->infoSize++] = '\n';
+			task->info[task->infoSize] = '\0';
+		}
+	}
+	*bytes += noteSize;
+	return TC_OK;
+}
+
+static int _tc_store_mem_serialize(struct tc_store * store, const char * taskHash, char ** text, size_t * seqSize, size_t * infoSize){
+	/* Written out the way the directory backend keeps it */
+	struct tc_memory_task * task = _tc_store_mem_find(store,taskHash);
+	char seqLine[TC_MAX_BUFF];
+	size_t length, i;
+	char * at;
+
+	*text = NULL;
+	if(task == NULL || task->eventCount == 0)
+		return TC_ERR_NOT_FOUND;
+	for(*seqSize = i = 0; i < task->eventCount; ++i)
+		*seqSize += sprintf(seqLine, "%i %i %ld\n", task->events[i].seqNum, task->events[i].state, (long)task->events[i].eventTime);
+	length = strlen(task->taskName);
+	*infoSize = length + 1 + task->infoSize;
+	if((*text = malloc(*seqSize + *infoSize + 1)) == NULL)
+		return TC_ERR_NOMEM;
+	for(at = *text, i = 0; i < task->eventCount; ++i)
+		at += sprintf(at, "%i %i %ld\n", task->events[i].seqNum, task->events[i].state, (long)task->events[i].eventTime);
+	memcpy(at,task->taskName,length);
+	at[length] = '\n';
+	if(task->infoSize > 0)
+		memcpy(at + length + 1,task->info,task->infoSize);
+	return TC_OK;
+}
+
+static int _tc_store_mem_add_info(struct tc_store * store, const char * taskHash, const char * text){
+	struct tc_memory_task * task = _tc_store_mem_find(store,taskHash);
+	size_t length;
+	char * grown;
+
+	if(task == NULL)
+		return TC_ERR_NOT_FOUND;
+	length = strlen(text);
+	grown = realloc(task->info,task->infoSize + length + 2);
+	if(grown == NULL)
+		return TC_ERR_NOMEM;
+	task->info = grown;
+	memcpy(task->info + task->infoSize,text,length);
+	task->infoSize += length;
+	task->info[task->infoSize++] = '\n';
+	task->info[task->infoSize] = '\0';
+	return TC_OK;
+}
+
+static int _tc_store_mem_add_info_stream(struct tc_store * store, const char * taskHash, int fd, long * bytes){
+	/* Kept in memory anyway, so read fd into the information a block at a time */
+	struct tc_memory_task * task = _tc_store_mem_find(store,taskHash);
+	ssize_t got;
+	char * grown;
+
+	*bytes = 0;
+	if(task == NULL)
+		return TC_ERR_NOT_FOUND;
+	for(;;){
+		grown = realloc(task->info,task->infoSize + TC_STREAM_BLOCK + 2);
+		if(grown == NULL)
+			return TC_ERR_NOMEM;
+		task->info = grown;
+		got = read(fd,task->info + task->infoSize,TC_STREAM_BLOCK);
+		if(got == -1 && errno == EINTR)
+			continue;
+		if(got <= 0)
+			break;
+		task->infoSize += got;
+		*bytes += got;
+	}
+	if(*bytes > 0 && task->info[task->infoSize-1] != '\n'){
+		task->info[task->infoSize++] = '\n';
+		++*bytes;
+	}
+	if(task->info != NULL)
+		task->info[task->infoSize] = '\0';
+	return got == 0 ? TC_OK : TC_ERR_IO;
+}
+
+static int _tc_store_mem_list(struct tc_store * store, tc_store_task_callback callback, void * data){
+	struct tc_memory_store * memory = store->data;
+	size_t i;
+	int count;
+
+	count = 0;
+	for(i = 0; i < memory->taskCapacity; ++i)
+		if(memory->tasks[i] != NULL && memory->tasks[i]->eventCount > 0){
+			callback(memory->tasks[i]->taskHash,memory->tasks[i]->taskName,data);
+			++count;
+		}
+	return count;
+}
+
+static int _tc_store_mem_current_get(struct tc_store * store, char * taskName){
+	struct tc_memory_store * memory = store->data;
+
+	strcpy(taskName,memory->currentName);
+	return taskName[0] == '\0' ? TC_ERR_NO_CURRENT : TC_OK;
+}
+
+static int _tc_store_mem_current_set(struct tc_store * store, const char * taskName, const char * taskHash, const struct tc_task_summary * summary){
+	struct tc_memory_store * memory = store->data;
+	(void)taskHash; (void)summary;
+
+	if(strlen(taskName) > TC_MAX_BUFF)
+		return TC_ERR_ARGS;
+	strcpy(memory->currentName,taskName);
+	return TC_OK;
+}
+
+static int _tc_store_mem_current_summary(struct tc_store * store, char * taskName, char * taskHash, struct tc_task_summary * summary){
+	/* Replaying from memory is already cheap, there is nothing to cache */
+	if(_tc_store_mem_current_get(store,taskName) != TC_OK)
+		return TC_ERR_NO_CURRENT;
+	_tc_taskName_to_Hash(taskName,taskHash);
+	_tc_store_summarize(store,taskHash,summary);
+	return TC_OK;
+}
+
+static int _tc_store_mem_current_clear(struct tc_store * store){
+	struct tc_memory_store * memory = store->data;
+
+	memory->currentName[0] = '\0';
+	return TC_OK;
+}
+
+static int _tc_store_mem_active_remove(struct tc_store * store, const char * taskHash);
+
+static void _tc_store_mem_free_task(struct tc_memory_task * task){
+	free(task->events);
+	free(task->info);
+	free(task);
+}
+
+static int _tc_store_mem_remove(struct tc_store * store, const char * taskHash){
+	/* Pull the task out and put back anything its probe run was covering */
+	struct tc_memory_store * memory = store->data;
+	struct tc_memory_task * moved;
+	struct tc_task_summary summary;
+	size_t index;
+
+	if(_tc_store_mem_find(store,taskHash) == NULL)
+		return TC_ERR_NOT_FOUND;
+	/* Only the state counts, sizes are whatever the writers tallied */
+	_tc_store_summarize(store,taskHash,&summary);
+	_tc_counters_tally(&memory->counters,summary.state,TC_TASK_NOT_FOUND,0);
+	index = _tc_store_mem_probe(memory,taskHash);
+	_tc_store_mem_free_task(memory->tasks[index]);
+	memory->tasks[index] = NULL;
+	--memory->taskCount;
+
+	index = (index + 1) & (memory->taskCapacity - 1);
+	while(memory->tasks[index] != NULL){
+		moved = memory->tasks[index];
+		memory->tasks[index] = NULL;
+		memory->tasks[_tc_store_mem_probe(memory,moved->taskHash)] = moved;
+		index = (index + 1) & (memory->taskCapacity - 1);
+	}
+	_tc_store_mem_active_remove(store,taskHash);
+	return TC_OK;
+}
+
+static int _tc_store_mem_lock(struct tc_store * store, const char * taskName, int withCurrentTask, char * currentTaskName, struct tc_lockset * locks){
+	/* Nothing to lock, the caller just wants to know what is current */
+	(void)taskName; (void)withCurrentTask;
+	locks->count = 0;
+	_tc_store_mem_current_get(store,currentTaskName);
+	return TC_OK;
+}
+
+static void _tc_store_mem_unlock(struct tc_store * store, struct tc_lockset * locks){
+	(void)store;
+	locks->count = 0;
+}
+
+static int _tc_store_mem_active_find(struct tc_store * store, const char * taskHash, struct tc_active_slot * slot){
+	struct tc_memory_store * memory = store->data;
+	int i;
+
+	for(i = 0; i < TC_ACTIVE_SLOTS; ++i)
+		if(memory->active[i].used == TC_ACTIVE_USED && strcmp(memory->active[i].taskHash,taskHash) == 0){
+			*slot = memory->active[i];
+			return TRUE;
+		}
+	return FALSE;
+}
+
+static int _tc_store_mem_active_insert(struct tc_store * store, struct tc_active_slot * slot){
+	struct tc_memory_store * memory = store->data;
+	int i, freeIndex;
+
+	freeIndex = -1;
+	for(i = 0; i < TC_ACTIVE_SLOTS; ++i){
+		if(memory->active[i].used == TC_ACTIVE_USED && strcmp(memory->active[i].taskHash,slot->taskHash) == 0){
+			freeIndex = i;
+			break;
+		}
+		if(memory->active[i].used != TC_ACTIVE_USED && freeIndex == -1)
+			freeIndex = i;
+	}
+	if(freeIndex == -1)
+		return TC_ERR_FULL;
+	slot->used = TC_ACTIVE_USED;
+	memory->active[freeIndex] = *slot;
+	return TC_OK;
+}
+
+static int _tc_store_mem_active_remove(struct tc_store * store, const char * taskHash){
+	struct tc_memory_store * memory = store->data;
+	int i;
+
+	for(i = 0; i < TC_ACTIVE_SLOTS; ++i)
+		if(memory->active[i].used == TC_ACTIVE_USED && strcmp(memory->active[i].taskHash,taskHash) == 0){
+			memory->active[i].used = TC_ACTIVE_EMPTY;
+			return TRUE;
+		}
+	return FALSE;
+}
+
+static void _tc_store_mem_close(struct tc_store * store){
+	struct tc_memory_store * memory = store->data;
+	size_t i;
+
+	for(i = 0; i < memory->taskCapacity; ++i)
+		if(memory->tasks[i] != NULL)
+			_tc_store_mem_free_task(memory->tasks[i]);
+	free(memory->tasks);
+	_tc_projects_free(&memory->projects);
+	_tc_sessions_free(&memory->sessions);
+	free(memory);
+	free(store);
+}
+
+static int _tc_store_mem_restore(struct tc_store * store, const char * taskHash){
+	/* Nothing is ever archived in memory */
+	(void)store;
+	(void)taskHash;
+	return TC_ERR_NOT_FOUND;
+}
+
+static int _tc_store_mem_rollup(struct tc_store * store, const char * taskName, long seconds, long tasks){
+	struct tc_memory_store * memory = store->data;
+	return _tc_projects_add(&memory->projects,taskName,seconds,tasks);
+}
+
+static int _tc_store_mem_tally(struct tc_store * store, int priorState, int state, long bytes){
+	struct tc_memory_store * memory = store->data;
+	_tc_counters_tally(&memory->counters,priorState,state,bytes);
+	return TC_OK;
+}
+
+static int _tc_store_mem_session(struct tc_store * store, const char * taskHash, long seconds, time_t closedAt){
+	/* A task's own sketch is replayed from its events when asked for */
+	struct tc_memory_store * memory = store->data;
+	(void)taskHash;
+	return _tc_sessions_add(&memory->sessions,_tc_sessions_day(closedAt),seconds,1);
+}
+
+static const struct tc_store_ops _tc_store_mem_ops = {
+	"memory",
+	_tc_store_mem_task_open,
+	_tc_store_mem_task_name,
+	_tc_store_mem_append,
+	_tc_store_mem_history,
+	_tc_store_mem_last,
+	_tc_store_mem_spans,
+	_tc_store_mem_append_events,
+	_tc_store_mem_serialize,
+	_tc_store_mem_add_info,
+	_tc_store_mem_add_info_stream,
+	_tc_store_mem_list,
+	_tc_store_mem_current_get,
+	_tc_store_mem_current_set,
+	_tc_store_mem_current_summary,
+	_tc_store_mem_current_clear,
+	_tc_store_mem_remove,
+	_tc_store_mem_restore,
+	_tc_store_mem_rollup,
+	_tc_store_mem_tally,
+	_tc_store_mem_session,
+	_tc_store_mem_lock,
+	_tc_store_mem_unlock,
+	_tc_store_mem_active_find,
+	_tc_store_mem_active_insert,
+	_tc_store_mem_active_remove,
+	_tc_store_mem_close
+};
+
+int _tc_store_open_memory(struct tc_store ** store){
+	struct tc_store * opened;
+
+	*store = NULL;
+	opened = malloc(sizeof(*opened));
+	if(opened == NULL)
+		return TC_ERR_NOMEM;
+	opened->data = calloc(1,sizeof(struct tc_memory_store));
+	if(opened->data == NULL){
+		free(opened);
+		return TC_ERR_NOMEM;
+	}
+	_tc_projects_init(&((struct tc_memory_store *)opened->data)->projects);
+	_tc_counters_init(&((struct tc_memory_store *)opened->data)->counters);
+	_tc_sessions_init(&((struct tc_memory_store *)opened->data)->sessions);
+	opened->ops = &_tc_store_mem_ops;
+	opened->root[0] = '\0';
+	*store = opened;
+	return TC_OK;
+}
@@ -0,0 +1,574 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "tc-store.h"
+#include "tc-directory.h"
+#include "tc-prompt.h"
+#include "tc-manifest.h"
+#include "tc-interval.h"
+#include "tc-journal.h"
+#include "tc-archive.h"
+
+/* The directory backend, the layout tcatch has always used:
+
+	<tc home>/tasks/<taskName sha-1>.seq and <taskName sha-1>.info
+
+	The seq file format is as follows:
+	<seq num> <state> <epoch time>
+	<seq num> <state> <epoch time>
+
+	The info file is simply:
+	Task Name \n
+	[Raw text added through add-info]
+
+	Every event also gets an entry in the index segment of the day it happened
+	on, see tc-manifest.h, and a record in <tc home>/journal, see
+	tc-journal.h. <tc home>/current holds the name, hash and last
+	event of the current task and where it stands, see tc-task.h, and
+	<tc home>/prompt repeats it for shell prompts, see tc-prompt.h. Project totals are kept in <tc home>/projects,
+	see tc-project.h, and <taskName sha-1>.span indexes a task's intervals
+	once a window has been asked of it, see tc-interval.h. <tc home>/counters
+	keeps the task counts and sizes the metrics textfile shows, see
+	tc-counters.h. <taskName sha-1>.sketch and <tc home>/sessions keep
+	the lengths of closed intervals, see tc-sketch.h. Finished tasks packed
+	away in <tc home>/archive are unpacked again by restore, see tc-archive.h.
+*/
+
+static int _tc_store_dir_task_open(struct tc_store * store, const char * taskHash, const char * taskName, int create){
+	char taskInfoPath[TC_MAX_BUFF];
+	FILE * fp;
+
+	_tc_getTaskFilePath(taskInfoPath,store->root,taskHash,TC_INFO_EXT);
+	if(_tc_file_exists(taskInfoPath))
+		return TC_OK;
+	if(create == FALSE)
+		return TC_ERR_NOT_FOUND;
+
+	/* The first line of the info file is the name */
+	fp = fopen(taskInfoPath, "w"); /* Note that w overwrites so no security hole here*/
+	if(!fp)
+		return TC_ERR_IO;
+	fprintf(fp, "%s\n", taskName);
+	return fclose(fp) == 0 ? TC_OK : TC_ERR_IO;
+}
+
+static int _tc_store_dir_task_name(struct tc_store * store, const char * taskHash, char * taskName){
+	char taskInfoPath[TC_MAX_BUFF];
+
+	_tc_getTaskFilePath(taskInfoPath,store->root,taskHash,TC_INFO_EXT);
+	return _tc_task_name_from_info(taskInfoPath,taskName) ? TC_OK : TC_ERR_NOT_FOUND;
+}
+
+static int _tc_store_dir_append(struct tc_store * store, const char * taskHash, const char * taskName, int seqNum, int state, time_t eventTime){
+	char taskSequencePath[TC_MAX_BUFF];
+	char currentDate[TC_MAX_BUFF/2];
+	struct tm timeinfo;
+	FILE * fp;
+	int result;
+
+	/* Append the event to the sequence, creating it on the first one */
+	_tc_getTaskFilePath(taskSequencePath,store->root,taskHash,TC_SEQ_EXT);
+	fp = fopen(taskSequencePath, "a");
+	if(!fp)
+		return TC_ERR_IO;
+	fprintf(fp, "%i %i %ld\n", seqNum, state, eventTime);
+	if(fclose(fp) != 0)
+		return TC_ERR_IO;
+
+	/* Update the index segment of the day the event happened on */
+	if(localtime_r(&eventTime,&timeinfo) == NULL)
+		return TC_ERR_TIME;
+	strftime(currentDate,80,"%Y%m%d",&timeinfo);
+	result = _tc_manifest_append(store->root,currentDate,taskHash,taskName,state);
+
+	/* And the journal, which like the index takes its lock last */
+	if(_tc_journal_append(store->root,eventTime,taskHash,state,seqNum) != TC_OK && result == TC_OK)
+		result = TC_ERR_IO;
+	return result;
+}
+
+static int _tc_store_dir_history(struct tc_store * store, const char * taskHash, tc_seq_callback callback, void * data){
+	char taskSequencePath[TC_MAX_BUFF];
+	int records;
+
+	_tc_getTaskFilePath(taskSequencePath,store->root,taskHash,TC_SEQ_EXT);
+	records = _tc_seq_foreach(taskSequencePath,callback,data);
+	return records == -1 ? TC_ERR_NOT_FOUND : records;
+}
+
+static int _tc_store_dir_last(struct tc_store * store, const char * taskHash, tc_seq_callback callback, void * data){
+	char taskSequencePath[TC_MAX_BUFF];
+	int records;
+
+	_tc_getTaskFilePath(taskSequencePath,store->root,taskHash,TC_SEQ_EXT);
+	records = _tc_seq_last(taskSequencePath,callback,data);
+	return records == -1 ? TC_ERR_NOT_FOUND : records;
+}
+
+static int _tc_store_dir_spans(struct tc_store * store, const char * taskHash, struct tc_spans * spans){
+	/* From the span file, or from the archive for an archived task */
+	struct tc_archive_entry entry;
+	char * raw;
+	int result;
+
+	result = _tc_spans_open(store->root,taskHash,spans);
+	if(result != TC_ERR_NOT_FOUND || _tc_archive_find(store->root,taskHash,&entry) == FALSE)
+		return result;
+	if((raw = _tc_archive_unpack(store->root,&entry)) == NULL)
+		return TC_ERR_IO;
+	_tc_spans_from_text(raw,entry.seqSize,spans);
+	free(raw);
+	return spans->failed ? TC_ERR_NOMEM : TC_OK;
+}
+
+static int _tc_store_dir_cut(const char * path, long size){
+	/* Cut a file back to size, removing it when it had none. FALSE leaves
+	 * it to tcatch fsck --repair */
+	FILE * fp;
+	int result;
+
+	if(size < 0)
+		return remove(path) == 0;
+	if((fp = fopen(path,"r+")) == NULL)
+		return FALSE;
+	result = ftruncate(fileno(fp),size) == 0;
+	fclose(fp);
+	return result;
+}
+
+static int _tc_store_dir_append_events(struct tc_store * store, const char * taskHash, const char * taskName, const struct tc_store_event * events, size_t count, long * bytes){
+	/* Every event onto the .seq and every note onto the .info in one pass,
+	 * both cut back to where they were when a write fails */
+	char taskSequencePath[TC_MAX_BUFF];
+	char taskInfoPath[TC_MAX_BUFF];
+	struct stat fileStat;
+	FILE * seqFile, * infoFile;
+	long seqSize, infoSize;
+	int written, failed;
+	size_t i;
+
+	_tc_getTaskFilePath(taskSequencePath,store->root,taskHash,TC_SEQ_EXT);
+	_tc_getTaskFilePath(taskInfoPath,store->root,taskHash,TC_INFO_EXT);
+	seqSize = stat(taskSequencePath,&fileStat) == 0 ? (long)fileStat.st_size : -1;
+	infoSize = stat(taskInfoPath,&fileStat) == 0 ? (long)fileStat.st_size : -1;
+	failed = FALSE;
+	*bytes = 0;
+	if(infoSize < 0){
+		infoFile = fopen(taskInfoPath,"w");
+		if(infoFile && (written = fprintf(infoFile, "%s\n", taskName)) > 0)
+			*bytes += written;
+		else
+			failed = TRUE;
+	}else{
+		infoFile = fopen(taskInfoPath,"a");
+	}
+	seqFile = fopen(taskSequencePath,"a");
+
+	for(i = 0; i < count && seqFile && infoFile && failed == FALSE; ++i){
+		if((written = fprintf(seqFile, "%i %i %ld\n", events[i].seqNum, events[i].state, (long)events[i].eventTime)) > 0)
+			*bytes += written;
+		else
+			failed = TRUE;
+		if(events[i].note != NULL && events[i].note[0] != '\0'){
+			if((written = fprintf(infoFile, "%s\n", events[i].note)) > 0)
+				*bytes += written;
+			else
+				failed = TRUE;
+		}
+	}
+	if((seqFile && fclose(seqFile) != 0) || seqFile == NULL)
+		failed = TRUE;
+	if((infoFile && fclose(infoFile) != 0) || infoFile == NULL)
+		failed = TRUE;
+	if(failed == FALSE)
+		return TC_OK;
+	_tc_store_dir_cut(taskSequencePath,seqSize);
+	_tc_store_dir_cut(taskInfoPath,infoSize);
+	*bytes = 0;
+	return TC_ERR_IO;
+}
+
+static char * _tc_store_dir_slurp(const char * path, size_t * size){
+	/* The whole file in one buffer, NULL if it can't be read */
+	struct stat status;
+	char * buffer;
+	FILE * fp;
+
+	fp = fopen(path,"rb");
+	if(!fp)
+		return NULL;
+	if(fstat(fileno(fp),&status) != 0 || (buffer = malloc(status.st_size + 1)) == NULL){
+		fclose(fp);
+		return NULL;
+	}
+	*size = fread(buffer,1,status.st_size,fp);
+	fclose(fp);
+	if(*size != (size_t)status.st_size){
+		free(buffer);
+		return NULL;
+	}
+	return buffer;
+}
+
+static int _tc_store_dir_serialize(struct tc_store * store, const char * taskHash, char ** text, size_t * seqSize, size_t * infoSize){
+	char taskSequencePath[TC_MAX_BUFF];
+	char taskInfoPath[TC_MAX_BUFF];
+	char * seqText, * infoText;
+
+	*text = NULL;
+	_tc_getTaskFilePath(taskSequencePath,store->root,taskHash,TC_SEQ_EXT);
+	_tc_getTaskFilePath(taskInfoPath,store->root,taskHash,TC_INFO_EXT);
+	if(_tc_file_exists(taskSequencePath) == FALSE || _tc_file_exists(taskInfoPath) == FALSE)
+		return TC_ERR_NOT_FOUND;
+	seqText = _tc_store_dir_slurp(taskSequencePath,seqSize);
+	infoText = seqText ? _tc_store_dir_slurp(taskInfoPath,infoSize) : NULL;
+	*text = infoText ? malloc(*seqSize + *infoSize + 1) : NULL;
+	if(*text != NULL){
+		memcpy(*text,seqText,*seqSize);
+		memcpy(*text + *seqSize,infoText,*infoSize);
+	}
+	free(seqText);
+	free(infoText);
+	return *text != NULL ? TC_OK : TC_ERR_IO;
+}
+
+static int _tc_store_dir_add_info(struct tc_store * store, const char * taskHash, const char * text){
+	char taskInfoPath[TC_MAX_BUFF];
+	FILE * fp;
+
+	_tc_getTaskFilePath(taskInfoPath,store->root,taskHash,TC_INFO_EXT);
+	fp = fopen(taskInfoPath, "a");
+	if(!fp)
+		return TC_ERR_IO;
+	fprintf(fp, "%s\n", text);
+	return fclose(fp) == 0 ? TC_OK : TC_ERR_IO;
+}
+
+static int _tc_store_dir_write(int fd, const char * block, size_t size){
+	/* All of block, however many writes it takes */
+	ssize_t wrote;
+
+	while(size > 0){
+		wrote = write(fd,block,size);
+		if(wrote == -1 && errno == EINTR)
+			continue;
+		if(wrote <= 0)
+			return TC_ERR_IO;
+		block += wrote;
+		size -= wrote;
+	}
+	return TC_OK;
+}
+
+static int _tc_store_dir_add_info_stream(struct tc_store * store, const char * taskHash, int fd, long * bytes){
+	/* Straight from fd to the end of the info file, one block at a time */
+	char taskInfoPath[TC_MAX_BUFF];
+	char * block;
+	ssize_t got;
+	int infoFd, result;
+	char last;
+
+	*bytes = 0;
+	block = malloc(TC_STREAM_BLOCK);
+	if(block == NULL)
+		return TC_ERR_NOMEM;
+	_tc_getTaskFilePath(taskInfoPath,store->root,taskHash,TC_INFO_EXT);
+	infoFd = open(taskInfoPath,O_WRONLY|O_APPEND);
+	if(infoFd == -1){
+		free(block);
+		return TC_ERR_IO;
+	}
+
+	result = TC_OK;
+	last = '\n';
+	for(;;){
+		got = read(fd,block,TC_STREAM_BLOCK);
+		if(got == -1 && errno == EINTR)
+			continue;
+		if(got <= 0){
+			result = got == 0 ? TC_OK : TC_ERR_IO;
+			break;
+		}
+		if((result = _tc_store_dir_write(infoFd,block,got)) != TC_OK)
+			break;
+		*bytes += got;
+		last = block[got-1];
+	}
+	/* Information is kept in lines, like add_info leaves it */
+	if(result == TC_OK && last != '\n' && (result = _tc_store_dir_write(infoFd,"\n",1)) == TC_OK)
+		++*bytes;
+	if(close(infoFd) != 0 && result == TC_OK)
+		result = TC_ERR_IO;
+	free(block);
+	return result;
+}
+
+static int _tc_store_dir_list(struct tc_store * store, tc_store_task_callback callback, void * data){
+	DIR * dirPointer;
+	struct dirent * dirEntry;
+	char taskDir[TC_MAX_BUFF*2];
+	char taskHash[TC_MAX_BUFF];
+	char taskName[TC_MAX_BUFF];
+	char * namePointer;
+	int count;
+
+	sprintf(taskDir,"%s/%s",store->root,TC_TASK_DIR);
+	dirPointer = opendir(taskDir);
+	if(dirPointer == NULL)
+		return TC_ERR_IO;
+
+	count = 0;
+	while((dirEntry = readdir(dirPointer)) != NULL){
+		if((namePointer = strstr(dirEntry->d_name,".seq")) == NULL || namePointer[4] != '\0')
+			continue;
+		*namePointer = '\0';
+		strncpy(taskHash,dirEntry->d_name,TC_MAX_BUFF-1);
+		taskHash[TC_MAX_BUFF-1] = '\0';
+		if(_tc_store_dir_task_name(store,taskHash,taskName) != TC_OK)
+			continue; /* Without a name the task can't be reported on */
+		callback(taskHash,taskName,data);
+		++count;
+	}
+	closedir(dirPointer);
+	return count;
+}
+
+static int _tc_store_dir_current_get(struct tc_store * store, char * taskName){
+	_tc_current_task_name(store->root,taskName);
+	return taskName[0] == '\0' ? TC_ERR_NO_CURRENT : TC_OK;
+}
+
+static void _tc_store_dir_prompt(struct tc_store * store, const char * taskName, const struct tc_task_summary * summary){
+	/* The prompt record follows current. It is only a convenience for
+	 * prompts, so a failure here does not fail the write */
+	char promptPath[TC_MAX_BUFF*2];
+
+	sprintf(promptPath,"%s/%s",store->root,TC_PROMPT_FILE);
+	if(summary == NULL)
+		_tc_prompt_write(promptPath,NULL,TC_TASK_NOT_FOUND,0,0,0);
+	else
+		_tc_prompt_write(promptPath,taskName,summary->state,summary->startTime,summary->lastStart,summary->accumulated);
+}
+
+static int _tc_store_dir_current_set(struct tc_store * store, const char * taskName, const char * taskHash, const struct tc_task_summary * summary){
+	/* Write beside current and rename over it so readers never see half a
+	 * file. The record is tied to the .seq file as it is now, see tc-task.h */
+	char currentTaskPath[TC_MAX_BUFF*2];
+	char currentTempPath[TC_MAX_BUFF*2+8];
+	char taskSequencePath[TC_MAX_BUFF*2];
+	struct stat fileStat;
+	FILE * fp;
+
+	_tc_getTaskFilePath(taskSequencePath,store->root,taskHash,TC_SEQ_EXT);
+	if(stat(taskSequencePath,&fileStat) != 0)
+		return TC_ERR_IO;
+	sprintf(currentTaskPath,"%s/%s",store->root,TC_CURRENT_TASK);
+	sprintf(currentTempPath,"%s.tmp",currentTaskPath);
+	fp = fopen(currentTempPath,"w");
+	if(!fp)
+		return TC_ERR_IO;
+	fprintf(fp, "%s\n", taskName);
+	fprintf(fp, "%s\n", taskHash);
+	fprintf(fp, "%i %i %ld\n", summary->seqNum - 1, summary->state, (long)summary->lastTime);
+	fprintf(fp, "%ld %ld %ld %ld %ld\n", (long)summary->startTime, (long)summary->lastStart, (long)summary->accumulated,
+		(long)fileStat.st_size, (long)fileStat.st_mtime);
+	if(fclose(fp) != 0 || rename(currentTempPath,currentTaskPath) != 0)
+		return TC_ERR_IO;
+	_tc_store_dir_prompt(store,taskName,summary);
+	return TC_OK;
+}
+
+static int _tc_store_dir_current_summary(struct tc_store * store, char * taskName, char * taskHash, struct tc_task_summary * summary){
+	struct tc_current current;
+
+	if(_tc_current_read(store->root,&current) == TRUE){
+		strcpy(taskName,current.taskName);
+		strcpy(taskHash,current.taskHash);
+		*summary = current.summary;
+		return TC_OK;
+	}
+	strcpy(taskName,current.taskName);
+	if(taskName[0] == '\0')
+		return TC_ERR_NO_CURRENT;
+	_tc_taskName_to_Hash(taskName,taskHash);
+	_tc_store_summarize(store,taskHash,summary);
+	return TC_OK;
+}
+
+static int _tc_store_dir_current_clear(struct tc_store * store){
+	char currentTaskPath[TC_MAX_BUFF*2];
+
+	sprintf(currentTaskPath,"%s/%s",store->root,TC_CURRENT_TASK);
+	if(remove(currentTaskPath) != 0)
+		return TC_ERR_IO;
+	_tc_store_dir_prompt(store,NULL,NULL);
+	return TC_OK;
+}
+
+static int _tc_store_dir_remove(struct tc_store * store, const char * taskHash){
+	char taskSequencePath[TC_MAX_BUFF];
+	char taskInfoPath[TC_MAX_BUFF];
+	char taskSpanPath[TC_MAX_BUFF];
+	char taskSketchPath[TC_MAX_BUFF];
+	struct tc_task_summary summary;
+	struct stat fileStat;
+	long bytes;
+
+	_tc_getTaskFilePath(taskSequencePath,store->root,taskHash,TC_SEQ_EXT);
+	_tc_getTaskFilePath(taskInfoPath,store->root,taskHash,TC_INFO_EXT);
+	/* What the counters had of the task, before it goes */
+	_tc_store_summarize(store,taskHash,&summary);
+	bytes = 0;
+	if(stat(taskSequencePath,&fileStat) == 0)
+		bytes += fileStat.st_size;
+	if(stat(taskInfoPath,&fileStat) == 0)
+		bytes += fileStat.st_size;
+	if(remove(taskSequencePath) == -1 || remove(taskInfoPath) == -1)
+		return TC_ERR_IO;
+	_tc_counters_record(store->root,summary.state,TC_TASK_NOT_FOUND,-bytes);
+	/* The interval index and sketch go too, they may never have been built */
+	_tc_getTaskFilePath(taskSpanPath,store->root,taskHash,TC_SPAN_EXT);
+	remove(taskSpanPath);
+	_tc_getTaskFilePath(taskSketchPath,store->root,taskHash,TC_SKETCH_EXT);
+	remove(taskSketchPath);
+	_tc_active_remove(store->root,taskHash);
+	return TC_OK;
+}
+
+static int _tc_store_dir_restore(struct tc_store * store, const char * taskHash){
+	/* The archive took the task out of the counters, it goes back in */
+	char taskSequencePath[TC_MAX_BUFF];
+	char taskInfoPath[TC_MAX_BUFF];
+	struct tc_task_summary summary;
+	struct stat fileStat;
+	long bytes;
+	int result;
+
+	if((result = _tc_archive_restore(store->root,taskHash)) != TC_OK)
+		return result;
+	_tc_getTaskFilePath(taskSequencePath,store->root,taskHash,TC_SEQ_EXT);
+	_tc_getTaskFilePath(taskInfoPath,store->root,taskHash,TC_INFO_EXT);
+	_tc_store_summarize(store,taskHash,&summary);
+	bytes = 0;
+	if(stat(taskSequencePath,&fileStat) == 0)
+		bytes += fileStat.st_size;
+	if(stat(taskInfoPath,&fileStat) == 0)
+		bytes += fileStat.st_size;
+	_tc_counters_record(store->root,TC_TASK_NOT_FOUND,summary.state,bytes);
+	return TC_OK;
+}
+
+static int _tc_store_dir_rollup(struct tc_store * store, const char * taskName, long seconds, long tasks){
+	return _tc_projects_record(store->root,taskName,seconds,tasks);
+}
+
+static int _tc_store_dir_tally(struct tc_store * store, int priorState, int state, long bytes){
+	return _tc_counters_record(store->root,priorState,state,bytes);
+}
+
+static int _tc_store_dir_session(struct tc_store * store, const char * taskHash, long seconds, time_t closedAt){
+	/* Opening the task's sketch catches it up with the event just appended */
+	struct tc_sketch sketch;
+	int result;
+
+	if((result = _tc_sketch_open(store->root,taskHash,&sketch)) != TC_OK)
+		return result;
+	_tc_sketch_free(&sketch);
+	return _tc_sessions_record(store->root,closedAt,seconds);
+}
+
+static int _tc_store_dir_lock(struct tc_store * store, const char * taskName, int withCurrentTask, char * currentTaskName, struct tc_lockset * locks){
+	return _tc_lock_command(store->root,taskName,withCurrentTask,currentTaskName,locks);
+}
+
+static void _tc_store_dir_unlock(struct tc_store * store, struct tc_lockset * locks){
+	(void)store;
+	_tc_unlock_command(locks);
+}
+
+static int _tc_store_dir_active_find(struct tc_store * store, const char * taskHash, struct tc_active_slot * slot){
+	return _tc_active_find(store->root,taskHash,slot);
+}
+
+static int _tc_store_dir_active_insert(struct tc_store * store, struct tc_active_slot * slot){
+	return _tc_active_insert(store->root,slot);
+}
+
+static int _tc_store_dir_active_remove(struct tc_store * store, const char * taskHash){
+	return _tc_active_remove(store->root,taskHash);
+}
+
+static void _tc_store_dir_close(struct tc_store * store){
+	free(store);
+}
+
+static const struct tc_store_ops _tc_store_dir_ops = {
+	"directory",
+	_tc_store_dir_task_open,
+	_tc_store_dir_task_name,
+	_tc_store_dir_append,
+	_tc_store_dir_history,
+	_tc_store_dir_last,
+	_tc_store_dir_spans,
+	_tc_store_dir_append_events,
+	_tc_store_dir_serialize,
+	_tc_store_dir_add_info,
+	_tc_store_dir_add_info_stream,
+	_tc_store_dir_list,
+	_tc_store_dir_current_get,
+	_tc_store_dir_current_set,
+	_tc_store_dir_current_summary,
+	_tc_store_dir_current_clear,
+	_tc_store_dir_remove,
+	_tc_store_dir_restore,
+	_tc_store_dir_rollup,
+	_tc_store_dir_tally,
+	_tc_store_dir_session,
+	_tc_store_dir_lock,
+	_tc_store_dir_unlock,
+	_tc_store_dir_active_find,
+	_tc_store_dir_active_insert,
+	_tc_store_dir_active_remove,
+	_tc_store_dir_close
+};
+
+int _tc_store_open_directory(struct tc_store ** store, const char * tcHomeDirectory){
+	/* Paths get a hash and an extension added, leave them room */
+	struct tc_store * opened;
+
+	*store = NULL;
+	if(strlen(tcHomeDirectory) >= TC_MAX_BUFF/2)
+		return TC_ERR_ARGS;
+	if(_tc_store_create(tcHomeDirectory) == FALSE)
+		return TC_ERR_IO;
+
+	opened = malloc(sizeof(*opened));
+	if(opened == NULL)
+		return TC_ERR_NOMEM;
+	opened->ops = &_tc_store_dir_ops;
+	strcpy(opened->root,tcHomeDirectory);
+	opened->data = NULL;
+	*store = opened;
+	return TC_OK;
+}
+
+void _tc_store_close(struct tc_store * store){
+	if(store != NULL)
+		store->ops->close(store);
+}
+
+int _tc_store_summarize(struct tc_store * store, const char * taskHash, struct tc_task_summary * summary){
+	/* Replay a task into summary. Returns its last state */
+	_tc_task_summary_init(summary);
+	if(store->ops->history(store,taskHash,_tc_task_summary_record,summary) <= 0)
+		_tc_task_summary_init(summary);
+	return summary->state;
+}
@@ -1,118 +1,135 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include "tc-task.h"
 #include "tc-directory.h"
 
 #include <ctype.h>
-
-void _resolve_taskName_from_args(int argc, char const *argv[],char * taskName){
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+char * _tc_args_join(int argc, char const *argv[]){
+	/* The words after the command, flags left out, joined by spaces in one
+	 * pass into a buffer that doubles as it fills. NULL when out of memory */
+	char * joined, * grown;
+	size_t length, capacity, wordLength;
 	int i;
-	taskName[0] = '\0';
-	
-	for(i=2; i < argc; ++i)
-		if(argv[i][0] != '-')
-			sprintf(taskName,"%s %s",taskName,argv[i]);
-		else
+
+	capacity = TC_MAX_BUFF;
+	length = 0;
+	joined = malloc(capacity);
+	if(joined == NULL)
+		return NULL;
+	joined[0] = '\0';
+
+	for(i = 2; i < argc; ++i){
+		if(argv[i][0] == '-')
 			continue; /*Ignore any flag value*/
+		wordLength = strlen(argv[i]);
+		while(length + wordLength + 2 > capacity){
+			capacity *= 2;
+			grown = realloc(joined,capacity);
+			if(grown == NULL){
+				free(joined);
+				return NULL;
+			}
+			joined = grown;
+		}
+		if(length > 0)
+			joined[length++] = ' ';
+		memcpy(joined + length,argv[i],wordLength);
+		length += wordLength;
+		joined[length] = '\0';
+	}
 
 	/* Strip front white space or ending white space */
-	trim(taskName);
+	trim(joined);
+	return joined;
 }
 
-void _find_current_task(struct tc_task * taskStruct){
-	/*Returns an error code within the taskStruct to determine success or not*/
-	char currentTaskPath[TC_MAX_BUFF];
-	char tempBuffer[TC_MAX_BUFF];
-	FILE * fp;
-
-	_tc_getCurrentTaskPath(currentTaskPath);
-
-	/* Check if the file exists or not */
-	if( _tc_file_exists(currentTaskPath) ){
-		/* the current task file is simply the name of the current task and its hash */
-		fp = fopen(currentTaskPath, "r");
-		if(!fp){
-			fprintf(stderr, "%s\n", "Could not open current task file. Exiting");
-			taskStruct->state = TC_TASK_FOUND;
-			return;
-		}
-
-		/* Get the name of the task we want to read */
-		fgets(tempBuffer,TC_MAX_BUFF,fp);
-		tempBuffer[strlen(tempBuffer)-1] = '\0';
-		fclose(fp);
+int _resolve_taskName_from_args(int argc, char const *argv[],char * taskName){
+	/* Into a TC_MAX_BUFF buffer, a name too long for it is refused rather
+	 * than cut short. TC_ERR_ARGS or TC_ERR_NOMEM leave taskName "" */
+	char * joined;
+	int result;
 
-		_tc_task_read(tempBuffer, taskStruct);		
-	}else{
-		/* Return an error flag that there is no current task */
-		taskStruct->state = TC_TASK_NOT_FOUND;
+	taskName[0] = '\0';
+	joined = _tc_args_join(argc,argv);
+	if(joined == NULL)
+		return TC_ERR_NOMEM;
+	result = TC_ERR_ARGS;
+	if(strlen(joined) < TC_MAX_BUFF){
+		strcpy(taskName,joined);
+		result = TC_OK;
 	}
-
+	free(joined);
+	return result;
 }
 
-void _tc_task_read(char const * taskName, struct tc_task * structToFill){ 
-	/* Attempt to fill the structure with data from the file */
-	char taskHash[TC_MAX_BUFF];
-	char taskSequencePath[TC_MAX_BUFF];
-	char taskInfoPath[TC_MAX_BUFF];
-	FILE * fp;
-	int seqNum, seqState;
-	time_t priorTime,seqTime,runningTime;
+struct tc_task_replay {
+	struct tc_task * task;
+	int seqNum;
+	int seqState;
+	time_t seqTime;
 	int priorState;
+	time_t priorTime;
+	time_t runningTime;
+};
+
+static void _tc_task_replay_record(int seqNum, int seqState, time_t seqTime, void * data){
+	struct tc_task_replay * replay = data;
+
+	if (seqNum == 0)
+		replay->task->startTime = seqTime;
+	else if( replay->priorState == TC_TASK_STARTED && (seqState == TC_TASK_PAUSED || seqState == TC_TASK_FINISHED) ) 
+		/* Calculate time spent on task */	
+		replay->runningTime = replay->runningTime + (seqTime - replay->priorTime);
+
+	replay->priorTime = seqTime;
+	replay->priorState = seqState;
+	replay->seqNum = seqNum;
+	replay->seqState = seqState;
+	replay->seqTime = seqTime;
+}
 
-	strcpy(structToFill->taskName,taskName);
-	_tc_taskName_to_Hash((char *)taskName,taskHash);
-	
-	/* Read the sequence information for the sequence number and timing info and the last state*/
-	/* So to tease out the information we need to read the sequence information. The start time is 
-	 * the first time in the sequence file by default, so lets open the sequence file:
-	*/
-
-	sprintf(taskSequencePath,"%s/.tc/%s/%s.seq",_tc_getHomePath(),TC_TASK_DIR,taskHash);
-	sprintf(taskInfoPath,"%s/.tc/%s/%s.info",_tc_getHomePath(),TC_TASK_DIR,taskHash);
-	fp = fopen(taskSequencePath,"r");
-	if(!fp){
-		fprintf(stderr, "%s\n", "Could not find or open the sequence file for task. Exiting");
-		structToFill->state =  TC_TASK_NOT_FOUND;
-		return;
-	}
-
-	runningTime =  seqState = 0;
-	while( fscanf(fp, "%i %i %ld\n", &seqNum, &seqState, &seqTime) != EOF) {
-		if (seqNum == 0) {
-			structToFill->startTime = seqTime;
-			priorTime = seqTime;
-			priorState = seqState;
-		} else {
-			/* Calculate time spent on task */	
-			if( priorState == TC_TASK_STARTED && (seqState == TC_TASK_PAUSED || seqState == TC_TASK_FINISHED) ) 
-				runningTime = runningTime + (seqTime - priorTime);
-			
-			priorTime = seqTime;
-			priorState = seqState;
-			
-		}
-	}
-	
+static void _tc_task_replay_done(struct tc_task_replay * replay, struct tc_task * structToFill){
 	/* This occurs of the project just started and hasing had any stops yet*/
-	if(runningTime == 0 && seqState == TC_TASK_STARTED ){
-		runningTime =  time(0) - structToFill->startTime;
-	}
-
-	
-	structToFill->endTime = seqTime;
-	structToFill->state = seqState;
-	structToFill->seqNum = seqNum+1;
-	structToFill->pauseTime = runningTime;
+	if(replay->runningTime == 0 && replay->seqState == TC_TASK_STARTED )
+		replay->runningTime =  time(0) - structToFill->startTime;
 
-	fclose(fp);
+	structToFill->endTime = replay->seqTime;
+	structToFill->state = replay->seqState;
+	structToFill->seqNum = replay->seqNum+1;
+	structToFill->pauseTime = replay->runningTime;
+}
 
-	/* Cheat a little bit 
-	 * It's simple, we stored the NAME of the info file into the structure, then when we want to
-	 * display the information we don't read the whole file into memory, but rather we open it
-	 * then read it directly into an output stream. This saves us the trouble of realloc-ing memory
-	 * or reading the file some buffer size at a time.for no reason.
+int _tc_task_replay(char const * taskSequencePath, struct tc_task * structToFill){
+	/* Fill the times, state and next sequence number from the sequence file.
+	 * The start time is the first time in the file. FALSE if it can't be read.
 	*/
-	strcpy(structToFill->taskInfo , taskInfoPath);
+	struct tc_task_replay replay;
+
+	memset(&replay,0,sizeof(replay));
+	replay.task = structToFill;
+	replay.seqNum = -1;
+	structToFill->startTime = 0;
+	if(_tc_seq_foreach(taskSequencePath,_tc_task_replay_record,&replay) == -1)
+		return FALSE;
+	_tc_task_replay_done(&replay,structToFill);
+	return TRUE;
+}
+
+void _tc_task_replay_text(const char * text, size_t length, struct tc_task * structToFill){
+	/* The same, for sequence records already in memory */
+	struct tc_task_replay replay;
 
+	memset(&replay,0,sizeof(replay));
+	replay.task = structToFill;
+	replay.seqNum = -1;
+	structToFill->startTime = 0;
+	_tc_seq_parse(text,length,_tc_task_replay_record,&replay);
+	_tc_task_replay_done(&replay,structToFill);
 }
 
 void _tc_taskName_to_Hash(char * taskName, char  * fileHashName){
@@ -129,151 +146,64 @@ void _tc_taskName_to_Hash(char * taskName, char  * fileHashName){
 	strcpy(fileHashName,tempHashName);
 }
 
-void _tc_task_write(struct tc_task structToWrite, char tcHomeDirectory[]){
-	/* Write the task out in a useful format */
-
-	/* The format of a task file name is as follows:
-		<taskName sha-1>.seq and <taskName sha-1>.info
-
-		The seq file format is as follows:
-		<seq num> <state> <epoch time> [info hash for future]
-		<seq num> <state> <epoch time> [info hash for future]
-		<seq num> <state> <epoch time> [info hash for future]
-
-		The info file is simply:
-		Task Name \n
-		[Raw text added through add-info]
-		-- ideas for later implementation use info hash for future as info file
-		name and then store individual info added to task at each sequence 
-		Then the view command could also show the last added piece of info! --
-	*/
-	char taskSequencePath[TC_MAX_BUFF]; 
-	char taskInfoPath[TC_MAX_BUFF];
-	char * fileHash;
-	time_t rawtime, timeToWrite;
-	struct tm * timeinfo;
-	char currentDate[TC_MAX_BUFF/2];
-	char indexFilePath[TC_MAX_BUFF];
-	FILE * fp;
+void _tc_current_task_name(char const * tcHomeDirectory, char * currentTaskName){
+	/* Peek at the name in current without replaying the task, "" if there is none */
 	char currentTaskPath[TC_MAX_BUFF];
+	FILE * fp;
+	size_t len;
 
-	fileHash = malloc(25*sizeof(char)); /* hash is 20 characters .seq is 4 more \0 is 1 more */
-	if( fileHash == NULL ){
-		fprintf(stderr, "%s\n", "Could not allocate memory for file hash string.");
-		exit(1);
-	}
-	fileHash[0] = '\0';
-	
-	_tc_taskName_to_Hash(structToWrite.taskName,fileHash);
-	
-	sprintf(taskSequencePath,"%s/%s/%s.seq",tcHomeDirectory,TC_TASK_DIR,fileHash);
-	sprintf(taskInfoPath,"%s/%s/%s.info",tcHomeDirectory,TC_TASK_DIR,fileHash);
-
-	/* If the info file does not exist create it */
-	if((_tc_file_exists(taskInfoPath)) == FALSE){
-		fp = fopen(taskInfoPath, "w"); /* Note that w overwrites so no security hole here*/
-		if (!fp) {    		
-			fprintf(stderr,"%s\n", "Could not create task information file. Please check permissions");
-			free(fileHash);
-			exit(1);    		
-    	} else {
-    		/* Write out information to the file if there is any*/
-    		fprintf(fp, "%s\n", structToWrite.taskName);
-    		if(structToWrite.taskInfo != NULL && strstr(structToWrite.taskInfo,fileHash) == NULL)
-    			fprintf(fp, "%s\n", structToWrite.taskInfo);
-    		fflush(fp);
-    		fclose(fp);
-    	}
-	}else{
-		fp = fopen(taskInfoPath, "a+");
-		if (!fp) {    		
-			fprintf(stderr,"%s\n", "Could not create task sequence file. Please check permissions");
-			free(fileHash);
-			exit(1);    		
-    	} else {
-    		/* Write out information to the file if there is any*/
-
-    		if(structToWrite.taskInfo != NULL && strstr(structToWrite.taskInfo,fileHash) == NULL)
-    			fprintf(fp, "%s\n", structToWrite.taskInfo);
-    		fflush(fp);
-    		fclose(fp);
-    	}
-	}
-
-	/*If the .seq file doesn't exist create it*/
-	if((_tc_file_exists(taskSequencePath))==FALSE){
-		fp = fopen(taskSequencePath, "w"); /* Note that w overwrites so no security hole here*/
-		if (!fp) {
-			fprintf(stderr,"%s\n", "Could not create task sequence file. Please check permissions");
-			free(fileHash);
-			exit(1);    		
-		}
-	}else{
-		fp = fopen(taskSequencePath, "a+"); /* Note that w overwrites so no security hole here*/
-		if (!fp) {
-			fprintf(stderr,"%s\n", "Could not create task sequence file. Please check permissions");
-			free(fileHash);
-			exit(1);    		
-		}
-	}
-    if(fp){
-		/* Write out information to the sequence */    		
-		switch( structToWrite.state ){
-			case TC_TASK_PAUSED:
-				timeToWrite = structToWrite.pauseTime;
-				break;
-			case TC_TASK_FINISHED:
-				timeToWrite = structToWrite.endTime;
-				break;
-			case TC_TASK_STARTED:
-			default:
-				timeToWrite = time(0);
-				break;
-		}
-		fprintf(fp, "%i %i %ld\n", structToWrite.seqNum, structToWrite.state, timeToWrite);
-		fflush(fp);
-		fclose(fp);
-    }
+	currentTaskName[0] = '\0';
+	sprintf(currentTaskPath,"%s/%s",tcHomeDirectory,TC_CURRENT_TASK);
+	fp = fopen(currentTaskPath,"r");
+	if(!fp)
+		return;
+	if(fgets(currentTaskName,TC_MAX_BUFF,fp) == NULL)
+		currentTaskName[0] = '\0';
+	fclose(fp);
 
-    /* Update the index file */
-    rawtime = time(0); /*If you're starting a task at the crux of midnight then maybe this will be wrong*/
-	timeinfo = localtime (&rawtime);
-	strftime(currentDate,80,"%Y%m%d",timeinfo);
-	sprintf(indexFilePath,"%s/%s/%s.index",tcHomeDirectory,TC_INDEX_DIR,currentDate);
-
-	/* We don't need to check for the index file's existence because tc-init takes care of that */
-	fp = fopen(indexFilePath, "a");
-	if(!fp) {
-		/* Weird permission problem? */
-		free(fileHash);
-		fprintf(stderr, "%s\n", "Could not open index file for appending. Exiting");
-		exit(1);
-	}
+	len = strlen(currentTaskName);
+	if(len > 0 && currentTaskName[len-1] == '\n')
+		currentTaskName[len-1] = '\0';
+}
 
-	/* Append information to the index file 
-	 * This information is in the format: <task hash> <state>
-	*/
-	fprintf(fp, "%s %s %i\n", fileHash, structToWrite.taskName, structToWrite.state);
-	fflush(fp);
-	fclose(fp);
+int _tc_current_read(char const * tcHomeDirectory, struct tc_current * current){
+	/* The current task's record, TRUE when it is still in step with the
+	 * task's .seq file. The name is filled in either way, "" for none */
+	char currentTaskPath[TC_MAX_BUFF*2];
+	char taskSequencePath[TC_MAX_BUFF*2];
+	char line[TC_MAX_BUFF];
+	struct stat fileStat;
+	long lastTime, startTime, lastStart, accumulated, bytes, modified;
+	int seqNum, state, fields;
+	FILE * fp;
 
-	/* If the structure was just started then it is our current task */
-	_tc_getCurrentTaskPath(currentTaskPath);
-	fp = fopen(currentTaskPath,"w");
-	if(!fp) {
-		/* Something went wrong */
-		free(fileHash);
-		fprintf(stderr, "%s\n", "Could not open current task file for writing. Exiting");
-		exit(1);
-	}
-	fprintf(fp, "%s\n", structToWrite.taskName);
-	fprintf(fp, "%s\n", fileHash);
-	fprintf(fp, "%i %i %ld\n", structToWrite.seqNum, structToWrite.state, timeToWrite);
-	fflush(fp);
+	memset(current,0,sizeof(*current));
+	sprintf(currentTaskPath,"%s/%s",tcHomeDirectory,TC_CURRENT_TASK);
+	fp = fopen(currentTaskPath,"r");
+	if(!fp)
+		return FALSE;
+	fields = 0;
+	if(fgets(current->taskName,sizeof(current->taskName),fp) != NULL && fgets(current->taskHash,sizeof(current->taskHash),fp) != NULL
+		&& fgets(line,sizeof(line),fp) != NULL && sscanf(line,"%d %d %ld",&seqNum,&state,&lastTime) == 3
+		&& fgets(line,sizeof(line),fp) != NULL)
+		fields = sscanf(line,"%ld %ld %ld %ld %ld",&startTime,&lastStart,&accumulated,&bytes,&modified);
 	fclose(fp);
-
-	free(fileHash);
-	
+	current->taskName[strcspn(current->taskName,"\n")] = '\0';
+	current->taskHash[strcspn(current->taskHash,"\n")] = '\0';
+
+	/* Records from before the last line was kept are stale */
+	_tc_getTaskFilePath(taskSequencePath,tcHomeDirectory,current->taskHash,TC_SEQ_EXT);
+	if(fields != 5 || current->taskHash[0] == '\0' || stat(taskSequencePath,&fileStat) != 0
+		|| (long)fileStat.st_size != bytes || (long)fileStat.st_mtime != modified)
+		return FALSE;
+
+	current->summary.state = state;
+	current->summary.seqNum = seqNum + 1;
+	current->summary.startTime = startTime;
+	current->summary.lastStart = lastStart;
+	current->summary.lastTime = lastTime;
+	current->summary.accumulated = accumulated;
+	return TRUE;
 }
 
 char * _tc_stateToString(int state){
@@ -339,89 +269,237 @@ char *trim(char *str)
     return str;
 }
 
-void _tc_task_read_byHashPath(char const * taskHash, struct tc_task * structToFill){ 
-	/* Attempt to fill the structure with data from the file */
-	char taskSequencePath[TC_MAX_BUFF];
-	char taskInfoPath[TC_MAX_BUFF];
-	char taskName[TC_MAX_BUFF];
-	FILE * fp;
-	int seqNum, seqState;
-	time_t priorTime,seqTime,runningTime;
-	int priorState;
+static const char * _tc_seq_number(const char * cursor, const char * lineEnd, long * value){
+	/* Decode one decimal field after any blanks, NULL when there isn't one */
+	unsigned long number;
+	int negative;
+
+	while(cursor < lineEnd && (*cursor == ' ' || *cursor == '\t'))
+		++cursor;
+	negative = cursor < lineEnd && *cursor == '-';
+	if(negative)
+		++cursor;
+	if(cursor == lineEnd || (unsigned)(*cursor - '0') > 9)
+		return NULL;
+
+	number = 0;
+	do
+		number = number*10 + (unsigned)(*cursor++ - '0');
+	while(cursor < lineEnd && (unsigned)(*cursor - '0') <= 9);
+
+	*value = negative ? -(long)number : (long)number;
+	return cursor;
+}
+
+/* Repeated bytes at whatever width unsigned long has */
+#define TC_SEQ_BYTES(byte) ((~0UL/255)*(byte))
 
-	/* Read the sequence information for the sequence number and timing info and the last state*/
-	/* So to tease out the information we need to read the sequence information. The start time is 
-	 * the first time in the sequence file by default, so lets open the sequence file:
+static int _tc_seq_wide(void){
+	/* TRUE when eight digits fit one unsigned long with the first one in
+	 * its low byte, so _tc_seq_eight can decode them together */
+	unsigned long one = 1;
+
+	return sizeof(unsigned long) >= 8 && *(unsigned char *)&one == 1;
+}
+
+static int _tc_seq_eight(const char * cursor, unsigned long * value){
+	/* Eight ASCII digits as one number, without a branch per digit. FALSE
+	 * when they are not all digits */
+	unsigned long word;
+
+	memcpy(&word,cursor,sizeof(word));
+	if(((word & TC_SEQ_BYTES(0xF0)) | (((word + TC_SEQ_BYTES(0x06)) & TC_SEQ_BYTES(0xF0)) >> 4)) != TC_SEQ_BYTES(0x33))
+		return FALSE;
+	word -= TC_SEQ_BYTES('0');
+	word = (word*10 + (word >> 8)) & (~0UL/0xFFFF)*0xFF;
+	word = (word*100 + (word >> 16)) & (~0UL/0xFFFFFFFFUL)*0xFFFF;
+	*value = (word*10000 + (word >> 16 >> 16)) & 0xFFFFFFFFUL;
+	return TRUE;
+}
+
+static const char * _tc_seq_digits(const char * cursor, const char * end, int wide, unsigned long * value){
+	/* One run of digits, eight at a time while there are eight. NULL when
+	 * there isn't a digit at cursor */
+	unsigned long number, eight;
+
+	if(cursor == end || (unsigned)(*cursor - '0') > 9)
+		return NULL;
+	number = 0;
+	while(wide && end - cursor >= 8 && _tc_seq_eight(cursor,&eight)){
+		number = number*100000000UL + eight;
+		cursor += 8;
+	}
+	while(cursor != end && (unsigned)(*cursor - '0') <= 9)
+		number = number*10 + (unsigned)(*cursor++ - '0');
+	*value = number;
+	return cursor;
+}
+
+static const char * _tc_seq_line(const char * cursor, const char * end, int wide, long fields[3]){
+	/* The exact "<seq num> <state> <epoch time>\n" shape tcatch writes,
+	 * decoded without looking at anything twice. NULL for anything else.
 	*/
-	taskName[0] = '\0';
-	strcpy(structToFill->taskName,taskName);
-
-
-	sprintf(taskSequencePath,"%s/.tc/%s/%s.seq",_tc_getHomePath(),TC_TASK_DIR,taskHash);
-	sprintf(taskInfoPath,"%s/.tc/%s/%s.info",_tc_getHomePath(),TC_TASK_DIR,taskHash);
-	fp = fopen(taskSequencePath,"r");
-	if(!fp){
-		fprintf(stderr, "%s\n", "Could not find or open the sequence file for task.");
-		structToFill->startTime = 0;
-		structToFill->pauseTime = 0;
-		structToFill->endTime = 0;
-		structToFill->state =  TC_TASK_NOT_FOUND;
-		return;
+	unsigned long number;
+	int i;
+
+	for(i = 0; i < 3; ++i){
+		if((cursor = _tc_seq_digits(cursor,end,wide,&number)) == NULL)
+			return NULL;
+		fields[i] = (long)number;
+
+		if(cursor == end)
+			return i == 2 ? cursor : NULL;
+		if(*cursor++ != (i == 2 ? '\n' : ' '))
+			return NULL;
 	}
+	return cursor;
+}
 
-	runningTime =  seqState = seqTime = 0;
-	while( fscanf(fp, "%i %i %ld\n", &seqNum, &seqState, &seqTime) != EOF) {
-		if (seqNum == 0) {
-			structToFill->startTime = seqTime;
-			priorTime = seqTime;
-			priorState = seqState;
-		} else {
-			/* Calculate time spent on task */	
-			if( priorState == TC_TASK_STARTED && (seqState == TC_TASK_PAUSED || seqState == TC_TASK_FINISHED) ) 
-				runningTime = runningTime + (seqTime - priorTime);
-			
-			priorTime = seqTime;
-			priorState = seqState;
-			
+int _tc_seq_parse(const char * text, size_t length, tc_seq_callback callback, void * data){
+	/* Walk "<seq num> <state> <epoch time>" lines held in memory. Blank lines
+	 * are skipped and the walk stops at the first malformed record, like the
+	 * fscanf loop it replaces. Returns the number of records.
+	*/
+	const char * cursor, * end, * lineEnd, * field;
+	long fields[3];
+	int records, wide;
+
+	cursor = text;
+	end = text + length;
+	records = 0;
+	wide = _tc_seq_wide();
+	while(cursor < end){
+		/* Nearly every line takes the fast path, which finds its newline
+		 * as it decodes the last field */
+		if((field = _tc_seq_line(cursor,end,wide,fields)) != NULL){
+			callback((int)fields[0], (int)fields[1], (time_t)fields[2], data);
+			++records;
+			cursor = field;
+			continue;
 		}
+
+		/* Anything else (extra blanks, a sign, a \r or a blank line) is
+		 * decoded field by field up to the newline memchr finds */
+		lineEnd = memchr(cursor,'\n',end - cursor);
+		if(lineEnd == NULL)
+			lineEnd = end;
+
+		field = cursor;
+		while(field < lineEnd && isspace((unsigned char)*field))
+			++field;
+		if(field != lineEnd){
+			if((field = _tc_seq_number(field,lineEnd,&fields[0])) == NULL
+				|| (field = _tc_seq_number(field,lineEnd,&fields[1])) == NULL
+				|| (field = _tc_seq_number(field,lineEnd,&fields[2])) == NULL)
+				break;
+			callback((int)fields[0], (int)fields[1], (time_t)fields[2], data);
+			++records;
+		}
+		cursor = lineEnd + 1;
 	}
-	
-	/* This occurs of the project just started and hasing had any stops yet*/
-	if(runningTime == 0 && seqState == TC_TASK_STARTED ){
-		runningTime =  time(0) - structToFill->startTime;
+	return records;
+}
+
+int _tc_seq_foreach(char const * taskSequencePath, tc_seq_callback callback, void * data){
+	/* Walk every record of a sequence file, returns the number of records or -1 */
+	struct stat fileStat;
+	void * mapped;
+	int fd, records;
+
+	fd = open(taskSequencePath,O_RDONLY);
+	if(fd == -1)
+		return -1;
+	if(fstat(fd,&fileStat) == -1){
+		close(fd);
+		return -1;
+	}
+	if(fileStat.st_size == 0){
+		close(fd);
+		return 0;
 	}
 
-	
-	structToFill->endTime = seqTime;
-	structToFill->state = seqState;
-	structToFill->seqNum = seqNum+1;
-	structToFill->pauseTime = runningTime;
+	/* Map the whole file, it is only ever appended to with whole lines */
+	mapped = mmap(NULL,fileStat.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd);
+	if(mapped == MAP_FAILED)
+		return -1;
+	records = _tc_seq_parse(mapped,fileStat.st_size,callback,data);
+	munmap(mapped,fileStat.st_size);
 
-	fclose(fp);
+	return records;
+}
 
+int _tc_seq_last(char const * taskSequencePath, tc_seq_callback callback, void * data){
+	/* Only the last whole record, from the tail of the file. Returns 1, 0
+	 * for an empty file or -1 */
+	char tail[TC_SEQ_TAIL];
+	struct stat fileStat;
+	off_t offset;
+	ssize_t got;
+	char * line;
+	int fd;
+
+	fd = open(taskSequencePath,O_RDONLY);
+	if(fd == -1)
+		return -1;
+	if(fstat(fd,&fileStat) == -1){
+		close(fd);
+		return -1;
+	}
+	offset = fileStat.st_size > (off_t)sizeof(tail) ? fileStat.st_size - (off_t)sizeof(tail) : 0;
+	got = lseek(fd,offset,SEEK_SET) == -1 ? -1 : read(fd,tail,sizeof(tail));
+	close(fd);
+	if(got < 0)
+		return -1;
+
+	/* A writer may be halfway through the last line, it is left for next time */
+	while(got > 0 && tail[got-1] != '\n')
+		--got;
+	if(got == 0)
+		return 0;
+	for(line = tail + got - 1; line > tail && line[-1] != '\n'; --line)
+		;
+	return _tc_seq_parse(line,tail + got - line,callback,data);
+}
+
+int _tc_task_name_from_info(char const * taskInfoPath, char * taskName){
+	/* The first line of an info file is always the task name */
+	FILE * fp;
+	size_t len;
 
+	taskName[0] = '\0';
 	fp = fopen(taskInfoPath,"r");
-	if(!fp){
-		fprintf(stderr, "%s\n", "Could not find or open the info file for task.");
-		structToFill->state =  TC_TASK_NOT_FOUND;
-		structToFill->startTime = 0;
-		structToFill->pauseTime = 0;
-		structToFill->endTime = 0;
-		return;
+	if(!fp)
+		return FALSE;
+
+	if(fgets(taskName,TC_MAX_BUFF,fp) == NULL){
+		fclose(fp);
+		return FALSE;
 	}
+	fclose(fp);
 
-	/* The first line is the task name*/
-	fgets(taskName,TC_MAX_BUFF,fp);
-	taskName[strlen(taskName)-1] = '\0'; /* Remove the newline read in*/
-	strcpy(structToFill->taskName,taskName);
+	len = strlen(taskName);
+	if(len > 0 && taskName[len-1] == '\n')
+		taskName[len-1] = '\0';
+	return TRUE;
+}
 
-	fclose(fp);
-	/* Cheat a little bit 
-	 * It's simple, we stored the NAME of the info file into the structure, then when we want to
-	 * display the information we don't read the whole file into memory, but rather we open it
-	 * then read it directly into an output stream. This saves us the trouble of realloc-ing memory
-	 * or reading the file some buffer size at a time.for no reason.
-	*/
-	strcpy(structToFill->taskInfo , taskInfoPath);
+void _tc_task_summary_init(struct tc_task_summary * summary){
+	memset(summary,0,sizeof(*summary));
+	summary->state = TC_TASK_NOT_FOUND;
+}
 
-}
\ No newline at end of file
+void _tc_task_summary_record(int seqNum, int seqState, time_t seqTime, void * data){
+	/* Closed STARTED intervals add up, a new STARTED opens the running one */
+	struct tc_task_summary * summary = data;
+
+	if(seqNum == 0)
+		summary->startTime = seqTime;
+	if(summary->state == TC_TASK_STARTED && (seqState == TC_TASK_PAUSED || seqState == TC_TASK_FINISHED))
+		summary->accumulated += seqTime - summary->lastStart;
+	if(seqState == TC_TASK_STARTED && summary->state != TC_TASK_STARTED)
+		summary->lastStart = seqTime;
+	summary->state = seqState;
+	summary->lastTime = seqTime;
+	summary->seqNum = seqNum + 1;
+}
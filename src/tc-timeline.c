@@ -0,0 +1,441 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tc-timeline.h"
+#include "tc-init.h"
+#include "tc-task.h"
+#include "tc-view.h"
+#include "tc-log.h"
+#include "tc-active.h"
+#include "tc-interval.h"
+
+static int _tc_timeline_window(char const * text, int week, struct tc_timeline * timeline){
+	/* The day holding text, or the week from the Monday before it */
+	struct tm day;
+	time_t when;
+
+	if(text == NULL)
+		when = timeline->now;
+	else if(_tc_view_when(text,FALSE,&when) == FALSE)
+		return FALSE;
+	day = *localtime(&when);
+	day.tm_hour = day.tm_min = day.tm_sec = 0;
+	day.tm_isdst = -1;
+	if(week)
+		day.tm_mday -= (day.tm_wday + 6) % 7;
+	if((timeline->from = mktime(&day)) == -1)
+		return FALSE;
+	day.tm_mday += week ? 7 : 1;
+	day.tm_isdst = -1;
+	timeline->to = mktime(&day);
+	timeline->byDay = week;
+	return timeline->to > timeline->from;
+}
+
+void tc_timeline(int argc, char const *argv[]){
+	char tcHomeDirectory[TC_MAX_BUFF];
+	struct tc_timeline timeline;
+	char const * columns;
+	int week;
+
+	/* Usage has already been shown by the help check */
+	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
+		return;
+
+	tc_init(tcHomeDirectory);
+	memset(&timeline,0,sizeof(timeline));
+	if((timeline.now = time(0)) == -1){
+		fprintf(stderr, "%s\n", "Could not determine time.");
+		return;
+	}
+	week = _tc_args_flag_check(argc,argv,TC_WEEK_LONG,TC_WEEK_SHORT);
+	if((week && _tc_args_flag_check(argc,argv,TC_DAY_LONG,TC_DAY_SHORT))
+		|| _tc_timeline_window(week ? _tc_args_flag_value(argc,argv,TC_WEEK_LONG,TC_WEEK_SHORT) : _tc_args_flag_value(argc,argv,TC_DAY_LONG,TC_DAY_SHORT),week,&timeline) == FALSE){
+		_tc_display_usage(TC_TIMELINE_COMMAND);
+		return;
+	}
+
+	/* The chart fills the terminal when the shell says how wide it is */
+	columns = getenv("COLUMNS");
+	timeline.width = (columns != NULL ? atoi(columns) : TC_TIMELINE_COLUMNS) - TC_TIMELINE_LABEL - TC_TIMELINE_TOTAL - 2;
+	if(timeline.width < TC_TIMELINE_MIN_WIDTH)
+		timeline.width = TC_TIMELINE_MIN_WIDTH;
+
+	if(_tc_timeline_build(tcHomeDirectory,&timeline) != TC_OK)
+		fprintf(stderr, "%s\n", timeline.failed ? "Could not allocate memory for the timeline." : "Could not read the journal. tcatch fsck --repair rewrites it");
+	else
+		_tc_timeline_render(&timeline);
+	_tc_timeline_free(&timeline);
+}
+
+static void _tc_timeline_keep(struct tc_journal_record * record, void * data){
+	/* Even events after the window: a start there tells the pause after it
+	 * was not of a timer running across the window */
+	struct tc_timeline * timeline = data;
+	struct tc_journal_record * grown;
+	size_t capacity;
+
+	if(timeline->failed)
+		return;
+	if(timeline->recordCount == timeline->recordCapacity){
+		capacity = timeline->recordCapacity ? timeline->recordCapacity*2 : 256;
+		grown = realloc(timeline->records,capacity*sizeof(*grown));
+		if(grown == NULL){
+			timeline->failed = TRUE;
+			return;
+		}
+		timeline->records = grown;
+		timeline->recordCapacity = capacity;
+	}
+	timeline->records[timeline->recordCount++] = *record;
+}
+
+static void _tc_timeline_running(char const * taskHash, time_t lastStart, struct tc_timeline * timeline){
+	/* A timer started before the window has no event in it, start it here */
+	struct tc_journal_record record;
+
+	if(lastStart >= timeline->from || strlen(taskHash) >= sizeof(record.taskHash))
+		return;
+	memset(&record,0,sizeof(record));
+	record.eventTime = lastStart;
+	record.state = TC_TASK_STARTED;
+	record.seqNum = -1;
+	strcpy(record.taskHash,taskHash);
+	_tc_timeline_keep(&record,timeline);
+}
+
+static int _tc_timeline_record_compare(const void * left, const void * right){
+	/* By task, then in the order things happened to it */
+	const struct tc_journal_record * a = left;
+	const struct tc_journal_record * b = right;
+	int order;
+
+	if((order = strcmp(a->taskHash,b->taskHash)) != 0)
+		return order;
+	if(a->eventTime != b->eventTime)
+		return a->eventTime < b->eventTime ? -1 : 1;
+	return (a->seqNum > b->seqNum) - (a->seqNum < b->seqNum);
+}
+
+static int _tc_timeline_interval_compare(const void * left, const void * right){
+	const struct tc_timeline_interval * a = left;
+	const struct tc_timeline_interval * b = right;
+
+	if(a->start != b->start)
+		return a->start < b->start ? -1 : 1;
+	return (a->row > b->row) - (a->row < b->row);
+}
+
+static int _tc_timeline_row_compare(const void * left, const void * right){
+	/* By row and then start, so a row's intervals are side by side */
+	const struct tc_timeline_interval * a = left;
+	const struct tc_timeline_interval * b = right;
+
+	if(a->row != b->row)
+		return a->row < b->row ? -1 : 1;
+	return (a->start > b->start) - (a->start < b->start);
+}
+
+static void _tc_timeline_add(struct tc_timeline * timeline, size_t row, time_t start, time_t end){
+	/* The part of [start, end) inside the window, and before now */
+	struct tc_timeline_interval * grown;
+	size_t capacity;
+
+	if(start < timeline->from)
+		start = timeline->from;
+	if(end > timeline->to)
+		end = timeline->to;
+	if(end > timeline->now)
+		end = timeline->now;
+	if(end <= start || timeline->failed)
+		return;
+	if(timeline->intervalCount == timeline->intervalCapacity){
+		capacity = timeline->intervalCapacity ? timeline->intervalCapacity*2 : 256;
+		grown = realloc(timeline->intervals,capacity*sizeof(*grown));
+		if(grown == NULL){
+			timeline->failed = TRUE;
+			return;
+		}
+		timeline->intervals = grown;
+		timeline->intervalCapacity = capacity;
+	}
+	timeline->intervals[timeline->intervalCount].row = row;
+	timeline->intervals[timeline->intervalCount].start = start;
+	timeline->intervals[timeline->intervalCount].end = end;
+	++timeline->intervalCount;
+	timeline->rows[row].worked += end - start;
+}
+
+static void _tc_timeline_pair(struct tc_timeline * timeline, struct tc_journal_record * records, size_t count, size_t row){
+	/* One task's events into intervals. A task whose first event is not a
+	 * start was already running when the window began */
+	time_t opened;
+	int open;
+	size_t i;
+
+	open = count > 0 && records[0].state != TC_TASK_STARTED;
+	opened = timeline->from;
+	for(i = 0; i < count; ++i){
+		if(records[i].state == TC_TASK_STARTED){
+			if(open == FALSE)
+				opened = (time_t)records[i].eventTime;
+			open = TRUE;
+		}else if(open){
+			_tc_timeline_add(timeline,row,opened,(time_t)records[i].eventTime);
+			open = FALSE;
+		}
+	}
+	if(open)
+		_tc_timeline_add(timeline,row,opened,timeline->now);
+}
+
+int _tc_timeline_build(char const * tcHomeDirectory, struct tc_timeline * timeline){
+	/* Intervals of every task inside the window, and the rows in the order
+	 * work began on them. The intervals are left sorted by row */
+	struct tc_active_slot slots[TC_ACTIVE_SLOTS];
+	struct tc_timeline_row * ordered;
+	struct tc_spans spans;
+	char currentTaskName[TC_MAX_BUFF];
+	char taskHash[TC_MAX_BUFF];
+	size_t first, last, i, * rank;
+	int slotCount, s;
+
+	if(_tc_journal_since(tcHomeDirectory,timeline->from,_tc_timeline_keep,timeline) < 0)
+		return TC_ERR_IO;
+
+	/* Timers running since before the window, plain and --multi */
+	_tc_current_task_name(tcHomeDirectory,currentTaskName);
+	if(currentTaskName[0] != '\0'){
+		_tc_taskName_to_Hash(currentTaskName,taskHash);
+		if(_tc_spans_open(tcHomeDirectory,taskHash,&spans) == TC_OK){
+			if(spans.state == TC_TASK_STARTED)
+				_tc_timeline_running(taskHash,spans.openStart,timeline);
+			_tc_spans_free(&spans);
+		}
+	}
+	slotCount = _tc_active_list(tcHomeDirectory,slots,TC_ACTIVE_SLOTS);
+	for(s = 0; s < slotCount; ++s)
+		_tc_timeline_running(slots[s].taskHash,(time_t)slots[s].lastStart,timeline);
+	if(timeline->failed)
+		return TC_ERR_NOMEM;
+
+	/* A row for every task, named now so deleted ones are left out */
+	if(timeline->recordCount > 0)
+		qsort(timeline->records,timeline->recordCount,sizeof(*timeline->records),_tc_timeline_record_compare);
+	timeline->rows = malloc((timeline->recordCount + 1)*sizeof(*timeline->rows));
+	if(timeline->rows == NULL){
+		timeline->failed = TRUE;
+		return TC_ERR_NOMEM;
+	}
+	for(first = 0; first < timeline->recordCount; first = last){
+		for(last = first + 1; last < timeline->recordCount && strcmp(timeline->records[last].taskHash,timeline->records[first].taskHash) == 0; ++last)
+			;
+		if(_tc_log_name(tcHomeDirectory,timeline->records[first].taskHash,timeline->rows[timeline->rowCount].taskName) == FALSE)
+			continue;
+		strcpy(timeline->rows[timeline->rowCount].taskHash,timeline->records[first].taskHash);
+		timeline->rows[timeline->rowCount].worked = 0;
+		_tc_timeline_pair(timeline,timeline->records + first,last - first,timeline->rowCount);
+		++timeline->rowCount;
+	}
+	if(timeline->failed)
+		return TC_ERR_NOMEM;
+	if(timeline->intervalCount > 0)
+		qsort(timeline->intervals,timeline->intervalCount,sizeof(*timeline->intervals),_tc_timeline_interval_compare);
+
+	/* Number the rows by their first interval, dropping those without one */
+	rank = malloc((timeline->rowCount + 1)*sizeof(*rank));
+	ordered = malloc((timeline->rowCount + 1)*sizeof(*ordered));
+	if(rank == NULL || ordered == NULL){
+		free(rank);
+		free(ordered);
+		timeline->failed = TRUE;
+		return TC_ERR_NOMEM;
+	}
+	for(i = 0; i < timeline->rowCount; ++i)
+		rank[i] = timeline->rowCount;
+	for(last = 0, i = 0; i < timeline->intervalCount; ++i){
+		if(rank[timeline->intervals[i].row] == timeline->rowCount){
+			rank[timeline->intervals[i].row] = last;
+			ordered[last] = timeline->rows[timeline->intervals[i].row];
+			ordered[last].first = timeline->intervals[i].start;
+			++last;
+		}
+		timeline->intervals[i].row = rank[timeline->intervals[i].row];
+	}
+	free(timeline->rows);
+	free(rank);
+	timeline->rows = ordered;
+	timeline->rowCount = last;
+	if(timeline->intervalCount > 0)
+		qsort(timeline->intervals,timeline->intervalCount,sizeof(*timeline->intervals),_tc_timeline_row_compare);
+	return TC_OK;
+}
+
+static int _tc_timeline_edge_compare(const void * left, const void * right){
+	/* Ends before starts at the same instant, back to back is no overlap */
+	const struct tc_timeline_edge * a = left;
+	const struct tc_timeline_edge * b = right;
+
+	if(a->when != b->when)
+		return a->when < b->when ? -1 : 1;
+	return a->change - b->change;
+}
+
+static int _tc_timeline_column(struct tc_timeline * timeline, time_t when){
+	long column;
+
+	column = (long)((double)(when - timeline->from)*timeline->width/(timeline->to - timeline->from));
+	return column < 0 ? 0 : column >= timeline->width ? timeline->width - 1 : (int)column;
+}
+
+static time_t _tc_timeline_column_start(struct tc_timeline * timeline, int column){
+	return timeline->from + (time_t)((double)column*(timeline->to - timeline->from)/timeline->width);
+}
+
+static void _tc_timeline_worked(char * text, time_t seconds){
+	sprintf(text, "%ldh%02ldm", (long)(seconds/3600), (long)(seconds/60%60));
+}
+
+static void _tc_timeline_axis(struct tc_timeline * timeline, char * line){
+	/* Hours for a day, as often as they fit, and day names for a week */
+	static int const steps[] = {1, 2, 3, 4, 6, 12, 24};
+	char label[16];
+	struct tm tick;
+	time_t when;
+	int step, column, clear, k, i;
+
+	memset(line,' ',timeline->width);
+	line[timeline->width] = '\0';
+	for(step = 0; step < 6 && steps[step]*3600.0*timeline->width/(timeline->to - timeline->from) < 3; ++step)
+		;
+	clear = 0;
+	for(k = 0;; ++k){
+		tick = *localtime(&timeline->from);
+		if(timeline->byDay)
+			tick.tm_mday += k;
+		else
+			tick.tm_hour += k*steps[step];
+		tick.tm_isdst = -1;
+		if((when = mktime(&tick)) == -1 || when >= timeline->to)
+			break;
+		strftime(label,sizeof(label),timeline->byDay ? "%a" : "%H",&tick);
+		column = _tc_timeline_column(timeline,when);
+		if(column < clear || column + (int)strlen(label) > timeline->width)
+			continue;
+		for(i = 0; label[i] != '\0'; ++i)
+			line[column + i] = label[i];
+		clear = column + i + 1;
+	}
+}
+
+void _tc_timeline_render(struct tc_timeline * timeline){
+	/* Row bars from each row's intervals, then the sweep for the totals */
+	struct tc_timeline_edge * edges;
+	struct tc_timeline_interval * interval;
+	char header[TC_MAX_BUFF/2];
+	char worked[TC_TIMELINE_TOTAL*2];
+	char * line;
+	long * covered, * most;
+	time_t cellStart, cellEnd, prev, limit, busy, idle, overlap;
+	double cellSeconds;
+	size_t i;
+	int active, column, first, last;
+
+	line = malloc(timeline->width + 1);
+	covered = calloc(timeline->width,sizeof(*covered));
+	most = malloc(timeline->width*sizeof(*most));
+	edges = malloc((timeline->intervalCount*2 + 1)*sizeof(*edges));
+	if(line == NULL || covered == NULL || most == NULL || edges == NULL){
+		fprintf(stderr, "%s\n", "Could not allocate memory for the timeline.");
+		free(line);
+		free(covered);
+		free(most);
+		free(edges);
+		return;
+	}
+	cellSeconds = (double)(timeline->to - timeline->from)/timeline->width;
+
+	strftime(header,sizeof(header),"%a %d %b %Y",localtime(&timeline->from));
+	fprintf(stdout, "%s %s, one column is %.0f minutes\n", timeline->byDay ? "Week from" : "Day of", header, cellSeconds/60);
+	_tc_timeline_axis(timeline,line);
+	fprintf(stdout, "%-*s|%s|\n", TC_TIMELINE_LABEL, "", line);
+
+	/* The intervals are sorted by row, each row's bar is one run of them */
+	interval = timeline->intervals;
+	for(i = 0; i < timeline->rowCount; ++i){
+		memset(covered,0,timeline->width*sizeof(*covered));
+		for(; interval < timeline->intervals + timeline->intervalCount && interval->row == i; ++interval){
+			first = _tc_timeline_column(timeline,interval->start);
+			last = _tc_timeline_column(timeline,interval->end - 1);
+			for(column = first; column <= last; ++column){
+				cellStart = _tc_timeline_column_start(timeline,column);
+				cellEnd = _tc_timeline_column_start(timeline,column + 1);
+				covered[column] += (interval->end < cellEnd ? interval->end : cellEnd) - (interval->start > cellStart ? interval->start : cellStart);
+			}
+		}
+		for(column = 0; column < timeline->width; ++column)
+			line[column] = covered[column]*2 >= cellSeconds ? '#' : covered[column] > 0 ? '+' : ' ';
+		_tc_timeline_worked(worked,timeline->rows[i].worked);
+		fprintf(stdout, "%-*.*s|%s| %s\n", TC_TIMELINE_LABEL, TC_TIMELINE_LABEL - 1, timeline->rows[i].taskName, line, worked);
+	}
+
+	/* The sweep: between neighbouring ends the number of tasks running is
+	 * fixed, which is idle, busy or overlapping time, and the most in every
+	 * column those instants fall in */
+	for(i = 0; i < timeline->intervalCount; ++i){
+		edges[2*i].when = timeline->intervals[i].start;
+		edges[2*i].change = 1;
+		edges[2*i+1].when = timeline->intervals[i].end;
+		edges[2*i+1].change = -1;
+	}
+	qsort(edges,timeline->intervalCount*2,sizeof(*edges),_tc_timeline_edge_compare);
+	limit = timeline->to < timeline->now ? timeline->to : timeline->now;
+	for(column = 0; column < timeline->width; ++column)
+		most[column] = -1;
+	busy = idle = overlap = 0;
+	active = 0;
+	prev = timeline->from;
+	for(i = 0; i <= timeline->intervalCount*2; ++i){
+		cellEnd = i < timeline->intervalCount*2 ? edges[i].when : limit;
+		if(cellEnd > prev){
+			if(active == 0)
+				idle += cellEnd - prev;
+			else
+				busy += cellEnd - prev;
+			if(active > 1)
+				overlap += cellEnd - prev;
+			for(column = _tc_timeline_column(timeline,prev); column <= _tc_timeline_column(timeline,cellEnd - 1); ++column)
+				if(active > most[column])
+					most[column] = active;
+			prev = cellEnd;
+		}
+		if(i < timeline->intervalCount*2)
+			active += edges[i].change;
+	}
+	for(column = 0; column < timeline->width; ++column)
+		line[column] = most[column] < 0 ? ' ' : most[column] == 0 ? '.' : most[column] > 9 ? '*' : (char)('0' + most[column]);
+	_tc_timeline_worked(worked,busy);
+	fprintf(stdout, "%-*s|%s| %s\n", TC_TIMELINE_LABEL, "running at once", line, worked);
+
+	_tc_timeline_worked(header,busy);
+	_tc_timeline_worked(worked,idle);
+	fprintf(stdout, "%lu task%s, busy %s, idle %s", (unsigned long)timeline->rowCount, timeline->rowCount == 1 ? "" : "s", header, worked);
+	_tc_timeline_worked(worked,overlap);
+	fprintf(stdout, ", %s with tasks overlapping\n", worked);
+
+	free(line);
+	free(covered);
+	free(most);
+	free(edges);
+}
+
+void _tc_timeline_free(struct tc_timeline * timeline){
+	free(timeline->records);
+	free(timeline->intervals);
+	free(timeline->rows);
+	timeline->records = NULL;
+	timeline->intervals = NULL;
+	timeline->rows = NULL;
+}
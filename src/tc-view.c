@@ -2,15 +2,23 @@
 #include "tc-view.h"
 #include "tc-directory.h"
 #include "tc-init.h"
+#include "tc-active.h"
+#include "tc-archive.h"
+#include "tc-project.h"
+#include "tc-interval.h"
+#include "tc-prompt.h"
+#include "tc-store.h"
+#include "tc-lock.h"
 
 #include <dirent.h>
+#include <ctype.h>
 
 void tc_view(int argc, char const *argv[]){
 	struct tc_task taskToView;
 	char taskName[TC_MAX_BUFF];
 	taskName[0] = '\0';
 
-	_resolve_taskName_from_args(argc,argv,taskName);
+	_tc_cli_task_name(argc,argv,taskName);
 	
 	taskToView.taskName = malloc(TC_MAX_BUFF*sizeof(char));
 	taskToView.taskInfo = malloc(TC_MAX_BUFF*sizeof(char));
@@ -28,19 +36,14 @@ void tc_view(int argc, char const *argv[]){
 }
 
 void _tc_view_no_args(struct tc_task working_task){
-	char taskName[TC_MAX_BUFF]; 
-	taskName[0] = '\0';
-
+	/* current's record resolves the task, its history is only replayed
+	 * when the record is stale */
 	_find_current_task(&working_task);
-	if(working_task.state == TC_TASK_NOT_FOUND){
+	if(working_task.state == TC_TASK_NOT_FOUND && working_task.taskName[0] == '\0'){
 		/* If we're working on a task then no. finish it first or pause it */
 		fprintf(stderr, "\n%s\n", "No current task being worked on.");
 		return;
 	}
-	strcpy(taskName,working_task.taskName);
-
-	/* There is a working task so we should resolve it into information */
-	_tc_task_read(taskName,&working_task);
 	if(working_task.state == TC_TASK_NOT_FOUND){
 		/* If we're working on a task then no. finish it first or pause it */
 		fprintf(stderr, "%s\n", "Current task file exists, but could not resolve sequence file");
@@ -58,7 +61,32 @@ void _tc_view_no_args(struct tc_task working_task){
 
 void _tc_view_with_args(struct tc_task working_task, int verboseFlag, int argc, char const *argv[], char * taskName){
 	struct tc_task allTasks[TC_MAX_BUFF];
+	char tcHomeDirectory[TC_MAX_BUFF];
 	int i;
+
+	sprintf(tcHomeDirectory,"%s/.tc",_tc_getHomePath());
+	/* Project totals come straight from the rollups */
+	if( _tc_args_flag_check(argc, argv, TC_PROJECT_LONG, TC_PROJECT_SHORT) == TRUE ){
+		_tc_view_projects(tcHomeDirectory,
+							_tc_args_flag_value(argc, argv, TC_PROJECT_LONG, TC_PROJECT_SHORT),
+							_tc_args_flag_value(argc, argv, TC_DEPTH_LONG, TC_DEPTH_SHORT));
+		return;
+	}
+	/* The highest few come from each task's span file or last record */
+	if( _tc_args_flag_check(argc, argv, TC_TOP_LONG, TC_TOP_SHORT) == TRUE ){
+		_tc_view_top(tcHomeDirectory,argc,argv);
+		return;
+	}
+	/* Time inside a window comes from the interval index */
+	if( _tc_args_flag_check(argc, argv, TC_BETWEEN_LONG, TC_BETWEEN_SHORT) == TRUE ){
+		_tc_view_between(tcHomeDirectory,argc,argv);
+		return;
+	}
+	/* Running timers come straight from the active table */
+	if( _tc_args_flag_check(argc, argv, TC_MULTI_LONG, TC_MULTI_SHORT) == TRUE ){
+		_tc_view_active(working_task,verboseFlag);
+		return;
+	}
 	/* Check for all flag in any position*/
 	if( _tc_args_flag_check(argc, argv, TC_VIEW_ALL_LONG, TC_VIEW_ALL_SHORT) == TRUE ){
 		/* Show all tasks */
@@ -70,11 +98,17 @@ void _tc_view_with_args(struct tc_task working_task, int verboseFlag, int argc,
 			free(allTasks[i].taskName);
 			free(allTasks[i].taskInfo);
 		}
+
+		/* The archive is only read when asked for */
+		if( _tc_args_flag_check(argc, argv, TC_INCLUDE_ARCHIVED_LONG, TC_INCLUDE_ARCHIVED_SHORT) == TRUE )
+			_tc_view_archived_all(tcHomeDirectory,working_task,verboseFlag);
 		
 	}else{
 		if(strcmp(taskName,"")==0)
 			_find_current_task(&working_task);
-		else
+		else if(_tc_view_archived(tcHomeDirectory,taskName,working_task,verboseFlag) == TRUE)
+			return;
+		else if(_tc_active_fill(tcHomeDirectory,taskName,&working_task) == FALSE)
 			_tc_task_read(taskName,&working_task);
 		
 		if( working_task.state == TC_TASK_FOUND )
@@ -87,6 +121,473 @@ void _tc_view_with_args(struct tc_task working_task, int verboseFlag, int argc,
 	}
 }
 
+void _tc_view_active(struct tc_task working_task, int verboseFlag){
+	struct tc_active_slot slots[TC_ACTIVE_SLOTS];
+	char taskInfoPath[TC_MAX_BUFF];
+	char tcHomeDirectory[TC_MAX_BUFF];
+	int i, count;
+
+	sprintf(tcHomeDirectory,"%s/.tc",_tc_getHomePath());
+	count = _tc_active_list(tcHomeDirectory,slots,TC_ACTIVE_SLOTS);
+	if(count == 0){
+		fprintf(stderr, "%s\n", "No timers are running.");
+		return;
+	}
+
+	/* The table already holds the running totals, display them as they are */
+	working_task.taskInfo = taskInfoPath;
+	working_task.state = TC_TASK_STARTED;
+	for(i = 0; i < count; ++i){
+		working_task.taskName = slots[i].taskName;
+		working_task.startTime = slots[i].startTime;
+		working_task.endTime = slots[i].lastStart;
+		working_task.pauseTime = slots[i].accumulated;
+		working_task.seqNum = slots[i].seqNum;
+		_tc_getTaskFilePath(taskInfoPath,tcHomeDirectory,slots[i].taskHash,TC_INFO_EXT);
+		_tc_displayView(working_task,verboseFlag,FALSE);
+	}
+}
+
+static void _tc_view_archived_entry(char const * tcHomeDirectory, struct tc_archive_entry * entry, struct tc_task working_task, int verboseFlag){
+	char * taskInfo;
+
+	if(_tc_archive_fill(tcHomeDirectory,entry,&working_task,&taskInfo) == FALSE){
+		fprintf(stderr, "Could not read %s from the archive.\n", entry->taskName);
+		return;
+	}
+	_tc_displayView(working_task,FALSE,FALSE);
+	if(verboseFlag == TRUE)
+		fprintf(stdout, "Task Information: \n%s\n", taskInfo);
+	free(taskInfo);
+}
+
+static void _tc_view_worked(long worked){
+	fprintf(stdout, "%ld Days %ld Hours %ld Minutes and %ld Seconds\n",
+		worked/86400L, (worked%86400L)/3600L, (worked%3600L)/60L, worked%60L);
+}
+
+static void _tc_view_project(struct tc_project * project, int depth, void * data){
+	/* One line of the tree, indented by depth below the selected project */
+	char const * name;
+	int indent;
+
+	indent = *(int *)data;
+	name = depth > 0 ? strrchr(project->path,TC_PROJECT_SEPARATOR) : NULL;
+	name = name == NULL ? project->path : name + 1;
+	fprintf(stdout, "%*s%s\t%ld tasks\t", 2*(depth - indent), "", name, project->tasks);
+	_tc_view_worked(project->accumulated);
+}
+
+void _tc_view_projects(char const * tcHomeDirectory, char const * path, char const * depth){
+	/* Show a project and its subprojects, or every project without a path */
+	struct tc_projects projects;
+	char * end;
+	long maxDepth;
+	int indent;
+
+	maxDepth = -1;
+	if(depth != NULL){
+		maxDepth = strtol(depth,&end,10);
+		if(end == depth || *end != '\0' || maxDepth < 0){
+			_tc_display_usage(TC_VIEW_COMMAND);
+			return;
+		}
+	}
+	if(_tc_projects_load(tcHomeDirectory,&projects) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not read the project totals. Please check permissions");
+		return;
+	}
+	/* Top level projects are at depth 1 when there is no project to start from */
+	indent = path == NULL ? 1 : 0;
+	if(_tc_projects_select(&projects,path,(int)maxDepth,_tc_view_project,&indent) == 0)
+		fprintf(stderr, "%s\n", "Could not find any projects to show.");
+	_tc_projects_free(&projects);
+}
+
+int _tc_view_archived(char const * tcHomeDirectory, char const * taskName, struct tc_task working_task, int verboseFlag){
+	/* Show taskName from the archive if it is only there. TRUE if it was */
+	struct tc_archive_entry entry;
+	char taskHash[TC_MAX_BUFF];
+	char taskSequencePath[TC_MAX_BUFF];
+
+	_tc_taskName_to_Hash((char *)taskName,taskHash);
+	_tc_getTaskFilePath(taskSequencePath,tcHomeDirectory,taskHash,TC_SEQ_EXT);
+	if(_tc_file_exists(taskSequencePath) || _tc_archive_find(tcHomeDirectory,taskHash,&entry) == FALSE)
+		return FALSE;
+	_tc_view_archived_entry(tcHomeDirectory,&entry,working_task,verboseFlag);
+	return TRUE;
+}
+
+struct tc_view_archived {
+	struct tc_archive_entry entry;
+	size_t line;
+};
+
+struct tc_view_archive_list {
+	struct tc_view_archived * entries;
+	size_t count;
+	size_t capacity;
+};
+
+static void _tc_view_archive_collect(struct tc_archive_entry * entry, void * data){
+	struct tc_view_archive_list * list = data;
+	struct tc_view_archived * grown;
+
+	if(list->count == list->capacity){
+		grown = realloc(list->entries,(list->capacity ? list->capacity*2 : 64)*sizeof(*grown));
+		if(grown == NULL)
+			return;
+		list->entries = grown;
+		list->capacity = list->capacity ? list->capacity*2 : 64;
+	}
+	list->entries[list->count].entry = *entry;
+	list->entries[list->count].line = list->count;
+	++list->count;
+}
+
+static int _tc_view_archive_compare(const void * left, const void * right){
+	/* By task, then by index line */
+	const struct tc_view_archived * a = left;
+	const struct tc_view_archived * b = right;
+	int order;
+
+	if((order = strcmp(a->entry.taskHash,b->entry.taskHash)) != 0)
+		return order;
+	return a->line < b->line ? -1 : (a->line > b->line);
+}
+
+void _tc_view_archived_all(char const * tcHomeDirectory, struct tc_task working_task, int verboseFlag){
+	/* Every archived task once, from its latest index line */
+	struct tc_view_archive_list list;
+	char taskSequencePath[TC_MAX_BUFF];
+	size_t i;
+
+	memset(&list,0,sizeof(list));
+	_tc_archive_each(tcHomeDirectory,_tc_view_archive_collect,&list);
+	qsort(list.entries,list.count,sizeof(*list.entries),_tc_view_archive_compare);
+	for(i = 0; i < list.count; ++i){
+		if(i + 1 < list.count && strcmp(list.entries[i].entry.taskHash,list.entries[i+1].entry.taskHash) == 0)
+			continue;
+		/* A task back in the tasks directory was listed already */
+		_tc_getTaskFilePath(taskSequencePath,tcHomeDirectory,list.entries[i].entry.taskHash,TC_SEQ_EXT);
+		if(_tc_file_exists(taskSequencePath) == FALSE)
+			_tc_view_archived_entry(tcHomeDirectory,&list.entries[i].entry,working_task,verboseFlag);
+	}
+	free(list.entries);
+}
+
+int _tc_view_when(char const * text, int endOfWindow, time_t * when){
+	/* YYYYMMDD is local midnight, the one after that day when it ends a
+	 * window so the day is included. Anything else is epoch seconds */
+	struct tm day;
+	char * end;
+	long seconds;
+	int i;
+
+	for(i = 0; isdigit((unsigned char)text[i]); ++i)
+		;
+	if(i == 0 || text[i] != '\0')
+		return FALSE;
+	if(i != 8){
+		seconds = strtol(text,&end,10);
+		*when = seconds;
+		return TRUE;
+	}
+	memset(&day,0,sizeof(day));
+	sscanf(text,"%4d%2d%2d",&day.tm_year,&day.tm_mon,&day.tm_mday);
+	day.tm_year -= 1900;
+	day.tm_mon -= 1;
+	day.tm_mday += endOfWindow ? 1 : 0;
+	day.tm_isdst = -1;
+	return (*when = mktime(&day)) != -1;
+}
+
+/* What _tc_view_between_all adds up */
+struct tc_view_between_run {
+	struct tc_store * store;
+	time_t from;
+	time_t to;
+	time_t now;
+	time_t worked;
+};
+
+static time_t _tc_view_between_task(struct tc_view_between_run * run, char const * taskHash, char const * taskName){
+	/* One line for a task that was worked on inside the window */
+	struct tc_spans spans;
+	time_t worked;
+
+	if(run->store->ops->spans(run->store,taskHash,&spans) != TC_OK){
+		fprintf(stderr, "Could not read the intervals of %s.\n", taskName);
+		return 0;
+	}
+	worked = _tc_spans_between(&spans,run->from,run->to,run->now);
+	_tc_spans_free(&spans);
+	if(worked > 0){
+		fprintf(stdout, "%s\t", taskName);
+		_tc_view_worked(worked);
+	}
+	return worked;
+}
+
+static void _tc_view_between_listed(const char * taskHash, const char * taskName, void * data){
+	struct tc_view_between_run * run = data;
+	run->worked += _tc_view_between_task(run,taskHash,taskName);
+}
+
+static time_t _tc_view_between_all(struct tc_store * store, time_t from, time_t to, time_t now, int includeArchived){
+	/* Every task with time in the window, then the archived ones if asked */
+	struct tc_view_archive_list list;
+	struct tc_view_between_run run;
+	size_t i;
+
+	run.store = store;
+	run.from = from;
+	run.to = to;
+	run.now = now;
+	run.worked = 0;
+	if(store->ops->list(store,_tc_view_between_listed,&run) < 0){
+		fprintf(stderr, "%s\n", "Could not open task directory for file listing");
+		return 0;
+	}
+
+	if(includeArchived == FALSE)
+		return run.worked;
+	memset(&list,0,sizeof(list));
+	_tc_archive_each(store->root,_tc_view_archive_collect,&list);
+	qsort(list.entries,list.count,sizeof(*list.entries),_tc_view_archive_compare);
+	for(i = 0; i < list.count; ++i){
+		if(i + 1 < list.count && strcmp(list.entries[i].entry.taskHash,list.entries[i+1].entry.taskHash) == 0)
+			continue;
+		/* A task back in the tasks directory was counted already */
+		if(store->ops->task_open(store,list.entries[i].entry.taskHash,list.entries[i].entry.taskName,FALSE) != TC_OK)
+			run.worked += _tc_view_between_task(&run,list.entries[i].entry.taskHash,list.entries[i].entry.taskName);
+	}
+	free(list.entries);
+	return run.worked;
+}
+
+void _tc_view_between(char const * tcHomeDirectory, int argc, char const *argv[]){
+	/* Time worked on a task, or on every task, from T1 up to T2 */
+	struct tc_spans spans;
+	struct tc_store * store;
+	char const ** nameArgs;
+	char taskName[TC_MAX_BUFF];
+	char taskHash[TC_MAX_BUFF];
+	char fromText[TC_MAX_BUFF/2];
+	char toText[TC_MAX_BUFF/2];
+	time_t from, to, now, worked;
+	int at, i, count, result;
+
+	at = _tc_args_flag_index(argc,argv,TC_BETWEEN_LONG,TC_BETWEEN_SHORT);
+	if(at + 2 >= argc || _tc_view_when(argv[at+1],FALSE,&from) == FALSE || _tc_view_when(argv[at+2],TRUE,&to) == FALSE){
+		_tc_display_usage(TC_VIEW_COMMAND);
+		return;
+	}
+	if((now = time(0)) == -1){
+		fprintf(stderr, "%s\n", "Could not determine time.");
+		return;
+	}
+	strftime(fromText,TC_MAX_BUFF/2,"%c",localtime(&from));
+	strftime(toText,TC_MAX_BUFF/2,"%c",localtime(&to));
+
+	if(_tc_store_open_directory(&store,tcHomeDirectory) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not open the .tc directory. Please check permissions");
+		return;
+	}
+
+	if( _tc_args_flag_check(argc, argv, TC_VIEW_ALL_LONG, TC_VIEW_ALL_SHORT) == TRUE ){
+		fprintf(stdout, "Time worked from %s up to %s\n", fromText, toText);
+		worked = _tc_view_between_all(store,from,to,now,
+			_tc_args_flag_check(argc, argv, TC_INCLUDE_ARCHIVED_LONG, TC_INCLUDE_ARCHIVED_SHORT));
+		fprintf(stdout, "%s", "Total\t");
+		_tc_view_worked(worked);
+		_tc_store_close(store);
+		return;
+	}
+
+	/* The window is not part of the task name */
+	nameArgs = malloc(argc*sizeof(*nameArgs));
+	if(nameArgs == NULL){
+		_tc_store_close(store);
+		return;
+	}
+	for(count = i = 0; i < argc; ++i)
+		if(i != at + 1 && i != at + 2)
+			nameArgs[count++] = argv[i];
+	_tc_cli_task_name(count,nameArgs,taskName);
+	free(nameArgs);
+	if(taskName[0] == '\0')
+		store->ops->current_get(store,taskName);
+	if(taskName[0] == '\0'){
+		fprintf(stderr, "%s\n", "Could not find a current task to show.");
+		_tc_store_close(store);
+		return;
+	}
+
+	_tc_taskName_to_Hash(taskName,taskHash);
+	result = store->ops->spans(store,taskHash,&spans);
+	_tc_store_close(store);
+	if(result != TC_OK){
+		fprintf(stderr, "%s\n", result == TC_ERR_NOT_FOUND ? "Could not find the task to show." : "Could not read the intervals of the task.");
+		return;
+	}
+	fprintf(stdout, "Task Name:\t\t%s\nWorked From:\t\t%s\nUp To:\t\t\t%s\nTime Worked: \t\t", taskName, fromText, toText);
+	_tc_view_worked(_tc_spans_between(&spans,from,to,now));
+	_tc_spans_free(&spans);
+}
+
+static int _tc_view_top_less(struct tc_view_top_entry const * left, struct tc_view_top_entry const * right){
+	/* Ties go to the lower hash, so a store always lists the same tasks */
+	return left->value < right->value || (left->value == right->value && strcmp(left->taskHash,right->taskHash) > 0);
+}
+
+static void _tc_view_top_down(struct tc_view_top_entry * heap, size_t count, size_t at){
+	/* Sift the entry at at down until no child is less than it */
+	struct tc_view_top_entry moved;
+	size_t child;
+
+	moved = heap[at];
+	while((child = 2*at + 1) < count){
+		if(child + 1 < count && _tc_view_top_less(&heap[child+1],&heap[child]))
+			++child;
+		if(!_tc_view_top_less(&heap[child],&moved))
+			break;
+		heap[at] = heap[child];
+		at = child;
+	}
+	heap[at] = moved;
+}
+
+static void _tc_view_top_offer(struct tc_view_top * top, long value, char const * taskHash){
+	/* Kept while there is room, or when it beats the least kept task */
+	struct tc_view_top_entry entry;
+	size_t at;
+
+	entry.value = value;
+	strncpy(entry.taskHash,taskHash,sizeof(entry.taskHash) - 1);
+	entry.taskHash[sizeof(entry.taskHash) - 1] = '\0';
+	if(top->count < top->capacity){
+		for(at = top->count++; at > 0 && _tc_view_top_less(&entry,&top->heap[(at-1)/2]); at = (at-1)/2)
+			top->heap[at] = top->heap[(at-1)/2];
+		top->heap[at] = entry;
+	}
+	else if(_tc_view_top_less(&top->heap[0],&entry)){
+		top->heap[0] = entry;
+		_tc_view_top_down(top->heap,top->count,0);
+	}
+}
+
+static int _tc_view_top_value(struct tc_view_top * top, char const * taskHash, long * value){
+	/* Time and sessions from the task's intervals, the last update from
+	 * its last event. No history is replayed */
+	struct tc_task_summary summary;
+	struct tc_spans spans;
+	struct tc_span * last;
+
+	if(strcmp(top->by,TC_VIEW_TOP_UPDATED) == 0){
+		_tc_task_summary_init(&summary);
+		if(top->store->ops->last(top->store,taskHash,_tc_task_summary_record,&summary) < 0)
+			return FALSE;
+		*value = summary.lastTime;
+		return TRUE;
+	}
+	if(top->store->ops->spans(top->store,taskHash,&spans) != TC_OK)
+		return FALSE;
+	/* A running task's open session counts, as its time does */
+	if(strcmp(top->by,TC_VIEW_TOP_SESSIONS) == 0)
+		*value = spans.count + (spans.state == TC_TASK_STARTED ? 1 : 0);
+	else{
+		last = spans.count > 0 ? &spans.spans[spans.count-1] : NULL;
+		*value = last == NULL ? 0 : last->before + (last->end - last->start);
+		if(spans.state == TC_TASK_STARTED)
+			*value += top->now - spans.openStart;
+	}
+	_tc_spans_free(&spans);
+	return TRUE;
+}
+
+static void _tc_view_top_listed(const char * taskHash, const char * taskName, void * data){
+	struct tc_view_top * top = data;
+	long value;
+
+	if(_tc_view_top_value(top,taskHash,&value) == TRUE)
+		_tc_view_top_offer(top,value,taskHash);
+	else
+		fprintf(stderr, "Could not read the intervals of %s.\n", taskName);
+}
+
+void _tc_view_top(char const * tcHomeDirectory, int argc, char const *argv[]){
+	/* The K tasks with the most time worked, the latest update or the most
+	 * sessions. One pass over the store's tasks, K entries held at most */
+	struct tc_view_top_entry swap;
+	struct tc_view_top top;
+	char taskName[TC_MAX_BUFF];
+	char updatedText[TC_MAX_BUFF/2];
+	char const * text;
+	char * end;
+	time_t updated;
+	long k;
+	size_t i;
+
+	memset(&top,0,sizeof(top));
+	text = _tc_args_flag_value(argc,argv,TC_TOP_LONG,TC_TOP_SHORT);
+	end = "";
+	k = text == NULL ? 0 : strtol(text,&end,10);
+	top.by = _tc_args_flag_value(argc,argv,TC_BY_LONG,TC_BY_SHORT);
+	if(top.by == NULL && _tc_args_flag_check(argc,argv,TC_BY_LONG,TC_BY_SHORT) == FALSE)
+		top.by = TC_VIEW_TOP_TIME;
+	if(k <= 0 || *end != '\0' || (unsigned long)k > ((size_t)-1)/sizeof(*top.heap) || top.by == NULL
+		|| (strcmp(top.by,TC_VIEW_TOP_TIME) != 0 && strcmp(top.by,TC_VIEW_TOP_UPDATED) != 0 && strcmp(top.by,TC_VIEW_TOP_SESSIONS) != 0)){
+		_tc_display_usage(TC_VIEW_COMMAND);
+		return;
+	}
+	if((top.now = time(0)) == -1){
+		fprintf(stderr, "%s\n", "Could not determine time.");
+		return;
+	}
+	top.capacity = k;
+	if((top.heap = malloc(top.capacity*sizeof(*top.heap))) == NULL){
+		fprintf(stderr, "%s\n", "Could not allocate memory for the top tasks.");
+		return;
+	}
+	if(_tc_store_open_directory(&top.store,tcHomeDirectory) != TC_OK){
+		fprintf(stderr, "%s\n", "Could not open the .tc directory. Please check permissions");
+		free(top.heap);
+		return;
+	}
+	if(top.store->ops->list(top.store,_tc_view_top_listed,&top) < 0){
+		fprintf(stderr, "%s\n", "Could not open task directory for file listing");
+		_tc_store_close(top.store);
+		free(top.heap);
+		return;
+	}
+
+	/* Moving the least to the back each time leaves the highest first */
+	for(i = top.count; i > 1; --i){
+		swap = top.heap[0];
+		top.heap[0] = top.heap[i-1];
+		top.heap[i-1] = swap;
+		_tc_view_top_down(top.heap,i-1,0);
+	}
+	for(i = 0; i < top.count; ++i){
+		if(top.store->ops->task_name(top.store,top.heap[i].taskHash,taskName) != TC_OK || taskName[0] == '\0')
+			strcpy(taskName,top.heap[i].taskHash);
+		if(strcmp(top.by,TC_VIEW_TOP_UPDATED) == 0){
+			updated = top.heap[i].value;
+			strftime(updatedText,TC_MAX_BUFF/2,"%c",localtime(&updated));
+			fprintf(stdout, "%s\t%s\n", taskName, updatedText);
+		}
+		else if(strcmp(top.by,TC_VIEW_TOP_SESSIONS) == 0)
+			fprintf(stdout, "%s\t%ld session%s\n", taskName, top.heap[i].value, top.heap[i].value == 1 ? "" : "s");
+		else{
+			fprintf(stdout, "%s\t", taskName);
+			_tc_view_worked(top.heap[i].value);
+		}
+	}
+	_tc_store_close(top.store);
+	free(top.heap);
+}
+
 int _getAllTasks(struct tc_task allTasks[]){
 	DIR * dirPointer;
 	struct dirent *dirEntry;
@@ -179,3 +680,166 @@ void _tc_displayView(struct tc_task working_task,int verbose, int finishFlag){
 		fclose(fp_info);
 	}
 }
+
+static int _tc_prompt_publish(char const * tcHomeDirectory, char const * promptPath, struct tc_prompt * prompt){
+	/* Stores from before the prompt record, or whose record was lost, get
+	 * it written from current's under the current lock like any writer */
+	struct tc_task_summary summary;
+	struct tc_store * store;
+	char taskName[TC_MAX_BUFF];
+	char taskHash[TC_MAX_BUFF];
+	int lock, result;
+
+	if(_tc_store_open_directory(&store,tcHomeDirectory) != TC_OK)
+		return FALSE;
+	if((lock = _tc_lock_current(tcHomeDirectory)) == -1){
+		_tc_store_close(store);
+		return FALSE;
+	}
+	if(store->ops->current_summary(store,taskName,taskHash,&summary) == TC_OK)
+		result = _tc_prompt_write(promptPath,taskName,summary.state,summary.startTime,summary.lastStart,summary.accumulated);
+	else
+		result = _tc_prompt_write(promptPath,NULL,TC_TASK_NOT_FOUND,0,0,0);
+	_tc_lock_release(lock);
+	_tc_store_close(store);
+	return result && tc_prompt_read(promptPath,prompt);
+}
+
+void tc_prompt(int argc, char const *argv[]){
+	/* The current task and its time for a shell prompt, nothing when there
+	 * is none. One read of the prompt record, see tc-prompt.h */
+	char tcHomeDirectory[TC_MAX_BUFF];
+	char promptPath[TC_MAX_BUFF*2];
+	struct tc_prompt prompt;
+	long worked;
+
+	/* Usage has already been shown by the help check */
+	if(_tc_args_flag_check(argc,argv,TC_HELP_LONG,TC_HELP_SHORT) == TRUE)
+		return;
+
+	/* A prompt never creates the .tc directory */
+	sprintf(tcHomeDirectory,"%s/.tc",_tc_getHomePath());
+	sprintf(promptPath,"%s/%s",tcHomeDirectory,TC_PROMPT_FILE);
+	if(tc_prompt_read(promptPath,&prompt) == 0
+		&& (_tc_directoryExists(tcHomeDirectory) != TRUE || _tc_prompt_publish(tcHomeDirectory,promptPath,&prompt) == FALSE))
+		return;
+	if(prompt.state != TC_TASK_STARTED)
+		return;
+
+	worked = (long)tc_prompt_worked(&prompt,time(0));
+	fprintf(stdout, "%s %ldh%02ldm\n", prompt.taskName, worked/3600, (worked%3600)/60);
+}
+
+void _find_current_task(struct tc_task * taskStruct){
+	/*Returns an error code within the taskStruct to determine success or not.
+	 * The name is left "" when there is no current task at all */
+	char tcHomeDirectory[TC_MAX_BUFF];
+	struct tc_current current;
+
+	taskStruct->taskName[0] = '\0';
+	sprintf(tcHomeDirectory,"%s/.tc",_tc_getHomePath());
+	if(_tc_current_read(tcHomeDirectory,&current) == FALSE){
+		if(current.taskName[0] == '\0')
+			/* Return an error flag that there is no current task */
+			taskStruct->state = TC_TASK_NOT_FOUND;
+		else
+			/* A stale record, the history has the answer */
+			_tc_task_read(current.taskName, taskStruct);
+		return;
+	}
+
+	/* Filled in as _tc_task_read would have, without the replay */
+	strcpy(taskStruct->taskName,current.taskName);
+	_tc_getTaskFilePath(taskStruct->taskInfo,tcHomeDirectory,current.taskHash,TC_INFO_EXT);
+	taskStruct->startTime = current.summary.startTime;
+	taskStruct->endTime = current.summary.lastTime;
+	taskStruct->state = current.summary.state;
+	taskStruct->seqNum = current.summary.seqNum;
+	taskStruct->pauseTime = current.summary.accumulated;
+	if(taskStruct->pauseTime == 0 && taskStruct->state == TC_TASK_STARTED)
+		taskStruct->pauseTime = time(0) - taskStruct->startTime;
+}
+
+void _tc_task_read(char const * taskName, struct tc_task * structToFill){ 
+	/* Attempt to fill the structure with data from the file */
+	char taskHash[TC_MAX_BUFF];
+	char taskSequencePath[TC_MAX_BUFF];
+	char taskInfoPath[TC_MAX_BUFF];
+
+	strcpy(structToFill->taskName,taskName);
+	_tc_taskName_to_Hash((char *)taskName,taskHash);
+	
+	/* Read the sequence information for the sequence number and timing info and the last state*/
+	/* So to tease out the information we need to read the sequence information. The start time is 
+	 * the first time in the sequence file by default, so lets open the sequence file:
+	*/
+
+	sprintf(taskSequencePath,"%s/.tc/%s/%s.seq",_tc_getHomePath(),TC_TASK_DIR,taskHash);
+	sprintf(taskInfoPath,"%s/.tc/%s/%s.info",_tc_getHomePath(),TC_TASK_DIR,taskHash);
+	if(_tc_task_replay(taskSequencePath,structToFill) == FALSE){
+		fprintf(stderr, "%s\n", "Could not find or open the sequence file for task. Exiting");
+		structToFill->state =  TC_TASK_NOT_FOUND;
+		return;
+	}
+
+	/* Cheat a little bit 
+	 * It's simple, we stored the NAME of the info file into the structure, then when we want to
+	 * display the information we don't read the whole file into memory, but rather we open it
+	 * then read it directly into an output stream. This saves us the trouble of realloc-ing memory
+	 * or reading the file some buffer size at a time.for no reason.
+	*/
+	strcpy(structToFill->taskInfo , taskInfoPath);
+
+}
+
+void _tc_task_read_byHashPath(char const * taskHash, struct tc_task * structToFill){ 
+	/* Attempt to fill the structure with data from the file */
+	char taskSequencePath[TC_MAX_BUFF];
+	char taskInfoPath[TC_MAX_BUFF];
+	char taskName[TC_MAX_BUFF];
+	FILE * fp;
+
+	/* Read the sequence information for the sequence number and timing info and the last state*/
+	/* So to tease out the information we need to read the sequence information. The start time is 
+	 * the first time in the sequence file by default, so lets open the sequence file:
+	*/
+	taskName[0] = '\0';
+	strcpy(structToFill->taskName,taskName);
+
+
+	sprintf(taskSequencePath,"%s/.tc/%s/%s.seq",_tc_getHomePath(),TC_TASK_DIR,taskHash);
+	sprintf(taskInfoPath,"%s/.tc/%s/%s.info",_tc_getHomePath(),TC_TASK_DIR,taskHash);
+	if(_tc_task_replay(taskSequencePath,structToFill) == FALSE){
+		fprintf(stderr, "%s\n", "Could not find or open the sequence file for task.");
+		structToFill->startTime = 0;
+		structToFill->pauseTime = 0;
+		structToFill->endTime = 0;
+		structToFill->state =  TC_TASK_NOT_FOUND;
+		return;
+	}
+
+	fp = fopen(taskInfoPath,"r");
+	if(!fp){
+		fprintf(stderr, "%s\n", "Could not find or open the info file for task.");
+		structToFill->state =  TC_TASK_NOT_FOUND;
+		structToFill->startTime = 0;
+		structToFill->pauseTime = 0;
+		structToFill->endTime = 0;
+		return;
+	}
+
+	/* The first line is the task name*/
+	fgets(taskName,TC_MAX_BUFF,fp);
+	taskName[strlen(taskName)-1] = '\0'; /* Remove the newline read in*/
+	strcpy(structToFill->taskName,taskName);
+
+	fclose(fp);
+	/* Cheat a little bit 
+	 * It's simple, we stored the NAME of the info file into the structure, then when we want to
+	 * display the information we don't read the whole file into memory, but rather we open it
+	 * then read it directly into an output stream. This saves us the trouble of realloc-ing memory
+	 * or reading the file some buffer size at a time.for no reason.
+	*/
+	strcpy(structToFill->taskInfo , taskInfoPath);
+
+}
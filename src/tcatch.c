@@ -1,6 +1,9 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <strings.h>
+#include <time.h>
 
 #include "tc-init.h"
 #include "tc-directory.h"
@@ -11,8 +14,41 @@
 #include "tc-finish.h"
 #include "tc-pause.h"
 #include "tc-delete.h"
+#include "tc-export.h"
+#include "tc-import.h"
+#include "tc-index.h"
+#include "tc-archive.h"
+#include "tc-fsck.h"
+#include "tc-metrics.h"
+#include "tc-merge.h"
+#include "tc-log.h"
+#include "tc-timeline.h"
+#include "tc-stats.h"
+#include "tc-report.h"
+#include "tc-counters.h"
+
+static struct timespec _tc_began;
+
+static void _tc_record_latency(void){
+	/* Every command ends up in the latency histogram, whichever way it exits.
+	 * The sample is only appended, the next writer folds it in */
+	char tcHomeDirectory[TC_MAX_BUFF*2];
+	struct timespec ended;
+	long micros;
+
+	sprintf(tcHomeDirectory,"%s/.tc",_tc_getHomePath());
+	if(_tc_directoryExists(tcHomeDirectory) != TRUE || clock_gettime(CLOCK_MONOTONIC,&ended) != 0)
+		return;
+	micros = (ended.tv_sec - _tc_began.tv_sec)*1000000L + (ended.tv_nsec - _tc_began.tv_nsec)/1000;
+	_tc_counters_sample(tcHomeDirectory,micros < 0 ? 0 : micros);
+}
 
 int main(int argc, char const *argv[]) {	
+	/* Time commands for tcatch metrics, usage alone is not one. Neither is
+	 * prompt, which runs for every shell prompt and must not touch the store */
+	if ( argc > 1 && strcasecmp(argv[1], TC_PROMPT_COMMAND) != 0 && clock_gettime(CLOCK_MONOTONIC,&_tc_began) == 0 )
+		atexit(_tc_record_latency);
+
 	/* Determine what we've been asked to do */
 	if ( argc <= 1 ) {
 		/* Called with no arguments. Display Usage */
@@ -24,6 +60,22 @@ int main(int argc, char const *argv[]) {
 			tc_view(argc,argv);
 		else if (strcasecmp(argv[1], TC_PAUSE_COMMAND) == 0)
 			tc_pause(argc,argv);
+		else if (strcasecmp(argv[1], TC_INDEX_COMMAND) == 0)
+			tc_index(argc,argv);
+		else if (strcasecmp(argv[1], TC_FSCK_COMMAND) == 0)
+			tc_fsck(argc,argv);
+		else if (strcasecmp(argv[1], TC_METRICS_COMMAND) == 0)
+			tc_metrics(argc,argv);
+		else if (strcasecmp(argv[1], TC_LOG_COMMAND) == 0)
+			tc_log(argc,argv);
+		else if (strcasecmp(argv[1], TC_TIMELINE_COMMAND) == 0)
+			tc_timeline(argc,argv);
+		else if (strcasecmp(argv[1], TC_STATS_COMMAND) == 0)
+			tc_stats(argc,argv);
+		else if (strcasecmp(argv[1], TC_PROMPT_COMMAND) == 0)
+			tc_prompt(argc,argv);
+		else if (strcasecmp(argv[1], TC_REPORT_COMMAND) == 0)
+			tc_report(argc,argv);
 		else 
 			_tc_display_usage(argv[1]);
 		
@@ -42,10 +94,39 @@ int main(int argc, char const *argv[]) {
 			tc_addInfo(argc,argv);
 		else if (strcasecmp( argv[1], TC_FINISH_COMMAND ) == 0 ) 
 			tc_finish(argc,argv);
-		else if (strcasecmp(argv[1], TC_PAUSE_COMMAND) == 0)
-			_tc_display_usage(argv[1]);
+		else if (strcasecmp(argv[1], TC_PAUSE_COMMAND) == 0){
+			/* Only multi-timer mode pauses a task by name */
+			if(_tc_args_flag_check(argc,argv,TC_MULTI_LONG,TC_MULTI_SHORT) == TRUE)
+				tc_pause(argc,argv);
+			else
+				_tc_display_usage(argv[1]);
+		}
 		else if (strcasecmp(argv[1], TC_DELETE_COMMAND)==0)
 			tc_delete(argc,argv);
+		else if (strcasecmp(argv[1], TC_EXPORT_COMMAND)==0)
+			tc_export(argc,argv);
+		else if (strcasecmp(argv[1], TC_IMPORT_COMMAND)==0)
+			tc_import(argc,argv);
+		else if (strcasecmp(argv[1], TC_INDEX_COMMAND)==0)
+			tc_index(argc,argv);
+		else if (strcasecmp(argv[1], TC_ARCHIVE_COMMAND)==0)
+			tc_archive(argc,argv);
+		else if (strcasecmp(argv[1], TC_FSCK_COMMAND)==0)
+			tc_fsck(argc,argv);
+		else if (strcasecmp(argv[1], TC_METRICS_COMMAND)==0)
+			tc_metrics(argc,argv);
+		else if (strcasecmp(argv[1], TC_MERGE_COMMAND)==0)
+			tc_merge(argc,argv);
+		else if (strcasecmp(argv[1], TC_LOG_COMMAND)==0)
+			tc_log(argc,argv);
+		else if (strcasecmp(argv[1], TC_TIMELINE_COMMAND)==0)
+			tc_timeline(argc,argv);
+		else if (strcasecmp(argv[1], TC_STATS_COMMAND)==0)
+			tc_stats(argc,argv);
+		else if (strcasecmp(argv[1], TC_PROMPT_COMMAND)==0)
+			tc_prompt(argc,argv);
+		else if (strcasecmp(argv[1], TC_REPORT_COMMAND)==0)
+			tc_report(argc,argv);
 		else
 			fprintf(stderr, "%s\n", "Command  not recognized."), _tc_display_usage(NULL);
 	}